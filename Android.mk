@@ -67,6 +67,7 @@ dsp_dec_srcs := \
     src/dsp/alpha_processing_sse2.c \
     src/dsp/alpha_processing_sse41.c \
     src/dsp/cpu.c \
+    src/dsp/cpu_level.c \
     src/dsp/dec.c \
     src/dsp/dec_clip_tables.c \
     src/dsp/dec_mips32.c \
@@ -75,6 +76,7 @@ dsp_dec_srcs := \
     src/dsp/dec_neon.$(NEON) \
     src/dsp/dec_sse2.c \
     src/dsp/dec_sse41.c \
+    src/dsp/dec_xtensa.c \
     src/dsp/filters.c \
     src/dsp/filters_mips_dsp_r2.c \
     src/dsp/filters_msa.c \
@@ -104,6 +106,7 @@ dsp_dec_srcs := \
     src/dsp/yuv_neon.$(NEON) \
     src/dsp/yuv_sse2.c \
     src/dsp/yuv_sse41.c \
+    src/dsp/yuv_xtensa.c \
 
 dsp_enc_srcs := \
     src/dsp/cost.c \
@@ -154,6 +157,8 @@ enc_srcs := \
     src/enc/webp_enc.c \
 
 mux_srcs := \
+    src/dsp/anim_enc.c \
+    src/dsp/anim_enc_sse2.c \
     src/mux/anim_encode.c \
     src/mux/muxedit.c \
     src/mux/muxinternal.c \
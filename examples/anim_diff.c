@@ -220,6 +220,7 @@ int main(int argc, const char* argv[]) {
   AnimatedImage images[2];
 
   INIT_WARGV(argc, argv);
+  if (!ExUtilSetDspLevelFromEnv()) FREE_WARGV_AND_RETURN(return_code);
 
   for (c = 1; c < argc; ++c) {
     int parse_error = 0;
@@ -17,6 +17,7 @@
 
 #include "../imageio/image_enc.h"
 #include "./anim_util.h"
+#include "./example_util.h"
 #include "./unicode.h"
 #include "webp/decode.h"
 #include "webp/types.h"
@@ -48,6 +49,7 @@ int main(int argc, const char* argv[]) {
   int c;
 
   INIT_WARGV(argc, argv);
+  if (!ExUtilSetDspLevelFromEnv()) FREE_WARGV_AND_RETURN(EXIT_FAILURE);
 
   if (argc < 2) {
     Help();
@@ -32,18 +32,6 @@
 #include "webp/encode.h"
 #include "webp/types.h"
 
-#ifndef WEBP_DLL
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-extern void* VP8GetCPUInfo;  // opaque forward declaration.
-
-#ifdef __cplusplus
-}  // extern "C"
-#endif
-#endif  // WEBP_DLL
-
 //------------------------------------------------------------------------------
 
 static int verbose = 0;
@@ -631,6 +619,8 @@ static void HelpLong(void) {
       "  -resize_mode <string> .. one of: up_only, down_only,"
       " always (default)\n");
   printf("  -mt .................... use multi-threading if available\n");
+  printf("  -threads <int> ......... use up to <int> threads (max 32),"
+         " 1 to disable\n");
   printf("  -low_memory ............ reduce memory usage (slower encoding)\n");
   printf("  -map <int> ............. print map of extra info\n");
   printf("  -print_psnr ............ prints averaged PSNR distortion\n");
@@ -670,9 +660,7 @@ static void HelpLong(void) {
   printf("  -short ................. condense printed message\n");
   printf("  -quiet ................. don't print anything\n");
   printf("  -version ............... print version number and exit\n");
-#ifndef WEBP_DLL
   printf("  -noasm ................. disable all assembly optimizations\n");
-#endif
   printf(
       "  -v ..................... verbose, e.g. print encoding/decoding "
       "times\n");
@@ -739,6 +727,7 @@ int main(int argc, const char* argv[]) {
   Stopwatch stop_watch;
 
   INIT_WARGV(argc, argv);
+  if (!ExUtilSetDspLevelFromEnv()) FREE_WARGV_AND_RETURN(EXIT_FAILURE);
 
   MetadataInit(&metadata);
   WebPMemoryWriterInit(&memory_writer);
@@ -854,6 +843,12 @@ int main(int argc, const char* argv[]) {
       config.emulate_jpeg_size = 1;
     } else if (!strcmp(argv[c], "-mt")) {
       ++config.thread_level;  // increase thread level
+    } else if (!strcmp(argv[c], "-threads") && c < argc - 1) {
+      const int num_threads = ExUtilGetInt(argv[++c], 0, &parse_error);
+      // thread_level 1 means two threads: map 1 to single-threaded instead.
+      // Larger values are clamped to the documented maximum of 32 threads.
+      config.thread_level =
+          (num_threads > 32) ? 32 : (num_threads > 1) ? num_threads : 0;
     } else if (!strcmp(argv[c], "-low_memory")) {
       config.low_memory = 1;
     } else if (!strcmp(argv[c], "-strong")) {
@@ -900,10 +895,8 @@ int main(int argc, const char* argv[]) {
         fprintf(stderr, "Error! Unrecognized resize mode: %s\n", argv[c]);
         goto Error;
       }
-#ifndef WEBP_DLL
     } else if (!strcmp(argv[c], "-noasm")) {
-      VP8GetCPUInfo = NULL;
-#endif
+      WebPSetDspLevel(WEBP_DSP_LEVEL_C);
     } else if (!strcmp(argv[c], "-version")) {
       const int version = WebPGetEncoderVersion();
       const int sharpyuv_version = SharpYuvGetVersion();
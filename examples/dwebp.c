@@ -30,18 +30,6 @@
 
 static int verbose = 0;
 static int quiet = 0;
-#ifndef WEBP_DLL
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-extern void* VP8GetCPUInfo;  // opaque forward declaration.
-
-#ifdef __cplusplus
-}  // extern "C"
-#endif
-#endif  // WEBP_DLL
-
 static int SaveOutput(const WebPDecBuffer* const buffer,
                       WebPOutputFileFormat format, const char* const out_file) {
   const int use_stdout = (out_file != NULL) && !WSTRCMP(out_file, "-");
@@ -97,6 +85,7 @@ static void Help(void) {
       "  -dither <d> .. dithering strength (in 0..100)\n"
       "  -alpha_dither  use alpha-plane dithering if needed\n"
       "  -mt .......... use multi-threading\n"
+      "  -threads <n> . use <n> threads for lossy reconstruction (implies -mt)\n"
       "  -crop <x> <y> <w> <h> ... crop output with the given rectangle\n"
       "  -resize <w> <h> ......... resize output (*after* any cropping)\n"
       "  -flip ........ flip the output vertically\n"
@@ -105,9 +94,7 @@ static void Help(void) {
       "  -h ........... this help message\n"
       "  -v ........... verbose (e.g. print encoding/decoding times)\n"
       "  -quiet ....... quiet mode, don't print anything\n"
-#ifndef WEBP_DLL
       "  -noasm ....... disable all assembly optimizations\n"
-#endif
   );
 }
 
@@ -195,6 +182,7 @@ int main(int argc, const char* argv[]) {
   int c;
 
   INIT_WARGV(argc, argv);
+  if (!ExUtilSetDspLevelFromEnv()) FREE_WARGV_AND_RETURN(EXIT_FAILURE);
 
   if (!WebPInitDecoderConfig(&config)) {
     fprintf(stderr, "Library version mismatch!\n");
@@ -273,6 +261,9 @@ int main(int argc, const char* argv[]) {
       }
     } else if (!strcmp(argv[c], "-mt")) {
       config.options.use_threads = 1;
+    } else if (!strcmp(argv[c], "-threads") && c < argc - 1) {
+      config.options.use_threads = 1;
+      config.options.num_threads = ExUtilGetInt(argv[++c], 0, &parse_error);
     } else if (!strcmp(argv[c], "-alpha_dither")) {
       config.options.alpha_dithering_strength = 100;
     } else if (!strcmp(argv[c], "-nodither")) {
@@ -295,10 +286,8 @@ int main(int argc, const char* argv[]) {
       config.options.flip = 1;
     } else if (!strcmp(argv[c], "-v")) {
       verbose = 1;
-#ifndef WEBP_DLL
     } else if (!strcmp(argv[c], "-noasm")) {
-      VP8GetCPUInfo = NULL;
-#endif
+      WebPSetDspLevel(WEBP_DSP_LEVEL_C);
     } else if (!strcmp(argv[c], "-incremental")) {
       incremental = 1;
     } else if (!strcmp(argv[c], "--")) {
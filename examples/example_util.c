@@ -137,3 +137,24 @@ int ExUtilReadFileToWebPData(const char* const filename,
   webp_data->size = size;
   return 1;
 }
+
+//------------------------------------------------------------------------------
+
+int ExUtilSetDspLevelFromEnv(void) {
+  static const struct {
+    const char* name;
+    WebPDspLevel level;
+  } kLevels[] = {{"c", WEBP_DSP_LEVEL_C},         {"sse2", WEBP_DSP_LEVEL_SSE2},
+                 {"sse4.1", WEBP_DSP_LEVEL_SSE41}, {"avx2", WEBP_DSP_LEVEL_AVX2},
+                 {"neon", WEBP_DSP_LEVEL_NEON},    {"auto", WEBP_DSP_LEVEL_AUTO}};
+  const char* const value = getenv("WEBP_DSP_LEVEL");
+  size_t i;
+  if (value == NULL || value[0] == '\0') return 1;
+  for (i = 0; i < sizeof(kLevels) / sizeof(kLevels[0]); ++i) {
+    if (!strcmp(value, kLevels[i].name)) {
+      return WebPSetDspLevel(kLevels[i].level);
+    }
+  }
+  fprintf(stderr, "Unknown WEBP_DSP_LEVEL value '%s'.\n", value);
+  return 0;
+}
@@ -41,6 +41,15 @@ int ExUtilGetInts(const char* v, int base, int max_output, int output[]);
 int ExUtilReadFileToWebPData(const char* const filename,
                              WebPData* const webp_data);
 
+//------------------------------------------------------------------------------
+// SIMD dispatch
+
+// Caps the SIMD code used by the library according to the WEBP_DSP_LEVEL
+// environment variable: one of "c", "sse2", "sse4.1", "avx2", "neon" or
+// "auto" (see WebPSetDspLevel()). Does nothing if the variable is not set.
+// Returns false and prints an error if the value is not recognized.
+int ExUtilSetDspLevelFromEnv(void);
+
 //------------------------------------------------------------------------------
 // Command-line arguments
 
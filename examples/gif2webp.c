@@ -148,6 +148,7 @@ int main(int argc, const char* argv[]) {
   int default_kmax = 1;
 
   INIT_WARGV(argc, argv);
+  if (!ExUtilSetDspLevelFromEnv()) FREE_WARGV_AND_RETURN(EXIT_FAILURE);
 
   if (!WebPConfigInit(&config) || !WebPAnimEncoderOptionsInit(&enc_options) ||
       !WebPPictureInit(&frame) || !WebPPictureInit(&curr_canvas) ||
@@ -239,6 +240,7 @@ int main(int argc, const char* argv[]) {
       }
     } else if (!strcmp(argv[c], "-mt")) {
       ++config.thread_level;
+      enc_options.lookahead = 4;  // Encode the next keyframes early.
     } else if (!strcmp(argv[c], "-version")) {
       const int enc_version = WebPGetEncoderVersion();
       const int mux_version = WebPGetMuxVersion();
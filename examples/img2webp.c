@@ -58,6 +58,7 @@ static void Help(void) {
       "conversion\n                        "
       "(lossy only)\n");
   printf(" -loop <int> .......... loop count (default: 0, = infinite loop)\n");
+  printf(" -mt .................. use multi-threading if available\n");
   printf(" -v ................... verbose mode\n");
   printf(" -h ................... this help\n");
   printf(" -version ............. print version number and exit\n");
@@ -167,6 +168,7 @@ int main(int argc, const char* argv[]) {
   int ok;
 
   INIT_WARGV(argc, argv);
+  if (!ExUtilSetDspLevelFromEnv()) FREE_WARGV_AND_RETURN(EXIT_FAILURE);
 
   ok = ExUtilInitCommandLineArguments(argc - 1, argv + 1, &cmd_args);
   if (!ok) FREE_WARGV_AND_RETURN(EXIT_FAILURE);
@@ -212,6 +214,9 @@ int main(int argc, const char* argv[]) {
         config.near_lossless = ExUtilGetInt(argv[++c], 0, &parse_error);
       } else if (!strcmp(argv[c], "-sharp_yuv")) {
         config.use_sharp_yuv = 1;
+      } else if (!strcmp(argv[c], "-mt")) {
+        ++config.thread_level;
+        anim_config.lookahead = 4;  // Encode the next keyframes early.
       } else if (!strcmp(argv[c], "-v")) {
         verbose = 1;
       } else if (!strcmp(argv[c], "-h") || !strcmp(argv[c], "-help")) {
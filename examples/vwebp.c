@@ -499,6 +499,7 @@ int main(int argc, char* argv[]) {
   WebPIterator* const curr = &kParams.curr_frame;
 
   INIT_WARGV(argc, argv);
+  if (!ExUtilSetDspLevelFromEnv()) FREE_WARGV_AND_RETURN(EXIT_FAILURE);
 
   if (!WebPInitDecoderConfig(config)) {
     fprintf(stderr, "Library version mismatch!\n");
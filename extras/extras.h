@@ -22,7 +22,7 @@ extern "C" {
 #include "sharpyuv/sharpyuv.h"
 #include "webp/encode.h"
 
-#define WEBP_EXTRAS_ABI_VERSION 0x0003  // MAJOR(8b) + MINOR(8b)
+#define WEBP_EXTRAS_ABI_VERSION 0x0004  // MAJOR(8b) + MINOR(8b)
 
 //------------------------------------------------------------------------------
 
@@ -105,6 +105,52 @@ WEBP_EXTERN int SharpYuvEstimate420Risk(const void* r_ptr, const void* g_ptr,
                                         const SharpYuvOptions* options,
                                         float* score);
 
+//------------------------------------------------------------------------------
+// Simulated memory tiers.
+
+// A WebPTierAllocator emulates, on top of malloc(), a small fast memory (e.g.
+// the internal SRAM of a micro-controller) next to an unbounded slow one
+// (e.g. PSRAM). WEBP_MEMORY_HINT_HOT allocations are placed in the fast tier
+// as long as they fit, all the others in the slow tier. The statistics gathered
+// per tier help tuning the placement of the buffers for a given fast memory
+// size. The allocator is not thread-safe.
+typedef struct WebPTierAllocator WebPTierAllocator;
+
+typedef enum WebPMemoryTier {
+  WEBP_MEMORY_TIER_FAST = 0,
+  WEBP_MEMORY_TIER_SLOW,
+  WEBP_MEMORY_TIER_NUM
+} WebPMemoryTier;
+
+typedef struct WebPMemoryTierStats {
+  size_t bytes;          // currently allocated
+  size_t peak_bytes;     // highest value of 'bytes'
+  uint64_t total_bytes;  // allocated since creation or the last reset
+  int num_allocs;
+  // Subset of the above made with WEBP_MEMORY_HINT_HOT. In the slow tier,
+  // these are the hot buffers that did not fit in the fast tier.
+  uint64_t hot_bytes;
+  int num_hot_allocs;
+} WebPMemoryTierStats;
+
+// Creates an allocator with 'fast_capacity' bytes of fast memory. Returns NULL
+// in case of memory error.
+WEBP_EXTERN WebPTierAllocator* WebPTierAllocatorNew(size_t fast_capacity);
+
+// Releases the allocator. All the memory it allocated must have been freed.
+WEBP_EXTERN void WebPTierAllocatorDelete(WebPTierAllocator* tier_allocator);
+
+// Fills 'allocator' with the functions to pass to WebPSetMemoryAllocator().
+WEBP_EXTERN void WebPTierAllocatorGetAllocator(
+    WebPTierAllocator* tier_allocator, WebPMemoryAllocator* allocator);
+
+// Returns the statistics of 'tier', or NULL if 'tier' is invalid.
+WEBP_EXTERN const WebPMemoryTierStats* WebPTierAllocatorGetStats(
+    const WebPTierAllocator* tier_allocator, WebPMemoryTier tier);
+
+// Resets the cumulative statistics. 'peak_bytes' restarts from 'bytes'.
+WEBP_EXTERN void WebPTierAllocatorResetStats(WebPTierAllocator* tier_allocator);
+
 //------------------------------------------------------------------------------
 
 #ifdef __cplusplus
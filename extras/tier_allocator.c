@@ -0,0 +1,122 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+//  Host-side simulation of a fast/slow memory split.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "./extras.h"
+#include "webp/types.h"
+
+// Each block is prefixed with its size and tier. The header is kept large
+// enough to preserve the alignment of malloc() for the SIMD code.
+#define HEADER_SIZE 32
+
+typedef struct {
+  size_t size;
+  int tier;
+} BlockHeader;
+
+struct WebPTierAllocator {
+  size_t fast_capacity;
+  WebPMemoryTierStats stats[WEBP_MEMORY_TIER_NUM];
+};
+
+static void* Allocate(WebPTierAllocator* const ta, size_t size,
+                      WebPMemoryHint hint, int zero) {
+  WebPMemoryTierStats* const fast = &ta->stats[WEBP_MEMORY_TIER_FAST];
+  BlockHeader header;
+  WebPMemoryTierStats* stats;
+  uint8_t* block;
+
+  if (size > (size_t)-1 - HEADER_SIZE) return NULL;
+  block = (uint8_t*)(zero ? calloc(1, HEADER_SIZE + size)
+                          : malloc(HEADER_SIZE + size));
+  if (block == NULL) return NULL;
+
+  header.size = size;
+  header.tier = (hint == WEBP_MEMORY_HINT_HOT &&
+                 size <= ta->fast_capacity - fast->bytes)
+                    ? WEBP_MEMORY_TIER_FAST
+                    : WEBP_MEMORY_TIER_SLOW;
+  memcpy(block, &header, sizeof(header));
+
+  stats = &ta->stats[header.tier];
+  stats->bytes += size;
+  if (stats->bytes > stats->peak_bytes) stats->peak_bytes = stats->bytes;
+  stats->total_bytes += size;
+  ++stats->num_allocs;
+  if (hint == WEBP_MEMORY_HINT_HOT) {
+    stats->hot_bytes += size;
+    ++stats->num_hot_allocs;
+  }
+  return block + HEADER_SIZE;
+}
+
+static void* TierMalloc(void* opaque, size_t size, WebPMemoryHint hint) {
+  return Allocate((WebPTierAllocator*)opaque, size, hint, /*zero=*/0);
+}
+
+static void* TierCalloc(void* opaque, size_t nmemb, size_t size,
+                        WebPMemoryHint hint) {
+  if (size != 0 && nmemb > (size_t)-1 / size) return NULL;
+  return Allocate((WebPTierAllocator*)opaque, nmemb * size, hint, /*zero=*/1);
+}
+
+static void TierFree(void* opaque, void* ptr) {
+  WebPTierAllocator* const ta = (WebPTierAllocator*)opaque;
+  uint8_t* block;
+  BlockHeader header;
+  if (ptr == NULL) return;
+  block = (uint8_t*)ptr - HEADER_SIZE;
+  memcpy(&header, block, sizeof(header));
+  ta->stats[header.tier].bytes -= header.size;
+  free(block);
+}
+
+//------------------------------------------------------------------------------
+
+WebPTierAllocator* WebPTierAllocatorNew(size_t fast_capacity) {
+  WebPTierAllocator* const ta = (WebPTierAllocator*)calloc(1, sizeof(*ta));
+  if (ta != NULL) ta->fast_capacity = fast_capacity;
+  return ta;
+}
+
+void WebPTierAllocatorDelete(WebPTierAllocator* tier_allocator) {
+  free(tier_allocator);
+}
+
+void WebPTierAllocatorGetAllocator(WebPTierAllocator* tier_allocator,
+                                   WebPMemoryAllocator* allocator) {
+  if (tier_allocator == NULL || allocator == NULL) return;
+  allocator->malloc_func = TierMalloc;
+  allocator->calloc_func = TierCalloc;
+  allocator->free_func = TierFree;
+  allocator->opaque = tier_allocator;
+}
+
+const WebPMemoryTierStats* WebPTierAllocatorGetStats(
+    const WebPTierAllocator* tier_allocator, WebPMemoryTier tier) {
+  if (tier_allocator == NULL || (int)tier < 0 || tier >= WEBP_MEMORY_TIER_NUM) {
+    return NULL;
+  }
+  return &tier_allocator->stats[tier];
+}
+
+void WebPTierAllocatorResetStats(WebPTierAllocator* tier_allocator) {
+  int i;
+  if (tier_allocator == NULL) return;
+  for (i = 0; i < WEBP_MEMORY_TIER_NUM; ++i) {
+    WebPMemoryTierStats* const stats = &tier_allocator->stats[i];
+    const size_t bytes = stats->bytes;
+    memset(stats, 0, sizeof(*stats));
+    stats->bytes = stats->peak_bytes = bytes;
+  }
+}
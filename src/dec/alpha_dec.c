@@ -158,12 +158,17 @@ WEBP_NODISCARD static int AllocateAlphaPlane(VP8Decoder* const dec,
   const int stride = io->width;
   const int height = io->crop_bottom;
   const uint64_t alpha_size = (uint64_t)stride * height;
-  assert(dec->alpha_plane_mem == NULL);
-  dec->alpha_plane_mem =
-      (uint8_t*)WebPSafeMalloc(alpha_size, sizeof(*dec->alpha_plane));
-  if (dec->alpha_plane_mem == NULL) {
-    return VP8SetError(dec, VP8_STATUS_OUT_OF_MEMORY,
-                       "Alpha decoder initialization failed.");
+  // The plane may be left over by a previous picture (see VP8Reset()).
+  if (dec->alpha_plane_mem == NULL || alpha_size > dec->alpha_plane_mem_size) {
+    WebPSafeFree(dec->alpha_plane_mem);
+    dec->alpha_plane_mem_size = 0;
+    dec->alpha_plane_mem =
+        (uint8_t*)WebPSafeMalloc(alpha_size, sizeof(*dec->alpha_plane));
+    if (dec->alpha_plane_mem == NULL) {
+      return VP8SetError(dec, VP8_STATUS_OUT_OF_MEMORY,
+                         "Alpha decoder initialization failed.");
+    }
+    dec->alpha_plane_mem_size = (size_t)alpha_size;
   }
   dec->alpha_plane = dec->alpha_plane_mem;
   dec->alpha_prev_line = NULL;
@@ -174,6 +179,7 @@ void WebPDeallocateAlphaMemory(VP8Decoder* const dec) {
   assert(dec != NULL);
   WebPSafeFree(dec->alpha_plane_mem);
   dec->alpha_plane_mem = NULL;
+  dec->alpha_plane_mem_size = 0;
   dec->alpha_plane = NULL;
   ALPHDelete(dec->alph_dec);
   dec->alph_dec = NULL;
@@ -80,15 +80,13 @@ static void DoUVTransform(uint32_t bits, const int16_t* const src,
   }
 }
 
-static void ReconstructRow(const VP8Decoder* const dec,
-                           const VP8ThreadContext* ctx) {
+// Initialize the left and top-left samples of the reconstruction block 'yuv_b'
+// before the first macroblock of row 'mb_y'.
+static void InitLeftSamples(uint8_t* const yuv_b, int mb_y) {
   int j;
-  int mb_x;
-  const int mb_y = ctx->mb_y;
-  const int cache_id = ctx->id;
-  uint8_t* const y_dst = dec->yuv_b + Y_OFF;
-  uint8_t* const u_dst = dec->yuv_b + U_OFF;
-  uint8_t* const v_dst = dec->yuv_b + V_OFF;
+  uint8_t* const y_dst = yuv_b + Y_OFF;
+  uint8_t* const u_dst = yuv_b + U_OFF;
+  uint8_t* const v_dst = yuv_b + V_OFF;
 
   // Initialize left-most block.
   for (j = 0; j < 16; ++j) {
@@ -109,102 +107,117 @@ static void ReconstructRow(const VP8Decoder* const dec,
     WEBP_UNSAFE_MEMSET(u_dst - BPS - 1, 127, 8 + 1);
     WEBP_UNSAFE_MEMSET(v_dst - BPS - 1, 127, 8 + 1);
   }
+}
 
-  // Reconstruct one row.
-  for (mb_x = 0; mb_x < dec->mb_w; ++mb_x) {
-    const VP8MBData* const block = ctx->mb_data + mb_x;
-
-    // Rotate in the left samples from previously decoded block. We move four
-    // pixels at a time for alignment reason, and because of in-loop filter.
-    if (mb_x > 0) {
-      for (j = -1; j < 16; ++j) {
-        Copy32b(&y_dst[j * BPS - 4], &y_dst[j * BPS + 12]);
-      }
-      for (j = -1; j < 8; ++j) {
-        Copy32b(&u_dst[j * BPS - 4], &u_dst[j * BPS + 4]);
-        Copy32b(&v_dst[j * BPS - 4], &v_dst[j * BPS + 4]);
-      }
+// Reconstruct macroblock 'mb_x' of the row described by 'ctx', using 'yuv_b'
+// as scratch. Macroblocks of a row must be processed from left to right.
+static WEBP_INLINE void ReconstructMB(const VP8Decoder* const dec,
+                                      const VP8ThreadContext* const ctx,
+                                      uint8_t* const yuv_b, int mb_x) {
+  int j;
+  const int mb_y = ctx->mb_y;
+  const int cache_id = ctx->id;
+  uint8_t* const y_dst = yuv_b + Y_OFF;
+  uint8_t* const u_dst = yuv_b + U_OFF;
+  uint8_t* const v_dst = yuv_b + V_OFF;
+  const VP8MBData* const block = ctx->mb_data + mb_x;
+
+  // Rotate in the left samples from previously decoded block. We move four
+  // pixels at a time for alignment reason, and because of in-loop filter.
+  if (mb_x > 0) {
+    for (j = -1; j < 16; ++j) {
+      Copy32b(&y_dst[j * BPS - 4], &y_dst[j * BPS + 12]);
     }
-    {
-      // bring top samples into the cache
-      VP8TopSamples* const top_yuv = dec->yuv_t + mb_x;
-      const int16_t* const coeffs = block->coeffs;
-      uint32_t bits = block->non_zero_y;
-      int n;
+    for (j = -1; j < 8; ++j) {
+      Copy32b(&u_dst[j * BPS - 4], &u_dst[j * BPS + 4]);
+      Copy32b(&v_dst[j * BPS - 4], &v_dst[j * BPS + 4]);
+    }
+  }
+  {
+    // bring top samples into the cache
+    VP8TopSamples* const top_yuv = dec->yuv_t + mb_x;
+    const int16_t* const coeffs = block->coeffs;
+    uint32_t bits = block->non_zero_y;
+    int n;
 
-      if (mb_y > 0) {
-        WEBP_UNSAFE_MEMCPY(y_dst - BPS, top_yuv[0].y, 16);
-        WEBP_UNSAFE_MEMCPY(u_dst - BPS, top_yuv[0].u, 8);
-        WEBP_UNSAFE_MEMCPY(v_dst - BPS, top_yuv[0].v, 8);
-      }
+    if (mb_y > 0) {
+      WEBP_UNSAFE_MEMCPY(y_dst - BPS, top_yuv[0].y, 16);
+      WEBP_UNSAFE_MEMCPY(u_dst - BPS, top_yuv[0].u, 8);
+      WEBP_UNSAFE_MEMCPY(v_dst - BPS, top_yuv[0].v, 8);
+    }
 
-      // predict and add residuals
-      if (block->is_i4x4) {  // 4x4
-        uint32_t* const top_right = (uint32_t*)(y_dst - BPS + 16);
+    // predict and add residuals
+    if (block->is_i4x4) {  // 4x4
+      uint32_t* const top_right = (uint32_t*)(y_dst - BPS + 16);
 
-        if (mb_y > 0) {
-          if (mb_x >= dec->mb_w - 1) {  // on rightmost border
-            WEBP_UNSAFE_MEMSET(top_right, top_yuv[0].y[15], sizeof(*top_right));
-          } else {
-            WEBP_UNSAFE_MEMCPY(top_right, top_yuv[1].y, sizeof(*top_right));
-          }
-        }
-        // replicate the top-right pixels below
-        top_right[BPS] = top_right[2 * BPS] = top_right[3 * BPS] = top_right[0];
-
-        // predict and add residuals for all 4x4 blocks in turn.
-        for (n = 0; n < 16; ++n, bits <<= 2) {
-          uint8_t* const dst = y_dst + kScan[n];
-          VP8PredLuma4[block->imodes[n]](dst);
-          DoTransform(bits, coeffs + n * 16, dst);
-        }
-      } else {  // 16x16
-        const int pred_func = CheckMode(mb_x, mb_y, block->imodes[0]);
-        VP8PredLuma16[pred_func](y_dst);
-        if (bits != 0) {
-          for (n = 0; n < 16; ++n, bits <<= 2) {
-            DoTransform(bits, coeffs + n * 16, y_dst + kScan[n]);
-          }
+      if (mb_y > 0) {
+        if (mb_x >= dec->mb_w - 1) {  // on rightmost border
+          WEBP_UNSAFE_MEMSET(top_right, top_yuv[0].y[15], sizeof(*top_right));
+        } else {
+          WEBP_UNSAFE_MEMCPY(top_right, top_yuv[1].y, sizeof(*top_right));
         }
       }
-      {
-        // Chroma
-        const uint32_t bits_uv = block->non_zero_uv;
-        const int pred_func = CheckMode(mb_x, mb_y, block->uvmode);
-        VP8PredChroma8[pred_func](u_dst);
-        VP8PredChroma8[pred_func](v_dst);
-        DoUVTransform(bits_uv >> 0, coeffs + 16 * 16, u_dst);
-        DoUVTransform(bits_uv >> 8, coeffs + 20 * 16, v_dst);
+      // replicate the top-right pixels below
+      top_right[BPS] = top_right[2 * BPS] = top_right[3 * BPS] = top_right[0];
+
+      // predict and add residuals for all 4x4 blocks in turn.
+      for (n = 0; n < 16; ++n, bits <<= 2) {
+        uint8_t* const dst = y_dst + kScan[n];
+        VP8PredLuma4[block->imodes[n]](dst);
+        DoTransform(bits, coeffs + n * 16, dst);
       }
-
-      // stash away top samples for next block
-      if (mb_y < dec->mb_h - 1) {
-        WEBP_UNSAFE_MEMCPY(top_yuv[0].y, y_dst + 15 * BPS, 16);
-        WEBP_UNSAFE_MEMCPY(top_yuv[0].u, u_dst + 7 * BPS, 8);
-        WEBP_UNSAFE_MEMCPY(top_yuv[0].v, v_dst + 7 * BPS, 8);
+    } else {  // 16x16
+      const int pred_func = CheckMode(mb_x, mb_y, block->imodes[0]);
+      VP8PredLuma16[pred_func](y_dst);
+      if (bits != 0) {
+        for (n = 0; n < 16; ++n, bits <<= 2) {
+          DoTransform(bits, coeffs + n * 16, y_dst + kScan[n]);
+        }
       }
     }
-    // Transfer reconstructed samples from yuv_b cache to final destination.
     {
-      const int y_offset = cache_id * 16 * dec->cache_y_stride;
-      const int uv_offset = cache_id * 8 * dec->cache_uv_stride;
-      uint8_t* const y_out = dec->cache_y + mb_x * 16 + y_offset;
-      uint8_t* const u_out = dec->cache_u + mb_x * 8 + uv_offset;
-      uint8_t* const v_out = dec->cache_v + mb_x * 8 + uv_offset;
-      for (j = 0; j < 16; ++j) {
-        WEBP_UNSAFE_MEMCPY(y_out + j * dec->cache_y_stride, y_dst + j * BPS,
-                           16);
-      }
-      for (j = 0; j < 8; ++j) {
-        WEBP_UNSAFE_MEMCPY(u_out + j * dec->cache_uv_stride, u_dst + j * BPS,
-                           8);
-        WEBP_UNSAFE_MEMCPY(v_out + j * dec->cache_uv_stride, v_dst + j * BPS,
-                           8);
-      }
+      // Chroma
+      const uint32_t bits_uv = block->non_zero_uv;
+      const int pred_func = CheckMode(mb_x, mb_y, block->uvmode);
+      VP8PredChroma8[pred_func](u_dst);
+      VP8PredChroma8[pred_func](v_dst);
+      DoUVTransform(bits_uv >> 0, coeffs + 16 * 16, u_dst);
+      DoUVTransform(bits_uv >> 8, coeffs + 20 * 16, v_dst);
+    }
+
+    // stash away top samples for next block
+    if (mb_y < dec->mb_h - 1) {
+      WEBP_UNSAFE_MEMCPY(top_yuv[0].y, y_dst + 15 * BPS, 16);
+      WEBP_UNSAFE_MEMCPY(top_yuv[0].u, u_dst + 7 * BPS, 8);
+      WEBP_UNSAFE_MEMCPY(top_yuv[0].v, v_dst + 7 * BPS, 8);
+    }
+  }
+  // Transfer reconstructed samples from yuv_b cache to final destination.
+  {
+    const int y_offset = cache_id * 16 * dec->cache_y_stride;
+    const int uv_offset = cache_id * 8 * dec->cache_uv_stride;
+    uint8_t* const y_out = dec->cache_y + mb_x * 16 + y_offset;
+    uint8_t* const u_out = dec->cache_u + mb_x * 8 + uv_offset;
+    uint8_t* const v_out = dec->cache_v + mb_x * 8 + uv_offset;
+    for (j = 0; j < 16; ++j) {
+      WEBP_UNSAFE_MEMCPY(y_out + j * dec->cache_y_stride, y_dst + j * BPS, 16);
+    }
+    for (j = 0; j < 8; ++j) {
+      WEBP_UNSAFE_MEMCPY(u_out + j * dec->cache_uv_stride, u_dst + j * BPS, 8);
+      WEBP_UNSAFE_MEMCPY(v_out + j * dec->cache_uv_stride, v_dst + j * BPS, 8);
     }
   }
 }
 
+static void ReconstructRow(const VP8Decoder* const dec,
+                           const VP8ThreadContext* ctx) {
+  int mb_x;
+  InitLeftSamples(dec->yuv_b, ctx->mb_y);
+  for (mb_x = 0; mb_x < dec->mb_w; ++mb_x) {
+    ReconstructMB(dec, ctx, dec->yuv_b, mb_x);
+  }
+}
+
 //------------------------------------------------------------------------------
 // Filtering
 
@@ -215,8 +228,8 @@ static void ReconstructRow(const VP8Decoder* const dec,
 //                 U/V, so it's 8 samples total (because of the 2x upsampling).
 static const uint8_t kFilterExtraRows[3] = {0, 2, 8};
 
-static void DoFilter(const VP8Decoder* const dec, int mb_x, int mb_y) {
-  const VP8ThreadContext* const ctx = &dec->thread_ctx;
+static void DoFilter(const VP8Decoder* const dec,
+                     const VP8ThreadContext* const ctx, int mb_x, int mb_y) {
   const int cache_id = ctx->id;
   const int y_bps = dec->cache_y_stride;
   const VP8FInfo* const f_info = ctx->f_info + mb_x;
@@ -265,12 +278,13 @@ static void DoFilter(const VP8Decoder* const dec, int mb_x, int mb_y) {
 }
 
 // Filter the decoded macroblock row (if needed)
-static void FilterRow(const VP8Decoder* const dec) {
+static void FilterRow(const VP8Decoder* const dec,
+                      const VP8ThreadContext* const ctx) {
   int mb_x;
-  const int mb_y = dec->thread_ctx.mb_y;
-  assert(dec->thread_ctx.filter_row);
+  const int mb_y = ctx->mb_y;
+  assert(ctx->filter_row);
   for (mb_x = dec->tl_mb_x; mb_x < dec->br_mb_x; ++mb_x) {
-    DoFilter(dec, mb_x, mb_y);
+    DoFilter(dec, ctx, mb_x, mb_y);
   }
 }
 
@@ -412,12 +426,11 @@ static void DitherRow(VP8Decoder* const dec) {
 
 #define MACROBLOCK_VPOS(mb_y) ((mb_y) * 16)  // vertical position of a MB
 
-// Finalize and transmit a complete row. Return false in case of user-abort.
-static int FinishRow(void* arg1, void* arg2) {
-  VP8Decoder* const dec = (VP8Decoder*)arg1;
-  VP8Io* const io = (VP8Io*)arg2;
+// Transmit a reconstructed and filtered row. Return false in case of
+// user-abort.
+static int EmitRow(VP8Decoder* const dec, const VP8ThreadContext* const ctx,
+                   VP8Io* const io) {
   int ok = 1;
-  const VP8ThreadContext* const ctx = &dec->thread_ctx;
   const int cache_id = ctx->id;
   const int extra_y_rows = kFilterExtraRows[dec->filter_type];
   const int ysize = extra_y_rows * dec->cache_y_stride;
@@ -431,18 +444,6 @@ static int FinishRow(void* arg1, void* arg2) {
   const int is_first_row = (mb_y == 0);
   const int is_last_row = (mb_y >= dec->br_mb_y - 1);
 
-  if (dec->mt_method == 2) {
-    ReconstructRow(dec, ctx);
-  }
-
-  if (ctx->filter_row) {
-    FilterRow(dec);
-  }
-
-  if (dec->dither) {
-    DitherRow(dec);
-  }
-
   if (io->put != NULL) {
     int y_start = MACROBLOCK_VPOS(mb_y);
     int y_end = MACROBLOCK_VPOS(mb_y + 1);
@@ -496,8 +497,8 @@ static int FinishRow(void* arg1, void* arg2) {
       ok = io->put(io);
     }
   }
-  // rotate top samples if needed
-  if (cache_id + 1 == dec->num_caches) {
+  // rotate top samples if needed (done per macroblock by wavefront jobs)
+  if (dec->mt_method != 3 && cache_id + 1 == dec->num_caches) {
     if (!is_last_row) {
       WEBP_UNSAFE_MEMCPY(dec->cache_y - ysize, ydst + 16 * dec->cache_y_stride,
                          ysize);
@@ -511,9 +512,165 @@ static int FinishRow(void* arg1, void* arg2) {
   return ok;
 }
 
+// Finalize and transmit a complete row. Return false in case of user-abort.
+static int FinishRow(void* arg1, void* arg2) {
+  VP8Decoder* const dec = (VP8Decoder*)arg1;
+  VP8Io* const io = (VP8Io*)arg2;
+  const VP8ThreadContext* const ctx = &dec->thread_ctx;
+
+  if (dec->mt_method == 2) {
+    ReconstructRow(dec, ctx);
+  }
+
+  if (ctx->filter_row) {
+    FilterRow(dec, ctx);
+  }
+
+  if (dec->dither) {
+    DitherRow(dec);
+  }
+
+  return EmitRow(dec, ctx, io);
+}
+
 #undef MACROBLOCK_VPOS
 
 //------------------------------------------------------------------------------
+// Wavefront reconstruction.
+//
+// Each macroblock row is handed to one of the 'num_jobs' row jobs, in
+// round-robin order. The job processing row 'mb_y' reconstructs and filters
+// macroblock 'mb_x' only once the row above is done up to 'mb_x + 1' included:
+//  * intra-prediction needs the unfiltered top-right samples (dec->yuv_t),
+//  * the top edge filtering needs the row above to be fully filtered there,
+//    including the left edge of macroblock 'mb_x + 1'.
+// Row 'mb_y' uses the cache row 'mb_y % num_caches', with num_caches being
+// num_jobs + 1 so that a cache row is never overwritten before its bottom
+// samples have been emitted. When wrapping around to cache row #0, the
+// bottom rows of the last cache row are copied above cache row #0 one
+// macroblock at a time, before the top edge is filtered. Finished rows are
+// emitted in order, progress->counters[num_jobs] being the number of rows
+// emitted so far.
+// When the partitions are parsed in parallel, row 'mb_y' additionally waits
+// for its tokens to be parsed by the token job 'mb_y % num_token_jobs', whose
+// progress is recorded in progress->counters[num_jobs + 1 + token job id].
+
+// Position of the macroblock (mb_x, mb_y) as recorded in the progress counters.
+#define ROW_POS(dec, mb_y, mb_x) ((mb_y) * ((dec)->mb_w + 1) + (mb_x))
+
+static void CopyTopExtraRows(const VP8Decoder* const dec, int mb_x) {
+  const int extra_y_rows = kFilterExtraRows[dec->filter_type];
+  const int extra_uv_rows = extra_y_rows / 2;
+  const int y_bps = dec->cache_y_stride;
+  const int uv_bps = dec->cache_uv_stride;
+  const int y_last = (16 * dec->num_caches - extra_y_rows) * y_bps;
+  const int uv_last = (8 * dec->num_caches - extra_uv_rows) * uv_bps;
+  uint8_t* const y_dst = dec->cache_y - extra_y_rows * y_bps + mb_x * 16;
+  uint8_t* const u_dst = dec->cache_u - extra_uv_rows * uv_bps + mb_x * 8;
+  uint8_t* const v_dst = dec->cache_v - extra_uv_rows * uv_bps + mb_x * 8;
+  int j;
+  for (j = 0; j < extra_y_rows; ++j) {
+    WEBP_UNSAFE_MEMCPY(y_dst + j * y_bps, dec->cache_y + y_last + mb_x * 16 +
+                       j * y_bps, 16);
+  }
+  for (j = 0; j < extra_uv_rows; ++j) {
+    WEBP_UNSAFE_MEMCPY(u_dst + j * uv_bps, dec->cache_u + uv_last + mb_x * 8 +
+                       j * uv_bps, 8);
+    WEBP_UNSAFE_MEMCPY(v_dst + j * uv_bps, dec->cache_v + uv_last + mb_x * 8 +
+                       j * uv_bps, 8);
+  }
+}
+
+static int ProcessWavefrontRow(void* arg1, void* arg2) {
+  VP8Decoder* const dec = (VP8Decoder*)arg1;
+  VP8RowJob* const job = (VP8RowJob*)arg2;
+  VP8ThreadContext* const ctx = &job->ctx;
+  WebPProgress* const progress = &dec->progress;
+  const int num_jobs = dec->num_jobs;
+  const int mb_y = ctx->mb_y;
+  const int job_id = mb_y % num_jobs;
+  const int prev_job_id = (mb_y + num_jobs - 1) % num_jobs;
+  const int copy_top_rows =
+      (ctx->id == 0 && mb_y > 0 && kFilterExtraRows[dec->filter_type] > 0);
+  const int token_id = (dec->num_token_jobs > 0)
+                           ? num_jobs + 1 + mb_y % dec->num_token_jobs
+                           : -1;
+  int mb_x;
+
+  InitLeftSamples(job->yuv_b, mb_y);
+  for (mb_x = 0; mb_x < dec->mb_w; ++mb_x) {
+    if (token_id >= 0 &&
+        !WebPProgressWait(progress, token_id, ROW_POS(dec, mb_y, mb_x + 1))) {
+      return 0;
+    }
+    if (mb_y > 0) {
+      const int needed = (mb_x + 2 < dec->mb_w) ? mb_x + 2 : dec->mb_w;
+      if (!WebPProgressWait(progress, prev_job_id,
+                            ROW_POS(dec, mb_y - 1, needed))) {
+        return 0;
+      }
+    }
+    ReconstructMB(dec, ctx, job->yuv_b, mb_x);
+    if (copy_top_rows) CopyTopExtraRows(dec, mb_x);
+    if (ctx->filter_row && mb_x >= dec->tl_mb_x && mb_x < dec->br_mb_x) {
+      DoFilter(dec, ctx, mb_x, mb_y);
+    }
+    WebPProgressUpdate(progress, job_id, ROW_POS(dec, mb_y, mb_x + 1));
+  }
+
+  if (!WebPProgressWait(progress, num_jobs, mb_y)) return 0;
+  if (!EmitRow(dec, ctx, &ctx->io)) {
+    WebPProgressAbort(progress);  // unblock the other jobs
+    return 0;
+  }
+  WebPProgressUpdate(progress, num_jobs, mb_y + 1);
+  return 1;
+}
+
+static int ParseTokenRow(void* arg1, void* arg2) {
+  VP8Decoder* const dec = (VP8Decoder*)arg1;
+  VP8TokenJob* const job = (VP8TokenJob*)arg2;
+  WebPProgress* const progress = &dec->progress;
+  const int mb_y = job->mb_y;
+  const int first_id = dec->num_jobs + 1;
+  const int id = first_id + mb_y % dec->num_token_jobs;
+  const int prev_id =
+      first_id + (mb_y + dec->num_token_jobs - 1) % dec->num_token_jobs;
+  int mb_x;
+
+  job->left.nz = 0;
+  job->left.nz_dc = 0;
+  for (mb_x = 0; mb_x < dec->mb_w; ++mb_x) {
+    // dec->mb_info[mb_x] must have been updated by the row above.
+    if (mb_y > 0 &&
+        !WebPProgressWait(progress, prev_id, ROW_POS(dec, mb_y - 1, mb_x + 1))) {
+      return 0;
+    }
+    if (!VP8DecodeTokens(dec, job, mb_x)) {
+      job->eof = 1;
+      WebPProgressAbort(progress);  // unblock the row jobs
+      return 0;
+    }
+    WebPProgressUpdate(progress, id, ROW_POS(dec, mb_y, mb_x + 1));
+  }
+  return 1;
+}
+
+#undef ROW_POS
+
+//------------------------------------------------------------------------------
+
+// Wait for the token job to finish its row, and report any truncated data.
+static int SyncTokenJob(VP8Decoder* const dec, VP8TokenJob* const job) {
+  if (!WebPGetWorkerInterface()->Sync(&job->worker)) {
+    if (job->eof) {
+      VP8SetError(dec, VP8_STATUS_NOT_ENOUGH_DATA,
+                  "Premature end-of-file encountered.");
+    }
+    return 0;
+  }
+  return 1;
+}
 
 int VP8ProcessRow(VP8Decoder* const dec, VP8Io* const io) {
   int ok = 1;
@@ -527,6 +684,40 @@ int VP8ProcessRow(VP8Decoder* const dec, VP8Io* const io) {
     ctx->filter_row = filter_row;
     ReconstructRow(dec, ctx);
     ok = FinishRow(dec, io);
+  } else if (dec->mt_method == 3) {
+    VP8RowJob* const job = &dec->jobs[dec->mb_y % dec->num_jobs];
+    // Wait for the previous row handled by this job to be emitted.
+    ok &= WebPGetWorkerInterface()->Sync(&job->worker);
+    if (ok && dec->num_token_jobs > 0) {
+      VP8TokenJob* const token_job =
+          &dec->token_jobs[dec->mb_y % dec->num_token_jobs];
+      ok = SyncTokenJob(dec, token_job);
+      if (ok) {  // parse the tokens of the row in parallel
+        token_job->mb_y = dec->mb_y;
+        token_job->br = &dec->parts[dec->mb_y & dec->num_parts_minus_one];
+        token_job->mb_data = dec->mb_data;
+        token_job->f_info = dec->f_info;
+        WebPGetWorkerInterface()->Launch(&token_job->worker);
+      }
+    }
+    if (ok) {
+      VP8ThreadContext* const job_ctx = &job->ctx;
+      job_ctx->io = *io;
+      job_ctx->id = dec->mb_y % dec->num_caches;
+      job_ctx->mb_y = dec->mb_y;
+      job_ctx->filter_row = filter_row;
+      {  // swap macroblock data
+        VP8MBData* const tmp = job_ctx->mb_data;
+        job_ctx->mb_data = dec->mb_data;
+        dec->mb_data = tmp;
+      }
+      if (dec->f_info != NULL) {  // swap filter info
+        VP8FInfo* const tmp = job_ctx->f_info;
+        job_ctx->f_info = dec->f_info;
+        dec->f_info = tmp;
+      }
+      WebPGetWorkerInterface()->Launch(&job->worker);
+    }
   } else {
     WebPWorker* const worker = &dec->worker;
     // Finish previous job *before* updating context
@@ -616,10 +807,7 @@ VP8StatusCode VP8EnterCritical(VP8Decoder* const dec, VP8Io* const io) {
 }
 
 int VP8ExitCritical(VP8Decoder* const dec, VP8Io* const io) {
-  int ok = 1;
-  if (dec->mt_method > 0) {
-    ok = WebPGetWorkerInterface()->Sync(&dec->worker);
-  }
+  const int ok = VP8SyncThreads(dec);
 
   if (io->teardown != NULL) {
     io->teardown(io);
@@ -650,14 +838,73 @@ int VP8ExitCritical(VP8Decoder* const dec, VP8Io* const io) {
 // and output process have non-concurrent writing:
 // Decode:  [ 0..15][16..31][ 0..15][16..31][...
 // io->put:         [ 0..15][16..31][ 0..15][...
+//
+// The wavefront reconstruction (mt_method == 3) uses num_jobs + 1 cache lines
+// instead, see ProcessWavefrontRow().
 
 #define MT_CACHE_LINES 3
 #define ST_CACHE_LINES 1  // 1 cache row only for single-threaded case
 
+static int InitRowJobs(VP8Decoder* const dec) {
+  const WebPWorkerInterface* const winterface = WebPGetWorkerInterface();
+  const int num_jobs = (dec->num_threads < dec->mb_h) ? dec->num_threads
+                                                      : dec->mb_h;
+  // Partitions are only worth parsing in parallel if there is more than one
+  // of them. Incremental decoding needs to suspend in the middle of a row.
+  const int num_parts = (int)dec->num_parts_minus_one + 1;
+  const int num_token_jobs =
+      (num_parts > 1 && !dec->incremental)
+          ? (num_parts < dec->mb_h) ? num_parts : dec->mb_h
+          : 0;
+  int i;
+  assert(num_jobs >= 1 && num_jobs <= MAX_DEC_THREADS);
+  VP8EndThreads(dec);  // in case of a previous frame
+  dec->jobs = (VP8RowJob*)WebPSafeCalloc(num_jobs, sizeof(*dec->jobs));
+  if (dec->jobs == NULL) return 0;
+  dec->num_jobs = num_jobs;
+  for (i = 0; i < num_jobs; ++i) {
+    winterface->Init(&dec->jobs[i].worker);
+  }
+  if (num_token_jobs > 0) {
+    dec->token_jobs =
+        (VP8TokenJob*)WebPSafeCalloc(num_token_jobs, sizeof(*dec->token_jobs));
+    if (dec->token_jobs == NULL) return 0;
+    dec->num_token_jobs = num_token_jobs;
+    for (i = 0; i < num_token_jobs; ++i) {
+      winterface->Init(&dec->token_jobs[i].worker);
+    }
+  }
+  if (!WebPProgressInit(&dec->progress, num_jobs + 1 + num_token_jobs)) {
+    return 0;
+  }
+  for (i = 0; i < num_jobs; ++i) {
+    WebPWorker* const worker = &dec->jobs[i].worker;
+    if (!winterface->Reset(worker)) return 0;
+    worker->data1 = dec;
+    worker->data2 = (void*)&dec->jobs[i];
+    worker->hook = ProcessWavefrontRow;
+  }
+  for (i = 0; i < num_token_jobs; ++i) {
+    WebPWorker* const worker = &dec->token_jobs[i].worker;
+    if (!winterface->Reset(worker)) return 0;
+    worker->data1 = dec;
+    worker->data2 = (void*)&dec->token_jobs[i];
+    worker->hook = ParseTokenRow;
+  }
+  return 1;
+}
+
 // Initialize multi/single-thread worker
 static int InitThreadContext(VP8Decoder* const dec) {
   dec->cache_id = 0;
-  if (dec->mt_method > 0) {
+  if (dec->mt_method == 3) {
+    if (!InitRowJobs(dec)) {
+      VP8EndThreads(dec);
+      return VP8SetError(dec, VP8_STATUS_OUT_OF_MEMORY,
+                         "thread initialization failed.");
+    }
+    dec->num_caches = dec->num_jobs + 1;
+  } else if (dec->mt_method > 0) {
     WebPWorker* const worker = &dec->worker;
     if (!WebPGetWorkerInterface()->Reset(worker)) {
       return VP8SetError(dec, VP8_STATUS_OUT_OF_MEMORY,
@@ -685,17 +932,82 @@ int VP8GetThreadMethod(const WebPDecoderOptions* const options,
   (void)height;
   assert(headers == NULL || !headers->is_lossless);
 #if defined(WEBP_USE_THREAD)
-  if (width >= MIN_WIDTH_FOR_THREADS) return 2;
+  if (width >= MIN_WIDTH_FOR_THREADS) {
+    // Dithering must be applied in row order, which requires the whole
+    // previous row to be filtered: keep the two-stage pipeline then.
+    return (options->num_threads > 1 && options->dithering_strength <= 0) ? 3
+                                                                          : 2;
+  }
 #endif
   return 0;
 }
 
+int VP8GetNumThreads(const WebPDecoderOptions* const options, int mt_method) {
+  if (mt_method != 3) return 1;
+  assert(options != NULL);
+  return (options->num_threads > MAX_DEC_THREADS) ? MAX_DEC_THREADS
+                                                  : options->num_threads;
+}
+
+int VP8SyncThreads(VP8Decoder* const dec) {
+  int ok = 1;
+  if (dec->mt_method == 3) {
+    int i;
+    for (i = 0; i < dec->num_token_jobs; ++i) {
+      ok &= SyncTokenJob(dec, &dec->token_jobs[i]);
+    }
+    for (i = 0; i < dec->num_jobs; ++i) {
+      ok &= WebPGetWorkerInterface()->Sync(&dec->jobs[i].worker);
+    }
+  } else if (dec->mt_method > 0) {
+    ok = WebPGetWorkerInterface()->Sync(&dec->worker);
+  }
+  return ok;
+}
+
+void VP8EndThreads(VP8Decoder* const dec) {
+  if (dec->jobs != NULL) {
+    int i;
+    for (i = 0; i < dec->num_jobs; ++i) {
+      WebPGetWorkerInterface()->End(&dec->jobs[i].worker);
+    }
+    WebPSafeFree(dec->jobs);
+    dec->jobs = NULL;
+  }
+  dec->num_jobs = 0;
+  if (dec->token_jobs != NULL) {
+    int i;
+    for (i = 0; i < dec->num_token_jobs; ++i) {
+      WebPGetWorkerInterface()->End(&dec->token_jobs[i].worker);
+    }
+    WebPSafeFree(dec->token_jobs);
+    dec->token_jobs = NULL;
+  }
+  dec->num_token_jobs = 0;
+  WebPProgressClear(&dec->progress);
+}
+
 #undef MT_CACHE_LINES
 #undef ST_CACHE_LINES
 
 //------------------------------------------------------------------------------
 // Memory setup
 
+// Grows '*mem' to at least 'needed' bytes. The content is not preserved.
+static int ReallocHotMemory(void** const mem, size_t* const mem_size,
+                            uint64_t needed) {
+  if (needed > *mem_size) {
+    WebPSafeFree(*mem);
+    *mem_size = 0;
+    *mem = WebPSafeMallocWithHint(needed, sizeof(uint8_t),
+                                  WEBP_MEMORY_HINT_HOT);
+    if (*mem == NULL) return 0;
+    // down-cast is ok, thanks to WebPSafeMallocWithHint() above.
+    *mem_size = (size_t)needed;
+  }
+  return 1;
+}
+
 static int AllocateMemory(VP8Decoder* const dec) {
   const int num_caches = dec->num_caches;
   const int mb_w = dec->mb_w;
@@ -703,37 +1015,36 @@ static int AllocateMemory(VP8Decoder* const dec) {
   const size_t intra_pred_mode_size = 4 * mb_w * sizeof(uint8_t);
   const size_t top_size = sizeof(VP8TopSamples) * mb_w;
   const size_t mb_info_size = (mb_w + 1) * sizeof(VP8MB);
+  // number of rows of parsed data: one being parsed, plus the processed ones
+  const int num_rows = (dec->mt_method == 3) ? dec->num_jobs + 1
+                     : (dec->mt_method > 0)  ? 2
+                                             : 1;
+  const int num_yuv_b = (dec->mt_method == 3) ? dec->num_jobs : 1;
   const size_t f_info_size =
-      (dec->filter_type > 0)
-          ? mb_w * (dec->mt_method > 0 ? 2 : 1) * sizeof(VP8FInfo)
-          : 0;
-  const size_t yuv_size = YUV_SIZE * sizeof(*dec->yuv_b);
+      (dec->filter_type > 0) ? mb_w * num_rows * sizeof(VP8FInfo) : 0;
+  const size_t yuv_size = YUV_SIZE * num_yuv_b * sizeof(*dec->yuv_b);
   const size_t mb_data_size =
-      (dec->mt_method == 2 ? 2 : 1) * mb_w * sizeof(*dec->mb_data);
+      (dec->mt_method == 1 ? 1 : num_rows) * mb_w * sizeof(*dec->mb_data);
   const size_t cache_height =
       (16 * num_caches + kFilterExtraRows[dec->filter_type]) * 3 / 2;
   const size_t cache_size = top_size * cache_height;
-  // alpha_size is the only one that scales as width x height.
-  const uint64_t alpha_size =
-      (dec->alpha_data != NULL)
-          ? (uint64_t)dec->pic_hdr.width * dec->pic_hdr.height
-          : 0ULL;
+  // Everything here is accessed for each macroblock, hence the 'hot' hint.
+  // The per-macroblock contexts are kept apart from the larger parsed data and
+  // row caches, so that they can fit in fast memory on their own. The alpha
+  // plane, which scales as width x height, is allocated by the alpha decoder.
   const uint64_t needed = (uint64_t)intra_pred_mode_size + top_size +
-                          mb_info_size + f_info_size + yuv_size + mb_data_size +
-                          cache_size + alpha_size + WEBP_ALIGN_CST;
+                          mb_info_size + f_info_size + yuv_size +
+                          WEBP_ALIGN_CST;
+  const uint64_t cache_needed = (uint64_t)mb_data_size + cache_size;
   uint8_t* mem;
 
   if (!CheckSizeOverflow(needed)) return 0;  // check for overflow
-  if (needed > dec->mem_size) {
-    WebPSafeFree(dec->mem);
-    dec->mem_size = 0;
-    dec->mem = WebPSafeMalloc(needed, sizeof(uint8_t));
-    if (dec->mem == NULL) {
-      return VP8SetError(dec, VP8_STATUS_OUT_OF_MEMORY,
-                         "no memory during frame initialization.");
-    }
-    // down-cast is ok, thanks to WebPSafeMalloc() above.
-    dec->mem_size = (size_t)needed;
+  if (!CheckSizeOverflow(cache_needed)) return 0;
+  if (!ReallocHotMemory(&dec->mem, &dec->mem_size, needed) ||
+      !ReallocHotMemory(&dec->cache_mem, &dec->cache_mem_size,
+                        cache_needed)) {
+    return VP8SetError(dec, VP8_STATUS_OUT_OF_MEMORY,
+                       "no memory during frame initialization.");
   }
 
   mem = (uint8_t*)dec->mem;
@@ -761,7 +1072,9 @@ static int AllocateMemory(VP8Decoder* const dec) {
   assert((yuv_size & WEBP_ALIGN_CST) == 0);
   dec->yuv_b = mem;
   mem += yuv_size;
+  assert(mem <= (uint8_t*)dec->mem + dec->mem_size);
 
+  mem = (uint8_t*)dec->cache_mem;
   dec->mb_data = (VP8MBData*)mem;
   dec->thread_ctx.mb_data = (VP8MBData*)mem;
   if (dec->mt_method == 2) {
@@ -769,6 +1082,17 @@ static int AllocateMemory(VP8Decoder* const dec) {
   }
   mem += mb_data_size;
 
+  if (dec->mt_method == 3) {
+    int i;
+    for (i = 0; i < dec->num_jobs; ++i) {
+      VP8RowJob* const job = &dec->jobs[i];
+      job->yuv_b = dec->yuv_b + i * YUV_SIZE;
+      job->ctx.mb_data = dec->mb_data + (i + 1) * mb_w;
+      job->ctx.f_info = (dec->f_info != NULL) ? dec->f_info + (i + 1) * mb_w
+                                              : NULL;
+    }
+  }
+
   dec->cache_y_stride = 16 * mb_w;
   dec->cache_uv_stride = 8 * mb_w;
   {
@@ -783,11 +1107,7 @@ static int AllocateMemory(VP8Decoder* const dec) {
     dec->cache_id = 0;
   }
   mem += cache_size;
-
-  // alpha plane
-  dec->alpha_plane = alpha_size ? mem : NULL;
-  mem += alpha_size;
-  assert(mem <= (uint8_t*)dec->mem + dec->mem_size);
+  assert(mem <= (uint8_t*)dec->cache_mem + dec->cache_mem_size);
 
   // note: left/top-info is initialized once for all.
   WEBP_UNSAFE_MEMSET(dec->mb_info - 1, 0, mb_info_size);
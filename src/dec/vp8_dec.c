@@ -69,7 +69,9 @@ int VP8InitIoInternal(VP8Io* const io, int version) {
 }
 
 VP8Decoder* VP8New(void) {
-  VP8Decoder* const dec = (VP8Decoder*)WebPSafeCalloc(1ULL, sizeof(*dec));
+  // The probabilities and the quantizers are read for each macroblock.
+  VP8Decoder* const dec = (VP8Decoder*)WebPSafeCallocWithHint(
+      1ULL, sizeof(*dec), WEBP_MEMORY_HINT_HOT);
   if (dec != NULL) {
     SetOk(dec);
     WebPGetWorkerInterface()->Init(&dec->worker);
@@ -531,13 +533,12 @@ static WEBP_INLINE uint32_t NzCodeBits(uint32_t nz_coeffs, int nz, int dc_nz) {
 }
 
 static int ParseResiduals(VP8Decoder* const dec, VP8MB* const mb,
+                          VP8MB* const left_mb, VP8MBData* const block,
                           VP8BitReader* const token_br) {
   const VP8BandProbas*(*const bands)[16 + 1] = dec->proba.bands_ptr;
   const VP8BandProbas* const* ac_proba;
-  VP8MBData* const block = dec->mb_data + dec->mb_x;
   const VP8QuantMatrix* const q = &dec->dqm[block->segment];
   int16_t* dst = block->coeffs;
-  VP8MB* const left_mb = dec->mb_info - 1;
   uint8_t tnz, lnz;
   uint32_t non_zero_y = 0;
   uint32_t non_zero_uv = 0;
@@ -624,14 +625,17 @@ static int ParseResiduals(VP8Decoder* const dec, VP8MB* const mb,
 //------------------------------------------------------------------------------
 // Main loop
 
-int VP8DecodeMB(VP8Decoder* const dec, VP8BitReader* const token_br) {
-  VP8MB* const left = dec->mb_info - 1;
-  VP8MB* const mb = dec->mb_info + dec->mb_x;
-  VP8MBData* const block = dec->mb_data + dec->mb_x;
+// Parse the coefficients of macroblock 'mb_x' into 'block', using the top
+// context dec->mb_info[mb_x] and the left context 'left'.
+static WEBP_INLINE int DecodeMB(VP8Decoder* const dec, int mb_x,
+                                VP8MB* const left, VP8MBData* const block,
+                                VP8FInfo* const f_info,
+                                VP8BitReader* const token_br) {
+  VP8MB* const mb = dec->mb_info + mb_x;
   int skip = dec->use_skip_proba ? block->skip : 0;
 
   if (!skip) {
-    skip = ParseResiduals(dec, mb, token_br);
+    skip = ParseResiduals(dec, mb, left, block, token_br);
   } else {
     left->nz = mb->nz = 0;
     if (!block->is_i4x4) {
@@ -643,14 +647,27 @@ int VP8DecodeMB(VP8Decoder* const dec, VP8BitReader* const token_br) {
   }
 
   if (dec->filter_type > 0) {  // store filter info
-    VP8FInfo* const finfo = dec->f_info + dec->mb_x;
-    *finfo = dec->fstrengths[block->segment][block->is_i4x4];
-    finfo->f_inner |= !skip;
+    *f_info = dec->fstrengths[block->segment][block->is_i4x4];
+    f_info->f_inner |= !skip;
   }
 
   return !token_br->eof;
 }
 
+int VP8DecodeMB(VP8Decoder* const dec, VP8BitReader* const token_br) {
+  const int mb_x = dec->mb_x;
+  VP8FInfo* const f_info = (dec->f_info != NULL) ? dec->f_info + mb_x : NULL;
+  return DecodeMB(dec, mb_x, dec->mb_info - 1, dec->mb_data + mb_x, f_info,
+                  token_br);
+}
+
+int VP8DecodeTokens(VP8Decoder* const dec, VP8TokenJob* const job,
+                    int mb_x) {
+  VP8FInfo* const f_info = (job->f_info != NULL) ? job->f_info + mb_x : NULL;
+  return DecodeMB(dec, mb_x, &job->left, job->mb_data + mb_x, f_info,
+                  job->br);
+}
+
 void VP8InitScanline(VP8Decoder* const dec) {
   VP8MB* const left = dec->mb_info - 1;
   left->nz = 0;
@@ -668,7 +685,8 @@ static int ParseFrame(VP8Decoder* const dec, VP8Io* io) {
       return VP8SetError(dec, VP8_STATUS_NOT_ENOUGH_DATA,
                          "Premature end-of-partition0 encountered.");
     }
-    for (; dec->mb_x < dec->mb_w; ++dec->mb_x) {
+    // With parallel partitions, tokens are parsed by the token jobs.
+    for (; dec->num_token_jobs == 0 && dec->mb_x < dec->mb_w; ++dec->mb_x) {
       if (!VP8DecodeMB(dec, token_br)) {
         return VP8SetError(dec, VP8_STATUS_NOT_ENOUGH_DATA,
                            "Premature end-of-file encountered.");
@@ -681,9 +699,7 @@ static int ParseFrame(VP8Decoder* const dec, VP8Io* io) {
       return VP8SetError(dec, VP8_STATUS_USER_ABORT, "Output aborted.");
     }
   }
-  if (dec->mt_method > 0) {
-    if (!WebPGetWorkerInterface()->Sync(&dec->worker)) return 0;
-  }
+  if (!VP8SyncThreads(dec)) return 0;
 
   return 1;
 }
@@ -733,12 +749,46 @@ void VP8Clear(VP8Decoder* const dec) {
     return;
   }
   WebPGetWorkerInterface()->End(&dec->worker);
+  VP8EndThreads(dec);
   WebPDeallocateAlphaMemory(dec);
   WebPSafeFree(dec->mem);
   dec->mem = NULL;
   dec->mem_size = 0;
+  WebPSafeFree(dec->cache_mem);
+  dec->cache_mem = NULL;
+  dec->cache_mem_size = 0;
   WEBP_UNSAFE_MEMSET(&dec->br, 0, sizeof(dec->br));
   dec->ready = 0;
 }
 
+void VP8Reset(VP8Decoder* const dec) {
+  void* mem;
+  size_t mem_size;
+  void* cache_mem;
+  size_t cache_mem_size;
+  uint8_t* alpha_plane_mem;
+  size_t alpha_plane_mem_size;
+  if (dec == NULL) return;
+  WebPGetWorkerInterface()->End(&dec->worker);
+  VP8EndThreads(dec);
+  alpha_plane_mem = dec->alpha_plane_mem;
+  alpha_plane_mem_size = dec->alpha_plane_mem_size;
+  dec->alpha_plane_mem = NULL;
+  WebPDeallocateAlphaMemory(dec);
+  mem = dec->mem;
+  mem_size = dec->mem_size;
+  cache_mem = dec->cache_mem;
+  cache_mem_size = dec->cache_mem_size;
+
+  WEBP_UNSAFE_MEMSET(dec, 0, sizeof(*dec));
+  SetOk(dec);
+  WebPGetWorkerInterface()->Init(&dec->worker);
+  dec->mem = mem;
+  dec->mem_size = mem_size;
+  dec->cache_mem = cache_mem;
+  dec->cache_mem_size = cache_mem_size;
+  dec->alpha_plane_mem = alpha_plane_mem;
+  dec->alpha_plane_mem_size = alpha_plane_mem_size;
+}
+
 //------------------------------------------------------------------------------
@@ -153,6 +153,10 @@ const char* VP8StatusMessage(VP8Decoder* const dec);
 // Not a mandatory call between calls to VP8Decode().
 void VP8Clear(VP8Decoder* const dec);
 
+// Resets the decoder to its VP8New() state for a new picture, keeping its
+// frame memory and alpha plane to be reused if they are large enough.
+void VP8Reset(VP8Decoder* const dec);
+
 // Destroy the decoder object.
 void VP8Delete(VP8Decoder* const dec);
 
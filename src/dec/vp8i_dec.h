@@ -70,6 +70,8 @@ extern "C" {
 
 // minimal width under which lossy multi-threading is always disabled
 #define MIN_WIDTH_FOR_THREADS 512
+// maximal number of row workers used for wavefront reconstruction
+#define MAX_DEC_THREADS 32
 
 //------------------------------------------------------------------------------
 // Headers
@@ -178,6 +180,28 @@ typedef struct {
   VP8Io io;            // copy of the VP8Io to pass to put()
 } VP8ThreadContext;
 
+// Token job, parsing the coefficients of the rows of one partition in
+// parallel with the other partitions (mt_method == 3 only). A row is parsed
+// one macroblock behind the row above, whose non-zero contexts it needs.
+typedef struct {
+  WebPWorker worker;
+  int mb_y;            // row to parse
+  VP8BitReader* br;    // partition the tokens are read from
+  VP8MB left;          // left non-zero context
+  VP8MBData* mb_data;  // row data, shared with the row job
+  VP8FInfo* f_info;    // row filter strengths (or NULL), idem
+  int eof;             // true if the partition ended prematurely
+} VP8TokenJob;
+
+// Row job for wavefront reconstruction (mt_method == 3). Each job
+// reconstructs and filters one macroblock row, lagging two macroblocks behind
+// the job handling the row above, then emits it in order.
+typedef struct {
+  WebPWorker worker;
+  VP8ThreadContext ctx;  // row to process
+  uint8_t* yuv_b;        // private Y/U/V reconstruction block
+} VP8RowJob;
+
 // Saved top samples, per macroblock. Fits into a cache-line.
 typedef struct {
   uint8_t y[16], u[8], v[8];
@@ -204,11 +228,20 @@ struct VP8Decoder {
   // Worker
   WebPWorker worker;
   int mt_method;   // multi-thread method: 0=off, 1=[parse+recon][filter]
-                   // 2=[parse][recon+filter]
+                   // 2=[parse][recon+filter], 3=[parse][N x wavefront rows]
   int cache_id;    // current cache row
-  int num_caches;  // number of cached rows of 16 pixels (1, 2 or 3)
+  int num_caches;  // number of cached rows of 16 pixels (1, 2, 3 or N + 1)
   VP8ThreadContext thread_ctx;  // Thread context
 
+  // Wavefront reconstruction (mt_method == 3)
+  int num_threads;        // requested number of row workers
+  VP8RowJob* jobs;        // row jobs, in use if num_jobs > 0
+  int num_jobs;           // number of allocated row jobs
+  VP8TokenJob* token_jobs;  // one per partition, if parsed in parallel
+  int num_token_jobs;       // 0 if tokens are parsed by the main thread
+  WebPProgress progress;    // macroblocks done per row job, rows emitted,
+                            // then macroblocks parsed per token job
+
   // dimension, in macroblock units.
   int mb_w, mb_h;
 
@@ -249,9 +282,12 @@ struct VP8Decoder {
   int cache_y_stride;
   int cache_uv_stride;
 
-  // main memory chunk for the above data. Persistent.
+  // main memory chunk for the above data, except cache_y/u/v. Persistent.
   void* mem;
   size_t mem_size;
+  // memory chunk for cache_y/u/v and mb_data. Persistent.
+  void* cache_mem;
+  size_t cache_mem_size;
 
   // Per macroblock non-persistent infos.
   int mb_x, mb_y;      // current position, in macroblock units
@@ -268,6 +304,7 @@ struct VP8Decoder {
   size_t alpha_data_size;
   int is_alpha_decoded;      // true if alpha_data is decoded in alpha_plane
   uint8_t* alpha_plane_mem;  // memory allocated for alpha_plane
+  size_t alpha_plane_mem_size;
   uint8_t* alpha_plane;      // output. Persistent, contains the whole data.
   const uint8_t* alpha_prev_line;  // last decoded alpha row (or NULL)
   int alpha_dithering;  // derived from decoding options (0=off, 100=full)
@@ -304,6 +341,12 @@ WEBP_NODISCARD int VP8ExitCritical(VP8Decoder* const dec, VP8Io* const io);
 int VP8GetThreadMethod(const WebPDecoderOptions* const options,
                        const WebPHeaderStructure* const headers, int width,
                        int height);
+// Return the number of row workers to use for the given 'mt_method'.
+int VP8GetNumThreads(const WebPDecoderOptions* const options, int mt_method);
+// Wait for all the pending row jobs. Returns false in case of error.
+WEBP_NODISCARD int VP8SyncThreads(VP8Decoder* const dec);
+// Terminate the row workers and release the associated memory.
+void VP8EndThreads(VP8Decoder* const dec);
 // Initialize dithering post-process if needed.
 void VP8InitDithering(const WebPDecoderOptions* const options,
                       VP8Decoder* const dec);
@@ -314,6 +357,10 @@ void VP8InitScanline(VP8Decoder* const dec);
 // Decode one macroblock. Returns false if there is not enough data.
 WEBP_NODISCARD int VP8DecodeMB(VP8Decoder* const dec,
                                VP8BitReader* const token_br);
+// Same as VP8DecodeMB(), for macroblock 'mb_x' of the row parsed by 'job'.
+// Only dec->mb_info[mb_x] is modified in 'dec'.
+WEBP_NODISCARD int VP8DecodeTokens(VP8Decoder* const dec,
+                                   VP8TokenJob* const job, int mb_x);
 
 // in alpha.c
 const uint8_t* VP8DecompressAlphaRows(VP8Decoder* const dec,
@@ -249,14 +249,22 @@ static int ReadHuffmanCodeLengths(VP8LDecoder* const dec,
   int symbol;
   int max_symbol;
   int prev_code_len = DEFAULT_CODE_LENGTH;
+  // The code lengths are at most LENGTHS_TABLE_BITS long, so a root table
+  // small enough for the stack holds the whole tree. VP8LBuildHuffmanTable()
+  // wants one spare entry to not allocate a new segment.
+  HuffmanCode codes[(1 << LENGTHS_TABLE_BITS) + 1];
   HuffmanTables tables;
   const int* WEBP_BIDI_INDEXABLE const bounded_code_lengths =
       WEBP_UNSAFE_FORGE_BIDI_INDEXABLE(
           const int*, code_length_code_lengths,
           NUM_CODE_LENGTH_CODES * sizeof(*code_length_code_lengths));
 
-  if (!VP8LHuffmanTablesAllocate(1 << LENGTHS_TABLE_BITS, &tables) ||
-      !VP8LBuildHuffmanTable(&tables, LENGTHS_TABLE_BITS, bounded_code_lengths,
+  tables.root.size = (1 << LENGTHS_TABLE_BITS) + 1;
+  tables.root.start = codes;
+  tables.root.curr_table = tables.root.start;
+  tables.root.next = NULL;
+  tables.curr_segment = &tables.root;
+  if (!VP8LBuildHuffmanTable(&tables, LENGTHS_TABLE_BITS, bounded_code_lengths,
                              NUM_CODE_LENGTH_CODES)) {
     goto End;
   }
@@ -300,6 +308,9 @@ static int ReadHuffmanCodeLengths(VP8LDecoder* const dec,
   ok = 1;
 
 End:
+  // Only release the segments allocated by VP8LBuildHuffmanTable(), if any.
+  tables.root.start = NULL;
+  tables.root.size = 0;
   VP8LHuffmanTablesDeallocate(&tables);
   if (!ok) return VP8LSetError(dec, VP8_STATUS_BITSTREAM_ERROR);
   return ok;
@@ -446,6 +457,74 @@ Error:
   return ok;
 }
 
+// The memory of the Huffman tables and tree groups released by
+// ClearMetadata() is kept in 'dec' and reused by the following image streams,
+// since each of them needs at least one set of tables.
+
+// Sets 'huffman_tables' to the spare tables if they hold 'size' codes.
+static int ReuseHuffmanTables(VP8LDecoder* const dec, int size,
+                              HuffmanTables* const huffman_tables) {
+  HuffmanTablesSegment* const root = &huffman_tables->root;
+  if (dec->spare_tables == NULL || dec->spare_tables_size < size) return 0;
+  root->start = dec->spare_tables;
+  root->size = dec->spare_tables_size;
+  root->curr_table = root->start;
+  root->next = NULL;
+  huffman_tables->curr_segment = root;
+  dec->spare_tables = NULL;
+  dec->spare_tables_size = 0;
+  return 1;
+}
+
+// Returns the spare tree groups if there are at least 'num_htree_groups' of
+// them, NULL otherwise.
+static HTreeGroup* ReuseHtreeGroups(VP8LDecoder* const dec,
+                                    int num_htree_groups) {
+  HTreeGroup* const htree_groups = dec->spare_htree_groups;
+  if (htree_groups == NULL || dec->spare_num_htree_groups < num_htree_groups) {
+    return NULL;
+  }
+  dec->spare_htree_groups = NULL;
+  dec->spare_num_htree_groups = 0;
+  return htree_groups;
+}
+
+static void RecycleHuffmanTables(VP8LDecoder* const dec,
+                                 HuffmanTables* const huffman_tables) {
+  HuffmanTablesSegment* const root = &huffman_tables->root;
+  // Only the root segment is kept, the others are small and rare.
+  if (root->start != NULL && root->size > dec->spare_tables_size) {
+    WebPSafeFree(dec->spare_tables);
+    dec->spare_tables = root->start;
+    dec->spare_tables_size = root->size;
+    root->start = NULL;
+    root->size = 0;
+  }
+  VP8LHuffmanTablesDeallocate(huffman_tables);
+}
+
+static void RecycleHtreeGroups(VP8LDecoder* const dec,
+                               HTreeGroup* const htree_groups,
+                               int num_htree_groups) {
+  if (htree_groups != NULL &&
+      num_htree_groups > dec->spare_num_htree_groups) {
+    VP8LHtreeGroupsFree(dec->spare_htree_groups);
+    dec->spare_htree_groups = htree_groups;
+    dec->spare_num_htree_groups = num_htree_groups;
+  } else {
+    VP8LHtreeGroupsFree(htree_groups);
+  }
+}
+
+static void FreeSpareMemory(VP8LDecoder* const dec) {
+  WebPSafeFree(dec->spare_tables);
+  dec->spare_tables = NULL;
+  dec->spare_tables_size = 0;
+  VP8LHtreeGroupsFree(dec->spare_htree_groups);
+  dec->spare_htree_groups = NULL;
+  dec->spare_num_htree_groups = 0;
+}
+
 int ReadHuffmanCodesHelper(int color_cache_bits, int num_htree_groups,
                            int num_htree_groups_max, const int* const mapping,
                            VP8LDecoder* const dec,
@@ -464,11 +543,16 @@ int ReadHuffmanCodesHelper(int color_cache_bits, int num_htree_groups,
 
   code_lengths =
       (int*)WebPSafeCalloc((uint64_t)max_alphabet_size, sizeof(*code_lengths));
-  *htree_groups = VP8LHtreeGroupsNew(num_htree_groups);
+  *htree_groups = ReuseHtreeGroups(dec, num_htree_groups);
+  if (*htree_groups == NULL) {
+    *htree_groups = VP8LHtreeGroupsNew(num_htree_groups);
+  }
 
   if (*htree_groups == NULL || code_lengths == NULL ||
-      !VP8LHuffmanTablesAllocate(num_htree_groups * table_size,
-                                 huffman_tables)) {
+      (!ReuseHuffmanTables(dec, num_htree_groups * table_size,
+                           huffman_tables) &&
+       !VP8LHuffmanTablesAllocate(num_htree_groups * table_size,
+                                  huffman_tables))) {
     VP8LSetError(dec, VP8_STATUS_OUT_OF_MEMORY);
     goto Error;
   }
@@ -1465,12 +1549,12 @@ static void InitMetadata(VP8LMetadata* const hdr) {
   WEBP_UNSAFE_MEMSET(hdr, 0, sizeof(*hdr));
 }
 
-static void ClearMetadata(VP8LMetadata* const hdr) {
-  assert(hdr != NULL);
+static void ClearMetadata(VP8LDecoder* const dec) {
+  VP8LMetadata* const hdr = &dec->hdr;
 
   WebPSafeFree(hdr->huffman_image);
-  VP8LHuffmanTablesDeallocate(&hdr->huffman_tables);
-  VP8LHtreeGroupsFree(hdr->htree_groups);
+  RecycleHuffmanTables(dec, &hdr->huffman_tables);
+  RecycleHtreeGroups(dec, hdr->htree_groups, hdr->num_htree_groups);
   VP8LColorCacheClear(&hdr->color_cache);
   VP8LColorCacheClear(&hdr->saved_color_cache);
   InitMetadata(hdr);
@@ -1490,15 +1574,20 @@ VP8LDecoder* VP8LNew(void) {
   return dec;
 }
 
-// Resets the decoder in its initial state, reclaiming memory.
+// Resets the decoder in its initial state, reclaiming memory except the one
+// kept for reuse if 'keep_memory' is true.
 // Preserves the dec->status value.
-static void VP8LClear(VP8LDecoder* const dec) {
+static void ClearDecoder(VP8LDecoder* const dec, int keep_memory) {
   int i;
   if (dec == NULL) return;
-  ClearMetadata(&dec->hdr);
+  ClearMetadata(dec);
 
-  WebPSafeFree(dec->pixels);
-  dec->pixels = NULL;
+  if (!keep_memory) {
+    WebPSafeFree(dec->pixels);
+    dec->pixels = NULL;
+    dec->pixels_size = 0;
+    FreeSpareMemory(dec);
+  }
   for (i = 0; i < dec->next_transform; ++i) {
     ClearTransform(&dec->transforms[i]);
   }
@@ -1511,6 +1600,8 @@ static void VP8LClear(VP8LDecoder* const dec) {
   dec->output = NULL;  // leave no trace behind
 }
 
+static void VP8LClear(VP8LDecoder* const dec) { ClearDecoder(dec, 0); }
+
 void VP8LDelete(VP8LDecoder* const dec) {
   if (dec != NULL) {
     VP8LClear(dec);
@@ -1518,6 +1609,33 @@ void VP8LDelete(VP8LDecoder* const dec) {
   }
 }
 
+void VP8LReset(VP8LDecoder* const dec) {
+  uint32_t* pixels;
+  size_t pixels_size;
+  HuffmanCode* spare_tables;
+  int spare_tables_size;
+  HTreeGroup* spare_htree_groups;
+  int spare_num_htree_groups;
+  if (dec == NULL) return;
+  ClearDecoder(dec, 1);
+  pixels = dec->pixels;
+  pixels_size = dec->pixels_size;
+  spare_tables = dec->spare_tables;
+  spare_tables_size = dec->spare_tables_size;
+  spare_htree_groups = dec->spare_htree_groups;
+  spare_num_htree_groups = dec->spare_num_htree_groups;
+
+  WEBP_UNSAFE_MEMSET(dec, 0, sizeof(*dec));
+  dec->status = VP8_STATUS_OK;
+  dec->state = READ_DIM;
+  dec->pixels = pixels;
+  dec->pixels_size = pixels_size;
+  dec->spare_tables = spare_tables;
+  dec->spare_tables_size = spare_tables_size;
+  dec->spare_htree_groups = spare_htree_groups;
+  dec->spare_num_htree_groups = spare_num_htree_groups;
+}
+
 static void UpdateDecoder(VP8LDecoder* const dec, int width, int height) {
   VP8LMetadata* const hdr = &dec->hdr;
   const int num_bits = hdr->huffman_subsample_bits;
@@ -1598,7 +1716,7 @@ static int DecodeImageStream(int xsize, int ysize, int is_level0,
 End:
   if (!ok) {
     WebPSafeFree(data);
-    ClearMetadata(hdr);
+    ClearMetadata(dec);
   } else {
     if (decoded_data != NULL) {
       *decoded_data = data;
@@ -1609,13 +1727,26 @@ End:
       assert(is_level0);
     }
     dec->last_pixel = 0;  // Reset for future DECODE_DATA_FUNC() calls.
-    if (!is_level0) ClearMetadata(hdr);  // Clean up temporary data behind.
+    if (!is_level0) ClearMetadata(dec);  // Clean up temporary data behind.
   }
   return ok;
 }
 
 //------------------------------------------------------------------------------
 // Allocate internal buffers dec->pixels and dec->argb_cache.
+
+// Points dec->pixels to at least 'num' elements of 'size' bytes, reusing the
+// current buffer if it is large enough.
+static int AllocatePixels(VP8LDecoder* const dec, uint64_t num, size_t size) {
+  const uint64_t needed = num * size;
+  if (dec->pixels != NULL && needed <= dec->pixels_size) return 1;
+  WebPSafeFree(dec->pixels);
+  dec->pixels_size = 0;
+  dec->pixels = (uint32_t*)WebPSafeMalloc(num, size);
+  if (dec->pixels == NULL) return 0;
+  dec->pixels_size = (size_t)needed;  // no overflow, thanks to WebPSafeMalloc()
+  return 1;
+}
 static int AllocateInternalBuffers32b(VP8LDecoder* const dec, int final_width) {
   const uint64_t num_pixels = (uint64_t)dec->width * dec->height;
   // Scratch buffer corresponding to top-prediction row for transforming the
@@ -1634,8 +1765,7 @@ static int AllocateInternalBuffers32b(VP8LDecoder* const dec, int final_width) {
   total_num_pixels =
       num_pixels + cache_top_pixels + cache_pixels + accumulated_rgb_pixels;
   assert(dec->width <= final_width);
-  dec->pixels = (uint32_t*)WebPSafeMalloc(total_num_pixels, sizeof(uint32_t));
-  if (dec->pixels == NULL) {
+  if (!AllocatePixels(dec, total_num_pixels, sizeof(uint32_t))) {
     dec->argb_cache = NULL;  // for soundness
     return VP8LSetError(dec, VP8_STATUS_OUT_OF_MEMORY);
   }
@@ -1652,8 +1782,7 @@ static int AllocateInternalBuffers32b(VP8LDecoder* const dec, int final_width) {
 static int AllocateInternalBuffers8b(VP8LDecoder* const dec) {
   const uint64_t total_num_pixels = (uint64_t)dec->width * dec->height;
   dec->argb_cache = NULL;  // for soundness
-  dec->pixels = (uint32_t*)WebPSafeMalloc(total_num_pixels, sizeof(uint8_t));
-  if (dec->pixels == NULL) {
+  if (!AllocatePixels(dec, total_num_pixels, sizeof(uint8_t))) {
     return VP8LSetError(dec, VP8_STATUS_OUT_OF_MEMORY);
   }
   return 1;
@@ -94,6 +94,13 @@ struct VP8LDecoder {
 
   uint8_t* rescaler_memory;  // Working memory for rescaling work.
   WebPRescaler* rescaler;    // Common rescaler for all channels.
+
+  // Memory kept for reuse by the next image stream or picture.
+  size_t pixels_size;  // allocated size of 'pixels', in bytes
+  HuffmanCode* spare_tables;
+  int spare_tables_size;
+  HTreeGroup* spare_htree_groups;
+  int spare_num_htree_groups;
 };
 
 //------------------------------------------------------------------------------
@@ -129,6 +136,10 @@ WEBP_NODISCARD int VP8LDecodeImage(VP8LDecoder* const dec);
 // Clears and deallocate a lossless decoder instance.
 void VP8LDelete(VP8LDecoder* const dec);
 
+// Resets the decoder to its VP8LNew() state for a new picture, keeping the
+// pixel buffer and Huffman tables memory to be reused.
+void VP8LReset(VP8LDecoder* const dec);
+
 // Helper function for reading the different Huffman codes and storing them in
 // 'huffman_tables' and 'htree_groups'.
 // If mapping is NULL 'num_htree_groups_max' must equal 'num_htree_groups'.
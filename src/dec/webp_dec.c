@@ -465,13 +465,35 @@ void WebPResetDecParams(WebPDecParams* const params) {
   }
 }
 
+//------------------------------------------------------------------------------
+// Decoder context
+
+struct WebPDecoderContext {
+  VP8Decoder* vp8_dec;    // lossy decoder, or NULL if not used yet
+  VP8LDecoder* vp8l_dec;  // lossless decoder, or NULL if not used yet
+};
+
+WebPDecoderContext* WebPNewDecoderContext(void) {
+  return (WebPDecoderContext*)WebPSafeCalloc(1ULL,
+                                             sizeof(WebPDecoderContext));
+}
+
+void WebPDeleteDecoderContext(WebPDecoderContext* context) {
+  if (context != NULL) {
+    VP8Delete(context->vp8_dec);
+    VP8LDelete(context->vp8l_dec);
+    WebPSafeFree(context);
+  }
+}
+
 //------------------------------------------------------------------------------
 // "Into" decoding variants
 
-// Main flow
+// Main flow. If 'context' is not NULL, its decoders are used and kept for the
+// next call instead of new ones.
 WEBP_NODISCARD static VP8StatusCode DecodeInto(
     const uint8_t* WEBP_COUNTED_BY(data_size) const data, size_t data_size,
-    WebPDecParams* const params) {
+    WebPDecParams* const params, WebPDecoderContext* const context) {
   VP8StatusCode status;
   VP8Io io;
   WebPHeaderStructure headers;
@@ -493,10 +515,13 @@ WEBP_NODISCARD static VP8StatusCode DecodeInto(
   WebPInitCustomIo(params, &io);  // Plug the I/O functions.
 
   if (!headers.is_lossless) {
-    VP8Decoder* const dec = VP8New();
+    VP8Decoder* const dec = (context != NULL && context->vp8_dec != NULL)
+                                ? context->vp8_dec
+                                : VP8New();
     if (dec == NULL) {
       return VP8_STATUS_OUT_OF_MEMORY;
     }
+    if (context != NULL) context->vp8_dec = dec;
     dec->alpha_data = headers.alpha_data;
     dec->alpha_data_size = headers.alpha_data_size;
 
@@ -511,18 +536,26 @@ WEBP_NODISCARD static VP8StatusCode DecodeInto(
         // This change must be done before calling VP8Decode()
         dec->mt_method =
             VP8GetThreadMethod(params->options, &headers, io.width, io.height);
+        dec->num_threads = VP8GetNumThreads(params->options, dec->mt_method);
         VP8InitDithering(params->options, dec);
         if (!VP8Decode(dec, &io)) {
           status = dec->status;
         }
       }
     }
-    VP8Delete(dec);
+    if (context != NULL) {
+      VP8Reset(dec);
+    } else {
+      VP8Delete(dec);
+    }
   } else {
-    VP8LDecoder* const dec = VP8LNew();
+    VP8LDecoder* const dec = (context != NULL && context->vp8l_dec != NULL)
+                                 ? context->vp8l_dec
+                                 : VP8LNew();
     if (dec == NULL) {
       return VP8_STATUS_OUT_OF_MEMORY;
     }
+    if (context != NULL) context->vp8l_dec = dec;
     if (!VP8LDecodeHeader(dec, &io)) {
       status = dec->status;  // An error occurred. Grab error status.
     } else {
@@ -535,7 +568,11 @@ WEBP_NODISCARD static VP8StatusCode DecodeInto(
         }
       }
     }
-    VP8LDelete(dec);
+    if (context != NULL) {
+      VP8LReset(dec);
+    } else {
+      VP8LDelete(dec);
+    }
   }
 
   if (status != VP8_STATUS_OK) {
@@ -567,7 +604,7 @@ WEBP_NODISCARD static uint8_t* DecodeIntoRGBABuffer(
   buf.u.RGBA.stride = stride;
   buf.u.RGBA.size = size;
   buf.is_external_memory = 1;
-  if (DecodeInto(data, data_size, &params) != VP8_STATUS_OK) {
+  if (DecodeInto(data, data_size, &params, NULL) != VP8_STATUS_OK) {
     return NULL;
   }
   return rgba;
@@ -631,7 +668,7 @@ uint8_t* WebPDecodeYUVInto(const uint8_t* WEBP_COUNTED_BY(data_size) data,
   output.u.YUVA.v_stride = v_stride;
   output.u.YUVA.v_size = v_size;
   output.is_external_memory = 1;
-  if (DecodeInto(data, data_size, &params) != VP8_STATUS_OK) {
+  if (DecodeInto(data, data_size, &params, NULL) != VP8_STATUS_OK) {
     return NULL;
   }
   return luma;
@@ -663,7 +700,7 @@ WEBP_NODISCARD static uint8_t* Decode(WEBP_CSP_MODE mode,
   if (height != NULL) *height = output.height;
 
   // Decode
-  if (DecodeInto(data, data_size, &params) != VP8_STATUS_OK) {
+  if (DecodeInto(data, data_size, &params, NULL) != VP8_STATUS_OK) {
     return NULL;
   }
   if (keep_info != NULL) {  // keep track of the side-info
@@ -834,6 +871,10 @@ int WebPValidateDecoderConfig(const WebPDecoderConfig* config) {
     return 0;
   }
 
+  if (options->num_threads < 0) {
+    return 0;
+  }
+
   return 1;
 }
 
@@ -851,8 +892,9 @@ VP8StatusCode WebPGetFeaturesInternal(const uint8_t* WEBP_COUNTED_BY(data_size)
   return GetFeatures(data, data_size, features);
 }
 
-VP8StatusCode WebPDecode(const uint8_t* WEBP_COUNTED_BY(data_size) data,
-                         size_t data_size, WebPDecoderConfig* config) {
+static VP8StatusCode DecodeWithConfig(
+    const uint8_t* WEBP_COUNTED_BY(data_size) data, size_t data_size,
+    WebPDecoderConfig* const config, WebPDecoderContext* const context) {
   WebPDecParams params;
   VP8StatusCode status;
 
@@ -881,18 +923,32 @@ VP8StatusCode WebPDecode(const uint8_t* WEBP_COUNTED_BY(data_size) data,
     in_mem_buffer.width = config->input.width;
     in_mem_buffer.height = config->input.height;
     params.output = &in_mem_buffer;
-    status = DecodeInto(data, data_size, &params);
+    status = DecodeInto(data, data_size, &params, context);
     if (status == VP8_STATUS_OK) {  // do the slow-copy
       status = WebPCopyDecBufferPixels(&in_mem_buffer, &config->output);
     }
     WebPFreeDecBuffer(&in_mem_buffer);
   } else {
-    status = DecodeInto(data, data_size, &params);
+    status = DecodeInto(data, data_size, &params, context);
   }
 
   return status;
 }
 
+VP8StatusCode WebPDecode(const uint8_t* WEBP_COUNTED_BY(data_size) data,
+                         size_t data_size, WebPDecoderConfig* config) {
+  return DecodeWithConfig(data, data_size, config, NULL);
+}
+
+VP8StatusCode WebPDecodeWithContext(WebPDecoderContext* context,
+                                    const uint8_t* WEBP_COUNTED_BY(data_size)
+                                        data,
+                                    size_t data_size,
+                                    WebPDecoderConfig* config) {
+  if (context == NULL) return VP8_STATUS_INVALID_PARAM;
+  return DecodeWithConfig(data, data_size, config, context);
+}
+
 //------------------------------------------------------------------------------
 // Cropping and rescaling.
 
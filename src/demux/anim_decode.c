@@ -15,8 +15,10 @@
 #endif
 
 #include <assert.h>
+#include <limits.h>
 #include <string.h>
 
+#include "src/utils/thread_utils.h"
 #include "src/utils/utils.h"
 #include "src/webp/decode.h"
 #include "src/webp/demux.h"
@@ -27,6 +29,7 @@
 WEBP_ASSUME_UNSAFE_INDEXABLE_ABI
 
 #define NUM_CHANNELS 4
+#define MAX_LOOKAHEAD 16  // Maximum value of WebPAnimDecoderOptions.lookahead.
 
 // Channel extraction from a uint32_t representation of a uint8_t RGBA/BGRA
 // buffer.
@@ -42,6 +45,16 @@ static void BlendPixelRowNonPremult(uint32_t* const src,
 static void BlendPixelRowPremult(uint32_t* const src, const uint32_t* const dst,
                                  int num_pixels);
 
+// Frame decoded ahead of time by a worker.
+typedef struct {
+  WebPWorker worker;
+  int frame_num;             // Frame being decoded, 0 if none.
+  WebPIterator iter;
+  WebPDecoderConfig config;  // Copy of the decoder config, output to 'rgba'.
+  uint8_t* rgba;             // Frame rectangle, 'iter.width' pixels per row.
+  size_t rgba_size;          // Allocated size of 'rgba'.
+} LookaheadSlot;
+
 struct WebPAnimDecoder {
   WebPDemuxer* demux;        // Demuxer created from given WebP bitstream.
   WebPDecoderConfig config;  // Decoder config.
@@ -49,6 +62,7 @@ struct WebPAnimDecoder {
   // allow possible inlining of per-pixel blending function.
   BlendRowFunc blend_func;       // Pointer to the chose blend row function.
   WebPAnimInfo info;             // Global info about the animation.
+  // Canvases of WebPAnimDecoderGetNext(), allocated by its first call.
   uint8_t* curr_frame;           // Current canvas (not disposed).
   uint8_t* prev_frame_disposed;  // Previous canvas (properly disposed).
   int prev_frame_timestamp;      // Previous frame timestamp (milliseconds).
@@ -56,11 +70,35 @@ struct WebPAnimDecoder {
   int prev_frame_was_keyframe;   // True if previous frame was a keyframe.
   int next_frame;                // Index of the next frame to be decoded
                                  // (starting from 1).
+  int start_frame;               // First frame decoded since the last reset
+                                 // or seek, which clears the whole canvas.
+  int target_frame;              // First frame to be returned since the last
+                                 // reset or seek. The ones before it are
+                                 // only decoded.
+  int use_external_canvas;       // True if the frames since the last reset
+                                 // were decoded in the caller's canvas, -1 if
+                                 // none was decoded yet.
+  uint8_t* blend_backup;         // Pixels of the caller's canvas under the
+                                 // current frame, before it is decoded.
+  size_t blend_backup_size;      // Allocated size of 'blend_backup'.
+  // Bounding box of the pixels changed by the last frame. 'dirty_width' is 0
+  // if no frame was returned since the last reset.
+  int dirty_x, dirty_y, dirty_width, dirty_height;
+  // Ring of 'num_slots' frames decoded ahead of time. Frame n is decoded in
+  // slots[(n - 1) % num_slots].
+  LookaheadSlot* slots;
+  int num_slots;
+  int next_launch;  // Index of the next frame to be launched (starting from 1).
+  // Index built by the first seek. For frame n, timestamps[n - 1] is its
+  // timestamp and key_frames[n - 1] the closest key-frame up to it.
+  int* timestamps;
+  int* key_frames;
 };
 
 static void DefaultDecoderOptions(WebPAnimDecoderOptions* const dec_options) {
   dec_options->color_mode = MODE_RGBA;
   dec_options->use_threads = 0;
+  dec_options->lookahead = 0;
 }
 
 int WebPAnimDecoderOptionsInitInternal(WebPAnimDecoderOptions* dec_options,
@@ -95,6 +133,29 @@ WEBP_NODISCARD static int ApplyDecoderOptions(
   config->output.is_external_memory = 1;
   config->options.use_threads = dec_options->use_threads;
   // Note: config->output.u.RGBA is set at the time of decoding each frame.
+  if (dec_options->lookahead < 0 || dec_options->lookahead > MAX_LOOKAHEAD) {
+    return 0;
+  }
+  dec->num_slots = dec_options->lookahead;
+  return 1;
+}
+
+// Allocates the look-ahead slots, once the frame count is known.
+WEBP_NODISCARD static int InitLookahead(WebPAnimDecoder* const dec) {
+  int i;
+  if (dec->num_slots > (int)dec->info.frame_count) {
+    dec->num_slots = (int)dec->info.frame_count;
+  }
+  if (dec->num_slots == 0) return 1;
+  dec->slots = (LookaheadSlot*)WebPSafeCalloc((uint64_t)dec->num_slots,
+                                              sizeof(*dec->slots));
+  if (dec->slots == NULL) {
+    dec->num_slots = 0;
+    return 0;
+  }
+  for (i = 0; i < dec->num_slots; ++i) {
+    WebPGetWorkerInterface()->Init(&dec->slots[i].worker);
+  }
   return 1;
 }
 
@@ -135,14 +196,7 @@ WebPAnimDecoder* WebPAnimDecoderNewInternal(
   dec->info.loop_count = WebPDemuxGetI(dec->demux, WEBP_FF_LOOP_COUNT);
   dec->info.bgcolor = WebPDemuxGetI(dec->demux, WEBP_FF_BACKGROUND_COLOR);
   dec->info.frame_count = WebPDemuxGetI(dec->demux, WEBP_FF_FRAME_COUNT);
-
-  // Note: calloc() because we fill frame with zeroes as well.
-  dec->curr_frame = (uint8_t*)WebPSafeCalloc(
-      dec->info.canvas_width * NUM_CHANNELS, dec->info.canvas_height);
-  if (dec->curr_frame == NULL) goto Error;
-  dec->prev_frame_disposed = (uint8_t*)WebPSafeCalloc(
-      dec->info.canvas_width * NUM_CHANNELS, dec->info.canvas_height);
-  if (dec->prev_frame_disposed == NULL) goto Error;
+  if (!InitLookahead(dec)) goto Error;
 
   WebPAnimDecoderReset(dec);
   return dec;
@@ -331,28 +385,240 @@ static void FindBlendRangeAtRow(const WebPIterator* const src,
   }
 }
 
-int WebPAnimDecoderGetNext(WebPAnimDecoder* dec, uint8_t** buf_ptr,
-                           int* timestamp_ptr) {
-  WebPIterator iter;
-  uint32_t width;
-  uint32_t height;
-  int is_key_frame;
-  int timestamp;
-  BlendRowFunc blend_row;
+//------------------------------------------------------------------------------
+// Look-ahead decoding
 
-  if (dec == NULL || buf_ptr == NULL || timestamp_ptr == NULL) return 0;
-  if (!WebPAnimDecoderHasMoreFrames(dec)) return 0;
+static int DecodeSlotHook(void* arg1, void* arg2) {
+  LookaheadSlot* const slot = (LookaheadSlot*)arg1;
+  (void)arg2;
+  return (WebPDecode(slot->iter.fragment.bytes, slot->iter.fragment.size,
+                     &slot->config) == VP8_STATUS_OK);
+}
+
+// Starts decoding the frame 'frame_num' in its slot, which must be idle.
+WEBP_NODISCARD static int LaunchFrame(WebPAnimDecoder* const dec,
+                                      int frame_num) {
+  const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  LookaheadSlot* const slot = &dec->slots[(frame_num - 1) % dec->num_slots];
+  WebPRGBABuffer* const buf = &slot->config.output.u.RGBA;
+  uint64_t size;
+  assert(slot->frame_num == 0);
+  if (!WebPDemuxGetFrame(dec->demux, frame_num, &slot->iter)) return 0;
+  size = (uint64_t)slot->iter.width * NUM_CHANNELS * slot->iter.height;
+  if (!CheckSizeOverflow(size)) return 0;
+  if (size > slot->rgba_size) {
+    WebPSafeFree(slot->rgba);
+    slot->rgba_size = 0;
+    slot->rgba = (uint8_t*)WebPSafeMalloc(1ULL, (size_t)size);
+    if (slot->rgba == NULL) return 0;
+    slot->rgba_size = (size_t)size;
+  }
+  if (!worker_interface->Reset(&slot->worker)) return 0;
+  slot->config = dec->config;
+  buf->rgba = slot->rgba;
+  buf->stride = slot->iter.width * NUM_CHANNELS;
+  buf->size = (size_t)size;
+  slot->worker.hook = DecodeSlotHook;
+  slot->worker.data1 = slot;
+  slot->worker.data2 = NULL;
+  slot->frame_num = frame_num;
+  worker_interface->Launch(&slot->worker);
+  return 1;
+}
 
-  width = dec->info.canvas_width;
-  height = dec->info.canvas_height;
-  blend_row = dec->blend_func;
+// Launches the frames following the current one, as far as the slots allow.
+// A frame that cannot be launched is retried when it is needed.
+static void LaunchLookahead(WebPAnimDecoder* const dec) {
+  if (dec->num_slots == 0) return;
+  while (dec->next_launch < dec->next_frame + dec->num_slots &&
+         dec->next_launch <= (int)dec->info.frame_count) {
+    if (!LaunchFrame(dec, dec->next_launch)) break;
+    ++dec->next_launch;
+  }
+}
 
-  // Get compressed frame.
-  if (!WebPDemuxGetFrame(dec->demux, dec->next_frame, &iter)) {
+// Waits for all the slots and discards their frames. They are launched again
+// from the next frame on.
+static void StopLookahead(WebPAnimDecoder* const dec) {
+  int i;
+  for (i = 0; i < dec->num_slots; ++i) {
+    (void)WebPGetWorkerInterface()->Sync(&dec->slots[i].worker);
+    dec->slots[i].frame_num = 0;
+  }
+  dec->next_launch = dec->next_frame;
+}
+
+// Copies the frame 'iter' from its slot to 'canvas' once it is decoded.
+WEBP_NODISCARD static int GetLookaheadFrame(WebPAnimDecoder* const dec,
+                                            const WebPIterator* const iter,
+                                            uint8_t* canvas, uint32_t stride) {
+  LookaheadSlot* const slot =
+      &dec->slots[(iter->frame_num - 1) % dec->num_slots];
+  const size_t row_size = (size_t)iter->width * NUM_CHANNELS;
+  int ok, y;
+  if (slot->frame_num != iter->frame_num) {
+    LaunchLookahead(dec);
+    if (slot->frame_num != iter->frame_num) return 0;
+  }
+  ok = WebPGetWorkerInterface()->Sync(&slot->worker);
+  slot->frame_num = 0;
+  if (!ok) {
+    StopLookahead(dec);
     return 0;
   }
+  canvas += (size_t)iter->y_offset * stride +
+            (size_t)iter->x_offset * NUM_CHANNELS;
+  for (y = 0; y < iter->height; ++y) {
+    WEBP_UNSAFE_MEMCPY(canvas + (size_t)y * stride, slot->rgba + y * row_size,
+                       row_size);
+  }
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+
+// Decodes the frame 'iter' in 'canvas', whose rows are 'stride' bytes apart.
+WEBP_NODISCARD static int DecodeFrame(WebPAnimDecoder* const dec,
+                                      const WebPIterator* const iter,
+                                      uint8_t* canvas, uint32_t stride) {
+  const uint64_t out_offset = (uint64_t)iter->y_offset * stride +
+                              (uint64_t)iter->x_offset * NUM_CHANNELS;  // 53b
+  const uint64_t size = (uint64_t)iter->height * stride;  // at most 25 + 27b
+  WebPDecoderConfig* const config = &dec->config;
+  WebPRGBABuffer* const buf = &config->output.u.RGBA;
+  if ((size_t)size != size || stride > INT_MAX) return 0;
+  if (dec->num_slots > 0) return GetLookaheadFrame(dec, iter, canvas, stride);
+  buf->stride = (int)stride;
+  buf->size = (size_t)size;
+  buf->rgba = canvas + out_offset;
+  return (WebPDecode(iter->fragment.bytes, iter->fragment.size, config) ==
+          VP8_STATUS_OK);
+}
+
+// During the decoding of current frame, we may have set some pixels to be
+// transparent (i.e. alpha < 255). However, the value of each of these pixels
+// should have been determined by blending it against the value of that pixel
+// in the previous frame if blending method of is WEBP_MUX_BLEND.
+// 'prev' holds the previous canvas, properly disposed, from the canvas
+// position ('prev_x', 'prev_y') on.
+static void BlendFrame(const WebPAnimDecoder* const dec,
+                       const WebPIterator* const iter, uint8_t* canvas,
+                       uint32_t canvas_stride, const uint8_t* prev,
+                       uint32_t prev_stride, int prev_x, int prev_y) {
+  const BlendRowFunc blend_row = dec->blend_func;
+#define CANVAS_ROW(x, y) \
+  ((uint32_t*)(canvas + (size_t)(y) * canvas_stride) + (x))
+#define PREV_ROW(x, y) \
+  ((const uint32_t*)(prev + (size_t)((y) - prev_y) * prev_stride) + \
+   ((x) - prev_x))
+  if (dec->prev_iter.dispose_method == WEBP_MUX_DISPOSE_NONE) {
+    int y;
+    // Blend transparent pixels with pixels in previous canvas.
+    for (y = iter->y_offset; y < iter->y_offset + iter->height; ++y) {
+      blend_row(CANVAS_ROW(iter->x_offset, y), PREV_ROW(iter->x_offset, y),
+                iter->width);
+    }
+  } else {
+    int y;
+    assert(dec->prev_iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND);
+    // We need to blend a transparent pixel with its value just after
+    // initialization. That is, blend it with:
+    // * Fully transparent pixel if it belongs to prevRect <-- No-op.
+    // * The pixel in the previous canvas otherwise <-- Need alpha-blending.
+    for (y = iter->y_offset; y < iter->y_offset + iter->height; ++y) {
+      int left1, width1, left2, width2;
+      FindBlendRangeAtRow(iter, &dec->prev_iter, y, &left1, &width1, &left2,
+                          &width2);
+      if (width1 > 0) {
+        blend_row(CANVAS_ROW(left1, y), PREV_ROW(left1, y), width1);
+      }
+      if (width2 > 0) {
+        blend_row(CANVAS_ROW(left2, y), PREV_ROW(left2, y), width2);
+      }
+    }
+  }
+#undef PREV_ROW
+#undef CANVAS_ROW
+}
+
+// Fetches the next frame and checks that the same kind of canvas has been
+// used since the last reset. Returns false in case of error.
+WEBP_NODISCARD static int GetNextFrame(WebPAnimDecoder* const dec,
+                                       int use_external_canvas,
+                                       WebPIterator* const iter) {
+  if (!WebPAnimDecoderHasMoreFrames(dec)) return 0;
+  if (dec->use_external_canvas < 0) {
+    dec->use_external_canvas = use_external_canvas;
+  } else if (dec->use_external_canvas != use_external_canvas) {
+    return 0;
+  }
+  return WebPDemuxGetFrame(dec->demux, dec->next_frame, iter);
+}
+
+// Updates the info of the previous frame for the next iteration.
+static void FrameDone(WebPAnimDecoder* const dec,
+                      const WebPIterator* const iter, int is_key_frame,
+                      int timestamp) {
+  const WebPIterator* const prev = &dec->prev_iter;
+  if (iter->frame_num <= dec->target_frame) {
+    // The whole canvas was cleared, or the caller did not see the frames
+    // decoded since then.
+    dec->dirty_x = 0;
+    dec->dirty_y = 0;
+    dec->dirty_width = (int)dec->info.canvas_width;
+    dec->dirty_height = (int)dec->info.canvas_height;
+  } else {
+    // Key-frames included, only the frame rectangle and the rectangle
+    // disposed to the background differ from the previous canvas.
+    int x0 = iter->x_offset, y0 = iter->y_offset;
+    int x1 = x0 + iter->width, y1 = y0 + iter->height;
+    if (prev->dispose_method == WEBP_MUX_DISPOSE_BACKGROUND) {
+      const int prev_x1 = prev->x_offset + prev->width;
+      const int prev_y1 = prev->y_offset + prev->height;
+      if (prev->x_offset < x0) x0 = prev->x_offset;
+      if (prev->y_offset < y0) y0 = prev->y_offset;
+      if (prev_x1 > x1) x1 = prev_x1;
+      if (prev_y1 > y1) y1 = prev_y1;
+    }
+    dec->dirty_x = x0;
+    dec->dirty_y = y0;
+    dec->dirty_width = x1 - x0;
+    dec->dirty_height = y1 - y0;
+  }
+  dec->prev_frame_timestamp = timestamp;
+  WebPDemuxReleaseIterator(&dec->prev_iter);
+  dec->prev_iter = *iter;
+  dec->prev_frame_was_keyframe = is_key_frame;
+  ++dec->next_frame;
+  // The slot of this frame is free: the workers decode the next frames while
+  // the caller uses this one.
+  LaunchLookahead(dec);
+}
+
+// Reconstructs the next frame in 'dec->curr_frame'.
+WEBP_NODISCARD static int ReconstructFrame(WebPAnimDecoder* const dec,
+                                           int* const timestamp_ptr) {
+  WebPIterator iter;
+  const uint32_t width = dec->info.canvas_width;
+  const uint32_t height = dec->info.canvas_height;
+  int is_key_frame;
+  int timestamp;
+
+  // Get compressed frame.
+  if (!GetNextFrame(dec, /*use_external_canvas=*/0, &iter)) return 0;
   timestamp = dec->prev_frame_timestamp + iter.duration;
 
+  // Note: calloc() because we fill frame with zeroes as well.
+  if (dec->curr_frame == NULL) {
+    dec->curr_frame = (uint8_t*)WebPSafeCalloc(width * NUM_CHANNELS, height);
+    if (dec->curr_frame == NULL) goto Error;
+  }
+  if (dec->prev_frame_disposed == NULL) {
+    dec->prev_frame_disposed =
+        (uint8_t*)WebPSafeCalloc(width * NUM_CHANNELS, height);
+    if (dec->prev_frame_disposed == NULL) goto Error;
+  }
+
   // Initialize.
   is_key_frame = IsKeyFrame(&iter, &dec->prev_iter,
                             dec->prev_frame_was_keyframe, width, height);
@@ -367,90 +633,141 @@ int WebPAnimDecoderGetNext(WebPAnimDecoder* dec, uint8_t** buf_ptr,
   }
 
   // Decode.
-  {
-    const uint8_t* in = iter.fragment.bytes;
-    const size_t in_size = iter.fragment.size;
-    const uint32_t stride = width * NUM_CHANNELS;  // at most 25 + 2 bits
-    const uint64_t out_offset = (uint64_t)iter.y_offset * stride +
-                                (uint64_t)iter.x_offset * NUM_CHANNELS;  // 53b
-    const uint64_t size = (uint64_t)iter.height * stride;  // at most 25 + 27b
-    WebPDecoderConfig* const config = &dec->config;
-    WebPRGBABuffer* const buf = &config->output.u.RGBA;
-    if ((size_t)size != size) goto Error;
-    buf->stride = (int)stride;
-    buf->size = (size_t)size;
-    buf->rgba = dec->curr_frame + out_offset;
-
-    if (WebPDecode(in, in_size, config) != VP8_STATUS_OK) {
-      goto Error;
-    }
+  if (!DecodeFrame(dec, &iter, dec->curr_frame, width * NUM_CHANNELS)) {
+    goto Error;
   }
 
-  // During the decoding of current frame, we may have set some pixels to be
-  // transparent (i.e. alpha < 255). However, the value of each of these
-  // pixels should have been determined by blending it against the value of
-  // that pixel in the previous frame if blending method of is WEBP_MUX_BLEND.
   if (iter.frame_num > 1 && iter.blend_method == WEBP_MUX_BLEND &&
       !is_key_frame) {
-    if (dec->prev_iter.dispose_method == WEBP_MUX_DISPOSE_NONE) {
-      int y;
-      // Blend transparent pixels with pixels in previous canvas.
-      for (y = 0; y < iter.height; ++y) {
-        const size_t offset = (iter.y_offset + y) * width + iter.x_offset;
-        blend_row((uint32_t*)dec->curr_frame + offset,
-                  (uint32_t*)dec->prev_frame_disposed + offset, iter.width);
-      }
-    } else {
-      int y;
-      assert(dec->prev_iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND);
-      // We need to blend a transparent pixel with its value just after
-      // initialization. That is, blend it with:
-      // * Fully transparent pixel if it belongs to prevRect <-- No-op.
-      // * The pixel in the previous canvas otherwise <-- Need alpha-blending.
-      for (y = 0; y < iter.height; ++y) {
-        const int canvas_y = iter.y_offset + y;
-        int left1, width1, left2, width2;
-        FindBlendRangeAtRow(&iter, &dec->prev_iter, canvas_y, &left1, &width1,
-                            &left2, &width2);
-        if (width1 > 0) {
-          const size_t offset1 = canvas_y * width + left1;
-          blend_row((uint32_t*)dec->curr_frame + offset1,
-                    (uint32_t*)dec->prev_frame_disposed + offset1, width1);
-        }
-        if (width2 > 0) {
-          const size_t offset2 = canvas_y * width + left2;
-          blend_row((uint32_t*)dec->curr_frame + offset2,
-                    (uint32_t*)dec->prev_frame_disposed + offset2, width2);
-        }
-      }
-    }
+    BlendFrame(dec, &iter, dec->curr_frame, width * NUM_CHANNELS,
+               dec->prev_frame_disposed, width * NUM_CHANNELS, 0, 0);
   }
 
   // Update info of the previous frame and dispose it for the next iteration.
-  dec->prev_frame_timestamp = timestamp;
-  WebPDemuxReleaseIterator(&dec->prev_iter);
-  dec->prev_iter = iter;
-  dec->prev_frame_was_keyframe = is_key_frame;
+  FrameDone(dec, &iter, is_key_frame, timestamp);
   if (!CopyCanvas(dec->curr_frame, dec->prev_frame_disposed, width, height)) {
-    goto Error;
+    return 0;
   }
   if (dec->prev_iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND) {
     ZeroFillFrameRect(dec->prev_frame_disposed, width * NUM_CHANNELS,
                       dec->prev_iter.x_offset, dec->prev_iter.y_offset,
                       dec->prev_iter.width, dec->prev_iter.height);
   }
-  ++dec->next_frame;
+
+  *timestamp_ptr = timestamp;
+  return 1;
+
+Error:
+  WebPDemuxReleaseIterator(&iter);
+  return 0;
+}
+
+int WebPAnimDecoderGetNext(WebPAnimDecoder* dec, uint8_t** buf_ptr,
+                           int* timestamp_ptr) {
+  int timestamp;
+  if (dec == NULL || buf_ptr == NULL || timestamp_ptr == NULL) return 0;
+  // After a seek, also decode the frames leading to the requested one.
+  do {
+    if (!ReconstructFrame(dec, &timestamp)) return 0;
+  } while (dec->next_frame <= dec->target_frame);
 
   // All OK, fill in the values.
   *buf_ptr = dec->curr_frame;
   *timestamp_ptr = timestamp;
   return 1;
+}
+
+// Reconstructs the next frame in the caller's 'canvas'.
+WEBP_NODISCARD static int ReconstructFrameInto(WebPAnimDecoder* const dec,
+                                               uint8_t* const canvas,
+                                               int stride,
+                                               int* const timestamp_ptr) {
+  WebPIterator iter;
+  const uint32_t width = dec->info.canvas_width;
+  const uint32_t height = dec->info.canvas_height;
+  int is_key_frame;
+  int need_blend;
+  int timestamp;
+
+  // Get compressed frame.
+  if (!GetNextFrame(dec, /*use_external_canvas=*/1, &iter)) return 0;
+  timestamp = dec->prev_frame_timestamp + iter.duration;
+
+  // 'canvas' still holds the previous frame: dispose it in place.
+  if (iter.frame_num == dec->start_frame) {
+    ZeroFillFrameRect(canvas, stride, 0, 0, width, height);
+  } else if (dec->prev_iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND) {
+    ZeroFillFrameRect(canvas, stride, dec->prev_iter.x_offset,
+                      dec->prev_iter.y_offset, dec->prev_iter.width,
+                      dec->prev_iter.height);
+  }
+
+  // A key-frame does not need the canvas to be cleared: either it covers the
+  // whole canvas, which the decoding fully overwrites, or the disposal above
+  // already left the canvas fully transparent.
+  is_key_frame = IsKeyFrame(&iter, &dec->prev_iter,
+                            dec->prev_frame_was_keyframe, width, height);
+  need_blend = (iter.frame_num > 1 && iter.blend_method == WEBP_MUX_BLEND &&
+                !is_key_frame);
+
+  // Blending needs the pixels that the decoding overwrites.
+  if (need_blend) {
+    const size_t backup_stride = (size_t)iter.width * NUM_CHANNELS;
+    const uint64_t size = (uint64_t)backup_stride * iter.height;
+    int y;
+    if (!CheckSizeOverflow(size)) goto Error;
+    if (size > dec->blend_backup_size) {
+      WebPSafeFree(dec->blend_backup);
+      dec->blend_backup_size = 0;
+      dec->blend_backup = (uint8_t*)WebPSafeMalloc(1ULL, (size_t)size);
+      if (dec->blend_backup == NULL) goto Error;
+      dec->blend_backup_size = (size_t)size;
+    }
+    for (y = 0; y < iter.height; ++y) {
+      WEBP_UNSAFE_MEMCPY(dec->blend_backup + y * backup_stride,
+                         canvas + (size_t)(iter.y_offset + y) * stride +
+                             (size_t)iter.x_offset * NUM_CHANNELS,
+                         backup_stride);
+    }
+  }
+
+  // Decode.
+  if (!DecodeFrame(dec, &iter, canvas, (uint32_t)stride)) goto Error;
+
+  if (need_blend) {
+    BlendFrame(dec, &iter, canvas, (uint32_t)stride, dec->blend_backup,
+               (uint32_t)iter.width * NUM_CHANNELS, iter.x_offset,
+               iter.y_offset);
+  }
+
+  // The disposal of the frame is done at the beginning of the next call.
+  FrameDone(dec, &iter, is_key_frame, timestamp);
+
+  *timestamp_ptr = timestamp;
+  return 1;
 
 Error:
   WebPDemuxReleaseIterator(&iter);
   return 0;
 }
 
+int WebPAnimDecoderGetNextInto(WebPAnimDecoder* dec, uint8_t* canvas,
+                               int stride, int* timestamp_ptr) {
+  int timestamp;
+  if (dec == NULL || canvas == NULL || timestamp_ptr == NULL) return 0;
+  if (stride < 0 ||
+      (uint64_t)stride < (uint64_t)dec->info.canvas_width * NUM_CHANNELS) {
+    return 0;
+  }
+  // After a seek, also decode the frames leading to the requested one.
+  do {
+    if (!ReconstructFrameInto(dec, canvas, stride, &timestamp)) return 0;
+  } while (dec->next_frame <= dec->target_frame);
+
+  *timestamp_ptr = timestamp;
+  return 1;
+}
+
 int WebPAnimDecoderHasMoreFrames(const WebPAnimDecoder* dec) {
   if (dec == NULL) return 0;
   return (dec->next_frame <= (int)dec->info.frame_count);
@@ -463,7 +780,114 @@ void WebPAnimDecoderReset(WebPAnimDecoder* dec) {
     WEBP_UNSAFE_MEMSET(&dec->prev_iter, 0, sizeof(dec->prev_iter));
     dec->prev_frame_was_keyframe = 0;
     dec->next_frame = 1;
+    dec->start_frame = 1;
+    dec->target_frame = 1;
+    dec->use_external_canvas = -1;
+    dec->dirty_width = 0;
+    StopLookahead(dec);
+    LaunchLookahead(dec);
+  }
+}
+
+// Lists the timestamp and the previous key-frame of each frame.
+WEBP_NODISCARD static int BuildFrameIndex(WebPAnimDecoder* const dec) {
+  const int frame_count = (int)dec->info.frame_count;
+  WebPIterator prev, iter;
+  int prev_was_key_frame = 0;
+  int timestamp = 0;
+  int n;
+  if (dec->timestamps != NULL) return 1;
+  if (frame_count <= 0) return 0;
+  dec->timestamps =
+      (int*)WebPSafeMalloc(2ULL * frame_count, sizeof(*dec->timestamps));
+  if (dec->timestamps == NULL) return 0;
+  dec->key_frames = dec->timestamps + frame_count;
+  WEBP_UNSAFE_MEMSET(&prev, 0, sizeof(prev));
+  for (n = 1; n <= frame_count; ++n) {
+    int is_key_frame;
+    if (!WebPDemuxGetFrame(dec->demux, n, &iter)) {
+      WebPSafeFree(dec->timestamps);
+      dec->timestamps = NULL;
+      dec->key_frames = NULL;
+      return 0;
+    }
+    // Same decision as in WebPAnimDecoderGetNext().
+    is_key_frame =
+        IsKeyFrame(&iter, &prev, prev_was_key_frame, dec->info.canvas_width,
+                   dec->info.canvas_height);
+    timestamp += iter.duration;
+    dec->timestamps[n - 1] = timestamp;
+    dec->key_frames[n - 1] = is_key_frame ? n : dec->key_frames[n - 2];
+    prev = iter;
+    prev_was_key_frame = is_key_frame;
   }
+  return 1;
+}
+
+int WebPAnimDecoderSeekToFrame(WebPAnimDecoder* dec, int frame_num) {
+  int key_frame;
+  if (dec == NULL || frame_num < 1 || frame_num > (int)dec->info.frame_count) {
+    return 0;
+  }
+  if (!BuildFrameIndex(dec)) return 0;
+  key_frame = dec->key_frames[frame_num - 1];
+  dec->dirty_width = 0;
+  if (dec->next_frame >= key_frame && dec->next_frame <= frame_num) {
+    // Continuing from the current position is at least as fast.
+    dec->target_frame = frame_num;
+    return 1;
+  }
+
+  // Restart from the key-frame, with the state left by the frame before it.
+  WebPDemuxReleaseIterator(&dec->prev_iter);
+  WEBP_UNSAFE_MEMSET(&dec->prev_iter, 0, sizeof(dec->prev_iter));
+  dec->prev_frame_timestamp = 0;
+  dec->prev_frame_was_keyframe = 0;
+  if (key_frame > 1) {
+    if (!WebPDemuxGetFrame(dec->demux, key_frame - 1, &dec->prev_iter)) {
+      return 0;
+    }
+    dec->prev_frame_timestamp = dec->timestamps[key_frame - 2];
+    dec->prev_frame_was_keyframe =
+        (dec->key_frames[key_frame - 2] == key_frame - 1);
+  }
+  dec->next_frame = key_frame;
+  dec->start_frame = key_frame;
+  dec->target_frame = frame_num;
+  StopLookahead(dec);
+  LaunchLookahead(dec);
+  return 1;
+}
+
+int WebPAnimDecoderSeekToTimestamp(WebPAnimDecoder* dec, int timestamp) {
+  int lo, hi;
+  if (dec == NULL || timestamp < 0) return 0;
+  if (!BuildFrameIndex(dec)) return 0;
+  // Binary search of the first frame ending after 'timestamp'.
+  lo = 1;
+  hi = (int)dec->info.frame_count;
+  while (lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if (dec->timestamps[mid - 1] > timestamp) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return WebPAnimDecoderSeekToFrame(dec, lo);
+}
+
+int WebPAnimDecoderGetDirtyRect(const WebPAnimDecoder* dec, int* x_offset,
+                                int* y_offset, int* width, int* height) {
+  if (dec == NULL || x_offset == NULL || y_offset == NULL || width == NULL ||
+      height == NULL || dec->dirty_width == 0) {
+    return 0;
+  }
+  *x_offset = dec->dirty_x;
+  *y_offset = dec->dirty_y;
+  *width = dec->dirty_width;
+  *height = dec->dirty_height;
+  return 1;
 }
 
 const WebPDemuxer* WebPAnimDecoderGetDemuxer(const WebPAnimDecoder* dec) {
@@ -473,10 +897,18 @@ const WebPDemuxer* WebPAnimDecoderGetDemuxer(const WebPAnimDecoder* dec) {
 
 void WebPAnimDecoderDelete(WebPAnimDecoder* dec) {
   if (dec != NULL) {
+    int i;
+    for (i = 0; i < dec->num_slots; ++i) {
+      WebPGetWorkerInterface()->End(&dec->slots[i].worker);
+      WebPSafeFree(dec->slots[i].rgba);
+    }
+    WebPSafeFree(dec->slots);
+    WebPSafeFree(dec->timestamps);
     WebPDemuxReleaseIterator(&dec->prev_iter);
     WebPDemuxDelete(dec->demux);
     WebPSafeFree(dec->curr_frame);
     WebPSafeFree(dec->prev_frame_disposed);
+    WebPSafeFree(dec->blend_backup);
     WebPSafeFree(dec);
   }
 }
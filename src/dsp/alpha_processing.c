@@ -437,6 +437,7 @@ extern VP8CPUInfo VP8GetCPUInfo;
 extern void WebPInitAlphaProcessingMIPSdspR2(void);
 extern void WebPInitAlphaProcessingSSE2(void);
 extern void WebPInitAlphaProcessingSSE41(void);
+extern void WebPInitAlphaProcessingAVX2(void);
 extern void WebPInitAlphaProcessingNEON(void);
 
 WEBP_DSP_INIT_FUNC(WebPInitAlphaProcessing) {
@@ -468,6 +469,11 @@ WEBP_DSP_INIT_FUNC(WebPInitAlphaProcessing) {
 #if defined(WEBP_HAVE_SSE41)
       if (VP8GetCPUInfo(kSSE4_1)) {
         WebPInitAlphaProcessingSSE41();
+#if defined(WEBP_HAVE_AVX2)
+        if (VP8GetCPUInfo(kAVX2)) {
+          WebPInitAlphaProcessingAVX2();
+        }
+#endif
       }
 #endif
     }
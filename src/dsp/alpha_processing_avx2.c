@@ -0,0 +1,327 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// Utilities for processing transparent channel, AVX2 variant.
+
+#include "src/dsp/cpu.h"
+#include "src/dsp/dsp.h"
+#include "src/webp/types.h"
+
+#if defined(WEBP_USE_AVX2)
+#include <immintrin.h>
+
+//------------------------------------------------------------------------------
+
+static int DispatchAlpha_AVX2(const uint8_t* WEBP_RESTRICT alpha,
+                              int alpha_stride, int width, int height,
+                              uint8_t* WEBP_RESTRICT dst, int dst_stride) {
+  // alpha_and stores an 'and' operation of all the alpha[] values. The final
+  // value is not 0xff if any of the alpha[] is not equal to 0xff.
+  uint32_t alpha_and = 0xff;
+  int i, j;
+  const __m256i rgb_mask = _mm256_set1_epi32((int)0xffffff00u);
+  const __m256i all_0xff = _mm256_set1_epi8((char)0xff);
+  __m256i all_alphas32 = all_0xff;
+  __m128i all_alphas8 = _mm256_castsi256_si128(all_0xff);
+
+  // We must be able to access 3 extra bytes after the last written byte
+  // 'dst[4 * width - 4]', because we don't know if alpha is the first or the
+  // last byte of the quadruplet. Unlike the SSE2 version, the other three
+  // bytes are read back and rewritten unchanged instead of using
+  // _mm_maskmoveu_si128(), which bypasses the cache.
+  for (j = 0; j < height; ++j) {
+    __m256i* ptr = (__m256i*)dst;
+    for (i = 0; i + 32 <= width - 1; i += 32) {
+      // load 32 alpha bytes
+      const __m256i a0 = _mm256_loadu_si256((const __m256i*)&alpha[i]);
+      const __m128i a0_lo = _mm256_castsi256_si128(a0);
+      const __m128i a0_hi = _mm256_extracti128_si256(a0, 1);
+      const __m256i a1_0 = _mm256_cvtepu8_epi32(a0_lo);
+      const __m256i a1_1 = _mm256_cvtepu8_epi32(_mm_srli_si128(a0_lo, 8));
+      const __m256i a1_2 = _mm256_cvtepu8_epi32(a0_hi);
+      const __m256i a1_3 = _mm256_cvtepu8_epi32(_mm_srli_si128(a0_hi, 8));
+      const __m256i d0 =
+          _mm256_and_si256(_mm256_loadu_si256(ptr + 0), rgb_mask);
+      const __m256i d1 =
+          _mm256_and_si256(_mm256_loadu_si256(ptr + 1), rgb_mask);
+      const __m256i d2 =
+          _mm256_and_si256(_mm256_loadu_si256(ptr + 2), rgb_mask);
+      const __m256i d3 =
+          _mm256_and_si256(_mm256_loadu_si256(ptr + 3), rgb_mask);
+      _mm256_storeu_si256(ptr + 0, _mm256_or_si256(d0, a1_0));
+      _mm256_storeu_si256(ptr + 1, _mm256_or_si256(d1, a1_1));
+      _mm256_storeu_si256(ptr + 2, _mm256_or_si256(d2, a1_2));
+      _mm256_storeu_si256(ptr + 3, _mm256_or_si256(d3, a1_3));
+      // accumulate 32 alpha 'and' in parallel
+      all_alphas32 = _mm256_and_si256(all_alphas32, a0);
+      ptr += 4;
+    }
+    for (; i + 8 <= width - 1; i += 8) {
+      // load 8 alpha bytes
+      const __m128i a0 = _mm_loadl_epi64((const __m128i*)&alpha[i]);
+      const __m256i a1 = _mm256_cvtepu8_epi32(a0);
+      const __m256i d0 = _mm256_and_si256(_mm256_loadu_si256(ptr), rgb_mask);
+      _mm256_storeu_si256(ptr, _mm256_or_si256(d0, a1));
+      // accumulate 8 alpha 'and' in parallel
+      all_alphas8 = _mm_and_si128(all_alphas8, a0);
+      ptr += 1;
+    }
+    for (; i < width; ++i) {
+      const uint32_t alpha_value = alpha[i];
+      dst[4 * i] = alpha_value;
+      alpha_and &= alpha_value;
+    }
+    alpha += alpha_stride;
+    dst += dst_stride;
+  }
+  // Combine the eight alpha 'and' into a 8-bit mask.
+  alpha_and &= _mm_movemask_epi8(_mm_cmpeq_epi8(
+                   all_alphas8, _mm256_castsi256_si128(all_0xff))) &
+               0xff;
+  return (alpha_and != 0xff ||
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(all_alphas32, all_0xff)) !=
+              -1);
+}
+
+static int ExtractAlpha_AVX2(const uint8_t* WEBP_RESTRICT argb,
+                             int argb_stride, int width, int height,
+                             uint8_t* WEBP_RESTRICT alpha, int alpha_stride) {
+  // alpha_and stores an 'and' operation of all the alpha[] values. The final
+  // value is not 0xff if any of the alpha[] is not equal to 0xff.
+  uint32_t alpha_and = 0xff;
+  int i, j;
+  const __m256i a_mask = _mm256_set1_epi32(0xff);  // to preserve alpha
+  const __m256i all_0xff = _mm256_set1_epi8((char)0xff);
+  // packs/packus work within 128-bit lanes: this restores the pixel order.
+  const __m256i kPermute = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  __m256i all_alphas32 = all_0xff;
+  __m128i all_alphas8 = _mm256_castsi256_si128(all_0xff);
+
+  // We must be able to access 3 extra bytes after the last written byte
+  // 'src[4 * width - 4]', because we don't know if alpha is the first or the
+  // last byte of the quadruplet.
+  const int limit32 = (width - 1) & ~31;
+  const int limit8 = (width - 1) & ~7;
+
+  for (j = 0; j < height; ++j) {
+    const __m256i* src = (const __m256i*)argb;
+    for (i = 0; i < limit32; i += 32) {
+      // load 128 argb bytes
+      const __m256i a0 = _mm256_loadu_si256(src + 0);
+      const __m256i a1 = _mm256_loadu_si256(src + 1);
+      const __m256i a2 = _mm256_loadu_si256(src + 2);
+      const __m256i a3 = _mm256_loadu_si256(src + 3);
+      const __m256i b0 = _mm256_and_si256(a0, a_mask);
+      const __m256i b1 = _mm256_and_si256(a1, a_mask);
+      const __m256i b2 = _mm256_and_si256(a2, a_mask);
+      const __m256i b3 = _mm256_and_si256(a3, a_mask);
+      const __m256i c0 = _mm256_packs_epi32(b0, b1);
+      const __m256i c1 = _mm256_packs_epi32(b2, b3);
+      const __m256i d0 = _mm256_packus_epi16(c0, c1);
+      const __m256i e0 = _mm256_permutevar8x32_epi32(d0, kPermute);
+      // store
+      _mm256_storeu_si256((__m256i*)&alpha[i], e0);
+      // accumulate 32 alpha 'and' in parallel
+      all_alphas32 = _mm256_and_si256(all_alphas32, e0);
+      src += 4;
+    }
+    for (; i < limit8; i += 8) {
+      // load 32 argb bytes
+      const __m256i a0 = _mm256_loadu_si256(src);
+      const __m256i b0 = _mm256_and_si256(a0, a_mask);
+      const __m256i c0 = _mm256_packs_epi32(b0, b0);
+      const __m256i d0 = _mm256_packus_epi16(c0, c0);
+      const __m128i e0 =
+          _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(d0, kPermute));
+      // store
+      _mm_storel_epi64((__m128i*)&alpha[i], e0);
+      // accumulate eight alpha 'and' in parallel
+      all_alphas8 = _mm_and_si128(all_alphas8, e0);
+      src += 1;
+    }
+    for (; i < width; ++i) {
+      const uint32_t alpha_value = argb[4 * i];
+      alpha[i] = alpha_value;
+      alpha_and &= alpha_value;
+    }
+    argb += argb_stride;
+    alpha += alpha_stride;
+  }
+  // Combine the alpha 'and' into an 8-bit mask.
+  alpha_and &= _mm_movemask_epi8(_mm_cmpeq_epi8(
+      all_alphas8, _mm256_castsi256_si128(all_0xff)));
+  return (alpha_and == 0xff &&
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(all_alphas32, all_0xff)) ==
+              -1);
+}
+
+//------------------------------------------------------------------------------
+// Non-dither premultiplied modes
+
+#define MULTIPLIER(a) ((a) * 0x8081)
+#define PREMULTIPLY(x, m) (((x) * (m)) >> 23)
+
+// Same as APPLY_ALPHA in alpha_processing_sse2.c, on 8 pixels at a time.
+// The in-lane unpack/pack pair leaves the pixel order unchanged.
+#define APPLY_ALPHA(RGBX, SHUFFLE)                                           \
+  do {                                                                       \
+    const __m256i argb0 = _mm256_loadu_si256((const __m256i*)&(RGBX));       \
+    const __m256i argb1_lo = _mm256_unpacklo_epi8(argb0, zero);              \
+    const __m256i argb1_hi = _mm256_unpackhi_epi8(argb0, zero);              \
+    const __m256i alpha0_lo = _mm256_or_si256(argb1_lo, kMask);              \
+    const __m256i alpha0_hi = _mm256_or_si256(argb1_hi, kMask);              \
+    const __m256i alpha1_lo = _mm256_shufflelo_epi16(alpha0_lo, SHUFFLE);    \
+    const __m256i alpha1_hi = _mm256_shufflelo_epi16(alpha0_hi, SHUFFLE);    \
+    const __m256i alpha2_lo = _mm256_shufflehi_epi16(alpha1_lo, SHUFFLE);    \
+    const __m256i alpha2_hi = _mm256_shufflehi_epi16(alpha1_hi, SHUFFLE);    \
+    /* alpha2 = [ff a0 a0 a0][ff a1 a1 a1] */                                \
+    const __m256i A0_lo = _mm256_mullo_epi16(alpha2_lo, argb1_lo);           \
+    const __m256i A0_hi = _mm256_mullo_epi16(alpha2_hi, argb1_hi);           \
+    const __m256i A1_lo = _mm256_mulhi_epu16(A0_lo, kMult);                  \
+    const __m256i A1_hi = _mm256_mulhi_epu16(A0_hi, kMult);                  \
+    const __m256i A2_lo = _mm256_srli_epi16(A1_lo, 7);                       \
+    const __m256i A2_hi = _mm256_srli_epi16(A1_hi, 7);                       \
+    const __m256i A3 = _mm256_packus_epi16(A2_lo, A2_hi);                    \
+    _mm256_storeu_si256((__m256i*)&(RGBX), A3);                              \
+  } while (0)
+
+static void ApplyAlphaMultiply_AVX2(uint8_t* rgba, int alpha_first, int w,
+                                    int h, int stride) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i kMult = _mm256_set1_epi16((short)0x8081);
+  const __m256i kMask = _mm256_setr_epi16(0, 0xff, 0xff, 0, 0, 0xff, 0xff, 0,
+                                          0, 0xff, 0xff, 0, 0, 0xff, 0xff, 0);
+  const int kSpan = 8;
+  while (h-- > 0) {
+    uint32_t* const rgbx = (uint32_t*)rgba;
+    int i;
+    if (!alpha_first) {
+      for (i = 0; i + kSpan <= w; i += kSpan) {
+        APPLY_ALPHA(rgbx[i], _MM_SHUFFLE(2, 3, 3, 3));
+      }
+    } else {
+      for (i = 0; i + kSpan <= w; i += kSpan) {
+        APPLY_ALPHA(rgbx[i], _MM_SHUFFLE(0, 0, 0, 1));
+      }
+    }
+    // Finish with left-overs.
+    for (; i < w; ++i) {
+      uint8_t* const rgb = rgba + (alpha_first ? 1 : 0);
+      const uint8_t* const alpha = rgba + (alpha_first ? 0 : 3);
+      const uint32_t a = alpha[4 * i];
+      if (a != 0xff) {
+        const uint32_t mult = MULTIPLIER(a);
+        rgb[4 * i + 0] = PREMULTIPLY(rgb[4 * i + 0], mult);
+        rgb[4 * i + 1] = PREMULTIPLY(rgb[4 * i + 1], mult);
+        rgb[4 * i + 2] = PREMULTIPLY(rgb[4 * i + 2], mult);
+      }
+    }
+    rgba += stride;
+  }
+}
+#undef APPLY_ALPHA
+#undef MULTIPLIER
+#undef PREMULTIPLY
+
+// -----------------------------------------------------------------------------
+// Apply alpha value to rows
+
+static void MultARGBRow_AVX2(uint32_t* const ptr, int width, int inverse) {
+  int x = 0;
+  if (!inverse) {
+    const int kSpan = 8;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i k128 = _mm256_set1_epi16(128);
+    const __m256i kMult = _mm256_set1_epi16(0x0101);
+    const __m256i kMask = _mm256_setr_epi16(0, 0, 0xff, 0, 0, 0, 0xff, 0,
+                                            0, 0, 0xff, 0, 0, 0, 0xff, 0);
+    for (x = 0; x + kSpan <= width; x += kSpan) {
+      // To compute 'result = (int)(a * x / 255. + .5)', we use:
+      //   tmp = a * v + 128, result = (tmp * 0x0101u) >> 16
+      const __m256i A0 = _mm256_loadu_si256((const __m256i*)&ptr[x]);
+      const __m256i A1_lo = _mm256_unpacklo_epi8(A0, zero);
+      const __m256i A1_hi = _mm256_unpackhi_epi8(A0, zero);
+      const __m256i A2_lo = _mm256_or_si256(A1_lo, kMask);
+      const __m256i A2_hi = _mm256_or_si256(A1_hi, kMask);
+      const __m256i A3_lo =
+          _mm256_shufflelo_epi16(A2_lo, _MM_SHUFFLE(2, 3, 3, 3));
+      const __m256i A3_hi =
+          _mm256_shufflelo_epi16(A2_hi, _MM_SHUFFLE(2, 3, 3, 3));
+      const __m256i A4_lo =
+          _mm256_shufflehi_epi16(A3_lo, _MM_SHUFFLE(2, 3, 3, 3));
+      const __m256i A4_hi =
+          _mm256_shufflehi_epi16(A3_hi, _MM_SHUFFLE(2, 3, 3, 3));
+      // here, A4 = [ff a0 a0 a0][ff a1 a1 a1]
+      const __m256i A5_lo = _mm256_mullo_epi16(A4_lo, A1_lo);
+      const __m256i A5_hi = _mm256_mullo_epi16(A4_hi, A1_hi);
+      const __m256i A6_lo = _mm256_add_epi16(A5_lo, k128);
+      const __m256i A6_hi = _mm256_add_epi16(A5_hi, k128);
+      const __m256i A7_lo = _mm256_mulhi_epu16(A6_lo, kMult);
+      const __m256i A7_hi = _mm256_mulhi_epu16(A6_hi, kMult);
+      const __m256i A8 = _mm256_packus_epi16(A7_lo, A7_hi);
+      _mm256_storeu_si256((__m256i*)&ptr[x], A8);
+    }
+  }
+  width -= x;
+  if (width > 0) WebPMultARGBRow_C(ptr + x, width, inverse);
+}
+
+static void MultRow_AVX2(uint8_t* WEBP_RESTRICT const ptr,
+                         const uint8_t* WEBP_RESTRICT const alpha, int width,
+                         int inverse) {
+  int x = 0;
+  if (!inverse) {
+    const __m256i k128 = _mm256_set1_epi16(128);
+    const __m256i kMult = _mm256_set1_epi16(0x0101);
+    for (x = 0; x + 16 <= width; x += 16) {
+      const __m128i v0 = _mm_loadu_si128((const __m128i*)&ptr[x]);
+      const __m128i a0 = _mm_loadu_si128((const __m128i*)&alpha[x]);
+      const __m256i v1 = _mm256_cvtepu8_epi16(v0);
+      const __m256i a1 = _mm256_cvtepu8_epi16(a0);
+      const __m256i v2 = _mm256_mullo_epi16(v1, a1);
+      const __m256i v3 = _mm256_add_epi16(v2, k128);
+      const __m256i v4 = _mm256_mulhi_epu16(v3, kMult);
+      const __m256i v5 = _mm256_packus_epi16(v4, v4);
+      const __m256i v6 = _mm256_permute4x64_epi64(v5, _MM_SHUFFLE(3, 1, 2, 0));
+      _mm_storeu_si128((__m128i*)&ptr[x], _mm256_castsi256_si128(v6));
+    }
+    if (x + 8 <= width) {
+      const __m128i v0 = _mm_loadl_epi64((const __m128i*)&ptr[x]);
+      const __m128i a0 = _mm_loadl_epi64((const __m128i*)&alpha[x]);
+      const __m128i v1 = _mm_cvtepu8_epi16(v0);
+      const __m128i a1 = _mm_cvtepu8_epi16(a0);
+      const __m128i v2 = _mm_mullo_epi16(v1, a1);
+      const __m128i v3 = _mm_add_epi16(v2, _mm256_castsi256_si128(k128));
+      const __m128i v4 = _mm_mulhi_epu16(v3, _mm256_castsi256_si128(kMult));
+      _mm_storel_epi64((__m128i*)&ptr[x], _mm_packus_epi16(v4, v4));
+      x += 8;
+    }
+  }
+  width -= x;
+  if (width > 0) WebPMultRow_C(ptr + x, alpha + x, width, inverse);
+}
+
+//------------------------------------------------------------------------------
+// Entry point
+
+extern void WebPInitAlphaProcessingAVX2(void);
+
+WEBP_TSAN_IGNORE_FUNCTION void WebPInitAlphaProcessingAVX2(void) {
+  WebPMultARGBRow = MultARGBRow_AVX2;
+  WebPMultRow = MultRow_AVX2;
+  WebPApplyAlphaMultiply = ApplyAlphaMultiply_AVX2;
+  WebPDispatchAlpha = DispatchAlpha_AVX2;
+  WebPExtractAlpha = ExtractAlpha_AVX2;
+}
+
+#else  // !WEBP_USE_AVX2
+
+WEBP_DSP_INIT_STUB(WebPInitAlphaProcessingAVX2)
+
+#endif  // WEBP_USE_AVX2
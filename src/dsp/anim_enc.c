@@ -0,0 +1,193 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// Frame differencing functions used by the animation encoder.
+
+#include <assert.h>
+#include <stdlib.h>  // for abs()
+
+#include "src/dsp/cpu.h"
+#include "src/dsp/dsp.h"
+#include "src/webp/types.h"
+
+//------------------------------------------------------------------------------
+
+// Returns true if each channel of 'src' and 'dst' is at most off by
+// 'max_allowed_diff', relatively to the alpha of 'dst'.
+static WEBP_INLINE int PixelsAreSimilar_C(uint32_t src, uint32_t dst,
+                                          int max_allowed_diff) {
+  const int src_a = (src >> 24) & 0xff;
+  const int src_r = (src >> 16) & 0xff;
+  const int src_g = (src >> 8) & 0xff;
+  const int src_b = (src >> 0) & 0xff;
+  const int dst_a = (dst >> 24) & 0xff;
+  const int dst_r = (dst >> 16) & 0xff;
+  const int dst_g = (dst >> 8) & 0xff;
+  const int dst_b = (dst >> 0) & 0xff;
+
+  return (src_a == dst_a) &&
+         (abs(src_r - dst_r) * dst_a <= (max_allowed_diff * 255)) &&
+         (abs(src_g - dst_g) * dst_a <= (max_allowed_diff * 255)) &&
+         (abs(src_b - dst_b) * dst_a <= (max_allowed_diff * 255));
+}
+
+int WebPAnimFindFirstDiffLossless_C(const uint32_t* src, const uint32_t* dst,
+                                    int length, int max_allowed_diff) {
+  int i;
+  (void)max_allowed_diff;
+  for (i = 0; i < length; ++i) {
+    if (src[i] != dst[i]) break;
+  }
+  return i;
+}
+
+int WebPAnimFindFirstDiffLossy_C(const uint32_t* src, const uint32_t* dst,
+                                 int length, int max_allowed_diff) {
+  int i;
+  for (i = 0; i < length; ++i) {
+    if (!PixelsAreSimilar_C(src[i], dst[i], max_allowed_diff)) break;
+  }
+  return i;
+}
+
+int WebPAnimFindLastDiffLossless_C(const uint32_t* src, const uint32_t* dst,
+                                   int length, int max_allowed_diff) {
+  int i;
+  (void)max_allowed_diff;
+  for (i = length - 1; i >= 0; --i) {
+    if (src[i] != dst[i]) break;
+  }
+  return i;
+}
+
+int WebPAnimFindLastDiffLossy_C(const uint32_t* src, const uint32_t* dst,
+                                int length, int max_allowed_diff) {
+  int i;
+  for (i = length - 1; i >= 0; --i) {
+    if (!PixelsAreSimilar_C(src[i], dst[i], max_allowed_diff)) break;
+  }
+  return i;
+}
+
+int WebPAnimCanBlendLossless_C(const uint32_t* src, const uint32_t* dst,
+                               int length, int max_allowed_diff) {
+  int i;
+  (void)max_allowed_diff;
+  for (i = 0; i < length; ++i) {
+    if ((dst[i] >> 24) != 0xff && src[i] != dst[i]) return 0;
+  }
+  return 1;
+}
+
+int WebPAnimCanBlendLossy_C(const uint32_t* src, const uint32_t* dst,
+                            int length, int max_allowed_diff) {
+  int i;
+  for (i = 0; i < length; ++i) {
+    if ((dst[i] >> 24) != 0xff &&
+        !PixelsAreSimilar_C(src[i], dst[i], max_allowed_diff)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int WebPAnimIncreaseTransparency_C(const uint32_t* src, uint32_t* dst,
+                                   uint8_t* mask, int length) {
+  int i;
+  int modified = 0;
+  for (i = 0; i < length; ++i) {
+    if (src[i] == dst[i] && dst[i] != 0x00000000u) {
+      dst[i] = 0x00000000u;
+      mask[i] = 1;
+      modified = 1;
+    }
+  }
+  return modified;
+}
+
+static int IsSimilarBlock8x8_C(const uint32_t* src, int src_stride,
+                               const uint32_t* dst, int dst_stride,
+                               int max_allowed_diff, uint32_t* const color) {
+  int avg_r = 0, avg_g = 0, avg_b = 0;
+  int x, y;
+  for (y = 0; y < 8; ++y) {
+    for (x = 0; x < 8; ++x) {
+      const uint32_t src_pixel = src[x + y * src_stride];
+      if ((src_pixel >> 24) != 0xff ||
+          !PixelsAreSimilar_C(src_pixel, dst[x + y * dst_stride],
+                              max_allowed_diff)) {
+        return 0;
+      }
+      avg_r += (src_pixel >> 16) & 0xff;
+      avg_g += (src_pixel >> 8) & 0xff;
+      avg_b += (src_pixel >> 0) & 0xff;
+    }
+  }
+  *color = ((uint32_t)(avg_r / 64) << 16) | ((uint32_t)(avg_g / 64) << 8) |
+           ((uint32_t)(avg_b / 64) << 0);
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+// Init function
+
+WebPAnimCompareFunc WebPAnimFindFirstDiffLossless;
+WebPAnimCompareFunc WebPAnimFindFirstDiffLossy;
+WebPAnimCompareFunc WebPAnimFindLastDiffLossless;
+WebPAnimCompareFunc WebPAnimFindLastDiffLossy;
+WebPAnimCompareFunc WebPAnimCanBlendLossless;
+WebPAnimCompareFunc WebPAnimCanBlendLossy;
+WebPAnimIncreaseTransparencyFunc WebPAnimIncreaseTransparency;
+WebPAnimIsSimilarBlockFunc WebPAnimIsSimilarBlock8x8;
+
+// This file is built into libwebpmux: with a libwebp DLL, the CPU detection
+// variable has to be imported explicitly.
+#if defined(_WIN32) && defined(WEBP_DLL)
+extern __declspec(dllimport) VP8CPUInfo VP8GetCPUInfo;
+#else
+extern VP8CPUInfo VP8GetCPUInfo;
+#endif
+extern void WebPAnimEncDspInitSSE2(void);
+extern void WebPAnimEncDspInitAVX2(void);
+
+WEBP_DSP_INIT_FUNC(WebPAnimEncDspInit) {
+  // The plain-C versions are always set: the SIMD ones use them for the
+  // leftover pixels.
+  WebPAnimFindFirstDiffLossless = WebPAnimFindFirstDiffLossless_C;
+  WebPAnimFindFirstDiffLossy = WebPAnimFindFirstDiffLossy_C;
+  WebPAnimFindLastDiffLossless = WebPAnimFindLastDiffLossless_C;
+  WebPAnimFindLastDiffLossy = WebPAnimFindLastDiffLossy_C;
+  WebPAnimCanBlendLossless = WebPAnimCanBlendLossless_C;
+  WebPAnimCanBlendLossy = WebPAnimCanBlendLossy_C;
+  WebPAnimIncreaseTransparency = WebPAnimIncreaseTransparency_C;
+  WebPAnimIsSimilarBlock8x8 = IsSimilarBlock8x8_C;
+
+  // If defined, use CPUInfo() to overwrite some pointers with faster versions.
+  if (VP8GetCPUInfo != NULL) {
+#if defined(WEBP_HAVE_SSE2)
+    if (VP8GetCPUInfo(kSSE2)) {
+      WebPAnimEncDspInitSSE2();
+#if defined(WEBP_HAVE_AVX2)
+      if (VP8GetCPUInfo(kAVX2)) {
+        WebPAnimEncDspInitAVX2();
+      }
+#endif
+    }
+#endif
+  }
+
+  assert(WebPAnimFindFirstDiffLossless != NULL);
+  assert(WebPAnimFindFirstDiffLossy != NULL);
+  assert(WebPAnimFindLastDiffLossless != NULL);
+  assert(WebPAnimFindLastDiffLossy != NULL);
+  assert(WebPAnimCanBlendLossless != NULL);
+  assert(WebPAnimCanBlendLossy != NULL);
+  assert(WebPAnimIncreaseTransparency != NULL);
+  assert(WebPAnimIsSimilarBlock8x8 != NULL);
+}
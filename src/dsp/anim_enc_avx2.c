@@ -0,0 +1,234 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// AVX2 version of the animation encoder frame differencing.
+
+#include "src/dsp/dsp.h"
+
+#if defined(WEBP_USE_AVX2)
+#include <assert.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#include "src/dsp/cpu.h"
+#include "src/utils/utils.h"
+#include "src/webp/types.h"
+
+//------------------------------------------------------------------------------
+
+// Same as IsSimilar_SSE2(), for 8 pixels. The unpack and pack operations
+// work within each 128b lane, which keeps the pixels in order.
+static WEBP_INLINE __m256i IsSimilar_AVX2(const __m256i src, const __m256i dst,
+                                          const __m256i thresh) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000u);
+  const __m256i same_alpha = _mm256_cmpeq_epi32(
+      _mm256_and_si256(_mm256_xor_si256(src, dst), alpha_mask), zero);
+  const __m256i diff =
+      _mm256_or_si256(_mm256_subs_epu8(src, dst), _mm256_subs_epu8(dst, src));
+  const __m256i A0 = _mm256_srli_epi32(dst, 24);
+  const __m256i A1 = _mm256_or_si256(A0, _mm256_slli_epi32(A0, 16));
+  const __m256i A_lo = _mm256_unpacklo_epi32(A1, A1);
+  const __m256i A_hi = _mm256_unpackhi_epi32(A1, A1);
+  const __m256i D_lo =
+      _mm256_mullo_epi16(_mm256_unpacklo_epi8(diff, zero), A_lo);
+  const __m256i D_hi =
+      _mm256_mullo_epi16(_mm256_unpackhi_epi8(diff, zero), A_hi);
+  const __m256i ok_lo =
+      _mm256_cmpeq_epi16(_mm256_subs_epu16(D_lo, thresh), zero);
+  const __m256i ok_hi =
+      _mm256_cmpeq_epi16(_mm256_subs_epu16(D_hi, thresh), zero);
+  const __m256i ok = _mm256_cmpeq_epi32(_mm256_packs_epi16(ok_lo, ok_hi),
+                                        _mm256_set1_epi32(-1));
+  return _mm256_and_si256(ok, same_alpha);
+}
+
+static WEBP_INLINE __m256i IsOpaque_AVX2(const __m256i dst) {
+  const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000u);
+  return _mm256_cmpeq_epi32(_mm256_and_si256(dst, alpha_mask), alpha_mask);
+}
+
+// The C versions finish the job: the first (or last) difference, if any, is
+// among the eight pixels where the SIMD loops stop.
+
+static int FindFirstDiffLossless_AVX2(const uint32_t* src, const uint32_t* dst,
+                                      int length, int max_allowed_diff) {
+  int i;
+  for (i = 0; i + 8 <= length; i += 8) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)&src[i]);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)&dst[i]);
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) != -1) break;
+  }
+  return i + WebPAnimFindFirstDiffLossless_C(src + i, dst + i, length - i,
+                                             max_allowed_diff);
+}
+
+static int FindFirstDiffLossy_AVX2(const uint32_t* src, const uint32_t* dst,
+                                   int length, int max_allowed_diff) {
+  const __m256i thresh = _mm256_set1_epi16((short)(max_allowed_diff * 255));
+  int i;
+  assert(max_allowed_diff >= 0 && max_allowed_diff <= 255);
+  for (i = 0; i + 8 <= length; i += 8) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)&src[i]);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)&dst[i]);
+    if (_mm256_movemask_epi8(IsSimilar_AVX2(a, b, thresh)) != -1) break;
+  }
+  return i + WebPAnimFindFirstDiffLossy_C(src + i, dst + i, length - i,
+                                          max_allowed_diff);
+}
+
+static int FindLastDiffLossless_AVX2(const uint32_t* src, const uint32_t* dst,
+                                     int length, int max_allowed_diff) {
+  int i;
+  for (i = length; i >= 8; i -= 8) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)&src[i - 8]);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)&dst[i - 8]);
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) != -1) break;
+  }
+  return WebPAnimFindLastDiffLossless_C(src, dst, i, max_allowed_diff);
+}
+
+static int FindLastDiffLossy_AVX2(const uint32_t* src, const uint32_t* dst,
+                                  int length, int max_allowed_diff) {
+  const __m256i thresh = _mm256_set1_epi16((short)(max_allowed_diff * 255));
+  int i;
+  assert(max_allowed_diff >= 0 && max_allowed_diff <= 255);
+  for (i = length; i >= 8; i -= 8) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)&src[i - 8]);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)&dst[i - 8]);
+    if (_mm256_movemask_epi8(IsSimilar_AVX2(a, b, thresh)) != -1) break;
+  }
+  return WebPAnimFindLastDiffLossy_C(src, dst, i, max_allowed_diff);
+}
+
+static int CanBlendLossless_AVX2(const uint32_t* src, const uint32_t* dst,
+                                 int length, int max_allowed_diff) {
+  int i;
+  for (i = 0; i + 8 <= length; i += 8) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)&src[i]);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)&dst[i]);
+    const __m256i ok =
+        _mm256_or_si256(_mm256_cmpeq_epi32(a, b), IsOpaque_AVX2(b));
+    if (_mm256_movemask_epi8(ok) != -1) return 0;
+  }
+  return WebPAnimCanBlendLossless_C(src + i, dst + i, length - i,
+                                    max_allowed_diff);
+}
+
+static int CanBlendLossy_AVX2(const uint32_t* src, const uint32_t* dst,
+                              int length, int max_allowed_diff) {
+  const __m256i thresh = _mm256_set1_epi16((short)(max_allowed_diff * 255));
+  int i;
+  assert(max_allowed_diff >= 0 && max_allowed_diff <= 255);
+  for (i = 0; i + 8 <= length; i += 8) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)&src[i]);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)&dst[i]);
+    const __m256i ok =
+        _mm256_or_si256(IsSimilar_AVX2(a, b, thresh), IsOpaque_AVX2(b));
+    if (_mm256_movemask_epi8(ok) != -1) return 0;
+  }
+  return WebPAnimCanBlendLossy_C(src + i, dst + i, length - i,
+                                 max_allowed_diff);
+}
+
+static int IncreaseTransparency_AVX2(const uint32_t* src, uint32_t* dst,
+                                     uint8_t* mask, int length) {
+  const __m256i zero = _mm256_setzero_si256();
+  int modified = 0;
+  int i;
+  for (i = 0; i + 8 <= length; i += 8) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)&src[i]);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)&dst[i]);
+    const __m256i to_clear = _mm256_andnot_si256(_mm256_cmpeq_epi32(b, zero),
+                                                 _mm256_cmpeq_epi32(a, b));
+    if (_mm256_movemask_epi8(to_clear) != 0) {
+      // The first 4 bytes of each 128b lane flag 4 of the pixels.
+      const __m256i M0 = _mm256_packs_epi32(to_clear, to_clear);
+      const __m256i M1 = _mm256_packs_epi16(M0, M0);
+      const uint32_t bits_lo =
+          (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(M1)) &
+          0x01010101u;
+      const uint32_t bits_hi =
+          (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(M1, 1)) &
+          0x01010101u;
+      _mm256_storeu_si256((__m256i*)&dst[i], _mm256_andnot_si256(to_clear, b));
+      WebPUint32ToMem(mask + i, WebPMemToUint32(mask + i) | bits_lo);
+      WebPUint32ToMem(mask + i + 4, WebPMemToUint32(mask + i + 4) | bits_hi);
+      modified = 1;
+    }
+  }
+  if (WebPAnimIncreaseTransparency_C(src + i, dst + i, mask + i, length - i)) {
+    modified = 1;
+  }
+  return modified;
+}
+
+static int IsSimilarBlock8x8_AVX2(const uint32_t* src, int src_stride,
+                                  const uint32_t* dst, int dst_stride,
+                                  int max_allowed_diff, uint32_t* const color) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max_diff = _mm256_set1_epi8((char)max_allowed_diff);
+  __m256i alpha_and = _mm256_set1_epi8((char)0xff);
+  __m256i excess = zero;
+  __m256i sum = zero;
+  int y;
+  assert(max_allowed_diff >= 0 && max_allowed_diff <= 255);
+  for (y = 0; y < 8; ++y) {
+    const __m256i a = _mm256_loadu_si256((const __m256i*)src);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)dst);
+    const __m256i diff =
+        _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+    alpha_and = _mm256_and_si256(alpha_and, _mm256_and_si256(a, b));
+    excess = _mm256_or_si256(excess, _mm256_subs_epu8(diff, max_diff));
+    sum = _mm256_add_epi16(sum,
+                           _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero),
+                                            _mm256_unpackhi_epi8(a, zero)));
+    src += src_stride;
+    dst += dst_stride;
+  }
+  {
+    const __m256i all_alpha =
+        _mm256_or_si256(alpha_and, _mm256_set1_epi32(0x00ffffff));
+    const __m256i ok = _mm256_and_si256(
+        _mm256_cmpeq_epi8(all_alpha, _mm256_set1_epi8((char)0xff)),
+        _mm256_cmpeq_epi8(excess, zero));
+    if (_mm256_movemask_epi8(ok) != -1) return 0;
+  }
+  {
+    __m128i sum4 = _mm_add_epi16(_mm256_castsi256_si128(sum),
+                                 _mm256_extracti128_si256(sum, 1));
+    sum4 = _mm_add_epi16(sum4, _mm_srli_si128(sum4, 8));
+    *color = ((uint32_t)(_mm_extract_epi16(sum4, 2) / 64) << 16) |
+             ((uint32_t)(_mm_extract_epi16(sum4, 1) / 64) << 8) |
+             ((uint32_t)(_mm_extract_epi16(sum4, 0) / 64) << 0);
+  }
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+// Entry point
+
+extern void WebPAnimEncDspInitAVX2(void);
+
+WEBP_TSAN_IGNORE_FUNCTION void WebPAnimEncDspInitAVX2(void) {
+  WebPAnimFindFirstDiffLossless = FindFirstDiffLossless_AVX2;
+  WebPAnimFindFirstDiffLossy = FindFirstDiffLossy_AVX2;
+  WebPAnimFindLastDiffLossless = FindLastDiffLossless_AVX2;
+  WebPAnimFindLastDiffLossy = FindLastDiffLossy_AVX2;
+  WebPAnimCanBlendLossless = CanBlendLossless_AVX2;
+  WebPAnimCanBlendLossy = CanBlendLossy_AVX2;
+  WebPAnimIncreaseTransparency = IncreaseTransparency_AVX2;
+  WebPAnimIsSimilarBlock8x8 = IsSimilarBlock8x8_AVX2;
+}
+
+#else  // !WEBP_USE_AVX2
+
+WEBP_DSP_INIT_STUB(WebPAnimEncDspInitAVX2)
+
+#endif  // WEBP_USE_AVX2
@@ -0,0 +1,226 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// SSE2 version of the animation encoder frame differencing.
+
+#include "src/dsp/dsp.h"
+
+#if defined(WEBP_USE_SSE2)
+#include <assert.h>
+#include <emmintrin.h>
+
+#include "src/dsp/cpu.h"
+#include "src/utils/utils.h"
+#include "src/webp/types.h"
+
+//------------------------------------------------------------------------------
+
+// Returns 0xffffffff in the lanes where the 'src' and 'dst' pixels are
+// similar, 'thresh' being max_allowed_diff * 255 in each 16b lane.
+static WEBP_INLINE __m128i IsSimilar_SSE2(const __m128i src, const __m128i dst,
+                                          const __m128i thresh) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000u);
+  const __m128i same_alpha = _mm_cmpeq_epi32(
+      _mm_and_si128(_mm_xor_si128(src, dst), alpha_mask), zero);
+  // abs(src - dst) in 8b
+  const __m128i diff =
+      _mm_or_si128(_mm_subs_epu8(src, dst), _mm_subs_epu8(dst, src));
+  // alpha of 'dst', repeated in the four 16b lanes of each pixel
+  const __m128i A0 = _mm_srli_epi32(dst, 24);
+  const __m128i A1 = _mm_or_si128(A0, _mm_slli_epi32(A0, 16));
+  const __m128i A_lo = _mm_unpacklo_epi32(A1, A1);
+  const __m128i A_hi = _mm_unpackhi_epi32(A1, A1);
+  // abs(src - dst) * alpha fits in 16b and is at most 'thresh' if the
+  // saturated subtraction is 0.
+  const __m128i D_lo = _mm_mullo_epi16(_mm_unpacklo_epi8(diff, zero), A_lo);
+  const __m128i D_hi = _mm_mullo_epi16(_mm_unpackhi_epi8(diff, zero), A_hi);
+  const __m128i ok_lo = _mm_cmpeq_epi16(_mm_subs_epu16(D_lo, thresh), zero);
+  const __m128i ok_hi = _mm_cmpeq_epi16(_mm_subs_epu16(D_hi, thresh), zero);
+  const __m128i ok = _mm_cmpeq_epi32(_mm_packs_epi16(ok_lo, ok_hi),
+                                     _mm_set1_epi32(-1));
+  return _mm_and_si128(ok, same_alpha);
+}
+
+static WEBP_INLINE __m128i IsOpaque_SSE2(const __m128i dst) {
+  const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000u);
+  return _mm_cmpeq_epi32(_mm_and_si128(dst, alpha_mask), alpha_mask);
+}
+
+// The C versions finish the job: the first (or last) difference, if any, is
+// among the four pixels where the SIMD loops stop.
+
+static int FindFirstDiffLossless_SSE2(const uint32_t* src, const uint32_t* dst,
+                                      int length, int max_allowed_diff) {
+  int i;
+  for (i = 0; i + 4 <= length; i += 4) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)&src[i]);
+    const __m128i b = _mm_loadu_si128((const __m128i*)&dst[i]);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) != 0xffff) break;
+  }
+  return i + WebPAnimFindFirstDiffLossless_C(src + i, dst + i, length - i,
+                                             max_allowed_diff);
+}
+
+static int FindFirstDiffLossy_SSE2(const uint32_t* src, const uint32_t* dst,
+                                   int length, int max_allowed_diff) {
+  const __m128i thresh = _mm_set1_epi16((short)(max_allowed_diff * 255));
+  int i;
+  assert(max_allowed_diff >= 0 && max_allowed_diff <= 255);
+  for (i = 0; i + 4 <= length; i += 4) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)&src[i]);
+    const __m128i b = _mm_loadu_si128((const __m128i*)&dst[i]);
+    if (_mm_movemask_epi8(IsSimilar_SSE2(a, b, thresh)) != 0xffff) break;
+  }
+  return i + WebPAnimFindFirstDiffLossy_C(src + i, dst + i, length - i,
+                                          max_allowed_diff);
+}
+
+static int FindLastDiffLossless_SSE2(const uint32_t* src, const uint32_t* dst,
+                                     int length, int max_allowed_diff) {
+  int i;
+  for (i = length; i >= 4; i -= 4) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)&src[i - 4]);
+    const __m128i b = _mm_loadu_si128((const __m128i*)&dst[i - 4]);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) != 0xffff) break;
+  }
+  return WebPAnimFindLastDiffLossless_C(src, dst, i, max_allowed_diff);
+}
+
+static int FindLastDiffLossy_SSE2(const uint32_t* src, const uint32_t* dst,
+                                  int length, int max_allowed_diff) {
+  const __m128i thresh = _mm_set1_epi16((short)(max_allowed_diff * 255));
+  int i;
+  assert(max_allowed_diff >= 0 && max_allowed_diff <= 255);
+  for (i = length; i >= 4; i -= 4) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)&src[i - 4]);
+    const __m128i b = _mm_loadu_si128((const __m128i*)&dst[i - 4]);
+    if (_mm_movemask_epi8(IsSimilar_SSE2(a, b, thresh)) != 0xffff) break;
+  }
+  return WebPAnimFindLastDiffLossy_C(src, dst, i, max_allowed_diff);
+}
+
+static int CanBlendLossless_SSE2(const uint32_t* src, const uint32_t* dst,
+                                 int length, int max_allowed_diff) {
+  int i;
+  for (i = 0; i + 4 <= length; i += 4) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)&src[i]);
+    const __m128i b = _mm_loadu_si128((const __m128i*)&dst[i]);
+    const __m128i ok = _mm_or_si128(_mm_cmpeq_epi32(a, b), IsOpaque_SSE2(b));
+    if (_mm_movemask_epi8(ok) != 0xffff) return 0;
+  }
+  return WebPAnimCanBlendLossless_C(src + i, dst + i, length - i,
+                                    max_allowed_diff);
+}
+
+static int CanBlendLossy_SSE2(const uint32_t* src, const uint32_t* dst,
+                              int length, int max_allowed_diff) {
+  const __m128i thresh = _mm_set1_epi16((short)(max_allowed_diff * 255));
+  int i;
+  assert(max_allowed_diff >= 0 && max_allowed_diff <= 255);
+  for (i = 0; i + 4 <= length; i += 4) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)&src[i]);
+    const __m128i b = _mm_loadu_si128((const __m128i*)&dst[i]);
+    const __m128i ok =
+        _mm_or_si128(IsSimilar_SSE2(a, b, thresh), IsOpaque_SSE2(b));
+    if (_mm_movemask_epi8(ok) != 0xffff) return 0;
+  }
+  return WebPAnimCanBlendLossy_C(src + i, dst + i, length - i,
+                                 max_allowed_diff);
+}
+
+static int IncreaseTransparency_SSE2(const uint32_t* src, uint32_t* dst,
+                                     uint8_t* mask, int length) {
+  const __m128i zero = _mm_setzero_si128();
+  int modified = 0;
+  int i;
+  for (i = 0; i + 4 <= length; i += 4) {
+    const __m128i a = _mm_loadu_si128((const __m128i*)&src[i]);
+    const __m128i b = _mm_loadu_si128((const __m128i*)&dst[i]);
+    // Pixels equal to 'src' that are not transparent yet.
+    const __m128i to_clear =
+        _mm_andnot_si128(_mm_cmpeq_epi32(b, zero), _mm_cmpeq_epi32(a, b));
+    if (_mm_movemask_epi8(to_clear) != 0) {
+      const __m128i M0 = _mm_packs_epi32(to_clear, to_clear);
+      const __m128i M1 = _mm_packs_epi16(M0, M0);
+      const uint32_t bits = (uint32_t)_mm_cvtsi128_si32(M1) & 0x01010101u;
+      _mm_storeu_si128((__m128i*)&dst[i], _mm_andnot_si128(to_clear, b));
+      WebPUint32ToMem(mask + i, WebPMemToUint32(mask + i) | bits);
+      modified = 1;
+    }
+  }
+  if (WebPAnimIncreaseTransparency_C(src + i, dst + i, mask + i, length - i)) {
+    modified = 1;
+  }
+  return modified;
+}
+
+static int IsSimilarBlock8x8_SSE2(const uint32_t* src, int src_stride,
+                                  const uint32_t* dst, int dst_stride,
+                                  int max_allowed_diff, uint32_t* const color) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max_diff = _mm_set1_epi8((char)max_allowed_diff);
+  // As 'src' must be opaque, both pixels are and the color channels may not
+  // differ by more than 'max_allowed_diff'.
+  __m128i alpha_and = _mm_set1_epi8((char)0xff);
+  __m128i excess = zero;
+  __m128i sum = zero;  // 16b sums of the even and odd pixels
+  int y;
+  assert(max_allowed_diff >= 0 && max_allowed_diff <= 255);
+  for (y = 0; y < 8; ++y) {
+    int x;
+    for (x = 0; x < 8; x += 4) {
+      const __m128i a = _mm_loadu_si128((const __m128i*)&src[x]);
+      const __m128i b = _mm_loadu_si128((const __m128i*)&dst[x]);
+      const __m128i diff =
+          _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+      alpha_and = _mm_and_si128(alpha_and, _mm_and_si128(a, b));
+      excess = _mm_or_si128(excess, _mm_subs_epu8(diff, max_diff));
+      sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                             _mm_unpackhi_epi8(a, zero)));
+    }
+    src += src_stride;
+    dst += dst_stride;
+  }
+  {
+    const __m128i all_alpha =
+        _mm_or_si128(alpha_and, _mm_set1_epi32(0x00ffffff));
+    const __m128i ok = _mm_and_si128(
+        _mm_cmpeq_epi8(all_alpha, _mm_set1_epi8((char)0xff)),
+        _mm_cmpeq_epi8(excess, zero));
+    if (_mm_movemask_epi8(ok) != 0xffff) return 0;
+  }
+  sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+  *color = ((uint32_t)(_mm_extract_epi16(sum, 2) / 64) << 16) |
+           ((uint32_t)(_mm_extract_epi16(sum, 1) / 64) << 8) |
+           ((uint32_t)(_mm_extract_epi16(sum, 0) / 64) << 0);
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+// Entry point
+
+extern void WebPAnimEncDspInitSSE2(void);
+
+WEBP_TSAN_IGNORE_FUNCTION void WebPAnimEncDspInitSSE2(void) {
+  WebPAnimFindFirstDiffLossless = FindFirstDiffLossless_SSE2;
+  WebPAnimFindFirstDiffLossy = FindFirstDiffLossy_SSE2;
+  WebPAnimFindLastDiffLossless = FindLastDiffLossless_SSE2;
+  WebPAnimFindLastDiffLossy = FindLastDiffLossy_SSE2;
+  WebPAnimCanBlendLossless = CanBlendLossless_SSE2;
+  WebPAnimCanBlendLossy = CanBlendLossy_SSE2;
+  WebPAnimIncreaseTransparency = IncreaseTransparency_SSE2;
+  WebPAnimIsSimilarBlock8x8 = IsSimilarBlock8x8_SSE2;
+}
+
+#else  // !WEBP_USE_SSE2
+
+WEBP_DSP_INIT_STUB(WebPAnimEncDspInitSSE2)
+
+#endif  // WEBP_USE_SSE2
@@ -120,6 +120,10 @@ static int x86CPUInfo(CPUFeature feature) {
   int cpu_info[4];
   int is_intel = 0;
 
+#if defined(WEBP_XTENSA_PIE_EMULATION)
+  if (feature == kXtensaPIE) return 1;
+#endif
+
   // get the highest feature value cpuid supports
   GetCPUInfo(cpu_info, 0);
   max_cpuid_value = cpu_info[0];
@@ -210,6 +214,9 @@ VP8CPUInfo VP8GetCPUInfo = wasmCPUInfo;
 // the configuration), but enables turning off NEON at runtime, for testing
 // purposes, by setting VP8GetCPUInfo = NULL.
 static int armCPUInfo(CPUFeature feature) {
+#if defined(WEBP_XTENSA_PIE_EMULATION)
+  if (feature == kXtensaPIE) return 1;
+#endif
   if (feature != kNEON) return 0;
 #if defined(__linux__) && defined(WEBP_HAVE_NEON_RTCD)
   {
@@ -245,6 +252,10 @@ static int mipsCPUInfo(CPUFeature feature) {
 }
 WEBP_EXTERN VP8CPUInfo VP8GetCPUInfo;
 VP8CPUInfo VP8GetCPUInfo = mipsCPUInfo;
+#elif defined(WEBP_USE_XTENSA_PIE)
+static int xtensaCPUInfo(CPUFeature feature) { return (feature == kXtensaPIE); }
+WEBP_EXTERN VP8CPUInfo VP8GetCPUInfo;
+VP8CPUInfo VP8GetCPUInfo = xtensaCPUInfo;
 #else
 WEBP_EXTERN VP8CPUInfo VP8GetCPUInfo;
 VP8CPUInfo VP8GetCPUInfo = NULL;
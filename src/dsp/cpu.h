@@ -170,6 +170,10 @@ static WEBP_INLINE int _mm256_cvtsi256_si32(__m256i a) {
 
 #if defined(__XTENSA__) && defined(CONFIG_IDF_TARGET_ESP32S3)
 #define WEBP_USE_XTENSA_PIE 1
+#elif defined(WEBP_XTENSA_PIE_EMULATION)
+// Runs the PIE code on other hosts through a C emulation of the instructions,
+// see xtensa_pie.h.
+#define WEBP_USE_XTENSA_PIE 1
 #endif
 
 //------------------------------------------------------------------------------
@@ -320,7 +324,8 @@ typedef enum {
   kNEON,
   kMIPS32,
   kMIPSdspR2,
-  kMSA
+  kMSA,
+  kXtensaPIE
 } CPUFeature;
 
 // returns true if the CPU supports the feature.
@@ -0,0 +1,106 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// Runtime cap on the SIMD level used by the DSP function pointers.
+//
+// The cap is applied by replacing VP8GetCPUInfo with a wrapper that hides the
+// features above the requested level. Each level has its own wrapper so that
+// every WEBP_DSP_INIT_FUNC() notices the change of VP8GetCPUInfo and re-runs
+// on its next call.
+
+#include <stddef.h>
+
+#include "src/dsp/cpu.h"
+#include "src/dsp/dsp.h"
+#include "src/webp/types.h"
+
+extern VP8CPUInfo VP8GetCPUInfo;
+
+// The detection function being capped: VP8GetCPUInfo as it was before the
+// first WebPSetDspLevel() call, or after a later external replacement.
+static VP8CPUInfo base_cpu_info = NULL;
+
+// Levels are only ordered within one architecture, so both the features and
+// the levels are ranked within their own instruction set family: 1 for the
+// base SIMD set (SSE2, NEON, MIPS32, ...), and higher for its extensions.
+static int GetFeatureRank(CPUFeature feature) {
+  switch (feature) {
+    case kSSE3:
+    case kSlowSSSE3:
+    case kSSE4_1:
+      return 2;
+    case kAVX:
+    case kAVX2:
+      return 3;
+    default:
+      return 1;
+  }
+}
+
+static int GetLevelRank(WebPDspLevel level) {
+  switch (level) {
+    case WEBP_DSP_LEVEL_C:
+      return 0;
+    case WEBP_DSP_LEVEL_SSE41:
+      return 2;
+    case WEBP_DSP_LEVEL_AVX2:
+      return 3;
+    default:
+      return 1;  // WEBP_DSP_LEVEL_SSE2, WEBP_DSP_LEVEL_NEON
+  }
+}
+
+static int CappedCPUInfo(CPUFeature feature, WebPDspLevel level) {
+  if (GetFeatureRank(feature) > GetLevelRank(level)) return 0;
+  return (base_cpu_info != NULL) && base_cpu_info(feature);
+}
+
+static int CPUInfoC(CPUFeature feature) {
+  return CappedCPUInfo(feature, WEBP_DSP_LEVEL_C);
+}
+static int CPUInfoSSE2(CPUFeature feature) {
+  return CappedCPUInfo(feature, WEBP_DSP_LEVEL_SSE2);
+}
+static int CPUInfoSSE41(CPUFeature feature) {
+  return CappedCPUInfo(feature, WEBP_DSP_LEVEL_SSE41);
+}
+static int CPUInfoAVX2(CPUFeature feature) {
+  return CappedCPUInfo(feature, WEBP_DSP_LEVEL_AVX2);
+}
+static int CPUInfoNEON(CPUFeature feature) {
+  return CappedCPUInfo(feature, WEBP_DSP_LEVEL_NEON);
+}
+
+// Indexed by WebPDspLevel.
+static const VP8CPUInfo kCappedCPUInfo[WEBP_DSP_LEVEL_AUTO] = {
+    CPUInfoC, CPUInfoSSE2, CPUInfoSSE41, CPUInfoAVX2, CPUInfoNEON};
+
+static int IsCapped(VP8CPUInfo cpu_info) {
+  int i;
+  for (i = 0; i < WEBP_DSP_LEVEL_AUTO; ++i) {
+    if (cpu_info == kCappedCPUInfo[i]) return 1;
+  }
+  return 0;
+}
+
+WEBP_TSAN_IGNORE_FUNCTION int WebPSetDspLevel(WebPDspLevel level) {
+  if ((int)level < WEBP_DSP_LEVEL_C || level > WEBP_DSP_LEVEL_AUTO) return 0;
+  if (!IsCapped(VP8GetCPUInfo)) base_cpu_info = VP8GetCPUInfo;
+  VP8GetCPUInfo =
+      (level == WEBP_DSP_LEVEL_AUTO) ? base_cpu_info : kCappedCPUInfo[level];
+  return 1;
+}
+
+WebPDspLevel WebPGetDspLevel(void) {
+  int i;
+  for (i = 0; i < WEBP_DSP_LEVEL_AUTO; ++i) {
+    if (VP8GetCPUInfo == kCappedCPUInfo[i]) return (WebPDspLevel)i;
+  }
+  return WEBP_DSP_LEVEL_AUTO;
+}
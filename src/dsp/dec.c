@@ -746,6 +746,7 @@ void (*VP8DitherCombine8x8)(const uint8_t* WEBP_RESTRICT dither,
 extern VP8CPUInfo VP8GetCPUInfo;
 extern void VP8DspInitSSE2(void);
 extern void VP8DspInitSSE41(void);
+extern void VP8DspInitAVX2(void);
 extern void VP8DspInitNEON(void);
 extern void VP8DspInitMIPS32(void);
 extern void VP8DspInitMIPSdspR2(void);
@@ -824,6 +825,11 @@ WEBP_DSP_INIT_FUNC(VP8DspInit) {
 #if defined(WEBP_HAVE_SSE41)
       if (VP8GetCPUInfo(kSSE4_1)) {
         VP8DspInitSSE41();
+#if defined(WEBP_HAVE_AVX2)
+        if (VP8GetCPUInfo(kAVX2)) {
+          VP8DspInitAVX2();
+        }
+#endif
       }
 #endif
     }
@@ -853,7 +859,9 @@ WEBP_DSP_INIT_FUNC(VP8DspInit) {
 #endif
 
 #if defined(WEBP_USE_XTENSA_PIE)
-  VP8DspInitXtensa();
+  if (VP8GetCPUInfo != NULL && VP8GetCPUInfo(kXtensaPIE)) {
+    VP8DspInitXtensa();
+  }
 #endif
 
   assert(VP8TransformWHT != NULL);
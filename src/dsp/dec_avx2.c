@@ -0,0 +1,557 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// AVX2 version of some decoding functions (idct, loop filtering, prediction).
+
+#include "src/dsp/dsp.h"
+
+#if defined(WEBP_USE_AVX2)
+#include <immintrin.h>
+
+#include "src/dec/vp8i_dec.h"
+#include "src/dsp/cpu.h"
+#include "src/utils/utils.h"
+#include "src/webp/types.h"
+
+//------------------------------------------------------------------------------
+// Transforms (Paragraph 14.4)
+
+// One 1-D pass of the transform. On input, 'in01' holds the coefficient rows
+// [in0 | in1] and 'in23' holds [in2 | in3], each 128-bit lane containing the
+// row of both blocks (A in the low, B in the high 64 bits). On output,
+// 'out01' holds [tmp0 | tmp1] and 'out32' holds [tmp3 | tmp2].
+// See Transform_SSE2() for the multiplication trick with k1 and k2.
+static WEBP_INLINE void TransformPass_AVX2(const __m256i* const in01,
+                                           const __m256i* const in23,
+                                           __m256i* const out01,
+                                           __m256i* const out32) {
+  // The constants only apply to the upper lane (in1 and in3).
+  const __m256i k1 = _mm256_setr_epi16(0, 0, 0, 0, 0, 0, 0, 0, 20091, 20091,
+                                       20091, 20091, 20091, 20091, 20091,
+                                       20091);
+  const __m256i k2 = _mm256_setr_epi16(0, 0, 0, 0, 0, 0, 0, 0, -30068, -30068,
+                                       -30068, -30068, -30068, -30068, -30068,
+                                       -30068);
+  // [in0 + in2 | in1 + in3] and [in0 - in2 | in1 - in3]
+  const __m256i sum = _mm256_add_epi16(*in01, *in23);
+  const __m256i diff = _mm256_sub_epi16(*in01, *in23);
+  // [a | d]: d = MUL(in1, k1) + MUL(in3, k2) + in1 + in3
+  const __m256i d1 = _mm256_mulhi_epi16(*in01, k1);
+  const __m256i d2 = _mm256_mulhi_epi16(*in23, k2);
+  const __m256i ad = _mm256_add_epi16(sum, _mm256_add_epi16(d1, d2));
+  // [b | c]: c = MUL(in1, k2) - MUL(in3, k1) + in1 - in3
+  const __m256i c1 = _mm256_mulhi_epi16(*in01, k2);
+  const __m256i c2 = _mm256_mulhi_epi16(*in23, k1);
+  const __m256i bc = _mm256_add_epi16(diff, _mm256_sub_epi16(c1, c2));
+  // [a | b] and [d | c]
+  const __m256i ab = _mm256_permute2x128_si256(ad, bc, 0x20);
+  const __m256i dc = _mm256_permute2x128_si256(ad, bc, 0x31);
+  *out01 = _mm256_add_epi16(ab, dc);
+  *out32 = _mm256_sub_epi16(ab, dc);
+}
+
+// Transposes the two 4x4 blocks held in [tmp0 | tmp1] and [tmp3 | tmp2] (as
+// output by TransformPass_AVX2) into [T0 | T1] and [T2 | T3].
+static WEBP_INLINE void Transpose_2_4x4_AVX2(const __m256i* const in01,
+                                             const __m256i* const in32,
+                                             __m256i* const out01,
+                                             __m256i* const out23) {
+  // [tmp2 | tmp3]
+  const __m256i in23 = _mm256_permute4x64_epi64(*in32, 0x4e);
+  // a00 a20 a01 a21 a02 a22 a03 a23 | a10 a30 a11 a31 a12 a32 a13 a33
+  // b00 b20 b01 b21 b02 b22 b03 b23 | b10 b30 b11 b31 b12 b32 b13 b33
+  const __m256i A = _mm256_unpacklo_epi16(*in01, in23);
+  const __m256i B = _mm256_unpackhi_epi16(*in01, in23);
+  // a00 a20 a01 a21 a02 a22 a03 a23 | b00 b20 b01 b21 b02 b22 b03 b23
+  // a10 a30 a11 a31 a12 a32 a13 a33 | b10 b30 b11 b31 b12 b32 b13 b33
+  const __m256i C0 = _mm256_permute2x128_si256(A, B, 0x20);
+  const __m256i C1 = _mm256_permute2x128_si256(A, B, 0x31);
+  // a00 a10 a20 a30 a01 a11 a21 a31 | b00 b10 b20 b30 b01 b11 b21 b31
+  // a02 a12 a22 a32 a03 a13 a23 a33 | b02 b12 b22 b32 b03 b13 b23 b33
+  const __m256i D0 = _mm256_unpacklo_epi16(C0, C1);
+  const __m256i D1 = _mm256_unpackhi_epi16(C0, C1);
+  // a00 a10 a20 a30 b00 b10 b20 b30 | a01 a11 a21 a31 b01 b11 b21 b31
+  // a02 a12 a22 a32 b02 b12 b22 b32 | a03 a13 a23 a33 b03 b13 b23 b33
+  *out01 = _mm256_permute4x64_epi64(D0, 0xd8);
+  *out23 = _mm256_permute4x64_epi64(D1, 0xd8);
+}
+
+static void Transform_AVX2(const int16_t* WEBP_RESTRICT in,
+                           uint8_t* WEBP_RESTRICT dst, int do_two) {
+  __m256i T01, T23;
+
+  // Load the coefficients and gather the rows of both blocks as
+  // [in0 | in1] and [in2 | in3]. In the case of only one transform, the
+  // second block is a copy of the first one that we'll never store.
+  {
+    // in0 in2 | in1 in3, for block A (resp. B)
+    const __m256i A = _mm256_permute4x64_epi64(
+        _mm256_loadu_si256((const __m256i*)&in[0]), 0xd8);
+    const __m256i B =
+        do_two ? _mm256_permute4x64_epi64(
+                     _mm256_loadu_si256((const __m256i*)&in[16]), 0xd8)
+               : A;
+    T01 = _mm256_unpacklo_epi64(A, B);
+    T23 = _mm256_unpackhi_epi64(A, B);
+  }
+
+  // Vertical pass and subsequent transpose.
+  {
+    __m256i tmp01, tmp32;
+    TransformPass_AVX2(&T01, &T23, &tmp01, &tmp32);
+    Transpose_2_4x4_AVX2(&tmp01, &tmp32, &T01, &T23);
+  }
+
+  // Horizontal pass and subsequent transpose.
+  {
+    // The rounder only applies to T0 (lower lane).
+    const __m256i four = _mm256_setr_epi16(4, 4, 4, 4, 4, 4, 4, 4, 0, 0, 0, 0,
+                                           0, 0, 0, 0);
+    const __m256i dc = _mm256_add_epi16(T01, four);
+    __m256i tmp01, tmp32;
+    TransformPass_AVX2(&dc, &T23, &tmp01, &tmp32);
+    tmp01 = _mm256_srai_epi16(tmp01, 3);
+    tmp32 = _mm256_srai_epi16(tmp32, 3);
+    Transpose_2_4x4_AVX2(&tmp01, &tmp32, &T01, &T23);
+  }
+
+  // Add inverse transform to 'dst' and store.
+  {
+    __m128i dst0, dst1, dst2, dst3;
+    __m256i out;
+    if (do_two) {
+      // Load eight bytes/pixels per line.
+      dst0 = _mm_loadl_epi64((__m128i*)(dst + 0 * BPS));
+      dst1 = _mm_loadl_epi64((__m128i*)(dst + 1 * BPS));
+      dst2 = _mm_loadl_epi64((__m128i*)(dst + 2 * BPS));
+      dst3 = _mm_loadl_epi64((__m128i*)(dst + 3 * BPS));
+    } else {
+      // Load four bytes/pixels per line.
+      dst0 = _mm_cvtsi32_si128(WebPMemToInt32(dst + 0 * BPS));
+      dst1 = _mm_cvtsi32_si128(WebPMemToInt32(dst + 1 * BPS));
+      dst2 = _mm_cvtsi32_si128(WebPMemToInt32(dst + 2 * BPS));
+      dst3 = _mm_cvtsi32_si128(WebPMemToInt32(dst + 3 * BPS));
+    }
+    {
+      // Convert to 16b as [row0 | row1] and [row2 | row3], matching T01/T23.
+      const __m256i d01 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(dst0, dst1));
+      const __m256i d23 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(dst2, dst3));
+      // Add the inverse transform(s) and convert back to 8b:
+      // row0 row2 | row1 row3
+      out = _mm256_packus_epi16(_mm256_add_epi16(d01, T01),
+                                _mm256_add_epi16(d23, T23));
+    }
+    {
+      const __m128i out02 = _mm256_castsi256_si128(out);
+      const __m128i out13 = _mm256_extracti128_si256(out, 1);
+      if (do_two) {
+        _mm_storel_epi64((__m128i*)(dst + 0 * BPS), out02);
+        _mm_storel_epi64((__m128i*)(dst + 1 * BPS), out13);
+        _mm_storel_epi64((__m128i*)(dst + 2 * BPS), _mm_srli_si128(out02, 8));
+        _mm_storel_epi64((__m128i*)(dst + 3 * BPS), _mm_srli_si128(out13, 8));
+      } else {
+        WebPInt32ToMem(dst + 0 * BPS, _mm_cvtsi128_si32(out02));
+        WebPInt32ToMem(dst + 1 * BPS, _mm_cvtsi128_si32(out13));
+        WebPInt32ToMem(dst + 2 * BPS,
+                       _mm_cvtsi128_si32(_mm_srli_si128(out02, 8)));
+        WebPInt32ToMem(dst + 3 * BPS,
+                       _mm_cvtsi128_si32(_mm_srli_si128(out13, 8)));
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Loop Filter (Paragraph 15)
+//
+// The complex filters work on pairs of rows [pi | qi] held in the two 128-bit
+// lanes of a register, so that the work on both sides of the edge is shared.
+
+// Compute abs(p - q) = subs(p - q) OR subs(q - p)
+#define MM_ABS(p, q) \
+  _mm_or_si128(_mm_subs_epu8((q), (p)), _mm_subs_epu8((p), (q)))
+#define MM256_ABS(p, q) \
+  _mm256_or_si256(_mm256_subs_epu8((q), (p)), _mm256_subs_epu8((p), (q)))
+
+static WEBP_INLINE __m256i MakePair_AVX2(const __m128i* const lo,
+                                         const __m128i* const hi) {
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(*lo), *hi, 1);
+}
+
+static WEBP_INLINE void SplitPair_AVX2(const __m256i* const pair,
+                                       __m128i* const lo, __m128i* const hi) {
+  *lo = _mm256_castsi256_si128(*pair);
+  *hi = _mm256_extracti128_si256(*pair, 1);
+}
+
+// Shift each byte of "x" by 3 bits while preserving by the sign bit.
+static WEBP_INLINE void SignedShift8b_AVX2(__m256i* const x) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i lo_0 = _mm256_unpacklo_epi8(zero, *x);
+  const __m256i hi_0 = _mm256_unpackhi_epi8(zero, *x);
+  const __m256i lo_1 = _mm256_srai_epi16(lo_0, 3 + 8);
+  const __m256i hi_1 = _mm256_srai_epi16(hi_0, 3 + 8);
+  *x = _mm256_packs_epi16(lo_1, hi_1);
+}
+
+// input pixels are uint8_t
+static WEBP_INLINE void NeedsFilter_AVX2(const __m128i* const p1,
+                                         const __m128i* const p0,
+                                         const __m128i* const q0,
+                                         const __m128i* const q1, int thresh,
+                                         __m128i* const mask) {
+  const __m128i m_thresh = _mm_set1_epi8((char)thresh);
+  const __m128i t1 = MM_ABS(*p1, *q1);  // abs(p1 - q1)
+  const __m128i kFE = _mm_set1_epi8((char)0xFE);
+  const __m128i t2 = _mm_and_si128(t1, kFE);  // set lsb of each byte to zero
+  const __m128i t3 = _mm_srli_epi16(t2, 1);   // abs(p1 - q1) / 2
+
+  const __m128i t4 = MM_ABS(*p0, *q0);       // abs(p0 - q0)
+  const __m128i t5 = _mm_adds_epu8(t4, t4);  // abs(p0 - q0) * 2
+  const __m128i t6 = _mm_adds_epu8(t5, t3);  // abs(p0-q0)*2 + abs(p1-q1)/2
+
+  const __m128i t7 = _mm_subs_epu8(t6, m_thresh);  // mask <= m_thresh
+  *mask = _mm_cmpeq_epi8(t7, _mm_setzero_si128());
+}
+
+// Applies the macroblock edge filter on the pairs [p3 | q3] ... [p0 | q0].
+// Pixels are uint8_t on input and output.
+static WEBP_INLINE void DoFilter6_AVX2(const __m256i* const p3q3,
+                                       __m256i* const p2q2,
+                                       __m256i* const p1q1,
+                                       __m256i* const p0q0, int thresh,
+                                       int ithresh, int hev_thresh) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m256i sign_bit = _mm256_set1_epi8((char)0x80);
+  // Negates the q-side (upper lane) when used with _mm256_sign_epi8().
+  const __m256i neg_q = _mm256_setr_epi8(
+      1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  __m128i mask, not_hev, a;
+
+  {  // compute the filter and hev masks
+    const __m256i d10 = MM256_ABS(*p1q1, *p0q0);
+    const __m256i d32 = MM256_ABS(*p3q3, *p2q2);
+    const __m256i d21 = MM256_ABS(*p2q2, *p1q1);
+    const __m256i max_diff = _mm256_max_epu8(d10, _mm256_max_epu8(d32, d21));
+    __m128i p1, p0, q0, q1, m_lo, m_hi, h_lo, h_hi, filter_mask;
+    SplitPair_AVX2(&max_diff, &m_lo, &m_hi);
+    SplitPair_AVX2(&d10, &h_lo, &h_hi);
+    SplitPair_AVX2(p1q1, &p1, &q1);
+    SplitPair_AVX2(p0q0, &p0, &q0);
+    {
+      const __m128i it = _mm_set1_epi8(ithresh);
+      const __m128i diff = _mm_subs_epu8(_mm_max_epu8(m_lo, m_hi), it);
+      NeedsFilter_AVX2(&p1, &p0, &q0, &q1, thresh, &filter_mask);
+      mask = _mm_and_si128(_mm_cmpeq_epi8(diff, zero), filter_mask);
+    }
+    {
+      const __m128i h = _mm_set1_epi8(hev_thresh);
+      const __m128i t_max_h = _mm_subs_epu8(_mm_max_epu8(h_lo, h_hi), h);
+      not_hev = _mm_cmpeq_epi8(t_max_h, zero);
+    }
+  }
+
+  *p2q2 = _mm256_xor_si256(*p2q2, sign_bit);
+  *p1q1 = _mm256_xor_si256(*p1q1, sign_bit);
+  *p0q0 = _mm256_xor_si256(*p0q0, sign_bit);
+  {
+    // beware of addition order, for saturation!
+    __m128i p1, p0, q0, q1;
+    SplitPair_AVX2(p1q1, &p1, &q1);
+    SplitPair_AVX2(p0q0, &p0, &q0);
+    {
+      const __m128i p1_q1 = _mm_subs_epi8(p1, q1);     // p1 - q1
+      const __m128i q0_p0 = _mm_subs_epi8(q0, p0);     // q0 - p0
+      const __m128i s1 = _mm_adds_epi8(p1_q1, q0_p0);  // p1 - q1 + 1 * (q0 - p0)
+      const __m128i s2 = _mm_adds_epi8(q0_p0, s1);     // p1 - q1 + 2 * (q0 - p0)
+      a = _mm_adds_epi8(q0_p0, s2);                    // p1 - q1 + 3 * (q0 - p0)
+    }
+  }
+
+  {  // do simple filter on pixels with hev: p0 += (f + 3) >> 3,
+     // q0 -= (f + 4) >> 3
+    const __m256i k34 = _mm256_setr_epi8(3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+                                         3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+                                         4, 4, 4, 4, 4, 4);
+    const __m128i m = _mm_andnot_si128(not_hev, mask);
+    const __m128i f = _mm_and_si128(a, m);
+    __m256i v = _mm256_adds_epi8(_mm256_broadcastsi128_si256(f), k34);
+    SignedShift8b_AVX2(&v);
+    *p0q0 = _mm256_adds_epi8(*p0q0, _mm256_sign_epi8(v, neg_q));
+  }
+
+  {  // do strong filter on pixels with not hev
+    const __m256i k9 = _mm256_set1_epi16(9);
+    const __m256i k63 = _mm256_set1_epi16(63);
+
+    const __m128i m = _mm_and_si128(not_hev, mask);
+    const __m128i f = _mm_and_si128(a, m);
+    const __m256i f16 = _mm256_cvtepi8_epi16(f);
+
+    const __m256i f9 = _mm256_mullo_epi16(f16, k9);  // Filter * 9
+    const __m256i a2 = _mm256_add_epi16(f9, k63);    // Filter * 9 + 63
+    const __m256i a1 = _mm256_add_epi16(a2, f9);     // Filter * 18 + 63
+    const __m256i a0 = _mm256_add_epi16(a1, f9);     // Filter * 27 + 63
+
+    // [delta2 | delta1] and [delta0 | delta0]
+    const __m256i d21 = _mm256_permute4x64_epi64(
+        _mm256_packs_epi16(_mm256_srai_epi16(a2, 7), _mm256_srai_epi16(a1, 7)),
+        0xd8);
+    const __m256i a0_7 = _mm256_srai_epi16(a0, 7);
+    const __m256i d00 =
+        _mm256_permute4x64_epi64(_mm256_packs_epi16(a0_7, a0_7), 0xd8);
+    // [delta | -delta], for p += delta and q -= delta
+    const __m256i d2 =
+        _mm256_sign_epi8(_mm256_permute4x64_epi64(d21, 0x44), neg_q);
+    const __m256i d1 =
+        _mm256_sign_epi8(_mm256_permute4x64_epi64(d21, 0xee), neg_q);
+    const __m256i d0 = _mm256_sign_epi8(d00, neg_q);
+    *p2q2 = _mm256_xor_si256(_mm256_adds_epi8(*p2q2, d2), sign_bit);
+    *p1q1 = _mm256_xor_si256(_mm256_adds_epi8(*p1q1, d1), sign_bit);
+    *p0q0 = _mm256_xor_si256(_mm256_adds_epi8(*p0q0, d0), sign_bit);
+  }
+}
+
+// reads 8 rows across a vertical edge.
+static WEBP_INLINE void Load8x4_AVX2(const uint8_t* const b, int stride,
+                                     __m128i* const p, __m128i* const q) {
+  // A0 = 63 62 61 60 23 22 21 20 43 42 41 40 03 02 01 00
+  // A1 = 73 72 71 70 33 32 31 30 53 52 51 50 13 12 11 10
+  const __m128i A0 = _mm_set_epi32(
+      WebPMemToInt32(&b[6 * stride]), WebPMemToInt32(&b[2 * stride]),
+      WebPMemToInt32(&b[4 * stride]), WebPMemToInt32(&b[0 * stride]));
+  const __m128i A1 = _mm_set_epi32(
+      WebPMemToInt32(&b[7 * stride]), WebPMemToInt32(&b[3 * stride]),
+      WebPMemToInt32(&b[5 * stride]), WebPMemToInt32(&b[1 * stride]));
+
+  // B0 = 53 43 52 42 51 41 50 40 13 03 12 02 11 01 10 00
+  // B1 = 73 63 72 62 71 61 70 60 33 23 32 22 31 21 30 20
+  const __m128i B0 = _mm_unpacklo_epi8(A0, A1);
+  const __m128i B1 = _mm_unpackhi_epi8(A0, A1);
+
+  // C0 = 33 23 13 03 32 22 12 02 31 21 11 01 30 20 10 00
+  // C1 = 73 63 53 43 72 62 52 42 71 61 51 41 70 60 50 40
+  const __m128i C0 = _mm_unpacklo_epi16(B0, B1);
+  const __m128i C1 = _mm_unpackhi_epi16(B0, B1);
+
+  // *p = 71 61 51 41 31 21 11 01 70 60 50 40 30 20 10 00
+  // *q = 73 63 53 43 33 23 13 03 72 62 52 42 32 22 12 02
+  *p = _mm_unpacklo_epi32(C0, C1);
+  *q = _mm_unpackhi_epi32(C0, C1);
+}
+
+// Loads 4 columns of 16 rows, see Load16x4_SSE2().
+static WEBP_INLINE void Load16x4_AVX2(const uint8_t* const r0,
+                                      const uint8_t* const r8, int stride,
+                                      __m128i* const p1, __m128i* const p0,
+                                      __m128i* const q0, __m128i* const q1) {
+  __m128i t1, t2;
+  Load8x4_AVX2(r0, stride, &t1, &t2);
+  Load8x4_AVX2(r8, stride, p0, q1);
+  *p1 = _mm_unpacklo_epi64(t1, *p0);
+  *p0 = _mm_unpackhi_epi64(t1, *p0);
+  *q0 = _mm_unpacklo_epi64(t2, *q1);
+  *q1 = _mm_unpackhi_epi64(t2, *q1);
+}
+
+static WEBP_INLINE void Store4x4_AVX2(__m128i* const x, uint8_t* dst,
+                                      int stride) {
+  int i;
+  for (i = 0; i < 4; ++i, dst += stride) {
+    WebPInt32ToMem(dst, _mm_cvtsi128_si32(*x));
+    *x = _mm_srli_si128(*x, 4);
+  }
+}
+
+// Transpose back and store 4 columns of 16 rows, see Store16x4_SSE2().
+static WEBP_INLINE void Store16x4_AVX2(const __m128i* const p1,
+                                       const __m128i* const p0,
+                                       const __m128i* const q0,
+                                       const __m128i* const q1, uint8_t* r0,
+                                       uint8_t* r8, int stride) {
+  const __m128i p0_s = _mm_unpacklo_epi8(*p1, *p0);
+  const __m128i p1_s = _mm_unpackhi_epi8(*p1, *p0);
+  const __m128i q0_s = _mm_unpacklo_epi8(*q0, *q1);
+  const __m128i q1_s = _mm_unpackhi_epi8(*q0, *q1);
+  __m128i r0_0 = _mm_unpacklo_epi16(p0_s, q0_s);
+  __m128i r0_4 = _mm_unpackhi_epi16(p0_s, q0_s);
+  __m128i r8_0 = _mm_unpacklo_epi16(p1_s, q1_s);
+  __m128i r8_4 = _mm_unpackhi_epi16(p1_s, q1_s);
+
+  Store4x4_AVX2(&r0_0, r0, stride);
+  Store4x4_AVX2(&r0_4, r0 + 4 * stride, stride);
+  Store4x4_AVX2(&r8_0, r8, stride);
+  Store4x4_AVX2(&r8_4, r8 + 4 * stride, stride);
+}
+
+#define LOAD_PAIR(p, lo, hi)                                   \
+  do {                                                         \
+    const __m128i LO = _mm_loadu_si128((const __m128i*)(lo)); \
+    const __m128i HI = _mm_loadu_si128((const __m128i*)(hi)); \
+    (p) = MakePair_AVX2(&LO, &HI);                             \
+  } while (0)
+
+#define STORE_PAIR(p, lo, hi)                                             \
+  do {                                                                    \
+    _mm_storeu_si128((__m128i*)(lo), _mm256_castsi256_si128(p));          \
+    _mm_storeu_si128((__m128i*)(hi), _mm256_extracti128_si256((p), 1));   \
+  } while (0)
+
+// Loads [u | v] rows 'lo' and 'hi' as a pair.
+#define LOADUV_PAIR(p, u, v, lo, hi)                                    \
+  do {                                                                  \
+    const __m128i LO =                                                  \
+        _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&(u)[(lo)]), \
+                           _mm_loadl_epi64((const __m128i*)&(v)[(lo)])); \
+    const __m128i HI =                                                  \
+        _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&(u)[(hi)]), \
+                           _mm_loadl_epi64((const __m128i*)&(v)[(hi)])); \
+    (p) = MakePair_AVX2(&LO, &HI);                                      \
+  } while (0)
+
+#define STOREUV_PAIR(p, u, v, lo, hi)                                 \
+  do {                                                                \
+    const __m128i LO = _mm256_castsi256_si128(p);                     \
+    const __m128i HI = _mm256_extracti128_si256((p), 1);              \
+    _mm_storel_epi64((__m128i*)&(u)[(lo)], LO);                       \
+    _mm_storel_epi64((__m128i*)&(v)[(lo)], _mm_srli_si128(LO, 8));    \
+    _mm_storel_epi64((__m128i*)&(u)[(hi)], HI);                       \
+    _mm_storel_epi64((__m128i*)&(v)[(hi)], _mm_srli_si128(HI, 8));    \
+  } while (0)
+
+// on macroblock edges
+static void VFilter16_AVX2(uint8_t* p, int stride, int thresh, int ithresh,
+                           int hev_thresh) {
+  __m256i p3q3, p2q2, p1q1, p0q0;
+
+  LOAD_PAIR(p3q3, p - 4 * stride, p + 3 * stride);
+  LOAD_PAIR(p2q2, p - 3 * stride, p + 2 * stride);
+  LOAD_PAIR(p1q1, p - 2 * stride, p + 1 * stride);
+  LOAD_PAIR(p0q0, p - 1 * stride, p + 0 * stride);
+
+  DoFilter6_AVX2(&p3q3, &p2q2, &p1q1, &p0q0, thresh, ithresh, hev_thresh);
+
+  STORE_PAIR(p2q2, p - 3 * stride, p + 2 * stride);
+  STORE_PAIR(p1q1, p - 2 * stride, p + 1 * stride);
+  STORE_PAIR(p0q0, p - 1 * stride, p + 0 * stride);
+}
+
+static void HFilter16_AVX2(uint8_t* p, int stride, int thresh, int ithresh,
+                           int hev_thresh) {
+  __m128i p3, p2, p1, p0, q0, q1, q2, q3;
+  __m256i p3q3, p2q2, p1q1, p0q0;
+
+  uint8_t* const b = p - 4;
+  Load16x4_AVX2(b, b + 8 * stride, stride, &p3, &p2, &p1, &p0);
+  Load16x4_AVX2(p, p + 8 * stride, stride, &q0, &q1, &q2, &q3);
+  p3q3 = MakePair_AVX2(&p3, &q3);
+  p2q2 = MakePair_AVX2(&p2, &q2);
+  p1q1 = MakePair_AVX2(&p1, &q1);
+  p0q0 = MakePair_AVX2(&p0, &q0);
+
+  DoFilter6_AVX2(&p3q3, &p2q2, &p1q1, &p0q0, thresh, ithresh, hev_thresh);
+
+  SplitPair_AVX2(&p2q2, &p2, &q2);
+  SplitPair_AVX2(&p1q1, &p1, &q1);
+  SplitPair_AVX2(&p0q0, &p0, &q0);
+  Store16x4_AVX2(&p3, &p2, &p1, &p0, b, b + 8 * stride, stride);
+  Store16x4_AVX2(&q0, &q1, &q2, &q3, p, p + 8 * stride, stride);
+}
+
+// 8-pixels wide variant, for chroma filtering
+static void VFilter8_AVX2(uint8_t* WEBP_RESTRICT u, uint8_t* WEBP_RESTRICT v,
+                          int stride, int thresh, int ithresh, int hev_thresh) {
+  __m256i p3q3, p2q2, p1q1, p0q0;
+
+  LOADUV_PAIR(p3q3, u, v, -4 * stride, 3 * stride);
+  LOADUV_PAIR(p2q2, u, v, -3 * stride, 2 * stride);
+  LOADUV_PAIR(p1q1, u, v, -2 * stride, 1 * stride);
+  LOADUV_PAIR(p0q0, u, v, -1 * stride, 0 * stride);
+
+  DoFilter6_AVX2(&p3q3, &p2q2, &p1q1, &p0q0, thresh, ithresh, hev_thresh);
+
+  STOREUV_PAIR(p2q2, u, v, -3 * stride, 2 * stride);
+  STOREUV_PAIR(p1q1, u, v, -2 * stride, 1 * stride);
+  STOREUV_PAIR(p0q0, u, v, -1 * stride, 0 * stride);
+}
+
+static void HFilter8_AVX2(uint8_t* WEBP_RESTRICT u, uint8_t* WEBP_RESTRICT v,
+                          int stride, int thresh, int ithresh, int hev_thresh) {
+  __m128i p3, p2, p1, p0, q0, q1, q2, q3;
+  __m256i p3q3, p2q2, p1q1, p0q0;
+
+  uint8_t* const tu = u - 4;
+  uint8_t* const tv = v - 4;
+  Load16x4_AVX2(tu, tv, stride, &p3, &p2, &p1, &p0);
+  Load16x4_AVX2(u, v, stride, &q0, &q1, &q2, &q3);
+  p3q3 = MakePair_AVX2(&p3, &q3);
+  p2q2 = MakePair_AVX2(&p2, &q2);
+  p1q1 = MakePair_AVX2(&p1, &q1);
+  p0q0 = MakePair_AVX2(&p0, &q0);
+
+  DoFilter6_AVX2(&p3q3, &p2q2, &p1q1, &p0q0, thresh, ithresh, hev_thresh);
+
+  SplitPair_AVX2(&p2q2, &p2, &q2);
+  SplitPair_AVX2(&p1q1, &p1, &q1);
+  SplitPair_AVX2(&p0q0, &p0, &q0);
+  Store16x4_AVX2(&p3, &p2, &p1, &p0, tu, tv, stride);
+  Store16x4_AVX2(&q0, &q1, &q2, &q3, u, v, stride);
+}
+
+#undef LOAD_PAIR
+#undef STORE_PAIR
+#undef LOADUV_PAIR
+#undef STOREUV_PAIR
+
+//------------------------------------------------------------------------------
+// Intra predictions (Paragraph 12.3)
+//
+// The prediction rows are only 16 bytes wide within the BPS stride, so two
+// rows are computed per register rather than one 32-byte row.
+
+static void TM16_AVX2(uint8_t* dst) {
+  const uint8_t* top = dst - BPS;
+  const __m256i top_base =
+      _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)top));
+  int y;
+  for (y = 0; y < 16; y += 2, dst += 2 * BPS) {
+    const __m256i base0 = _mm256_set1_epi16(dst[-1] - top[-1]);
+    const __m256i base1 = _mm256_set1_epi16(dst[BPS - 1] - top[-1]);
+    const __m256i out0 = _mm256_add_epi16(base0, top_base);
+    const __m256i out1 = _mm256_add_epi16(base1, top_base);
+    // row0 | row1
+    const __m256i out =
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(out0, out1), 0xd8);
+    _mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(out));
+    _mm_storeu_si128((__m128i*)(dst + BPS), _mm256_extracti128_si256(out, 1));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Entry point
+
+extern void VP8DspInitAVX2(void);
+
+WEBP_TSAN_IGNORE_FUNCTION void VP8DspInitAVX2(void) {
+  VP8Transform = Transform_AVX2;
+
+  VP8VFilter16 = VFilter16_AVX2;
+  VP8HFilter16 = HFilter16_AVX2;
+  VP8VFilter8 = VFilter8_AVX2;
+  VP8HFilter8 = HFilter8_AVX2;
+
+  VP8PredLuma16[1] = TM16_AVX2;
+}
+
+#else  // !WEBP_USE_AVX2
+
+WEBP_DSP_INIT_STUB(VP8DspInitAVX2)
+
+#endif  // WEBP_USE_AVX2
@@ -4,231 +4,1135 @@
 //
 // This implements SIMD-accelerated DSP functions using the Xtensa
 // Processor Instruction Extensions (PIE) available on ESP32-S3.
+//
+// The pixels are processed as 16-bit lanes. The coefficients and the filtered
+// pixels (which live in the row cache right after the VP8MBData array) are
+// only 4-byte aligned, so the Q registers are filled and emptied 32 bits at a
+// time with PIE_MOVI_32_Q() / PIE_MOVI_32_A(). The 16x16 and 8x8 predictors
+// use 64-bit accesses: their rows in yuv_b are 8-byte aligned.
 
 #include "src/dsp/dsp.h"
 
 #if defined(WEBP_USE_XTENSA_PIE)
 
-#include <assert.h>
 #include <string.h>
 #include "src/dsp/xtensa_pie.h"
 #include "src/dec/vp8i_dec.h"
 
 //------------------------------------------------------------------------------
-// Transform constants
+// Constants, broadcast with PIE_VLDBC_16()
+
+static const int16_t kOne = 1;
+static const int16_t kTwo = 2;
+static const int16_t kThree = 3;
+static const int16_t kFour = 4;
+static const int16_t k255 = 255;
+static const int16_t kMinus16 = -16;
+static const int16_t k15 = 15;
+static const int16_t kMinus128 = -128;
+static const int16_t k127 = 127;
+static const int16_t k63 = 63;
+// MUL1(x) = x + ((x * kC1) >> 16) and MUL2(x) = x + ((x * kC2) >> 16), with
+// kC2 = WEBP_TRANSFORM_AC3_C2 - 65536 to fit in 16 bits.
+static const int16_t kC1 = WEBP_TRANSFORM_AC3_C1;
+static const int16_t kC2 = WEBP_TRANSFORM_AC3_C2 - 65536;
+
+// Clamps the lanes of 'qreg' to [0, 255], using 'tmp'.
+#define CLIP_8B(qreg, tmp) do {          \
+    PIE_VZERO(tmp);                      \
+    PIE_VMAX_S16(qreg, qreg, tmp);       \
+    PIE_VLDBC_16(tmp, &k255);            \
+    PIE_VMIN_S16(qreg, qreg, tmp);       \
+} while (0)
 
-#define kC1 WEBP_TRANSFORM_AC3_C1  // 20091
-#define kC2 WEBP_TRANSFORM_AC3_C2  // 35468
+// Clamps the lanes of 'qreg' to [lo, hi], using 'tmp'.
+#define CLAMP(qreg, lo, hi, tmp) do {    \
+    PIE_VLDBC_16(tmp, &(lo));            \
+    PIE_VMAX_S16(qreg, qreg, tmp);       \
+    PIE_VLDBC_16(tmp, &(hi));            \
+    PIE_VMIN_S16(qreg, qreg, tmp);       \
+} while (0)
 
 //------------------------------------------------------------------------------
-// Helper functions
+// Transforms
+
+// Adds the residuals of rows 'y' and 'y + 1' (in 'qa' and 'qb', 4 pixels per
+// block) to dst. Uses q0, q4, q6 and q7.
+#define ADD_ROWS(qa, qb, y) do {                                          \
+    uint8_t* const d0 = dst + (y) * BPS;                                  \
+    uint8_t* const d1 = d0 + BPS;                                         \
+    uint32_t w;                                                           \
+    PIE_MOVI_32_Q(q0, pie_load_32(d0), 0);                                \
+    PIE_MOVI_32_Q(q0, do_two ? pie_load_32(d0 + 4) : 0, 1);               \
+    PIE_MOVI_32_Q(q0, pie_load_32(d1), 2);                                \
+    PIE_MOVI_32_Q(q0, do_two ? pie_load_32(d1 + 4) : 0, 3);               \
+    PIE_VZERO(q4);                                                        \
+    PIE_VZIP_8(q0, q4);                                                   \
+    PIE_VADDS_S16(q0, q0, qa);                                            \
+    PIE_VADDS_S16(q4, q4, qb);                                            \
+    PIE_VMAX_S16(q0, q0, q6);                                             \
+    PIE_VMIN_S16(q0, q0, q7);                                             \
+    PIE_VMAX_S16(q4, q4, q6);                                             \
+    PIE_VMIN_S16(q4, q4, q7);                                             \
+    PIE_VUNZIP_8(q0, q4);                                                 \
+    PIE_MOVI_32_A(q0, w, 0);                                              \
+    pie_store_32(d0, w);                                                  \
+    PIE_MOVI_32_A(q0, w, 2);                                              \
+    pie_store_32(d1, w);                                                  \
+    if (do_two) {                                                         \
+        PIE_MOVI_32_A(q0, w, 1);                                          \
+        pie_store_32(d0 + 4, w);                                          \
+        PIE_MOVI_32_A(q0, w, 3);                                          \
+        pie_store_32(d1 + 4, w);                                          \
+    }                                                                     \
+} while (0)
+
+// Inverse transform of one block, or of the two side by side blocks 'in' and
+// 'in + 16' if 'do_two' is set. Each register holds a row of both blocks:
+// lanes 0..3 for the first one and lanes 4..7 for the second one.
+static void TransformTwo_Xtensa(const int16_t* WEBP_RESTRICT in,
+                                 uint8_t* WEBP_RESTRICT dst, int do_two) {
+    int k;
+
+    // Load the rows of coefficients in q0..q3.
+#define LOAD_COEFFS(qreg, k) do {                                          \
+    PIE_MOVI_32_Q(qreg, pie_load_32(in + 4 * (k)), 0);                     \
+    PIE_MOVI_32_Q(qreg, pie_load_32(in + 4 * (k) + 2), 1);                 \
+    PIE_MOVI_32_Q(qreg, do_two ? pie_load_32(in + 16 + 4 * (k)) : 0, 2);   \
+    PIE_MOVI_32_Q(qreg, do_two ? pie_load_32(in + 18 + 4 * (k)) : 0, 3);   \
+} while (0)
+    LOAD_COEFFS(q0, 0);
+    LOAD_COEFFS(q1, 1);
+    LOAD_COEFFS(q2, 2);
+    LOAD_COEFFS(q3, 3);
+#undef LOAD_COEFFS
 
-static WEBP_INLINE uint8_t clip_8b(int v) {
-    return (!(v & ~0xff)) ? v : (v < 0) ? 0 : 255;
+    // Vertical pass.
+    PIE_VADDS_S16(q4, q0, q2);           // a = in0 + in8
+    PIE_VSUBS_S16(q0, q0, q2);           // b = in0 - in8
+    PIE_VLDBC_16(q5, &kC1);
+    PIE_VMUL_S16(q2, q1, q5, 16);
+    PIE_VADDS_S16(q2, q2, q1);           // MUL1(in4)
+    PIE_VMUL_S16(q6, q3, q5, 16);
+    PIE_VADDS_S16(q6, q6, q3);           // MUL1(in12)
+    PIE_VLDBC_16(q5, &kC2);
+    PIE_VMUL_S16(q7, q1, q5, 16);
+    PIE_VADDS_S16(q1, q1, q7);           // MUL2(in4)
+    PIE_VMUL_S16(q7, q3, q5, 16);
+    PIE_VADDS_S16(q3, q3, q7);           // MUL2(in12)
+    PIE_VSUBS_S16(q1, q1, q6);           // c = MUL2(in4) - MUL1(in12)
+    PIE_VADDS_S16(q2, q2, q3);           // d = MUL1(in4) + MUL2(in12)
+    PIE_VADDS_S16(q3, q4, q2);           // tmp0 = a + d
+    PIE_VSUBS_S16(q4, q4, q2);           // tmp3 = a - d
+    PIE_VADDS_S16(q2, q0, q1);           // tmp1 = b + c
+    PIE_VSUBS_S16(q0, q0, q1);           // tmp2 = b - c
+
+    // Transpose the two 4x4 blocks: q3, q0, q2, q4 get the columns 0..3.
+    PIE_VUNZIP_16(q3, q0);
+    PIE_VUNZIP_16(q2, q4);
+    PIE_VUNZIP_16(q3, q2);
+    PIE_VUNZIP_16(q0, q4);
+
+    // Horizontal pass.
+    PIE_VLDBC_16(q5, &kFour);
+    PIE_VADDS_S16(q3, q3, q5);           // dc = tmp0 + 4
+    PIE_VADDS_S16(q5, q3, q2);           // a = dc + tmp8
+    PIE_VSUBS_S16(q3, q3, q2);           // b = dc - tmp8
+    PIE_VLDBC_16(q6, &kC1);
+    PIE_VMUL_S16(q2, q0, q6, 16);
+    PIE_VADDS_S16(q2, q2, q0);           // MUL1(tmp4)
+    PIE_VMUL_S16(q7, q4, q6, 16);
+    PIE_VADDS_S16(q7, q7, q4);           // MUL1(tmp12)
+    PIE_VLDBC_16(q6, &kC2);
+    PIE_VMUL_S16(q1, q0, q6, 16);
+    PIE_VADDS_S16(q0, q0, q1);           // MUL2(tmp4)
+    PIE_VMUL_S16(q1, q4, q6, 16);
+    PIE_VADDS_S16(q4, q4, q1);           // MUL2(tmp12)
+    PIE_VSUBS_S16(q0, q0, q7);           // c
+    PIE_VADDS_S16(q2, q2, q4);           // d
+    PIE_VADDS_S16(q1, q5, q2);           // a + d
+    PIE_VSUBS_S16(q5, q5, q2);           // a - d
+    PIE_VADDS_S16(q2, q3, q0);           // b + c
+    PIE_VSUBS_S16(q3, q3, q0);           // b - c
+    PIE_VLDBC_16(q0, &kOne);
+    PIE_VMUL_S16(q1, q1, q0, 3);
+    PIE_VMUL_S16(q2, q2, q0, 3);
+    PIE_VMUL_S16(q3, q3, q0, 3);
+    PIE_VMUL_S16(q5, q5, q0, 3);
+
+    // Transpose back: q1, q3, q2, q5 get the rows 0..3 of pixels.
+    PIE_VZIP_16(q1, q3);
+    PIE_VZIP_16(q2, q5);
+    PIE_VZIP_16(q1, q2);
+    PIE_VZIP_16(q3, q5);
+
+    PIE_VZERO(q6);
+    PIE_VLDBC_16(q7, &k255);
+    k = 0;
+    ADD_ROWS(q1, q3, k);
+    k = 2;
+    ADD_ROWS(q2, q5, k);
 }
 
-#define STORE(x, y, v) \
-    dst[(x) + (y) * BPS] = clip_8b(dst[(x) + (y) * BPS] + ((v) >> 3))
+#undef ADD_ROWS
 
-//------------------------------------------------------------------------------
-// DC-only Transform (simplified case for smooth areas)
-//
-// When only the DC coefficient is non-zero, we just add a constant
-// to all 16 pixels of the 4x4 block.
+static void TransformAC3_Xtensa(const int16_t* WEBP_RESTRICT in,
+                                 uint8_t* WEBP_RESTRICT dst) {
+    // Going through the full transform gives the same results.
+    PIE_ALIGNED_ARRAY(int16_t, coeffs, 16);
+    memset(coeffs, 0, sizeof(coeffs));
+    coeffs[0] = in[0];
+    coeffs[1] = in[1];
+    coeffs[4] = in[4];
+    TransformTwo_Xtensa(coeffs, dst, 0);
+}
 
 static void TransformDC_Xtensa(const int16_t* WEBP_RESTRICT in,
                                 uint8_t* WEBP_RESTRICT dst) {
-    const int DC = in[0] + 4;
-    const int dc_value = DC >> 3;
-    int i, j;
+    const int16_t DC = (in[0] + 4) >> 3;
+    uint32_t w;
+    int j;
 
-    // For small DC values, use PIE for parallel processing
-    // Each row is 4 pixels at dst + j*BPS
     for (j = 0; j < 4; ++j) {
-        for (i = 0; i < 4; ++i) {
-            const int v = dst[i + j * BPS] + dc_value;
-            dst[i + j * BPS] = clip_8b(v);
+        const uint32_t row = pie_load_32(dst + j * BPS);
+        switch (j) {
+            case 0: PIE_MOVI_32_Q(q0, row, 0); break;
+            case 1: PIE_MOVI_32_Q(q0, row, 1); break;
+            case 2: PIE_MOVI_32_Q(q0, row, 2); break;
+            default: PIE_MOVI_32_Q(q0, row, 3); break;
         }
     }
+    PIE_VZERO(q1);
+    PIE_VZIP_8(q0, q1);
+    PIE_VLDBC_16(q2, &DC);
+    PIE_VADDS_S16(q0, q0, q2);
+    PIE_VADDS_S16(q1, q1, q2);
+    CLIP_8B(q0, q3);
+    CLIP_8B(q1, q3);
+    PIE_VUNZIP_8(q0, q1);
+    PIE_MOVI_32_A(q0, w, 0);
+    pie_store_32(dst + 0 * BPS, w);
+    PIE_MOVI_32_A(q0, w, 1);
+    pie_store_32(dst + 1 * BPS, w);
+    PIE_MOVI_32_A(q0, w, 2);
+    pie_store_32(dst + 2 * BPS, w);
+    PIE_MOVI_32_A(q0, w, 3);
+    pie_store_32(dst + 3 * BPS, w);
 }
 
-//------------------------------------------------------------------------------
-// Full 4x4 Inverse DCT Transform
-//
-// This is the main transform used for VP8 decoding. It takes 16 int16_t
-// coefficients and adds the inverse DCT to a 4x4 block of uint8_t pixels.
-//
-// The algorithm:
-// 1. Vertical pass: Process 4 columns
-// 2. Horizontal pass: Process 4 rows
-// 3. Add to destination with clipping to [0,255]
-
-static void TransformOne_Xtensa(const int16_t* WEBP_RESTRICT in,
-                                 uint8_t* WEBP_RESTRICT dst) {
-    int C[4 * 4], *tmp;
+// Walsh-Hadamard Transform (used for DC coefficients of 16 blocks). The
+// halves of the registers are exchanged through an aligned buffer.
+static void TransformWHT_Xtensa(const int16_t* WEBP_RESTRICT in,
+                                 int16_t* WEBP_RESTRICT out) {
+    static const PIE_ALIGNED_ARRAY(int16_t, kRound, 8) =
+        { 3, 3, 3, 3, 0, 0, 0, 0 };
+    PIE_ALIGNED_ARRAY(int16_t, buf, 16);
+    const int16_t* src = buf;
+    const int16_t* src2 = buf + 8;
+    const int16_t* round = kRound;
+    int16_t* dst = buf;
     int i;
 
-    // Vertical pass
-    tmp = C;
-    for (i = 0; i < 4; ++i) {
-        const int a = in[0] + in[8];
-        const int b = in[0] - in[8];
-        const int c = WEBP_TRANSFORM_AC3_MUL2(in[4]) -
-                      WEBP_TRANSFORM_AC3_MUL1(in[12]);
-        const int d = WEBP_TRANSFORM_AC3_MUL1(in[4]) +
-                      WEBP_TRANSFORM_AC3_MUL2(in[12]);
-        tmp[0] = a + d;
-        tmp[1] = b + c;
-        tmp[2] = b - c;
-        tmp[3] = a - d;
-        tmp += 4;
-        in++;
-    }
-
-    // Horizontal pass
-    tmp = C;
+    // 'in' is only 2-byte aligned. Rows 0 and 3, 1 and 2 face each other.
+    memcpy(buf + 0, in + 0, 8 * sizeof(*in));
+    memcpy(buf + 8, in + 12, 4 * sizeof(*in));
+    memcpy(buf + 12, in + 8, 4 * sizeof(*in));
+    PIE_VLD_128(q0, src);
+    PIE_VLD_128(q1, src2);
+
+    // Vertical pass.
+    PIE_VADDS_S16(q2, q0, q1);           // a0 | a1
+    PIE_VSUBS_S16(q3, q0, q1);           // a3 | a2
+    PIE_VST_L_64(q2, buf + 0);
+    PIE_VST_L_64(q3, buf + 4);
+    PIE_VST_H_64(q2, buf + 8);
+    PIE_VST_H_64(q3, buf + 12);
+    PIE_VLD_128(q0, src);                // a0 | a3
+    PIE_VLD_128(q1, src2);               // a1 | a2
+    PIE_VADDS_S16(q2, q0, q1);           // tmp rows 0 | 1
+    PIE_VSUBS_S16(q3, q0, q1);           // tmp rows 2 | 3
+
+    // Transpose: q2 gets the columns 0 | 1, q3 the columns 3 | 2.
+    PIE_VZIP_16(q2, q3);
+    PIE_VZIP_16(q2, q3);
+    PIE_VST_H_64(q3, buf + 0);
+    PIE_VST_L_64(q3, buf + 4);
+    PIE_VLD_128(q3, src);
+
+    // Horizontal pass.
+    PIE_VLD_128(q4, round);
+    PIE_VADDS_S16(q2, q2, q4);           // dc = tmp[0] + 3
+    PIE_VADDS_S16(q0, q2, q3);           // a0 | a1
+    PIE_VSUBS_S16(q1, q2, q3);           // a3 | a2
+    PIE_VST_L_64(q0, buf + 0);
+    PIE_VST_L_64(q1, buf + 4);
+    PIE_VST_H_64(q0, buf + 8);
+    PIE_VST_H_64(q1, buf + 12);
+    PIE_VLD_128(q0, src);                // a0 | a3
+    PIE_VLD_128(q1, src2);               // a1 | a2
+    PIE_VADDS_S16(q2, q0, q1);           // out[0] | out[16]
+    PIE_VSUBS_S16(q3, q0, q1);           // out[32] | out[48]
+    PIE_VLDBC_16(q4, &kOne);
+    PIE_VMUL_S16(q2, q2, q4, 3);
+    PIE_VMUL_S16(q3, q3, q4, 3);
+    PIE_VST_128_IP(q2, dst);
+    PIE_VST_128(q3, dst);
+
     for (i = 0; i < 4; ++i) {
-        const int dc = tmp[0] + 4;
-        const int a = dc + tmp[8];
-        const int b = dc - tmp[8];
-        const int c = WEBP_TRANSFORM_AC3_MUL2(tmp[4]) -
-                      WEBP_TRANSFORM_AC3_MUL1(tmp[12]);
-        const int d = WEBP_TRANSFORM_AC3_MUL1(tmp[4]) +
-                      WEBP_TRANSFORM_AC3_MUL2(tmp[12]);
-        STORE(0, 0, a + d);
-        STORE(1, 0, b + c);
-        STORE(2, 0, b - c);
-        STORE(3, 0, a - d);
-        tmp++;
-        dst += BPS;
+        out[0] = buf[i + 0];
+        out[16] = buf[i + 4];
+        out[32] = buf[i + 8];
+        out[48] = buf[i + 12];
+        out += 64;
     }
 }
 
 //------------------------------------------------------------------------------
-// Transform for AC3 case (only coefficients 0, 1, 4 are non-zero)
-
-#define STORE2(y, dc, d, c) do { \
-    const int DC = (dc);         \
-    STORE(0, y, DC + (d));       \
-    STORE(1, y, DC + (c));       \
-    STORE(2, y, DC - (c));       \
-    STORE(3, y, DC - (d));       \
+// Loop filters
+//
+// The filtered lines are processed 8 at a time, one per lane. Their pixels
+// p3..q3 across the edge are widened and stored in the rows of the 'px'
+// buffer, which the filters update in place before they are written back.
+
+enum { P3 = 0, P2, P1, P0, Q0, Q1, Q2, Q3 };
+
+#define LOAD_ROW(qreg, r) do {                     \
+    const int16_t* pie_row = px + 8 * (r);         \
+    PIE_VLD_128(qreg, pie_row);                    \
 } while (0)
 
-static void TransformAC3_Xtensa(const int16_t* WEBP_RESTRICT in,
-                                 uint8_t* WEBP_RESTRICT dst) {
-    const int a = in[0] + 4;
-    const int c4 = WEBP_TRANSFORM_AC3_MUL2(in[4]);
-    const int d4 = WEBP_TRANSFORM_AC3_MUL1(in[4]);
-    const int c1 = WEBP_TRANSFORM_AC3_MUL2(in[1]);
-    const int d1 = WEBP_TRANSFORM_AC3_MUL1(in[1]);
-    STORE2(0, a + d4, d1, c1);
-    STORE2(1, a + c4, d1, c1);
-    STORE2(2, a - c4, d1, c1);
-    STORE2(3, a - d4, d1, c1);
-}
+#define STORE_ROW(qreg, r) do {                    \
+    int16_t* pie_row = px + 8 * (r);               \
+    PIE_VST_128(qreg, pie_row);                    \
+} while (0)
 
-#undef STORE2
+// a = |a - b|, using 'tmp'.
+#define ABS_DIFF(a, b, tmp) do {                   \
+    PIE_VSUBS_S16(tmp, a, b);                      \
+    PIE_VSUBS_S16(a, b, a);                        \
+    PIE_VMAX_S16(a, a, tmp);                       \
+} while (0)
 
-//------------------------------------------------------------------------------
-// Two-transform wrapper
+// old = mask ? new : old, using 'tmp'.
+#define SELECT(old, new, mask, tmp) do {           \
+    PIE_XORQ(tmp, old, new);                       \
+    PIE_ANDQ(tmp, tmp, mask);                      \
+    PIE_XORQ(old, old, tmp);                       \
+} while (0)
 
-static void TransformTwo_Xtensa(const int16_t* WEBP_RESTRICT in,
-                                 uint8_t* WEBP_RESTRICT dst, int do_two) {
-    TransformOne_Xtensa(in, dst);
-    if (do_two) {
-        TransformOne_Xtensa(in + 16, dst + 4);
+// Loads the rows [first, last) of pixels across an horizontal edge, 8 pixels
+// each. 'p' points to the first pixel of row Q0. The number of rows is even.
+static void LoadV_Xtensa(const uint8_t* p, int stride, int first, int last,
+                         int16_t* px) {
+    int r;
+    for (r = first; r < last; r += 2) {
+        const uint8_t* const a = p + (r - Q0) * stride;
+        const uint8_t* const b = a + stride;
+        int16_t* row = px + 8 * r;
+        PIE_MOVI_32_Q(q0, pie_load_32(a), 0);
+        PIE_MOVI_32_Q(q0, pie_load_32(a + 4), 1);
+        PIE_MOVI_32_Q(q0, pie_load_32(b), 2);
+        PIE_MOVI_32_Q(q0, pie_load_32(b + 4), 3);
+        PIE_VZERO(q1);
+        PIE_VZIP_8(q0, q1);
+        PIE_VST_128_IP(q0, row);
+        PIE_VST_128(q1, row);
     }
 }
 
-//------------------------------------------------------------------------------
-// Walsh-Hadamard Transform (used for DC coefficients of 16 blocks)
+static void StoreV_Xtensa(uint8_t* p, int stride, int first, int last,
+                          const int16_t* px) {
+    int r;
+    for (r = first; r < last; r += 2) {
+        uint8_t* const a = p + (r - Q0) * stride;
+        uint8_t* const b = a + stride;
+        const int16_t* row = px + 8 * r;
+        uint32_t w;
+        PIE_VLD_128_IP(q0, row);
+        PIE_VLD_128(q1, row);
+        PIE_VUNZIP_8(q0, q1);
+        PIE_MOVI_32_A(q0, w, 0);
+        pie_store_32(a, w);
+        PIE_MOVI_32_A(q0, w, 1);
+        pie_store_32(a + 4, w);
+        PIE_MOVI_32_A(q0, w, 2);
+        pie_store_32(b, w);
+        PIE_MOVI_32_A(q0, w, 3);
+        pie_store_32(b + 4, w);
+    }
+}
 
-static void TransformWHT_Xtensa(const int16_t* WEBP_RESTRICT in,
-                                 int16_t* WEBP_RESTRICT out) {
-    int tmp[16];
-    int i;
+// Loads the 8 pixels p3..q3 of 8 lines across a vertical edge. 'p' points to
+// the pixel p3 of the first line. The 8x8 transposition leaves the lines in
+// the lane order 0, 1, 4, 5, 2, 3, 6, 7, which StoreH_Xtensa() undoes.
+static void LoadH_Xtensa(const uint8_t* p, int stride, int16_t* px) {
+    int16_t* row = px;
+#define LOAD_LINES(qreg, y) do {                                      \
+    PIE_MOVI_32_Q(qreg, pie_load_32(p + (y) * stride), 0);            \
+    PIE_MOVI_32_Q(qreg, pie_load_32(p + (y) * stride + 4), 1);        \
+    PIE_MOVI_32_Q(qreg, pie_load_32(p + ((y) + 1) * stride), 2);      \
+    PIE_MOVI_32_Q(qreg, pie_load_32(p + ((y) + 1) * stride + 4), 3);  \
+} while (0)
+    LOAD_LINES(q0, 0);
+    LOAD_LINES(q1, 2);
+    LOAD_LINES(q2, 4);
+    LOAD_LINES(q3, 6);
+#undef LOAD_LINES
+    PIE_VZIP_8(q0, q1);
+    PIE_VZIP_8(q2, q3);
+    PIE_VZIP_8(q0, q2);
+    PIE_VZIP_8(q1, q3);
+    PIE_VZIP_8(q0, q1);
+    PIE_VZIP_8(q2, q3);
+    // q0..q3 hold the columns (p3, p2), (p1, p0), (q0, q1), (q2, q3).
+#define WIDEN_COLUMNS(qreg) do {     \
+    PIE_VZERO(q4);                   \
+    PIE_VZIP_8(qreg, q4);            \
+    PIE_VST_128_IP(qreg, row);       \
+    PIE_VST_128_IP(q4, row);         \
+} while (0)
+    WIDEN_COLUMNS(q0);
+    WIDEN_COLUMNS(q1);
+    WIDEN_COLUMNS(q2);
+    WIDEN_COLUMNS(q3);
+#undef WIDEN_COLUMNS
+}
 
-    // Vertical pass
-    for (i = 0; i < 4; ++i) {
-        const int a0 = in[0 + i] + in[12 + i];
-        const int a1 = in[4 + i] + in[8 + i];
-        const int a2 = in[4 + i] - in[8 + i];
-        const int a3 = in[0 + i] - in[12 + i];
-        tmp[0 + i] = a0 + a1;
-        tmp[8 + i] = a0 - a1;
-        tmp[4 + i] = a3 + a2;
-        tmp[12 + i] = a3 - a2;
-    }
+static void StoreH_Xtensa(uint8_t* p, int stride, const int16_t* px) {
+    const int16_t* row = px;
+    uint32_t w;
+#define NARROW_COLUMNS(qreg) do {    \
+    PIE_VLD_128_IP(qreg, row);       \
+    PIE_VLD_128_IP(q4, row);         \
+    PIE_VUNZIP_8(qreg, q4);          \
+} while (0)
+    NARROW_COLUMNS(q0);
+    NARROW_COLUMNS(q1);
+    NARROW_COLUMNS(q2);
+    NARROW_COLUMNS(q3);
+#undef NARROW_COLUMNS
+    PIE_VUNZIP_8(q0, q1);
+    PIE_VUNZIP_8(q2, q3);
+    PIE_VUNZIP_8(q0, q2);
+    PIE_VUNZIP_8(q1, q3);
+    PIE_VUNZIP_8(q0, q1);
+    PIE_VUNZIP_8(q2, q3);
+#define STORE_LINES(qreg, y) do {                      \
+    PIE_MOVI_32_A(qreg, w, 0);                         \
+    pie_store_32(p + (y) * stride, w);                 \
+    PIE_MOVI_32_A(qreg, w, 1);                         \
+    pie_store_32(p + (y) * stride + 4, w);             \
+    PIE_MOVI_32_A(qreg, w, 2);                         \
+    pie_store_32(p + ((y) + 1) * stride, w);           \
+    PIE_MOVI_32_A(qreg, w, 3);                         \
+    pie_store_32(p + ((y) + 1) * stride + 4, w);       \
+} while (0)
+    STORE_LINES(q0, 0);
+    STORE_LINES(q1, 2);
+    STORE_LINES(q2, 4);
+    STORE_LINES(q3, 6);
+#undef STORE_LINES
+}
 
-    // Horizontal pass
-    for (i = 0; i < 4; ++i) {
-        const int dc = tmp[0 + i * 4] + 3;  // rounding
-        const int a0 = dc + tmp[3 + i * 4];
-        const int a1 = tmp[1 + i * 4] + tmp[2 + i * 4];
-        const int a2 = tmp[1 + i * 4] - tmp[2 + i * 4];
-        const int a3 = dc - tmp[3 + i * 4];
-        out[0] = (a0 + a1) >> 3;
-        out[16] = (a3 + a2) >> 3;
-        out[32] = (a0 - a1) >> 3;
-        out[48] = (a3 - a2) >> 3;
-        out++;
+// Sets 'mask' on the lanes where 4 * |p0 - q0| + |p1 - q1| <= thresh2, as in
+// NeedsFilter_C(). Leaves |p1 - p0| and |q1 - q0| aside in q6 and q7.
+static void NeedsFilter_Xtensa(const int16_t* px, int thresh2, int16_t* mask) {
+    const int16_t t = thresh2;
+    LOAD_ROW(q0, P1);
+    LOAD_ROW(q1, Q1);
+    LOAD_ROW(q2, P0);
+    LOAD_ROW(q3, Q0);
+    ABS_DIFF(q2, q3, q4);
+    PIE_VADDS_S16(q2, q2, q2);
+    PIE_VADDS_S16(q2, q2, q2);
+    ABS_DIFF(q0, q1, q4);
+    PIE_VADDS_S16(q2, q2, q0);
+    PIE_VLDBC_16(q5, &t);
+    PIE_VCMP_GT_S16(q2, q2, q5);
+    PIE_NOTQ(q2, q2);
+    PIE_VST_128(q2, mask);
+}
+
+// Sets 'masks[0..7]' on the lanes to filter with DoFilter2 (NeedsFilter2_C()
+// and Hev()) and 'masks[8..15]' on the lanes to filter with DoFilter4 or
+// DoFilter6 (NeedsFilter2_C() and !Hev()).
+static void NeedsFilter2_Xtensa(const int16_t* px, int thresh2, int ithresh,
+                                int hev_thresh, int16_t* masks) {
+    const int16_t t = thresh2, it = ithresh, hev_t = hev_thresh;
+    int16_t* masks2 = masks + 8;
+    // q0 = max of the interior differences, q2 = max(|p1 - p0|, |q1 - q0|).
+    LOAD_ROW(q0, P3);
+    LOAD_ROW(q1, P2);
+    ABS_DIFF(q0, q1, q2);
+    LOAD_ROW(q2, P1);
+    ABS_DIFF(q1, q2, q3);
+    PIE_VMAX_S16(q0, q0, q1);
+    LOAD_ROW(q3, P0);
+    ABS_DIFF(q2, q3, q1);
+    PIE_VMAX_S16(q0, q0, q2);
+    LOAD_ROW(q4, Q3);
+    LOAD_ROW(q5, Q2);
+    ABS_DIFF(q4, q5, q1);
+    PIE_VMAX_S16(q0, q0, q4);
+    LOAD_ROW(q4, Q1);
+    ABS_DIFF(q5, q4, q1);
+    PIE_VMAX_S16(q0, q0, q5);
+    LOAD_ROW(q5, Q0);
+    ABS_DIFF(q4, q5, q1);
+    PIE_VMAX_S16(q0, q0, q4);
+    PIE_VMAX_S16(q2, q2, q4);
+    PIE_VLDBC_16(q1, &it);
+    PIE_VCMP_GT_S16(q0, q0, q1);
+    // q3 = 4 * |p0 - q0| + |p1 - q1|
+    ABS_DIFF(q3, q5, q1);
+    PIE_VADDS_S16(q3, q3, q3);
+    PIE_VADDS_S16(q3, q3, q3);
+    LOAD_ROW(q4, P1);
+    LOAD_ROW(q5, Q1);
+    ABS_DIFF(q4, q5, q1);
+    PIE_VADDS_S16(q3, q3, q4);
+    PIE_VLDBC_16(q1, &t);
+    PIE_VCMP_GT_S16(q3, q3, q1);
+    PIE_ORQ(q0, q0, q3);
+    PIE_NOTQ(q0, q0);                    // needs filter
+    PIE_VLDBC_16(q1, &hev_t);
+    PIE_VCMP_GT_S16(q2, q2, q1);         // hev
+    PIE_ANDQ(q1, q0, q2);
+    PIE_VST_128(q1, masks);
+    PIE_NOTQ(q2, q2);
+    PIE_ANDQ(q2, q2, q0);
+    PIE_VST_128(q2, masks2);
+}
+
+// q0 = sclip2((q4 + 4) >> 3) and q5 = sclip2((q4 + 3) >> 3), with q7 = 1.
+// Uses q1.
+#define FILTER_A1_A2() do {                      \
+    PIE_VLDBC_16(q0, &kFour);                    \
+    PIE_VADDS_S16(q0, q4, q0);                   \
+    PIE_VMUL_S16(q0, q0, q7, 3);                 \
+    CLAMP(q0, kMinus16, k15, q1);                \
+    PIE_VLDBC_16(q5, &kThree);                   \
+    PIE_VADDS_S16(q5, q4, q5);                   \
+    PIE_VMUL_S16(q5, q5, q7, 3);                 \
+    CLAMP(q5, kMinus16, k15, q1);                \
+} while (0)
+
+// Same as DoFilter2_C() on the lanes set in 'mask'.
+static void DoFilter2_Xtensa(int16_t* px, const int16_t* mask) {
+    LOAD_ROW(q0, P1);
+    LOAD_ROW(q1, Q1);
+    PIE_VSUBS_S16(q0, q0, q1);
+    CLAMP(q0, kMinus128, k127, q1);      // sclip1(p1 - q1)
+    LOAD_ROW(q2, P0);
+    LOAD_ROW(q3, Q0);
+    PIE_VSUBS_S16(q4, q3, q2);
+    PIE_VADDS_S16(q5, q4, q4);
+    PIE_VADDS_S16(q4, q4, q5);
+    PIE_VADDS_S16(q4, q4, q0);           // a = 3 * (q0 - p0) + sclip1(p1 - q1)
+    PIE_VLDBC_16(q7, &kOne);
+    FILTER_A1_A2();
+    PIE_VADDS_S16(q5, q2, q5);
+    CLIP_8B(q5, q1);
+    PIE_VSUBS_S16(q0, q3, q0);
+    CLIP_8B(q0, q1);
+    PIE_VLD_128(q6, mask);
+    SELECT(q2, q5, q6, q1);
+    SELECT(q3, q0, q6, q1);
+    STORE_ROW(q2, P0);
+    STORE_ROW(q3, Q0);
+}
+
+// Same as DoFilter4_C() on the lanes set in 'mask'.
+static void DoFilter4_Xtensa(int16_t* px, const int16_t* mask) {
+    LOAD_ROW(q2, P0);
+    LOAD_ROW(q3, Q0);
+    PIE_VSUBS_S16(q4, q3, q2);
+    PIE_VADDS_S16(q5, q4, q4);
+    PIE_VADDS_S16(q4, q4, q5);           // a = 3 * (q0 - p0)
+    PIE_VLDBC_16(q7, &kOne);
+    FILTER_A1_A2();
+    PIE_VADDS_S16(q4, q0, q7);
+    PIE_VMUL_S16(q4, q4, q7, 1);         // a3 = (a1 + 1) >> 1
+    PIE_VLD_128(q6, mask);
+    PIE_VADDS_S16(q5, q2, q5);
+    CLIP_8B(q5, q1);
+    SELECT(q2, q5, q6, q1);
+    STORE_ROW(q2, P0);
+    PIE_VSUBS_S16(q0, q3, q0);
+    CLIP_8B(q0, q1);
+    SELECT(q3, q0, q6, q1);
+    STORE_ROW(q3, Q0);
+    LOAD_ROW(q2, P1);
+    PIE_VADDS_S16(q5, q2, q4);
+    CLIP_8B(q5, q1);
+    SELECT(q2, q5, q6, q1);
+    STORE_ROW(q2, P1);
+    LOAD_ROW(q3, Q1);
+    PIE_VSUBS_S16(q5, q3, q4);
+    CLIP_8B(q5, q1);
+    SELECT(q3, q5, q6, q1);
+    STORE_ROW(q3, Q1);
+}
+
+// Same as DoFilter6_C() on the lanes set in 'mask'.
+static void DoFilter6_Xtensa(int16_t* px, const int16_t* mask) {
+    static const int16_t kTaps[3] = { 27, 18, 9 };
+    int i;
+    LOAD_ROW(q0, P1);
+    LOAD_ROW(q1, Q1);
+    PIE_VSUBS_S16(q0, q0, q1);
+    CLAMP(q0, kMinus128, k127, q1);
+    LOAD_ROW(q2, P0);
+    LOAD_ROW(q3, Q0);
+    PIE_VSUBS_S16(q4, q3, q2);
+    PIE_VADDS_S16(q5, q4, q4);
+    PIE_VADDS_S16(q4, q4, q5);
+    PIE_VADDS_S16(q4, q4, q0);
+    CLAMP(q4, kMinus128, k127, q1);      // a
+    PIE_VLDBC_16(q7, &kOne);
+    PIE_VLD_128(q6, mask);
+    for (i = 0; i < 3; ++i) {
+        // q0 = (tap * a + 63) >> 7, applied to the rows P0 - i and Q0 + i.
+        PIE_VLDBC_16(q0, &kTaps[i]);
+        PIE_VMUL_S16(q0, q4, q0, 0);
+        PIE_VLDBC_16(q5, &k63);
+        PIE_VADDS_S16(q0, q0, q5);
+        PIE_VMUL_S16(q0, q0, q7, 7);
+        LOAD_ROW(q2, P0 - i);
+        LOAD_ROW(q3, Q0 + i);
+        PIE_VADDS_S16(q5, q2, q0);
+        CLIP_8B(q5, q1);
+        SELECT(q2, q5, q6, q1);
+        STORE_ROW(q2, P0 - i);
+        PIE_VSUBS_S16(q5, q3, q0);
+        CLIP_8B(q5, q1);
+        SELECT(q3, q5, q6, q1);
+        STORE_ROW(q3, Q0 + i);
     }
 }
 
-#undef STORE
+#undef FILTER_A1_A2
 
-//------------------------------------------------------------------------------
-// Simple Loop Filters
-//
-// These are used for deblocking. They operate on 16-pixel edges.
+// Simple filter of 8 lines: the rows P1..Q1 of 'px' must be loaded.
+static void SimpleFilter_Xtensa(int16_t* px, int thresh2) {
+    PIE_ALIGNED_ARRAY(int16_t, mask, 8);
+    NeedsFilter_Xtensa(px, thresh2, mask);
+    DoFilter2_Xtensa(px, mask);
+}
 
-// Get absolute difference
-static WEBP_INLINE int abs_diff(int a, int b) {
-    return (a > b) ? (a - b) : (b - a);
+// Complex filter of 8 lines, FilterLoop24_C() if 'inner' is set and
+// FilterLoop26_C() otherwise. Returns the first and last+1 rows modified.
+static void ComplexFilter_Xtensa(int16_t* px, int thresh2, int ithresh,
+                                 int hev_thresh, int inner) {
+    PIE_ALIGNED_ARRAY(int16_t, masks, 16);
+    NeedsFilter2_Xtensa(px, thresh2, ithresh, hev_thresh, masks);
+    DoFilter2_Xtensa(px, masks);
+    if (inner) {
+        DoFilter4_Xtensa(px, masks + 8);
+    } else {
+        DoFilter6_Xtensa(px, masks + 8);
+    }
 }
 
-// Simple vertical filter for 16 pixels
+#undef SELECT
+#undef ABS_DIFF
+#undef STORE_ROW
+#undef LOAD_ROW
+
 static void SimpleVFilter16_Xtensa(uint8_t* p, int stride, int thresh) {
-    int i;
+    PIE_ALIGNED_ARRAY(int16_t, px, 8 * 8);
     const int thresh2 = 2 * thresh + 1;
-    for (i = 0; i < 16; ++i) {
-        if (abs_diff(p[-2 * stride], p[-stride]) <= thresh2 &&
-            abs_diff(p[-stride], p[0]) <= thresh2 &&
-            abs_diff(p[0], p[stride]) <= thresh2) {
-            // Apply simple filter
-            const int p0 = p[-stride];
-            const int q0 = p[0];
-            const int a = 3 * (q0 - p0);
-            const int a1 = VP8ksclip2[(a + 4) >> 3];
-            const int a2 = VP8ksclip2[(a + 3) >> 3];
-            p[-stride] = VP8kclip1[p0 + a2];
-            p[0] = VP8kclip1[q0 - a1];
-        }
-        p++;
+    int i;
+    for (i = 0; i < 16; i += 8) {
+        LoadV_Xtensa(p + i, stride, P1, Q1 + 1, px);
+        SimpleFilter_Xtensa(px, thresh2);
+        StoreV_Xtensa(p + i, stride, P0, Q0 + 1, px);
     }
 }
 
-// Simple horizontal filter for 16 pixels
 static void SimpleHFilter16_Xtensa(uint8_t* p, int stride, int thresh) {
+    PIE_ALIGNED_ARRAY(int16_t, px, 8 * 8);
+    const int thresh2 = 2 * thresh + 1;
     int i;
+    for (i = 0; i < 16; i += 8) {
+        uint8_t* const line = p + i * stride - 4;
+        LoadH_Xtensa(line, stride, px);
+        SimpleFilter_Xtensa(px, thresh2);
+        StoreH_Xtensa(line, stride, px);
+    }
+}
+
+static void SimpleVFilter16i_Xtensa(uint8_t* p, int stride, int thresh) {
+    int k;
+    for (k = 3; k > 0; --k) {
+        p += 4 * stride;
+        SimpleVFilter16_Xtensa(p, stride, thresh);
+    }
+}
+
+static void SimpleHFilter16i_Xtensa(uint8_t* p, int stride, int thresh) {
+    int k;
+    for (k = 3; k > 0; --k) {
+        p += 4;
+        SimpleHFilter16_Xtensa(p, stride, thresh);
+    }
+}
+
+// Filters 'size' (8 or 16) lines across an horizontal edge.
+static void FilterLoopV_Xtensa(uint8_t* p, int stride, int size, int thresh,
+                               int ithresh, int hev_thresh, int inner) {
+    PIE_ALIGNED_ARRAY(int16_t, px, 8 * 8);
     const int thresh2 = 2 * thresh + 1;
-    for (i = 0; i < 16; ++i) {
-        if (abs_diff(p[-2], p[-1]) <= thresh2 &&
-            abs_diff(p[-1], p[0]) <= thresh2 &&
-            abs_diff(p[0], p[1]) <= thresh2) {
-            const int p0 = p[-1];
-            const int q0 = p[0];
-            const int a = 3 * (q0 - p0);
-            const int a1 = VP8ksclip2[(a + 4) >> 3];
-            const int a2 = VP8ksclip2[(a + 3) >> 3];
-            p[-1] = VP8kclip1[p0 + a2];
-            p[0] = VP8kclip1[q0 - a1];
+    int i;
+    for (i = 0; i < size; i += 8) {
+        LoadV_Xtensa(p + i, stride, P3, Q3 + 1, px);
+        ComplexFilter_Xtensa(px, thresh2, ithresh, hev_thresh, inner);
+        if (inner) {
+            StoreV_Xtensa(p + i, stride, P1, Q1 + 1, px);
+        } else {
+            StoreV_Xtensa(p + i, stride, P2, Q2 + 1, px);
         }
-        p += stride;
     }
 }
 
+// Filters 'size' (8 or 16) lines across a vertical edge.
+static void FilterLoopH_Xtensa(uint8_t* p, int stride, int size, int thresh,
+                               int ithresh, int hev_thresh, int inner) {
+    PIE_ALIGNED_ARRAY(int16_t, px, 8 * 8);
+    const int thresh2 = 2 * thresh + 1;
+    int i;
+    for (i = 0; i < size; i += 8) {
+        uint8_t* const line = p + i * stride - 4;
+        LoadH_Xtensa(line, stride, px);
+        ComplexFilter_Xtensa(px, thresh2, ithresh, hev_thresh, inner);
+        StoreH_Xtensa(line, stride, px);
+    }
+}
+
+// on macroblock edges
+static void VFilter16_Xtensa(uint8_t* p, int stride, int thresh, int ithresh,
+                             int hev_thresh) {
+    FilterLoopV_Xtensa(p, stride, 16, thresh, ithresh, hev_thresh, 0);
+}
+
+static void HFilter16_Xtensa(uint8_t* p, int stride, int thresh, int ithresh,
+                             int hev_thresh) {
+    FilterLoopH_Xtensa(p, stride, 16, thresh, ithresh, hev_thresh, 0);
+}
+
+// on three inner edges
+static void VFilter16i_Xtensa(uint8_t* p, int stride, int thresh, int ithresh,
+                              int hev_thresh) {
+    int k;
+    for (k = 3; k > 0; --k) {
+        p += 4 * stride;
+        FilterLoopV_Xtensa(p, stride, 16, thresh, ithresh, hev_thresh, 1);
+    }
+}
+
+static void HFilter16i_Xtensa(uint8_t* p, int stride, int thresh, int ithresh,
+                              int hev_thresh) {
+    int k;
+    for (k = 3; k > 0; --k) {
+        p += 4;
+        FilterLoopH_Xtensa(p, stride, 16, thresh, ithresh, hev_thresh, 1);
+    }
+}
+
+// 8-pixels wide variants, for chroma filtering
+static void VFilter8_Xtensa(uint8_t* WEBP_RESTRICT u, uint8_t* WEBP_RESTRICT v,
+                            int stride, int thresh, int ithresh,
+                            int hev_thresh) {
+    FilterLoopV_Xtensa(u, stride, 8, thresh, ithresh, hev_thresh, 0);
+    FilterLoopV_Xtensa(v, stride, 8, thresh, ithresh, hev_thresh, 0);
+}
+
+static void HFilter8_Xtensa(uint8_t* WEBP_RESTRICT u, uint8_t* WEBP_RESTRICT v,
+                            int stride, int thresh, int ithresh,
+                            int hev_thresh) {
+    FilterLoopH_Xtensa(u, stride, 8, thresh, ithresh, hev_thresh, 0);
+    FilterLoopH_Xtensa(v, stride, 8, thresh, ithresh, hev_thresh, 0);
+}
+
+static void VFilter8i_Xtensa(uint8_t* WEBP_RESTRICT u,
+                             uint8_t* WEBP_RESTRICT v, int stride, int thresh,
+                             int ithresh, int hev_thresh) {
+    FilterLoopV_Xtensa(u + 4 * stride, stride, 8, thresh, ithresh, hev_thresh,
+                       1);
+    FilterLoopV_Xtensa(v + 4 * stride, stride, 8, thresh, ithresh, hev_thresh,
+                       1);
+}
+
+static void HFilter8i_Xtensa(uint8_t* WEBP_RESTRICT u,
+                             uint8_t* WEBP_RESTRICT v, int stride, int thresh,
+                             int ithresh, int hev_thresh) {
+    FilterLoopH_Xtensa(u + 4, stride, 8, thresh, ithresh, hev_thresh, 1);
+    FilterLoopH_Xtensa(v + 4, stride, 8, thresh, ithresh, hev_thresh, 1);
+}
+
+//------------------------------------------------------------------------------
+// 16x16 and 8x8 intra predictions
+
+// Sum of the 'size' (8 or 16) pixels at 'top', which must be 8-byte aligned.
+static WEBP_INLINE int SumTop_Xtensa(const uint8_t* top, int size) {
+    uint32_t sum;
+    PIE_VLD_L_64(q0, top);
+    if (size == 16) PIE_VLD_H_64(q0, top + 8);
+    PIE_VZERO(q1);
+    PIE_VZIP_8(q0, q1);
+    PIE_VLDBC_16(q2, &kOne);
+    PIE_ZERO_ACCX();
+    PIE_VMULAS_S16_ACCX(q0, q2);
+    if (size == 16) PIE_VMULAS_S16_ACCX(q1, q2);
+    PIE_RUR_ACCX_0(sum);
+    return (int)sum;
+}
+
+static WEBP_INLINE int SumLeft_Xtensa(const uint8_t* dst, int size) {
+    int sum = 0;
+    int j;
+    for (j = 0; j < size; ++j) sum += dst[-1 + j * BPS];
+    return sum;
+}
+
+// Fills the 'size' rows of 'size' (8 or 16) pixels with 'v'.
+static WEBP_INLINE void Put_Xtensa(uint8_t v, uint8_t* dst, int size) {
+    int j;
+    PIE_VLDBC_8(q0, &v);
+    for (j = 0; j < size; ++j) {
+        PIE_VST_L_64(q0, dst + j * BPS);
+        if (size == 16) PIE_VST_H_64(q0, dst + j * BPS + 8);
+    }
+}
+
+static WEBP_INLINE void VerticalPred_Xtensa(uint8_t* dst, int size) {
+    int j;
+    PIE_VLD_L_64(q0, dst - BPS);
+    if (size == 16) PIE_VLD_H_64(q0, dst - BPS + 8);
+    for (j = 0; j < size; ++j) {
+        PIE_VST_L_64(q0, dst + j * BPS);
+        if (size == 16) PIE_VST_H_64(q0, dst + j * BPS + 8);
+    }
+}
+
+static WEBP_INLINE void HorizontalPred_Xtensa(uint8_t* dst, int size) {
+    int j;
+    for (j = 0; j < size; ++j) {
+        PIE_VLDBC_8(q0, dst + j * BPS - 1);
+        PIE_VST_L_64(q0, dst + j * BPS);
+        if (size == 16) PIE_VST_H_64(q0, dst + j * BPS + 8);
+    }
+}
+
+static void TM16_Xtensa(uint8_t* dst) {
+    const uint8_t* const top = dst - BPS;
+    int y;
+    PIE_VLD_L_64(q0, top);
+    PIE_VLD_H_64(q0, top + 8);
+    PIE_VZERO(q1);
+    PIE_VZIP_8(q0, q1);
+    PIE_VZERO(q5);
+    PIE_VLDBC_16(q6, &k255);
+    for (y = 0; y < 16; ++y) {
+        const int16_t left = dst[-1] - top[-1];
+        PIE_VLDBC_16(q2, &left);
+        PIE_VADDS_S16(q3, q0, q2);
+        PIE_VADDS_S16(q4, q1, q2);
+        PIE_VMAX_S16(q3, q3, q5);
+        PIE_VMIN_S16(q3, q3, q6);
+        PIE_VMAX_S16(q4, q4, q5);
+        PIE_VMIN_S16(q4, q4, q6);
+        PIE_VUNZIP_8(q3, q4);
+        PIE_VST_L_64(q3, dst);
+        PIE_VST_H_64(q3, dst + 8);
+        dst += BPS;
+    }
+}
+
+static void VE16_Xtensa(uint8_t* dst) { VerticalPred_Xtensa(dst, 16); }
+static void HE16_Xtensa(uint8_t* dst) { HorizontalPred_Xtensa(dst, 16); }
+
+static void DC16_Xtensa(uint8_t* dst) {
+    const int DC = SumTop_Xtensa(dst - BPS, 16) + SumLeft_Xtensa(dst, 16) + 16;
+    Put_Xtensa(DC >> 5, dst, 16);
+}
+
+static void DC16NoTop_Xtensa(uint8_t* dst) {
+    Put_Xtensa((SumLeft_Xtensa(dst, 16) + 8) >> 4, dst, 16);
+}
+
+static void DC16NoLeft_Xtensa(uint8_t* dst) {
+    Put_Xtensa((SumTop_Xtensa(dst - BPS, 16) + 8) >> 4, dst, 16);
+}
+
+static void DC16NoTopLeft_Xtensa(uint8_t* dst) { Put_Xtensa(0x80, dst, 16); }
+
+static void TM8uv_Xtensa(uint8_t* dst) {
+    const uint8_t* const top = dst - BPS;
+    int y;
+    PIE_VLD_L_64(q0, top);
+    PIE_VZERO(q1);
+    PIE_VZIP_8(q0, q1);
+    PIE_VZERO(q5);
+    PIE_VLDBC_16(q6, &k255);
+    for (y = 0; y < 8; y += 2) {
+        const int16_t left0 = dst[-1] - top[-1];
+        const int16_t left1 = dst[-1 + BPS] - top[-1];
+        PIE_VLDBC_16(q2, &left0);
+        PIE_VLDBC_16(q3, &left1);
+        PIE_VADDS_S16(q2, q0, q2);
+        PIE_VADDS_S16(q3, q0, q3);
+        PIE_VMAX_S16(q2, q2, q5);
+        PIE_VMIN_S16(q2, q2, q6);
+        PIE_VMAX_S16(q3, q3, q5);
+        PIE_VMIN_S16(q3, q3, q6);
+        PIE_VUNZIP_8(q2, q3);
+        PIE_VST_L_64(q2, dst);
+        PIE_VST_H_64(q2, dst + BPS);
+        dst += 2 * BPS;
+    }
+}
+
+static void VE8uv_Xtensa(uint8_t* dst) { VerticalPred_Xtensa(dst, 8); }
+static void HE8uv_Xtensa(uint8_t* dst) { HorizontalPred_Xtensa(dst, 8); }
+
+static void DC8uv_Xtensa(uint8_t* dst) {
+    const int DC = SumTop_Xtensa(dst - BPS, 8) + SumLeft_Xtensa(dst, 8) + 8;
+    Put_Xtensa(DC >> 4, dst, 8);
+}
+
+static void DC8uvNoTop_Xtensa(uint8_t* dst) {
+    Put_Xtensa((SumLeft_Xtensa(dst, 8) + 4) >> 3, dst, 8);
+}
+
+static void DC8uvNoLeft_Xtensa(uint8_t* dst) {
+    Put_Xtensa((SumTop_Xtensa(dst - BPS, 8) + 4) >> 3, dst, 8);
+}
+
+static void DC8uvNoTopLeft_Xtensa(uint8_t* dst) { Put_Xtensa(0x80, dst, 8); }
+
+//------------------------------------------------------------------------------
+// 4x4 intra predictions
+//
+// The directional modes take their pixels from AVG3() and AVG2() of
+// consecutive edge samples, which are computed for 8 positions at once. The
+// rows are then assembled as 32-bit words.
+
+#define PACK4(a, b, c, d)                                  \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) |                \
+     ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+// Byte 'n' of the 8 bytes in 'w'.
+static WEBP_INLINE uint32_t Byte_Xtensa(const uint32_t w[2], int n) {
+    return (w[n >> 2] >> (8 * (n & 3))) & 0xff;
+}
+
+// Bytes n..n+3 of the 8 bytes in 'w', with n in [0, 4].
+static WEBP_INLINE uint32_t Window_Xtensa(const uint32_t w[2], int n) {
+    if ((n & 3) == 0) return w[n >> 2];
+    return (w[0] >> (8 * n)) | (w[1] << (32 - 8 * n));
+}
+
+// Computes avg3[i] = AVG3(e[i], e[i + 1], e[i + 2]) and
+// avg2[i] = AVG2(e[i], e[i + 1]) for i in [0, 8), where e[] are the bytes of
+// e0, e1 and e2.
+static void EdgeAverages_Xtensa(uint32_t e0, uint32_t e1, uint32_t e2,
+                                uint32_t avg3[2], uint32_t avg2[2]) {
+    PIE_MOVI_32_Q(q0, e0, 0);
+    PIE_MOVI_32_Q(q0, e1, 1);
+    PIE_MOVI_32_Q(q1, (e0 >> 8) | (e1 << 24), 0);
+    PIE_MOVI_32_Q(q1, (e1 >> 8) | (e2 << 24), 1);
+    PIE_MOVI_32_Q(q2, (e0 >> 16) | (e1 << 16), 0);
+    PIE_MOVI_32_Q(q2, (e1 >> 16) | (e2 << 16), 1);
+    PIE_VZERO(q3);
+    PIE_VZIP_8(q0, q3);
+    PIE_VZERO(q3);
+    PIE_VZIP_8(q1, q3);
+    PIE_VZERO(q3);
+    PIE_VZIP_8(q2, q3);
+    PIE_VLDBC_16(q5, &kOne);
+    PIE_VLDBC_16(q6, &kTwo);
+    PIE_VADDS_S16(q4, q0, q1);
+    PIE_VADDS_S16(q4, q4, q5);
+    PIE_VMUL_S16(q4, q4, q5, 1);         // (a + b + 1) >> 1
+    PIE_VADDS_S16(q1, q1, q1);
+    PIE_VADDS_S16(q1, q1, q0);
+    PIE_VADDS_S16(q1, q1, q2);
+    PIE_VADDS_S16(q1, q1, q6);
+    PIE_VMUL_S16(q1, q1, q5, 2);         // (a + 2 * b + c + 2) >> 2
+    PIE_VUNZIP_8(q1, q4);
+    PIE_MOVI_32_A(q1, avg3[0], 0);
+    PIE_MOVI_32_A(q1, avg3[1], 1);
+    PIE_MOVI_32_A(q1, avg2[0], 2);
+    PIE_MOVI_32_A(q1, avg2[1], 3);
+}
+
+#define LEFT4(dst)                                                         \
+    PACK4((dst)[-1], (dst)[-1 + BPS], (dst)[-1 + 2 * BPS], (dst)[-1 + 3 * BPS])
+
+static WEBP_INLINE void Store4x4_Xtensa(uint8_t* dst, uint32_t r0, uint32_t r1,
+                                        uint32_t r2, uint32_t r3) {
+    pie_store_32(dst + 0 * BPS, r0);
+    pie_store_32(dst + 1 * BPS, r1);
+    pie_store_32(dst + 2 * BPS, r2);
+    pie_store_32(dst + 3 * BPS, r3);
+}
+
+static void DC4_Xtensa(uint8_t* dst) {
+    uint32_t dc;
+    PIE_MOVI_32_Q(q0, pie_load_32(dst - BPS), 0);
+    PIE_MOVI_32_Q(q0, LEFT4(dst), 1);
+    PIE_VZERO(q1);
+    PIE_VZIP_8(q0, q1);
+    PIE_VLDBC_16(q2, &kOne);
+    PIE_ZERO_ACCX();
+    PIE_VMULAS_S16_ACCX(q0, q2);
+    PIE_RUR_ACCX_0(dc);
+    dc = 0x01010101U * ((dc + 4) >> 3);
+    Store4x4_Xtensa(dst, dc, dc, dc, dc);
+}
+
+static void TM4_Xtensa(uint8_t* dst) {
+    const uint8_t* const top = dst - BPS;
+    const uint32_t t = pie_load_32(top);
+    const int tl = top[-1];
+    uint32_t w;
+#define SPLAT16(v) ((uint32_t)(uint16_t)(v) * 0x00010001U)
+    const uint32_t d0 = SPLAT16(dst[-1 + 0 * BPS] - tl);
+    const uint32_t d1 = SPLAT16(dst[-1 + 1 * BPS] - tl);
+    const uint32_t d2 = SPLAT16(dst[-1 + 2 * BPS] - tl);
+    const uint32_t d3 = SPLAT16(dst[-1 + 3 * BPS] - tl);
+#undef SPLAT16
+    PIE_MOVI_32_Q(q0, t, 0);
+    PIE_MOVI_32_Q(q0, t, 1);
+    PIE_VZERO(q1);
+    PIE_VZIP_8(q0, q1);                  // the top pixels, twice
+    PIE_MOVI_32_Q(q2, d0, 0);
+    PIE_MOVI_32_Q(q2, d0, 1);
+    PIE_MOVI_32_Q(q2, d1, 2);
+    PIE_MOVI_32_Q(q2, d1, 3);
+    PIE_MOVI_32_Q(q3, d2, 0);
+    PIE_MOVI_32_Q(q3, d2, 1);
+    PIE_MOVI_32_Q(q3, d3, 2);
+    PIE_MOVI_32_Q(q3, d3, 3);
+    PIE_VADDS_S16(q2, q2, q0);
+    PIE_VADDS_S16(q3, q3, q0);
+    CLIP_8B(q2, q4);
+    CLIP_8B(q3, q4);
+    PIE_VUNZIP_8(q2, q3);
+    PIE_MOVI_32_A(q2, w, 0);
+    pie_store_32(dst + 0 * BPS, w);
+    PIE_MOVI_32_A(q2, w, 1);
+    pie_store_32(dst + 1 * BPS, w);
+    PIE_MOVI_32_A(q2, w, 2);
+    pie_store_32(dst + 2 * BPS, w);
+    PIE_MOVI_32_A(q2, w, 3);
+    pie_store_32(dst + 3 * BPS, w);
+}
+
+static void VE4_Xtensa(uint8_t* dst) {  // vertical
+    const uint8_t* const top = dst - BPS;
+    const uint32_t t0 = pie_load_32(top), t1 = pie_load_32(top + 4);
+    uint32_t avg3[2], avg2[2];
+    EdgeAverages_Xtensa((t0 << 8) | top[-1], (t1 << 8) | (t0 >> 24), t1 >> 24,
+                        avg3, avg2);
+    Store4x4_Xtensa(dst, avg3[0], avg3[0], avg3[0], avg3[0]);
+}
+
+static void HE4_Xtensa(uint8_t* dst) {  // horizontal
+    const uint32_t E = dst[-1 + 3 * BPS];
+    uint32_t avg3[2], avg2[2];
+    EdgeAverages_Xtensa(PACK4(dst[-1 - BPS], dst[-1], dst[-1 + BPS],
+                              dst[-1 + 2 * BPS]),
+                        E * 0x0101U, 0, avg3, avg2);
+    Store4x4_Xtensa(dst, 0x01010101U * Byte_Xtensa(avg3, 0),
+                    0x01010101U * Byte_Xtensa(avg3, 1),
+                    0x01010101U * Byte_Xtensa(avg3, 2),
+                    0x01010101U * Byte_Xtensa(avg3, 3));
+}
+
+static void RD4_Xtensa(uint8_t* dst) {  // Down-right
+    const uint8_t* const top = dst - BPS;
+    const uint32_t t0 = pie_load_32(top);
+    uint32_t avg3[2], avg2[2];
+    // Edge: L K J I X A B C D
+    EdgeAverages_Xtensa(
+        PACK4(dst[-1 + 3 * BPS], dst[-1 + 2 * BPS], dst[-1 + BPS], dst[-1]),
+        (t0 << 8) | top[-1], t0 >> 24, avg3, avg2);
+    Store4x4_Xtensa(dst, Window_Xtensa(avg3, 3), Window_Xtensa(avg3, 2),
+                    Window_Xtensa(avg3, 1), Window_Xtensa(avg3, 0));
+}
+
+static void LD4_Xtensa(uint8_t* dst) {  // Down-Left
+    const uint8_t* const top = dst - BPS;
+    const uint32_t t1 = pie_load_32(top + 4);
+    uint32_t avg3[2], avg2[2];
+    // Edge: A B C D E F G H H
+    EdgeAverages_Xtensa(pie_load_32(top), t1, t1 >> 24, avg3, avg2);
+    Store4x4_Xtensa(dst, Window_Xtensa(avg3, 0), Window_Xtensa(avg3, 1),
+                    Window_Xtensa(avg3, 2), Window_Xtensa(avg3, 3));
+}
+
+static void VR4_Xtensa(uint8_t* dst) {  // Vertical-Right
+    const uint8_t* const top = dst - BPS;
+    uint32_t avg3[2], avg2[2];
+    // Edge: K J I X A B C D
+    EdgeAverages_Xtensa(
+        PACK4(dst[-1 + 2 * BPS], dst[-1 + BPS], dst[-1], top[-1]),
+        pie_load_32(top), 0, avg3, avg2);
+    Store4x4_Xtensa(dst, Window_Xtensa(avg2, 3), Window_Xtensa(avg3, 2),
+                    (Window_Xtensa(avg2, 3) << 8) | Byte_Xtensa(avg3, 1),
+                    (Window_Xtensa(avg3, 2) << 8) | Byte_Xtensa(avg3, 0));
+}
+
+static void VL4_Xtensa(uint8_t* dst) {  // Vertical-Left
+    const uint8_t* const top = dst - BPS;
+    uint32_t avg3[2], avg2[2];
+    // Edge: A B C D E F G H
+    EdgeAverages_Xtensa(pie_load_32(top), pie_load_32(top + 4), 0, avg3, avg2);
+    Store4x4_Xtensa(dst, avg2[0], avg3[0],
+                    (avg2[0] >> 8) | (Byte_Xtensa(avg3, 4) << 24),
+                    (avg3[0] >> 8) | (Byte_Xtensa(avg3, 5) << 24));
+}
+
+static void HU4_Xtensa(uint8_t* dst) {  // Horizontal-Up
+    const uint32_t L = dst[-1 + 3 * BPS];
+    uint32_t avg3[2], avg2[2];
+    // Edge: I J K L L L
+    EdgeAverages_Xtensa(LEFT4(dst), 0x01010101U * L, 0, avg3, avg2);
+    Store4x4_Xtensa(
+        dst,
+        PACK4(Byte_Xtensa(avg2, 0), Byte_Xtensa(avg3, 0),
+              Byte_Xtensa(avg2, 1), Byte_Xtensa(avg3, 1)),
+        PACK4(Byte_Xtensa(avg2, 1), Byte_Xtensa(avg3, 1),
+              Byte_Xtensa(avg2, 2), Byte_Xtensa(avg3, 2)),
+        PACK4(Byte_Xtensa(avg2, 2), Byte_Xtensa(avg3, 2), L, L),
+        0x01010101U * L);
+}
+
+static void HD4_Xtensa(uint8_t* dst) {  // Horizontal-Down
+    const uint8_t* const top = dst - BPS;
+    const uint32_t t0 = pie_load_32(top);
+    uint32_t avg3[2], avg2[2];
+    // Edge: L K J I X A B C
+    EdgeAverages_Xtensa(
+        PACK4(dst[-1 + 3 * BPS], dst[-1 + 2 * BPS], dst[-1 + BPS], dst[-1]),
+        (t0 << 8) | top[-1], 0, avg3, avg2);
+    Store4x4_Xtensa(
+        dst,
+        PACK4(Byte_Xtensa(avg2, 3), Byte_Xtensa(avg3, 3),
+              Byte_Xtensa(avg3, 4), Byte_Xtensa(avg3, 5)),
+        PACK4(Byte_Xtensa(avg2, 2), Byte_Xtensa(avg3, 2),
+              Byte_Xtensa(avg2, 3), Byte_Xtensa(avg3, 3)),
+        PACK4(Byte_Xtensa(avg2, 1), Byte_Xtensa(avg3, 1),
+              Byte_Xtensa(avg2, 2), Byte_Xtensa(avg3, 2)),
+        PACK4(Byte_Xtensa(avg2, 0), Byte_Xtensa(avg3, 0),
+              Byte_Xtensa(avg2, 1), Byte_Xtensa(avg3, 1)));
+}
+
+#undef LEFT4
+#undef PACK4
+
 //------------------------------------------------------------------------------
 // Init function - register optimized functions
 
@@ -241,9 +1145,47 @@ WEBP_TSAN_IGNORE_FUNCTION void VP8DspInitXtensa(void) {
     VP8TransformAC3 = TransformAC3_Xtensa;
     VP8TransformWHT = TransformWHT_Xtensa;
 
-    // Simple filter functions
+    // Loop filters
+    VP8VFilter16 = VFilter16_Xtensa;
+    VP8HFilter16 = HFilter16_Xtensa;
+    VP8VFilter8 = VFilter8_Xtensa;
+    VP8HFilter8 = HFilter8_Xtensa;
+    VP8VFilter16i = VFilter16i_Xtensa;
+    VP8HFilter16i = HFilter16i_Xtensa;
+    VP8VFilter8i = VFilter8i_Xtensa;
+    VP8HFilter8i = HFilter8i_Xtensa;
     VP8SimpleVFilter16 = SimpleVFilter16_Xtensa;
     VP8SimpleHFilter16 = SimpleHFilter16_Xtensa;
+    VP8SimpleVFilter16i = SimpleVFilter16i_Xtensa;
+    VP8SimpleHFilter16i = SimpleHFilter16i_Xtensa;
+
+    // Intra predictions
+    VP8PredLuma4[0] = DC4_Xtensa;
+    VP8PredLuma4[1] = TM4_Xtensa;
+    VP8PredLuma4[2] = VE4_Xtensa;
+    VP8PredLuma4[3] = HE4_Xtensa;
+    VP8PredLuma4[4] = RD4_Xtensa;
+    VP8PredLuma4[5] = VR4_Xtensa;
+    VP8PredLuma4[6] = LD4_Xtensa;
+    VP8PredLuma4[7] = VL4_Xtensa;
+    VP8PredLuma4[8] = HD4_Xtensa;
+    VP8PredLuma4[9] = HU4_Xtensa;
+
+    VP8PredLuma16[0] = DC16_Xtensa;
+    VP8PredLuma16[1] = TM16_Xtensa;
+    VP8PredLuma16[2] = VE16_Xtensa;
+    VP8PredLuma16[3] = HE16_Xtensa;
+    VP8PredLuma16[4] = DC16NoTop_Xtensa;
+    VP8PredLuma16[5] = DC16NoLeft_Xtensa;
+    VP8PredLuma16[6] = DC16NoTopLeft_Xtensa;
+
+    VP8PredChroma8[0] = DC8uv_Xtensa;
+    VP8PredChroma8[1] = TM8uv_Xtensa;
+    VP8PredChroma8[2] = VE8uv_Xtensa;
+    VP8PredChroma8[3] = HE8uv_Xtensa;
+    VP8PredChroma8[4] = DC8uvNoTop_Xtensa;
+    VP8PredChroma8[5] = DC8uvNoLeft_Xtensa;
+    VP8PredChroma8[6] = DC8uvNoTopLeft_Xtensa;
 }
 
 #else  // !WEBP_USE_XTENSA_PIE
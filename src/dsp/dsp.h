@@ -208,6 +208,60 @@ extern VP8AccumulateSSEFunc VP8AccumulateSSE;
 // must be called before using any of the above directly
 void VP8SSIMDspInit(void);
 
+//------------------------------------------------------------------------------
+// Animation encoding
+
+// Two ARGB pixels are similar if they have the same alpha 'a' and if none of
+// their color channels differs by more than 'max_allowed_diff * 255 / a'.
+// 'max_allowed_diff' must be in [0, 255]. The Lossless variants require equal
+// pixels instead and ignore 'max_allowed_diff'.
+typedef int (*WebPAnimCompareFunc)(const uint32_t* src, const uint32_t* dst,
+                                   int length, int max_allowed_diff);
+// Return the index of the first (resp. last) of the 'length' pixels of 'src'
+// that is not similar to its counterpart in 'dst', or 'length' (resp. -1).
+extern WebPAnimCompareFunc WebPAnimFindFirstDiffLossless;
+extern WebPAnimCompareFunc WebPAnimFindFirstDiffLossy;
+extern WebPAnimCompareFunc WebPAnimFindLastDiffLossless;
+extern WebPAnimCompareFunc WebPAnimFindLastDiffLossy;
+// Return true if each 'dst' pixel that is not opaque is similar to its
+// counterpart in 'src', i.e. if 'dst' can be blended over 'src'.
+extern WebPAnimCompareFunc WebPAnimCanBlendLossless;
+extern WebPAnimCompareFunc WebPAnimCanBlendLossy;
+
+// Replaces the 'dst' pixels equal to 'src' by 0x00000000 and sets their 'mask'
+// entry to 1. Returns true if at least one pixel was modified.
+typedef int (*WebPAnimIncreaseTransparencyFunc)(const uint32_t* src,
+                                                uint32_t* dst, uint8_t* mask,
+                                                int length);
+extern WebPAnimIncreaseTransparencyFunc WebPAnimIncreaseTransparency;
+
+// Returns true if the 8x8 'src' block is opaque and similar to 'dst'. Then
+// 'color' is set to the average color of 'src', with a zero alpha.
+typedef int (*WebPAnimIsSimilarBlockFunc)(const uint32_t* src, int src_stride,
+                                          const uint32_t* dst, int dst_stride,
+                                          int max_allowed_diff,
+                                          uint32_t* const color);
+extern WebPAnimIsSimilarBlockFunc WebPAnimIsSimilarBlock8x8;
+
+// Plain-C versions, used as fallback by the SIMD implementations.
+int WebPAnimFindFirstDiffLossless_C(const uint32_t* src, const uint32_t* dst,
+                                    int length, int max_allowed_diff);
+int WebPAnimFindFirstDiffLossy_C(const uint32_t* src, const uint32_t* dst,
+                                 int length, int max_allowed_diff);
+int WebPAnimFindLastDiffLossless_C(const uint32_t* src, const uint32_t* dst,
+                                   int length, int max_allowed_diff);
+int WebPAnimFindLastDiffLossy_C(const uint32_t* src, const uint32_t* dst,
+                                int length, int max_allowed_diff);
+int WebPAnimCanBlendLossless_C(const uint32_t* src, const uint32_t* dst,
+                               int length, int max_allowed_diff);
+int WebPAnimCanBlendLossy_C(const uint32_t* src, const uint32_t* dst,
+                            int length, int max_allowed_diff);
+int WebPAnimIncreaseTransparency_C(const uint32_t* src, uint32_t* dst,
+                                   uint8_t* mask, int length);
+
+// must be called before using any of the above directly
+void WebPAnimEncDspInit(void);
+
 //------------------------------------------------------------------------------
 // Decoding
 
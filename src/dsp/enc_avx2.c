@@ -0,0 +1,566 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// AVX2 version of some encoding functions.
+//
+// Most kernels here work on two 4x4 blocks at once, one per 128-bit lane,
+// using the same per-lane arithmetic as the SSE2/SSE4.1 versions.
+
+#include "src/dsp/dsp.h"
+
+#if defined(WEBP_USE_AVX2)
+#include <immintrin.h>
+#include <stdlib.h>  // for abs()
+
+#include "src/dsp/cpu.h"
+#include "src/enc/vp8i_enc.h"
+#include "src/webp/types.h"
+
+// Returns the sum of the eight 32b values of 'v'.
+static WEBP_INLINE int HorizontalSum_AVX2(const __m256i v) {
+  const __m128i sum4 = _mm_add_epi32(_mm256_castsi256_si128(v),
+                                     _mm256_extracti128_si256(v, 1));
+  const __m128i sum2 = _mm_add_epi32(sum4, _mm_unpackhi_epi64(sum4, sum4));
+  const __m128i sum1 =
+      _mm_add_epi32(sum2, _mm_shuffle_epi32(sum2, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_cvtsi128_si32(sum1);
+}
+
+//------------------------------------------------------------------------------
+// Transforms (Paragraph 14.4)
+
+// Same as FTransformPass1_SSE2(), on one block per lane.
+static WEBP_INLINE void FTransformPass1_AVX2(const __m256i* const in01,
+                                             const __m256i* const in23,
+                                             __m256i* const out01,
+                                             __m256i* const out32) {
+  const __m256i k937 = _mm256_set1_epi32(937);
+  const __m256i k1812 = _mm256_set1_epi32(1812);
+
+  const __m256i k88p = _mm256_set1_epi16(8);
+  const __m256i k88m = _mm256_broadcastsi128_si256(
+      _mm_set_epi16(-8, 8, -8, 8, -8, 8, -8, 8));
+  const __m256i k5352_2217p = _mm256_broadcastsi128_si256(
+      _mm_set_epi16(2217, 5352, 2217, 5352, 2217, 5352, 2217, 5352));
+  const __m256i k5352_2217m = _mm256_broadcastsi128_si256(
+      _mm_set_epi16(-5352, 2217, -5352, 2217, -5352, 2217, -5352, 2217));
+
+  // *in01 = 00 01 10 11 02 03 12 13
+  // *in23 = 20 21 30 31 22 23 32 33
+  const __m256i shuf01_p =
+      _mm256_shufflehi_epi16(*in01, _MM_SHUFFLE(2, 3, 0, 1));
+  const __m256i shuf23_p =
+      _mm256_shufflehi_epi16(*in23, _MM_SHUFFLE(2, 3, 0, 1));
+  // 00 01 10 11 03 02 13 12
+  // 20 21 30 31 23 22 33 32
+  const __m256i s01 = _mm256_unpacklo_epi64(shuf01_p, shuf23_p);
+  const __m256i s32 = _mm256_unpackhi_epi64(shuf01_p, shuf23_p);
+  // 00 01 10 11 20 21 30 31
+  // 03 02 13 12 23 22 33 32
+  const __m256i a01 = _mm256_add_epi16(s01, s32);
+  const __m256i a32 = _mm256_sub_epi16(s01, s32);
+  // [d0 + d3 | d1 + d2 | ...] = [a0 a1 | a0' a1' | ... ]
+  // [d0 - d3 | d1 - d2 | ...] = [a3 a2 | a3' a2' | ... ]
+
+  const __m256i tmp0 = _mm256_madd_epi16(a01, k88p);  // [ (a0 + a1) << 3, ... ]
+  const __m256i tmp2 = _mm256_madd_epi16(a01, k88m);  // [ (a0 - a1) << 3, ... ]
+  const __m256i tmp1_1 = _mm256_madd_epi16(a32, k5352_2217p);
+  const __m256i tmp3_1 = _mm256_madd_epi16(a32, k5352_2217m);
+  const __m256i tmp1_2 = _mm256_add_epi32(tmp1_1, k1812);
+  const __m256i tmp3_2 = _mm256_add_epi32(tmp3_1, k937);
+  const __m256i tmp1 = _mm256_srai_epi32(tmp1_2, 9);
+  const __m256i tmp3 = _mm256_srai_epi32(tmp3_2, 9);
+  const __m256i s03 = _mm256_packs_epi32(tmp0, tmp2);
+  const __m256i s12 = _mm256_packs_epi32(tmp1, tmp3);
+  const __m256i s_lo = _mm256_unpacklo_epi16(s03, s12);  // 0 1 0 1 0 1...
+  const __m256i s_hi = _mm256_unpackhi_epi16(s03, s12);  // 2 3 2 3 2 3
+  const __m256i v23 = _mm256_unpackhi_epi32(s_lo, s_hi);
+  *out01 = _mm256_unpacklo_epi32(s_lo, s_hi);
+  *out32 = _mm256_shuffle_epi32(v23, _MM_SHUFFLE(1, 0, 3, 2));  // 3 2 3 2..
+}
+
+// Same as FTransformPass2_SSE2(), on one block per lane. The block of the
+// lower lane is stored in out[0..15], the one of the upper lane in
+// out[16..31].
+static WEBP_INLINE void FTransformPass2_AVX2(const __m256i* const v01,
+                                             const __m256i* const v32,
+                                             int16_t* WEBP_RESTRICT out) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i seven = _mm256_set1_epi16(7);
+  const __m256i k5352_2217 = _mm256_broadcastsi128_si256(
+      _mm_set_epi16(5352, 2217, 5352, 2217, 5352, 2217, 5352, 2217));
+  const __m256i k2217_5352 = _mm256_broadcastsi128_si256(
+      _mm_set_epi16(2217, -5352, 2217, -5352, 2217, -5352, 2217, -5352));
+  const __m256i k12000_plus_one = _mm256_set1_epi32(12000 + (1 << 16));
+  const __m256i k51000 = _mm256_set1_epi32(51000);
+
+  // Same operations are done on the (0,3) and (1,2) pairs.
+  // a3 = v0 - v3
+  // a2 = v1 - v2
+  const __m256i a32 = _mm256_sub_epi16(*v01, *v32);
+  const __m256i a22 = _mm256_unpackhi_epi64(a32, a32);
+
+  const __m256i b23 = _mm256_unpacklo_epi16(a22, a32);
+  const __m256i c1 = _mm256_madd_epi16(b23, k5352_2217);
+  const __m256i c3 = _mm256_madd_epi16(b23, k2217_5352);
+  const __m256i d1 = _mm256_add_epi32(c1, k12000_plus_one);
+  const __m256i d3 = _mm256_add_epi32(c3, k51000);
+  const __m256i e1 = _mm256_srai_epi32(d1, 16);
+  const __m256i e3 = _mm256_srai_epi32(d3, 16);
+  // f1 = ((b3 * 5352 + b2 * 2217 + 12000) >> 16)
+  // f3 = ((b3 * 2217 - b2 * 5352 + 51000) >> 16)
+  const __m256i f1 = _mm256_packs_epi32(e1, e1);
+  const __m256i f3 = _mm256_packs_epi32(e3, e3);
+  // g1 = f1 + (a3 != 0), see FTransformPass2_SSE2().
+  const __m256i g1 = _mm256_add_epi16(f1, _mm256_cmpeq_epi16(a32, zero));
+
+  // a0 = v0 + v3
+  // a1 = v1 + v2
+  const __m256i a01 = _mm256_add_epi16(*v01, *v32);
+  const __m256i a01_plus_7 = _mm256_add_epi16(a01, seven);
+  const __m256i a11 = _mm256_unpackhi_epi64(a01, a01);
+  const __m256i c0 = _mm256_add_epi16(a01_plus_7, a11);
+  const __m256i c2 = _mm256_sub_epi16(a01_plus_7, a11);
+  // d0 = (a0 + a1 + 7) >> 4;
+  // d2 = (a0 - a1 + 7) >> 4;
+  const __m256i d0 = _mm256_srai_epi16(c0, 4);
+  const __m256i d2 = _mm256_srai_epi16(c2, 4);
+
+  const __m256i d0_g1 = _mm256_unpacklo_epi64(d0, g1);
+  const __m256i d2_f3 = _mm256_unpacklo_epi64(d2, f3);
+  // 0..7 of the first block | 0..7 of the second block
+  // 8..15 of the first block | 8..15 of the second block
+  _mm256_storeu_si256((__m256i*)&out[0],
+                      _mm256_permute2x128_si256(d0_g1, d2_f3, 0x20));
+  _mm256_storeu_si256((__m256i*)&out[16],
+                      _mm256_permute2x128_si256(d0_g1, d2_f3, 0x31));
+}
+
+static void FTransform2_AVX2(const uint8_t* WEBP_RESTRICT src,
+                             const uint8_t* WEBP_RESTRICT ref,
+                             int16_t* WEBP_RESTRICT out) {
+  // Load 8 pixels per row (two blocks) and interleave rows by pairs:
+  // 00 01 10 11 02 03 12 13 | 04 05 14 15 06 07 16 17
+  // which is the input layout of FTransformPass1_SSE2() for each block.
+  const __m128i src0 = _mm_loadl_epi64((const __m128i*)&src[0 * BPS]);
+  const __m128i src1 = _mm_loadl_epi64((const __m128i*)&src[1 * BPS]);
+  const __m128i src2 = _mm_loadl_epi64((const __m128i*)&src[2 * BPS]);
+  const __m128i src3 = _mm_loadl_epi64((const __m128i*)&src[3 * BPS]);
+  const __m128i ref0 = _mm_loadl_epi64((const __m128i*)&ref[0 * BPS]);
+  const __m128i ref1 = _mm_loadl_epi64((const __m128i*)&ref[1 * BPS]);
+  const __m128i ref2 = _mm_loadl_epi64((const __m128i*)&ref[2 * BPS]);
+  const __m128i ref3 = _mm_loadl_epi64((const __m128i*)&ref[3 * BPS]);
+  // Convert to 16b and compute the difference.
+  const __m256i src_01 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi16(src0, src1));
+  const __m256i src_23 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi16(src2, src3));
+  const __m256i ref_01 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi16(ref0, ref1));
+  const __m256i ref_23 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi16(ref2, ref3));
+  const __m256i row01 = _mm256_sub_epi16(src_01, ref_01);
+  const __m256i row23 = _mm256_sub_epi16(src_23, ref_23);
+  __m256i v01, v32;
+
+  // First pass
+  FTransformPass1_AVX2(&row01, &row23, &v01, &v32);
+
+  // Second pass
+  FTransformPass2_AVX2(&v01, &v32, out);
+}
+
+//------------------------------------------------------------------------------
+// Compute susceptibility based on DCT-coeff histograms.
+
+static void CollectHistogram_AVX2(const uint8_t* WEBP_RESTRICT ref,
+                                  const uint8_t* WEBP_RESTRICT pred,
+                                  int start_block, int end_block,
+                                  VP8Histogram* WEBP_RESTRICT const histo) {
+  const __m256i max_coeff_thresh = _mm256_set1_epi16(MAX_COEFF_THRESH);
+  int j;
+  int distribution[MAX_COEFF_THRESH + 1] = {0};
+  for (j = start_block; j < end_block;) {
+    int16_t out[32];
+    int k, num_coeffs;
+
+    // Horizontally adjacent blocks are transformed together.
+    if (j + 1 < end_block && VP8DspScan[j + 1] == VP8DspScan[j] + 4) {
+      FTransform2_AVX2(ref + VP8DspScan[j], pred + VP8DspScan[j], out);
+      num_coeffs = 32;
+      j += 2;
+    } else {
+      VP8FTransform(ref + VP8DspScan[j], pred + VP8DspScan[j], out);
+      _mm256_storeu_si256((__m256i*)&out[16], _mm256_setzero_si256());
+      num_coeffs = 16;
+      j += 1;
+    }
+
+    // Convert coefficients to bin (within out[]).
+    {
+      // Load.
+      const __m256i out0 = _mm256_loadu_si256((__m256i*)&out[0]);
+      const __m256i out1 = _mm256_loadu_si256((__m256i*)&out[16]);
+      // v = abs(out) >> 3
+      const __m256i v0 = _mm256_srai_epi16(_mm256_abs_epi16(out0), 3);
+      const __m256i v1 = _mm256_srai_epi16(_mm256_abs_epi16(out1), 3);
+      // bin = min(v, MAX_COEFF_THRESH)
+      const __m256i bin0 = _mm256_min_epi16(v0, max_coeff_thresh);
+      const __m256i bin1 = _mm256_min_epi16(v1, max_coeff_thresh);
+      // Store.
+      _mm256_storeu_si256((__m256i*)&out[0], bin0);
+      _mm256_storeu_si256((__m256i*)&out[16], bin1);
+    }
+
+    // Convert coefficients to bin.
+    for (k = 0; k < num_coeffs; ++k) {
+      ++distribution[out[k]];
+    }
+  }
+  VP8SetHistogramData(distribution, histo);
+}
+
+//------------------------------------------------------------------------------
+// Metric
+
+// Returns the sum of squared differences of 'num_pairs' pairs of 16-pixel
+// rows, one row per lane.
+static WEBP_INLINE int SSE_16xN_AVX2(const uint8_t* WEBP_RESTRICT a,
+                                     const uint8_t* WEBP_RESTRICT b,
+                                     int num_pairs) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i sum = zero;
+  int i;
+
+  for (i = 0; i < num_pairs; ++i) {
+    const __m256i a01 = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)&a[BPS * 0])),
+        _mm_loadu_si128((const __m128i*)&a[BPS * 1]), 1);
+    const __m256i b01 = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)&b[BPS * 0])),
+        _mm_loadu_si128((const __m128i*)&b[BPS * 1]), 1);
+    // take abs(a-b) in 8b
+    const __m256i a_b = _mm256_subs_epu8(a01, b01);
+    const __m256i b_a = _mm256_subs_epu8(b01, a01);
+    const __m256i abs_a_b = _mm256_or_si256(a_b, b_a);
+    // zero-extend to 16b
+    const __m256i C0 = _mm256_unpacklo_epi8(abs_a_b, zero);
+    const __m256i C1 = _mm256_unpackhi_epi8(abs_a_b, zero);
+    // multiply with self
+    const __m256i sum1 = _mm256_madd_epi16(C0, C0);
+    const __m256i sum2 = _mm256_madd_epi16(C1, C1);
+    sum = _mm256_add_epi32(sum, _mm256_add_epi32(sum1, sum2));
+    a += 2 * BPS;
+    b += 2 * BPS;
+  }
+  return HorizontalSum_AVX2(sum);
+}
+
+static int SSE16x16_AVX2(const uint8_t* WEBP_RESTRICT a,
+                         const uint8_t* WEBP_RESTRICT b) {
+  return SSE_16xN_AVX2(a, b, 8);
+}
+
+static int SSE16x8_AVX2(const uint8_t* WEBP_RESTRICT a,
+                        const uint8_t* WEBP_RESTRICT b) {
+  return SSE_16xN_AVX2(a, b, 4);
+}
+
+//------------------------------------------------------------------------------
+// Texture distortion
+//
+// We try to match the spectral content (weighted) between source and
+// reconstructed samples.
+
+// Transposes the two 4x4 blocks of each lane, see VP8Transpose_2_4x4_16b().
+static WEBP_INLINE void Transpose_2_4x4_16b_AVX2(
+    const __m256i* const in0, const __m256i* const in1,
+    const __m256i* const in2, const __m256i* const in3, __m256i* const out0,
+    __m256i* const out1, __m256i* const out2, __m256i* const out3) {
+  const __m256i transpose0_0 = _mm256_unpacklo_epi16(*in0, *in1);
+  const __m256i transpose0_1 = _mm256_unpacklo_epi16(*in2, *in3);
+  const __m256i transpose0_2 = _mm256_unpackhi_epi16(*in0, *in1);
+  const __m256i transpose0_3 = _mm256_unpackhi_epi16(*in2, *in3);
+  const __m256i transpose1_0 =
+      _mm256_unpacklo_epi32(transpose0_0, transpose0_1);
+  const __m256i transpose1_1 =
+      _mm256_unpacklo_epi32(transpose0_2, transpose0_3);
+  const __m256i transpose1_2 =
+      _mm256_unpackhi_epi32(transpose0_0, transpose0_1);
+  const __m256i transpose1_3 =
+      _mm256_unpackhi_epi32(transpose0_2, transpose0_3);
+  *out0 = _mm256_unpacklo_epi64(transpose1_0, transpose1_1);
+  *out1 = _mm256_unpackhi_epi64(transpose1_0, transpose1_1);
+  *out2 = _mm256_unpacklo_epi64(transpose1_2, transpose1_3);
+  *out3 = _mm256_unpackhi_epi64(transpose1_2, transpose1_3);
+}
+
+// Hadamard transform of the two horizontally adjacent 4x4 blocks at 'inA'
+// and 'inA + 4' (resp. 'inB'). Each lane does the work of TTransform_SSE41()
+// for one block position. Returns the weighted sum difference of the first
+// block in 'sum[0]' and of the second block in 'sum[1]'.
+static WEBP_INLINE void TTransform2_AVX2(const uint8_t* inA,
+                                         const uint8_t* inB,
+                                         const uint16_t* const w,
+                                         int sum[2]) {
+  __m256i tmp_0, tmp_1, tmp_2, tmp_3;
+
+  // Load and combine inputs.
+  {
+    const __m128i inA_0 = _mm_loadl_epi64((const __m128i*)&inA[BPS * 0]);
+    const __m128i inA_1 = _mm_loadl_epi64((const __m128i*)&inA[BPS * 1]);
+    const __m128i inA_2 = _mm_loadl_epi64((const __m128i*)&inA[BPS * 2]);
+    const __m128i inA_3 = _mm_loadl_epi64((const __m128i*)&inA[BPS * 3]);
+    const __m128i inB_0 = _mm_loadl_epi64((const __m128i*)&inB[BPS * 0]);
+    const __m128i inB_1 = _mm_loadl_epi64((const __m128i*)&inB[BPS * 1]);
+    const __m128i inB_2 = _mm_loadl_epi64((const __m128i*)&inB[BPS * 2]);
+    const __m128i inB_3 = _mm_loadl_epi64((const __m128i*)&inB[BPS * 3]);
+
+    // Combine inA and inB (we'll do four transforms in parallel).
+    tmp_0 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi32(inA_0, inB_0));
+    tmp_1 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi32(inA_1, inB_1));
+    tmp_2 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi32(inA_2, inB_2));
+    tmp_3 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi32(inA_3, inB_3));
+    // a00 a01 a02 a03   b00 b01 b02 b03 | a04 .. a07   b04 .. b07
+    // a10 a11 a12 a13   b10 b11 b12 b13 | a14 .. a17   b14 .. b17
+    // a20 a21 a22 a23   b20 b21 b22 b23 | a24 .. a27   b24 .. b27
+    // a30 a31 a32 a33   b30 b31 b32 b33 | a34 .. a37   b34 .. b37
+  }
+
+  // Vertical pass first to avoid a transpose (vertical and horizontal passes
+  // are commutative because w/kWeightY is symmetric) and subsequent transpose.
+  {
+    const __m256i a0 = _mm256_add_epi16(tmp_0, tmp_2);
+    const __m256i a1 = _mm256_add_epi16(tmp_1, tmp_3);
+    const __m256i a2 = _mm256_sub_epi16(tmp_1, tmp_3);
+    const __m256i a3 = _mm256_sub_epi16(tmp_0, tmp_2);
+    const __m256i b0 = _mm256_add_epi16(a0, a1);
+    const __m256i b1 = _mm256_add_epi16(a3, a2);
+    const __m256i b2 = _mm256_sub_epi16(a3, a2);
+    const __m256i b3 = _mm256_sub_epi16(a0, a1);
+
+    Transpose_2_4x4_16b_AVX2(&b0, &b1, &b2, &b3, &tmp_0, &tmp_1, &tmp_2,
+                             &tmp_3);
+  }
+
+  // Horizontal pass and difference of weighted sums.
+  {
+    const __m256i w_0 =
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&w[0]));
+    const __m256i w_8 =
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&w[8]));
+
+    const __m256i a0 = _mm256_add_epi16(tmp_0, tmp_2);
+    const __m256i a1 = _mm256_add_epi16(tmp_1, tmp_3);
+    const __m256i a2 = _mm256_sub_epi16(tmp_1, tmp_3);
+    const __m256i a3 = _mm256_sub_epi16(tmp_0, tmp_2);
+    const __m256i b0 = _mm256_add_epi16(a0, a1);
+    const __m256i b1 = _mm256_add_epi16(a3, a2);
+    const __m256i b2 = _mm256_sub_epi16(a3, a2);
+    const __m256i b3 = _mm256_sub_epi16(a0, a1);
+
+    // Separate the transforms of inA and inB.
+    __m256i A_b0 = _mm256_unpacklo_epi64(b0, b1);
+    __m256i A_b2 = _mm256_unpacklo_epi64(b2, b3);
+    __m256i B_b0 = _mm256_unpackhi_epi64(b0, b1);
+    __m256i B_b2 = _mm256_unpackhi_epi64(b2, b3);
+
+    A_b0 = _mm256_abs_epi16(A_b0);
+    A_b2 = _mm256_abs_epi16(A_b2);
+    B_b0 = _mm256_abs_epi16(B_b0);
+    B_b2 = _mm256_abs_epi16(B_b2);
+
+    // weighted sums
+    A_b0 = _mm256_madd_epi16(A_b0, w_0);
+    A_b2 = _mm256_madd_epi16(A_b2, w_8);
+    B_b0 = _mm256_madd_epi16(B_b0, w_0);
+    B_b2 = _mm256_madd_epi16(B_b2, w_8);
+    A_b0 = _mm256_add_epi32(A_b0, A_b2);
+    B_b0 = _mm256_add_epi32(B_b0, B_b2);
+
+    // difference of weighted sums, reduced within each lane
+    {
+      const __m256i d = _mm256_sub_epi32(A_b0, B_b0);
+      const __m256i d2 = _mm256_add_epi32(d, _mm256_unpackhi_epi64(d, d));
+      const __m256i d1 = _mm256_add_epi32(
+          d2, _mm256_shuffle_epi32(d2, _MM_SHUFFLE(1, 1, 1, 1)));
+      sum[0] = _mm_cvtsi128_si32(_mm256_castsi256_si128(d1));
+      sum[1] = _mm_cvtsi128_si32(_mm256_extracti128_si256(d1, 1));
+    }
+  }
+}
+
+static int Disto16x16_AVX2(const uint8_t* WEBP_RESTRICT const a,
+                           const uint8_t* WEBP_RESTRICT const b,
+                           const uint16_t* WEBP_RESTRICT const w) {
+  int D = 0;
+  int x, y;
+  for (y = 0; y < 16 * BPS; y += 4 * BPS) {
+    for (x = 0; x < 16; x += 8) {
+      int sum[2];
+      TTransform2_AVX2(a + x + y, b + x + y, w, sum);
+      D += (abs(sum[0]) >> 5) + (abs(sum[1]) >> 5);
+    }
+  }
+  return D;
+}
+
+//------------------------------------------------------------------------------
+// Quantization
+//
+
+// Generates a pshufb constant for shuffling 16b words, in both lanes.
+#define PSHUFB_CST(A, B, C, D, E, F, G, H)                               \
+  _mm256_broadcastsi128_si256(                                           \
+      _mm_set_epi8(2 * (H) + 1, 2 * (H) + 0, 2 * (G) + 1, 2 * (G) + 0,   \
+                   2 * (F) + 1, 2 * (F) + 0, 2 * (E) + 1, 2 * (E) + 0,   \
+                   2 * (D) + 1, 2 * (D) + 0, 2 * (C) + 1, 2 * (C) + 0,   \
+                   2 * (B) + 1, 2 * (B) + 0, 2 * (A) + 1, 2 * (A) + 0))
+
+// Loads [ptr[0..7] | ptr[16..23]], i.e. the same 8 coefficients of two
+// consecutive blocks.
+#define LOAD_2x8(ptr)                                              \
+  _mm256_inserti128_si256(                                         \
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(ptr))), \
+      _mm_loadu_si128((const __m128i*)((ptr) + 16)), 1)
+
+#define STORE_2x8(ptr, v)                                               \
+  do {                                                                  \
+    _mm_storeu_si128((__m128i*)(ptr), _mm256_castsi256_si128(v));       \
+    _mm_storeu_si128((__m128i*)((ptr) + 16),                            \
+                     _mm256_extracti128_si256((v), 1));                 \
+  } while (0)
+
+// Same as DoQuantizeBlock_SSE41(), on two blocks at once (one per lane).
+// Returns the non-zero flags of the first and second blocks in bits 0 and 1.
+static int Quantize2Blocks_AVX2(int16_t in[32], int16_t out[32],
+                                const VP8Matrix* WEBP_RESTRICT const mtx) {
+  const __m256i max_coeff_2047 = _mm256_set1_epi16(MAX_LEVEL);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i out0, out8;
+  int mask;
+
+  // Load all inputs.
+  __m256i in0 = LOAD_2x8(&in[0]);
+  __m256i in8 = LOAD_2x8(&in[8]);
+  const __m256i iq0 =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&mtx->iq[0]));
+  const __m256i iq8 =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&mtx->iq[8]));
+  const __m256i q0 =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&mtx->q[0]));
+  const __m256i q8 =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&mtx->q[8]));
+
+  // coeff = abs(in)
+  __m256i coeff0 = _mm256_abs_epi16(in0);
+  __m256i coeff8 = _mm256_abs_epi16(in8);
+
+  // coeff = abs(in) + sharpen
+  {
+    const __m256i sharpen0 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)&mtx->sharpen[0]));
+    const __m256i sharpen8 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)&mtx->sharpen[8]));
+    coeff0 = _mm256_add_epi16(coeff0, sharpen0);
+    coeff8 = _mm256_add_epi16(coeff8, sharpen8);
+  }
+
+  // out = (coeff * iQ + B) >> QFIX
+  {
+    // doing calculations with 32b precision (QFIX=17)
+    // out = (coeff * iQ)
+    const __m256i coeff_iQ0H = _mm256_mulhi_epu16(coeff0, iq0);
+    const __m256i coeff_iQ0L = _mm256_mullo_epi16(coeff0, iq0);
+    const __m256i coeff_iQ8H = _mm256_mulhi_epu16(coeff8, iq8);
+    const __m256i coeff_iQ8L = _mm256_mullo_epi16(coeff8, iq8);
+    __m256i out_00 = _mm256_unpacklo_epi16(coeff_iQ0L, coeff_iQ0H);
+    __m256i out_04 = _mm256_unpackhi_epi16(coeff_iQ0L, coeff_iQ0H);
+    __m256i out_08 = _mm256_unpacklo_epi16(coeff_iQ8L, coeff_iQ8H);
+    __m256i out_12 = _mm256_unpackhi_epi16(coeff_iQ8L, coeff_iQ8H);
+    // out = (coeff * iQ + B)
+    const __m256i bias_00 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)&mtx->bias[0]));
+    const __m256i bias_04 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)&mtx->bias[4]));
+    const __m256i bias_08 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)&mtx->bias[8]));
+    const __m256i bias_12 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)&mtx->bias[12]));
+    out_00 = _mm256_add_epi32(out_00, bias_00);
+    out_04 = _mm256_add_epi32(out_04, bias_04);
+    out_08 = _mm256_add_epi32(out_08, bias_08);
+    out_12 = _mm256_add_epi32(out_12, bias_12);
+    // out = QUANTDIV(coeff, iQ, B, QFIX)
+    out_00 = _mm256_srai_epi32(out_00, QFIX);
+    out_04 = _mm256_srai_epi32(out_04, QFIX);
+    out_08 = _mm256_srai_epi32(out_08, QFIX);
+    out_12 = _mm256_srai_epi32(out_12, QFIX);
+
+    // pack result as 16b
+    out0 = _mm256_packs_epi32(out_00, out_04);
+    out8 = _mm256_packs_epi32(out_08, out_12);
+
+    // if (coeff > 2047) coeff = 2047
+    out0 = _mm256_min_epi16(out0, max_coeff_2047);
+    out8 = _mm256_min_epi16(out8, max_coeff_2047);
+  }
+
+  // put sign back
+  out0 = _mm256_sign_epi16(out0, in0);
+  out8 = _mm256_sign_epi16(out8, in8);
+
+  // in = out * Q
+  in0 = _mm256_mullo_epi16(out0, q0);
+  in8 = _mm256_mullo_epi16(out8, q8);
+
+  STORE_2x8(&in[0], in0);
+  STORE_2x8(&in[8], in8);
+
+  // zigzag the output before storing it, see DoQuantizeBlock_SSE41().
+  {
+    const __m256i kCst_lo = PSHUFB_CST(0, 1, 4, -1, 5, 2, 3, 6);
+    const __m256i kCst_7 = PSHUFB_CST(-1, -1, -1, -1, 7, -1, -1, -1);
+    const __m256i tmp_lo = _mm256_shuffle_epi8(out0, kCst_lo);
+    const __m256i tmp_7 = _mm256_shuffle_epi8(out0, kCst_7);  // extract #7
+    const __m256i kCst_hi = PSHUFB_CST(1, 4, 5, 2, -1, 3, 6, 7);
+    const __m256i kCst_8 = PSHUFB_CST(-1, -1, -1, 0, -1, -1, -1, -1);
+    const __m256i tmp_hi = _mm256_shuffle_epi8(out8, kCst_hi);
+    const __m256i tmp_8 = _mm256_shuffle_epi8(out8, kCst_8);  // extract #8
+    const __m256i out_z0 = _mm256_or_si256(tmp_lo, tmp_8);
+    const __m256i out_z8 = _mm256_or_si256(tmp_hi, tmp_7);
+    const __m256i packed_out = _mm256_packs_epi16(out_z0, out_z8);
+    STORE_2x8(&out[0], out_z0);
+    STORE_2x8(&out[8], out_z8);
+    mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(packed_out, zero));
+  }
+
+  // detect if all 'out' values are zeroes or not, for each block
+  return (((uint32_t)mask & 0xffffu) != 0xffffu) |
+         ((((uint32_t)mask >> 16) != 0xffffu) << 1);
+}
+
+#undef PSHUFB_CST
+#undef LOAD_2x8
+#undef STORE_2x8
+
+//------------------------------------------------------------------------------
+// Entry point
+
+extern void VP8EncDspInitAVX2(void);
+WEBP_TSAN_IGNORE_FUNCTION void VP8EncDspInitAVX2(void) {
+  VP8FTransform2 = FTransform2_AVX2;
+  VP8CollectHistogram = CollectHistogram_AVX2;
+  VP8SSE16x16 = SSE16x16_AVX2;
+  VP8SSE16x8 = SSE16x8_AVX2;
+  VP8TDisto16x16 = Disto16x16_AVX2;
+  VP8EncQuantize2Blocks = Quantize2Blocks_AVX2;
+}
+
+#else  // !WEBP_USE_AVX2
+
+WEBP_DSP_INIT_STUB(VP8EncDspInitAVX2)
+
+#endif  // WEBP_USE_AVX2
@@ -270,6 +270,7 @@ WEBP_DSP_INIT_FUNC(WebPInitYUV444Converters) {
 
 extern void WebPInitUpsamplersSSE2(void);
 extern void WebPInitUpsamplersSSE41(void);
+extern void WebPInitUpsamplersAVX2(void);
 extern void WebPInitUpsamplersNEON(void);
 extern void WebPInitUpsamplersMIPSdspR2(void);
 extern void WebPInitUpsamplersMSA(void);
@@ -300,6 +301,11 @@ WEBP_DSP_INIT_FUNC(WebPInitUpsamplers) {
 #if defined(WEBP_HAVE_SSE41)
     if (VP8GetCPUInfo(kSSE4_1)) {
       WebPInitUpsamplersSSE41();
+#if defined(WEBP_HAVE_AVX2)
+      if (VP8GetCPUInfo(kAVX2)) {
+        WebPInitUpsamplersAVX2();
+      }
+#endif
     }
 #endif
 #if defined(WEBP_USE_MIPS_DSP_R2)
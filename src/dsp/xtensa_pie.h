@@ -12,6 +12,7 @@
 
 #include <stdint.h>
 #include <stdalign.h>
+#include <string.h>
 
 // PIE Q registers are 128-bit (16 bytes)
 // They can hold 16 x int8, 8 x int16, 4 x int32, or 4 x float32
@@ -32,6 +33,8 @@
 #define PIE_TRANSFORM_C1 20091
 #define PIE_TRANSFORM_C2 35468
 
+#if !defined(WEBP_XTENSA_PIE_EMULATION)
+
 //------------------------------------------------------------------------------
 // Low-level PIE inline assembly wrappers
 //
@@ -76,6 +79,57 @@
         : "memory" \
     )
 
+// Load/store the low or high 64 bits of a Q register, leaving the other half
+// unchanged. The address must be 8-byte aligned.
+#define PIE_VLD_L_64(qreg, ptr) \
+    __asm__ volatile ( \
+        "ee.vld.l.64.ip " #qreg ", %0, 0" \
+        : \
+        : "a"(ptr) \
+        : "memory" \
+    )
+
+#define PIE_VLD_H_64(qreg, ptr) \
+    __asm__ volatile ( \
+        "ee.vld.h.64.ip " #qreg ", %0, 0" \
+        : \
+        : "a"(ptr) \
+        : "memory" \
+    )
+
+#define PIE_VST_L_64(qreg, ptr) \
+    __asm__ volatile ( \
+        "ee.vst.l.64.ip " #qreg ", %0, 0" \
+        : \
+        : "a"(ptr) \
+        : "memory" \
+    )
+
+#define PIE_VST_H_64(qreg, ptr) \
+    __asm__ volatile ( \
+        "ee.vst.h.64.ip " #qreg ", %0, 0" \
+        : \
+        : "a"(ptr) \
+        : "memory" \
+    )
+
+// Move a 32-bit value from an A register to lane 'sel' (0..3) of a Q register
+#define PIE_MOVI_32_Q(qreg, value, sel) \
+    __asm__ volatile ( \
+        "ee.movi.32.q " #qreg ", %0, " #sel \
+        : \
+        : "a"(value) \
+        : \
+    )
+
+// Move lane 'sel' (0..3) of a Q register to an A register
+#define PIE_MOVI_32_A(qreg, result, sel) \
+    __asm__ volatile ( \
+        "ee.movi.32.a " #qreg ", %0, " #sel \
+        : "=a"(result) \
+        : : \
+    )
+
 // Saturating add for signed 16-bit: dst = a + b (saturated)
 #define PIE_VADDS_S16(dst, a, b) \
     __asm__ volatile ( \
@@ -113,6 +167,70 @@
         : "memory" \
     )
 
+// Broadcast 8-bit value to all lanes of Q register
+#define PIE_VLDBC_8(qreg, ptr) \
+    __asm__ volatile ( \
+        "ee.vldbc.8 " #qreg ", %0" \
+        : \
+        : "a"(ptr) \
+        : "memory" \
+    )
+
+// Multiply signed 16-bit: dst = (a * b) >> shift, truncated to 16 bits.
+// 'shift' must be a literal in [0, 31]; it is loaded in SAR by the same
+// statement.
+#define PIE_VMUL_S16(dst, a, b, shift) \
+    __asm__ volatile ( \
+        "ssai " #shift "\n\t" \
+        "ee.vmul.s16 " #dst ", " #a ", " #b \
+        : : : \
+    )
+
+// Signed 16-bit maximum / minimum
+#define PIE_VMAX_S16(dst, a, b) \
+    __asm__ volatile ( \
+        "ee.vmax.s16 " #dst ", " #a ", " #b \
+        : : : \
+    )
+
+#define PIE_VMIN_S16(dst, a, b) \
+    __asm__ volatile ( \
+        "ee.vmin.s16 " #dst ", " #a ", " #b \
+        : : : \
+    )
+
+// Signed 16-bit compare: lanes of dst are all ones where a > b, zero elsewhere
+#define PIE_VCMP_GT_S16(dst, a, b) \
+    __asm__ volatile ( \
+        "ee.vcmp.gt.s16 " #dst ", " #a ", " #b \
+        : : : \
+    )
+
+// Bitwise operations
+#define PIE_ANDQ(dst, a, b) \
+    __asm__ volatile ( \
+        "ee.andq " #dst ", " #a ", " #b \
+        : : : \
+    )
+
+#define PIE_ORQ(dst, a, b) \
+    __asm__ volatile ( \
+        "ee.orq " #dst ", " #a ", " #b \
+        : : : \
+    )
+
+#define PIE_XORQ(dst, a, b) \
+    __asm__ volatile ( \
+        "ee.xorq " #dst ", " #a ", " #b \
+        : : : \
+    )
+
+#define PIE_NOTQ(dst, a) \
+    __asm__ volatile ( \
+        "ee.notq " #dst ", " #a \
+        : : : \
+    )
+
 // Interleave bytes (widen int8 to int16)
 #define PIE_VZIP_8(qreg_a, qreg_b) \
     __asm__ volatile ( \
@@ -127,6 +245,33 @@
         : : : \
     )
 
+// Interleave 32-bit values
+#define PIE_VZIP_32(qreg_a, qreg_b) \
+    __asm__ volatile ( \
+        "ee.vzip.32 " #qreg_a ", " #qreg_b \
+        : : : \
+    )
+
+// De-interleave (inverse of the zips): the even elements of the a:b pair go
+// to 'a', the odd ones to 'b'. PIE_VUNZIP_8 narrows int16 to int8.
+#define PIE_VUNZIP_8(qreg_a, qreg_b) \
+    __asm__ volatile ( \
+        "ee.vunzip.8 " #qreg_a ", " #qreg_b \
+        : : : \
+    )
+
+#define PIE_VUNZIP_16(qreg_a, qreg_b) \
+    __asm__ volatile ( \
+        "ee.vunzip.16 " #qreg_a ", " #qreg_b \
+        : : : \
+    )
+
+#define PIE_VUNZIP_32(qreg_a, qreg_b) \
+    __asm__ volatile ( \
+        "ee.vunzip.32 " #qreg_a ", " #qreg_b \
+        : : : \
+    )
+
 // Clear accumulator
 #define PIE_ZERO_ACCX() \
     __asm__ volatile ("ee.zero.accx" : : :)
@@ -146,6 +291,301 @@
         : : \
     )
 
+#else  // WEBP_XTENSA_PIE_EMULATION
+
+//------------------------------------------------------------------------------
+// Portable C emulation of the wrappers above
+//
+// Selected with -DWEBP_XTENSA_PIE_EMULATION to run and test the PIE code on
+// any host. The Q registers and the ACCX accumulator live in a per-thread
+// state, and the 'qreg' arguments name its fields. Like the hardware, the
+// 128-bit and 64-bit loads and stores ignore the 4 and 3 low bits of the
+// address, so unaligned accesses give the same wrong results as on the
+// ESP32-S3.
+
+#if defined(_MSC_VER)
+#define PIE_THREAD_LOCAL __declspec(thread)
+#else
+#define PIE_THREAD_LOCAL __thread
+#endif
+
+typedef union {
+    uint8_t u8[16];
+    int8_t s8[16];
+    int16_t s16[8];
+} PieQReg;
+
+typedef struct {
+    PieQReg q0, q1, q2, q3, q4, q5, q6, q7;
+    int64_t accx;  // 40-bit accumulator, sign-extended
+} PieState;
+
+static inline PieState* pie_state(void) {
+    static PIE_THREAD_LOCAL PieState state;
+    return &state;
+}
+
+#define PIE_Q(qreg) (pie_state()->qreg)
+
+static inline const void* pie_align_16(const void* ptr) {
+    return (const void*)((uintptr_t)ptr & ~(uintptr_t)15);
+}
+
+static inline void pie_load_128(PieQReg* q, const void* ptr) {
+    memcpy(q->u8, pie_align_16(ptr), 16);
+}
+
+static inline void pie_store_128(const PieQReg* q, void* ptr) {
+    memcpy((void*)((uintptr_t)ptr & ~(uintptr_t)15), q->u8, 16);
+}
+
+static inline int pie_sat_s16(int v) {
+    return (v < -32768) ? -32768 : (v > 32767) ? 32767 : v;
+}
+
+static inline int pie_sat_s8(int v) {
+    return (v < -128) ? -128 : (v > 127) ? 127 : v;
+}
+
+// 'dst' may be 'a' or 'b'.
+static inline void pie_vadds_s16(PieQReg* dst, const PieQReg* a,
+                                 const PieQReg* b) {
+    PieQReg r;
+    int i;
+    for (i = 0; i < 8; ++i) {
+        r.s16[i] = (int16_t)pie_sat_s16(a->s16[i] + b->s16[i]);
+    }
+    *dst = r;
+}
+
+static inline void pie_vsubs_s16(PieQReg* dst, const PieQReg* a,
+                                 const PieQReg* b) {
+    PieQReg r;
+    int i;
+    for (i = 0; i < 8; ++i) {
+        r.s16[i] = (int16_t)pie_sat_s16(a->s16[i] - b->s16[i]);
+    }
+    *dst = r;
+}
+
+static inline void pie_vadds_s8(PieQReg* dst, const PieQReg* a,
+                                const PieQReg* b) {
+    PieQReg r;
+    int i;
+    for (i = 0; i < 16; ++i) {
+        r.s8[i] = (int8_t)pie_sat_s8(a->s8[i] + b->s8[i]);
+    }
+    *dst = r;
+}
+
+static inline void pie_vldbc_16(PieQReg* q, const void* ptr) {
+    int16_t v;
+    int i;
+    memcpy(&v, (const void*)((uintptr_t)ptr & ~(uintptr_t)1), sizeof(v));
+    for (i = 0; i < 8; ++i) q->s16[i] = v;
+}
+
+// Interleaves the elements of 'a' and 'b' of 'size' bytes: the low halves go
+// to 'a', the high halves to 'b'.
+static inline void pie_vzip(PieQReg* a, PieQReg* b, int size) {
+    PieQReg lo, hi;
+    int i;
+    for (i = 0; i < 8 / size; ++i) {
+        memcpy(&lo.u8[2 * i * size], &a->u8[i * size], size);
+        memcpy(&lo.u8[(2 * i + 1) * size], &b->u8[i * size], size);
+        memcpy(&hi.u8[2 * i * size], &a->u8[8 + i * size], size);
+        memcpy(&hi.u8[(2 * i + 1) * size], &b->u8[8 + i * size], size);
+    }
+    *a = lo;
+    *b = hi;
+}
+
+// Inverse of pie_vzip(): the even elements of a:b go to 'a', the odd ones to
+// 'b'.
+static inline void pie_vunzip(PieQReg* a, PieQReg* b, int size) {
+    uint8_t ab[32];
+    int i;
+    memcpy(ab, a->u8, 16);
+    memcpy(ab + 16, b->u8, 16);
+    for (i = 0; i < 16 / size; ++i) {
+        memcpy(&a->u8[i * size], &ab[2 * i * size], size);
+        memcpy(&b->u8[i * size], &ab[(2 * i + 1) * size], size);
+    }
+}
+
+static inline void pie_load_64(PieQReg* q, const void* ptr, int half) {
+    memcpy(&q->u8[8 * half], (const void*)((uintptr_t)ptr & ~(uintptr_t)7),
+           8);
+}
+
+static inline void pie_store_64(const PieQReg* q, void* ptr, int half) {
+    memcpy((void*)((uintptr_t)ptr & ~(uintptr_t)7), &q->u8[8 * half], 8);
+}
+
+static inline void pie_vldbc_8(PieQReg* q, const void* ptr) {
+    memset(q->u8, *(const uint8_t*)ptr, 16);
+}
+
+static inline void pie_vmul_s16(PieQReg* dst, const PieQReg* a,
+                                const PieQReg* b, int shift) {
+    PieQReg r;
+    int i;
+    for (i = 0; i < 8; ++i) {
+        r.s16[i] = (int16_t)(((int32_t)a->s16[i] * b->s16[i]) >> shift);
+    }
+    *dst = r;
+}
+
+// 'op' is 0 for max, 1 for min and 2 for the greater-than compare.
+static inline void pie_vcmp_s16(PieQReg* dst, const PieQReg* a,
+                                const PieQReg* b, int op) {
+    PieQReg r;
+    int i;
+    for (i = 0; i < 8; ++i) {
+        const int16_t x = a->s16[i], y = b->s16[i];
+        r.s16[i] = (op == 0) ? (x > y ? x : y)
+                 : (op == 1) ? (x < y ? x : y)
+                 : (int16_t)(x > y ? -1 : 0);
+    }
+    *dst = r;
+}
+
+// 'op' is 0 for and, 1 for or and 2 for xor.
+static inline void pie_bitwise(PieQReg* dst, const PieQReg* a,
+                               const PieQReg* b, int op) {
+    PieQReg r;
+    int i;
+    for (i = 0; i < 16; ++i) {
+        r.u8[i] = (op == 0) ? (a->u8[i] & b->u8[i])
+                : (op == 1) ? (a->u8[i] | b->u8[i])
+                : (a->u8[i] ^ b->u8[i]);
+    }
+    *dst = r;
+}
+
+static inline void pie_notq(PieQReg* dst, const PieQReg* a) {
+    int i;
+    for (i = 0; i < 16; ++i) dst->u8[i] = (uint8_t)~a->u8[i];
+}
+
+static inline void pie_vmulas_s16_accx(const PieQReg* a, const PieQReg* b) {
+    PieState* const state = pie_state();
+    int64_t acc = state->accx;
+    int i;
+    for (i = 0; i < 8; ++i) acc += (int32_t)a->s16[i] * b->s16[i];
+    // Wrap around to 40 bits.
+    state->accx = (int64_t)((uint64_t)acc << 24) >> 24;
+}
+
+#define PIE_VLD_128_IP(qreg, ptr) \
+    do { \
+        pie_load_128(&PIE_Q(qreg), (ptr)); \
+        (ptr) += 16 / sizeof(*(ptr)); \
+    } while (0)
+
+#define PIE_VST_128_IP(qreg, ptr) \
+    do { \
+        pie_store_128(&PIE_Q(qreg), (ptr)); \
+        (ptr) += 16 / sizeof(*(ptr)); \
+    } while (0)
+
+#define PIE_VLD_128(qreg, ptr) pie_load_128(&PIE_Q(qreg), (ptr))
+
+#define PIE_VST_128(qreg, ptr) pie_store_128(&PIE_Q(qreg), (ptr))
+
+#define PIE_VLD_L_64(qreg, ptr) pie_load_64(&PIE_Q(qreg), (ptr), 0)
+#define PIE_VLD_H_64(qreg, ptr) pie_load_64(&PIE_Q(qreg), (ptr), 1)
+#define PIE_VST_L_64(qreg, ptr) pie_store_64(&PIE_Q(qreg), (ptr), 0)
+#define PIE_VST_H_64(qreg, ptr) pie_store_64(&PIE_Q(qreg), (ptr), 1)
+
+#define PIE_MOVI_32_Q(qreg, value, sel) \
+    do { \
+        const uint32_t pie_value = (uint32_t)(value); \
+        memcpy(&PIE_Q(qreg).u8[4 * (sel)], &pie_value, 4); \
+    } while (0)
+
+#define PIE_MOVI_32_A(qreg, result, sel) \
+    memcpy(&(result), &PIE_Q(qreg).u8[4 * (sel)], 4)
+
+#define PIE_VADDS_S16(dst, a, b) \
+    pie_vadds_s16(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b))
+
+#define PIE_VSUBS_S16(dst, a, b) \
+    pie_vsubs_s16(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b))
+
+#define PIE_VADDS_S8(dst, a, b) \
+    pie_vadds_s8(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b))
+
+#define PIE_VZERO(qreg) memset(&PIE_Q(qreg), 0, sizeof(PieQReg))
+
+#define PIE_VLDBC_16(qreg, ptr) pie_vldbc_16(&PIE_Q(qreg), (ptr))
+
+#define PIE_VLDBC_8(qreg, ptr) pie_vldbc_8(&PIE_Q(qreg), (ptr))
+
+#define PIE_VMUL_S16(dst, a, b, shift) \
+    pie_vmul_s16(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b), (shift))
+
+#define PIE_VMAX_S16(dst, a, b) \
+    pie_vcmp_s16(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b), 0)
+
+#define PIE_VMIN_S16(dst, a, b) \
+    pie_vcmp_s16(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b), 1)
+
+#define PIE_VCMP_GT_S16(dst, a, b) \
+    pie_vcmp_s16(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b), 2)
+
+#define PIE_ANDQ(dst, a, b) pie_bitwise(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b), 0)
+#define PIE_ORQ(dst, a, b) pie_bitwise(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b), 1)
+#define PIE_XORQ(dst, a, b) pie_bitwise(&PIE_Q(dst), &PIE_Q(a), &PIE_Q(b), 2)
+#define PIE_NOTQ(dst, a) pie_notq(&PIE_Q(dst), &PIE_Q(a))
+
+#define PIE_VZIP_8(qreg_a, qreg_b) \
+    pie_vzip(&PIE_Q(qreg_a), &PIE_Q(qreg_b), 1)
+
+#define PIE_VZIP_16(qreg_a, qreg_b) \
+    pie_vzip(&PIE_Q(qreg_a), &PIE_Q(qreg_b), 2)
+
+#define PIE_VZIP_32(qreg_a, qreg_b) \
+    pie_vzip(&PIE_Q(qreg_a), &PIE_Q(qreg_b), 4)
+
+#define PIE_VUNZIP_8(qreg_a, qreg_b) \
+    pie_vunzip(&PIE_Q(qreg_a), &PIE_Q(qreg_b), 1)
+
+#define PIE_VUNZIP_16(qreg_a, qreg_b) \
+    pie_vunzip(&PIE_Q(qreg_a), &PIE_Q(qreg_b), 2)
+
+#define PIE_VUNZIP_32(qreg_a, qreg_b) \
+    pie_vunzip(&PIE_Q(qreg_a), &PIE_Q(qreg_b), 4)
+
+#define PIE_ZERO_ACCX() (pie_state()->accx = 0)
+
+#define PIE_VMULAS_S16_ACCX(a, b) pie_vmulas_s16_accx(&PIE_Q(a), &PIE_Q(b))
+
+#define PIE_RUR_ACCX_0(result) \
+    ((result) = (uint32_t)pie_state()->accx)
+
+#endif  // !WEBP_XTENSA_PIE_EMULATION
+
+//------------------------------------------------------------------------------
+// Scalar 32-bit accesses, used to fill and empty the Q registers with
+// PIE_MOVI_32_Q() / PIE_MOVI_32_A() where the data is only 4-byte aligned.
+
+#if defined(__GNUC__)
+#define PIE_ASSUME_ALIGNED_4(ptr) __builtin_assume_aligned((ptr), 4)
+#else
+#define PIE_ASSUME_ALIGNED_4(ptr) (ptr)
+#endif
+
+static inline uint32_t pie_load_32(const void* ptr) {
+    uint32_t v;
+    memcpy(&v, PIE_ASSUME_ALIGNED_4(ptr), sizeof(v));
+    return v;
+}
+
+static inline void pie_store_32(void* ptr, uint32_t v) {
+    memcpy(PIE_ASSUME_ALIGNED_4(ptr), &v, sizeof(v));
+}
+
 //------------------------------------------------------------------------------
 // Clipping/saturation helpers
 
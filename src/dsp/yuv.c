@@ -90,8 +90,10 @@ WebPSamplerRowFunc WebPSamplers[MODE_LAST];
 extern VP8CPUInfo VP8GetCPUInfo;
 extern void WebPInitSamplersSSE2(void);
 extern void WebPInitSamplersSSE41(void);
+extern void WebPInitSamplersAVX2(void);
 extern void WebPInitSamplersMIPS32(void);
 extern void WebPInitSamplersMIPSdspR2(void);
+extern void WebPInitSamplersXtensa(void);
 
 WEBP_DSP_INIT_FUNC(WebPInitSamplers) {
   WebPSamplers[MODE_RGB] = YuvToRgbRow;
@@ -116,6 +118,11 @@ WEBP_DSP_INIT_FUNC(WebPInitSamplers) {
 #if defined(WEBP_HAVE_SSE41)
     if (VP8GetCPUInfo(kSSE4_1)) {
       WebPInitSamplersSSE41();
+#if defined(WEBP_HAVE_AVX2)
+      if (VP8GetCPUInfo(kAVX2)) {
+        WebPInitSamplersAVX2();
+      }
+#endif
     }
 #endif  // WEBP_HAVE_SSE41
 #if defined(WEBP_USE_MIPS32)
@@ -128,6 +135,11 @@ WEBP_DSP_INIT_FUNC(WebPInitSamplers) {
       WebPInitSamplersMIPSdspR2();
     }
 #endif  // WEBP_USE_MIPS_DSP_R2
+#if defined(WEBP_USE_XTENSA_PIE)
+    if (VP8GetCPUInfo(kXtensaPIE)) {
+      WebPInitSamplersXtensa();
+    }
+#endif  // WEBP_USE_XTENSA_PIE
   }
 }
 
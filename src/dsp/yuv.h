@@ -208,6 +208,35 @@ void VP8YuvToBgr32_SSE41(const uint8_t* WEBP_RESTRICT y,
 
 #endif  // WEBP_USE_SSE41
 
+//-----------------------------------------------------------------------------
+// AVX2 extra functions (mostly for upsampling_avx2.c)
+
+#if defined(WEBP_USE_AVX2)
+
+// Process 32 pixels and store the result (16b or 32b per pixel) in *dst.
+void VP8YuvToRgba32_AVX2(const uint8_t* WEBP_RESTRICT y,
+                         const uint8_t* WEBP_RESTRICT u,
+                         const uint8_t* WEBP_RESTRICT v,
+                         uint8_t* WEBP_RESTRICT dst);
+void VP8YuvToBgra32_AVX2(const uint8_t* WEBP_RESTRICT y,
+                         const uint8_t* WEBP_RESTRICT u,
+                         const uint8_t* WEBP_RESTRICT v,
+                         uint8_t* WEBP_RESTRICT dst);
+void VP8YuvToArgb32_AVX2(const uint8_t* WEBP_RESTRICT y,
+                         const uint8_t* WEBP_RESTRICT u,
+                         const uint8_t* WEBP_RESTRICT v,
+                         uint8_t* WEBP_RESTRICT dst);
+void VP8YuvToRgba444432_AVX2(const uint8_t* WEBP_RESTRICT y,
+                             const uint8_t* WEBP_RESTRICT u,
+                             const uint8_t* WEBP_RESTRICT v,
+                             uint8_t* WEBP_RESTRICT dst);
+void VP8YuvToRgb56532_AVX2(const uint8_t* WEBP_RESTRICT y,
+                           const uint8_t* WEBP_RESTRICT u,
+                           const uint8_t* WEBP_RESTRICT v,
+                           uint8_t* WEBP_RESTRICT dst);
+
+#endif  // WEBP_USE_AVX2
+
 //------------------------------------------------------------------------------
 // RGB -> YUV conversion
 
@@ -0,0 +1,308 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// AVX2 version of the YUV->RGB conversion functions.
+
+#include "src/dsp/yuv.h"
+
+#if defined(WEBP_USE_AVX2)
+#include <immintrin.h>
+
+#include "src/dsp/cpu.h"
+#include "src/dsp/dsp.h"
+#include "src/webp/decode.h"
+#include "src/webp/types.h"
+
+//-----------------------------------------------------------------------------
+// Convert spans of 16 pixels at a time. The arithmetic is the same as in
+// ConvertYUV444ToRGB_SSE2(), only twice as wide, hence bit-exact with it.
+
+static void ConvertYUV444ToRGB_AVX2(const __m256i* const Y0,
+                                    const __m256i* const U0,
+                                    const __m256i* const V0, __m256i* const R,
+                                    __m256i* const G, __m256i* const B) {
+  const __m256i k19077 = _mm256_set1_epi16(19077);
+  const __m256i k26149 = _mm256_set1_epi16(26149);
+  const __m256i k14234 = _mm256_set1_epi16(14234);
+  // 33050 doesn't fit in a signed short: only use this with unsigned arithmetic
+  const __m256i k33050 = _mm256_set1_epi16((short)33050);
+  const __m256i k17685 = _mm256_set1_epi16(17685);
+  const __m256i k6419 = _mm256_set1_epi16(6419);
+  const __m256i k13320 = _mm256_set1_epi16(13320);
+  const __m256i k8708 = _mm256_set1_epi16(8708);
+
+  const __m256i Y1 = _mm256_mulhi_epu16(*Y0, k19077);
+
+  const __m256i R0 = _mm256_mulhi_epu16(*V0, k26149);
+  const __m256i R1 = _mm256_sub_epi16(Y1, k14234);
+  const __m256i R2 = _mm256_add_epi16(R1, R0);
+
+  const __m256i G0 = _mm256_mulhi_epu16(*U0, k6419);
+  const __m256i G1 = _mm256_mulhi_epu16(*V0, k13320);
+  const __m256i G2 = _mm256_add_epi16(Y1, k8708);
+  const __m256i G3 = _mm256_add_epi16(G0, G1);
+  const __m256i G4 = _mm256_sub_epi16(G2, G3);
+
+  // be careful with the saturated *unsigned* arithmetic here!
+  const __m256i B0 = _mm256_mulhi_epu16(*U0, k33050);
+  const __m256i B1 = _mm256_adds_epu16(B0, Y1);
+  const __m256i B2 = _mm256_subs_epu16(B1, k17685);
+
+  // use logical shift for B2, which can be larger than 32767
+  *R = _mm256_srai_epi16(R2, 6);  // range: [-14234, 30815]
+  *G = _mm256_srai_epi16(G4, 6);  // range: [-10953, 27710]
+  *B = _mm256_srli_epi16(B2, 6);  // range: [0, 34238]
+}
+
+// Load 16 bytes into the *upper* part of 16b words. That's "<< 8", basically.
+static WEBP_INLINE __m256i Load_HI_16_AVX2(const uint8_t* src) {
+  const __m128i tmp = _mm_loadu_si128((const __m128i*)src);
+  return _mm256_slli_epi16(_mm256_cvtepu8_epi16(tmp), 8);
+}
+
+// Load and replicate 8 U/V samples
+static WEBP_INLINE __m256i Load_UV_HI_8_AVX2(const uint8_t* src) {
+  const __m128i tmp0 = _mm_loadl_epi64((const __m128i*)src);
+  const __m128i tmp1 = _mm_unpacklo_epi8(tmp0, tmp0);  // replicate samples
+  return _mm256_slli_epi16(_mm256_cvtepu8_epi16(tmp1), 8);
+}
+
+// Convert 16 samples of YUV444 to R/G/B
+static void YUV444ToRGB_AVX2(const uint8_t* WEBP_RESTRICT const y,
+                             const uint8_t* WEBP_RESTRICT const u,
+                             const uint8_t* WEBP_RESTRICT const v,
+                             __m256i* const R, __m256i* const G,
+                             __m256i* const B) {
+  const __m256i Y0 = Load_HI_16_AVX2(y), U0 = Load_HI_16_AVX2(u),
+                V0 = Load_HI_16_AVX2(v);
+  ConvertYUV444ToRGB_AVX2(&Y0, &U0, &V0, R, G, B);
+}
+
+// Convert 16 samples of YUV420 to R/G/B
+static void YUV420ToRGB_AVX2(const uint8_t* WEBP_RESTRICT const y,
+                             const uint8_t* WEBP_RESTRICT const u,
+                             const uint8_t* WEBP_RESTRICT const v,
+                             __m256i* const R, __m256i* const G,
+                             __m256i* const B) {
+  const __m256i Y0 = Load_HI_16_AVX2(y), U0 = Load_UV_HI_8_AVX2(u),
+                V0 = Load_UV_HI_8_AVX2(v);
+  ConvertYUV444ToRGB_AVX2(&Y0, &U0, &V0, R, G, B);
+}
+
+// Pack R/G/B/A results into 32b output. The in-lane unpacking leaves pixels
+// 0-3 and 8-11 in 'lo', 4-7 and 12-15 in 'hi': recombine the lanes on store.
+static WEBP_INLINE void PackAndStore4_AVX2(const __m256i* const R,
+                                           const __m256i* const G,
+                                           const __m256i* const B,
+                                           const __m256i* const A,
+                                           uint8_t* WEBP_RESTRICT const dst) {
+  const __m256i rb = _mm256_packus_epi16(*R, *B);
+  const __m256i ga = _mm256_packus_epi16(*G, *A);
+  const __m256i rg = _mm256_unpacklo_epi8(rb, ga);
+  const __m256i ba = _mm256_unpackhi_epi8(rb, ga);
+  const __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+  const __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+  _mm256_storeu_si256((__m256i*)(dst + 0), _mm256_permute2x128_si256(lo, hi,
+                                                                     0x20));
+  _mm256_storeu_si256((__m256i*)(dst + 32), _mm256_permute2x128_si256(lo, hi,
+                                                                      0x31));
+}
+
+// Pack R/G/B/A results into 16b output.
+static WEBP_INLINE void PackAndStore4444_AVX2(
+    const __m256i* const R, const __m256i* const G, const __m256i* const B,
+    const __m256i* const A, uint8_t* WEBP_RESTRICT const dst) {
+#if (WEBP_SWAP_16BIT_CSP == 0)
+  const __m256i rg0 = _mm256_packus_epi16(*R, *G);
+  const __m256i ba0 = _mm256_packus_epi16(*B, *A);
+#else
+  const __m256i rg0 = _mm256_packus_epi16(*B, *A);
+  const __m256i ba0 = _mm256_packus_epi16(*R, *G);
+#endif
+  const __m256i mask_0xf0 = _mm256_set1_epi8((char)0xf0);
+  const __m256i rb1 = _mm256_unpacklo_epi8(rg0, ba0);  // rbrbrbrbrb...
+  const __m256i ga1 = _mm256_unpackhi_epi8(rg0, ba0);  // gagagagaga...
+  const __m256i rb2 = _mm256_and_si256(rb1, mask_0xf0);
+  const __m256i ga2 =
+      _mm256_srli_epi16(_mm256_and_si256(ga1, mask_0xf0), 4);
+  const __m256i rgba4444 = _mm256_or_si256(rb2, ga2);
+  _mm256_storeu_si256((__m256i*)dst, rgba4444);
+}
+
+// Pack R/G/B results into 16b output.
+static WEBP_INLINE void PackAndStore565_AVX2(const __m256i* const R,
+                                             const __m256i* const G,
+                                             const __m256i* const B,
+                                             uint8_t* WEBP_RESTRICT const dst) {
+  const __m256i r0 = _mm256_packus_epi16(*R, *R);
+  const __m256i g0 = _mm256_packus_epi16(*G, *G);
+  const __m256i b0 = _mm256_packus_epi16(*B, *B);
+  const __m256i r1 = _mm256_and_si256(r0, _mm256_set1_epi8((char)0xf8));
+  const __m256i b1 =
+      _mm256_and_si256(_mm256_srli_epi16(b0, 3), _mm256_set1_epi8(0x1f));
+  const __m256i g1 = _mm256_srli_epi16(
+      _mm256_and_si256(g0, _mm256_set1_epi8((char)0xe0)), 5);
+  const __m256i g2 =
+      _mm256_slli_epi16(_mm256_and_si256(g0, _mm256_set1_epi8(0x1c)), 3);
+  const __m256i rg = _mm256_or_si256(r1, g1);
+  const __m256i gb = _mm256_or_si256(g2, b1);
+#if (WEBP_SWAP_16BIT_CSP == 0)
+  const __m256i rgb565 = _mm256_unpacklo_epi8(rg, gb);
+#else
+  const __m256i rgb565 = _mm256_unpacklo_epi8(gb, rg);
+#endif
+  _mm256_storeu_si256((__m256i*)dst, rgb565);
+}
+
+void VP8YuvToRgba32_AVX2(const uint8_t* WEBP_RESTRICT y,
+                         const uint8_t* WEBP_RESTRICT u,
+                         const uint8_t* WEBP_RESTRICT v,
+                         uint8_t* WEBP_RESTRICT dst) {
+  const __m256i kAlpha = _mm256_set1_epi16(255);
+  int n;
+  for (n = 0; n < 32; n += 16, dst += 64) {
+    __m256i R, G, B;
+    YUV444ToRGB_AVX2(y + n, u + n, v + n, &R, &G, &B);
+    PackAndStore4_AVX2(&R, &G, &B, &kAlpha, dst);
+  }
+}
+
+void VP8YuvToBgra32_AVX2(const uint8_t* WEBP_RESTRICT y,
+                         const uint8_t* WEBP_RESTRICT u,
+                         const uint8_t* WEBP_RESTRICT v,
+                         uint8_t* WEBP_RESTRICT dst) {
+  const __m256i kAlpha = _mm256_set1_epi16(255);
+  int n;
+  for (n = 0; n < 32; n += 16, dst += 64) {
+    __m256i R, G, B;
+    YUV444ToRGB_AVX2(y + n, u + n, v + n, &R, &G, &B);
+    PackAndStore4_AVX2(&B, &G, &R, &kAlpha, dst);
+  }
+}
+
+void VP8YuvToArgb32_AVX2(const uint8_t* WEBP_RESTRICT y,
+                         const uint8_t* WEBP_RESTRICT u,
+                         const uint8_t* WEBP_RESTRICT v,
+                         uint8_t* WEBP_RESTRICT dst) {
+  const __m256i kAlpha = _mm256_set1_epi16(255);
+  int n;
+  for (n = 0; n < 32; n += 16, dst += 64) {
+    __m256i R, G, B;
+    YUV444ToRGB_AVX2(y + n, u + n, v + n, &R, &G, &B);
+    PackAndStore4_AVX2(&kAlpha, &R, &G, &B, dst);
+  }
+}
+
+void VP8YuvToRgba444432_AVX2(const uint8_t* WEBP_RESTRICT y,
+                             const uint8_t* WEBP_RESTRICT u,
+                             const uint8_t* WEBP_RESTRICT v,
+                             uint8_t* WEBP_RESTRICT dst) {
+  const __m256i kAlpha = _mm256_set1_epi16(255);
+  int n;
+  for (n = 0; n < 32; n += 16, dst += 32) {
+    __m256i R, G, B;
+    YUV444ToRGB_AVX2(y + n, u + n, v + n, &R, &G, &B);
+    PackAndStore4444_AVX2(&R, &G, &B, &kAlpha, dst);
+  }
+}
+
+void VP8YuvToRgb56532_AVX2(const uint8_t* WEBP_RESTRICT y,
+                           const uint8_t* WEBP_RESTRICT u,
+                           const uint8_t* WEBP_RESTRICT v,
+                           uint8_t* WEBP_RESTRICT dst) {
+  int n;
+  for (n = 0; n < 32; n += 16, dst += 32) {
+    __m256i R, G, B;
+    YUV444ToRGB_AVX2(y + n, u + n, v + n, &R, &G, &B);
+    PackAndStore565_AVX2(&R, &G, &B, dst);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Arbitrary-length row conversion functions
+
+// A partial last span is handled by stepping back to an even position and
+// converting 16 pixels again, which rewrites some already-converted pixels with
+// the same values. At most one odd pixel is left for the C code.
+#define YUV420_ROW_FUNC(FUNC_NAME, PACK_AND_STORE, XSTEP, FUNC_C)       \
+  static void FUNC_NAME(const uint8_t* WEBP_RESTRICT y,                 \
+                        const uint8_t* WEBP_RESTRICT u,                 \
+                        const uint8_t* WEBP_RESTRICT v,                 \
+                        uint8_t* WEBP_RESTRICT dst, int len) {          \
+    const __m256i kAlpha = _mm256_set1_epi16(255);                      \
+    int n;                                                              \
+    (void)kAlpha;                                                       \
+    for (n = 0; n + 16 <= len; n += 16, dst += 16 * (XSTEP)) {          \
+      __m256i R, G, B;                                                  \
+      YUV420ToRGB_AVX2(y, u, v, &R, &G, &B);                            \
+      PACK_AND_STORE;                                                   \
+      y += 16;                                                          \
+      u += 8;                                                           \
+      v += 8;                                                           \
+    }                                                                   \
+    if (n < len && n >= 16) {                                         \
+      const int back = (16 - (len - n) + 1) & ~1;                           \
+      __m256i R, G, B;                                                  \
+      y -= back;                                                        \
+      u -= back >> 1;                                                   \
+      v -= back >> 1;                                                   \
+      dst -= back * (XSTEP);                                            \
+      YUV420ToRGB_AVX2(y, u, v, &R, &G, &B);                            \
+      PACK_AND_STORE;                                                   \
+      n += 16 - back;                                                   \
+      y += 16;                                                          \
+      u += 8;                                                           \
+      v += 8;                                                           \
+      dst += 16 * (XSTEP);                                              \
+    }                                                                   \
+    for (; n < len; ++n) { /* Finish off */                             \
+      FUNC_C(y[0], u[0], v[0], dst);                                    \
+      dst += (XSTEP);                                                   \
+      y += 1;                                                           \
+      u += (n & 1);                                                     \
+      v += (n & 1);                                                     \
+    }                                                                   \
+  }
+
+YUV420_ROW_FUNC(YuvToRgbaRow_AVX2,
+                PackAndStore4_AVX2(&R, &G, &B, &kAlpha, dst), 4, VP8YuvToRgba)
+YUV420_ROW_FUNC(YuvToBgraRow_AVX2,
+                PackAndStore4_AVX2(&B, &G, &R, &kAlpha, dst), 4, VP8YuvToBgra)
+YUV420_ROW_FUNC(YuvToArgbRow_AVX2,
+                PackAndStore4_AVX2(&kAlpha, &R, &G, &B, dst), 4, VP8YuvToArgb)
+YUV420_ROW_FUNC(YuvToRgba4444Row_AVX2,
+                PackAndStore4444_AVX2(&R, &G, &B, &kAlpha, dst), 2,
+                VP8YuvToRgba4444)
+YUV420_ROW_FUNC(YuvToRgb565Row_AVX2, PackAndStore565_AVX2(&R, &G, &B, dst), 2,
+                VP8YuvToRgb565)
+
+#undef YUV420_ROW_FUNC
+
+//------------------------------------------------------------------------------
+// Entry point
+
+extern void WebPInitSamplersAVX2(void);
+
+WEBP_TSAN_IGNORE_FUNCTION void WebPInitSamplersAVX2(void) {
+  WebPSamplers[MODE_RGBA] = YuvToRgbaRow_AVX2;
+  WebPSamplers[MODE_BGRA] = YuvToBgraRow_AVX2;
+  WebPSamplers[MODE_ARGB] = YuvToArgbRow_AVX2;
+  WebPSamplers[MODE_RGBA_4444] = YuvToRgba4444Row_AVX2;
+  WebPSamplers[MODE_RGB_565] = YuvToRgb565Row_AVX2;
+  WebPSamplers[MODE_rgbA] = YuvToRgbaRow_AVX2;
+  WebPSamplers[MODE_bgrA] = YuvToBgraRow_AVX2;
+  WebPSamplers[MODE_Argb] = YuvToArgbRow_AVX2;
+  WebPSamplers[MODE_rgbA_4444] = YuvToRgba4444Row_AVX2;
+}
+
+#else  // !WEBP_USE_AVX2
+
+WEBP_DSP_INIT_STUB(WebPInitSamplersAVX2)
+
+#endif  // WEBP_USE_AVX2
@@ -0,0 +1,253 @@
+// Copyright 2025 Google Inc. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the COPYING file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS. All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+// -----------------------------------------------------------------------------
+//
+// Xtensa PIE version of the YUV->RGB samplers for ESP32-S3.
+//
+// Eight pixels are converted at a time in 16-bit lanes, with the same
+// arithmetic as VP8YUVToR/G/B() in yuv.h. The rows are not aligned, so the
+// Q registers are filled 32 bits at a time with PIE_MOVI_32_Q().
+
+#include "src/dsp/yuv.h"
+
+#if defined(WEBP_USE_XTENSA_PIE)
+
+#include <string.h>
+
+#include "src/dsp/xtensa_pie.h"
+
+//------------------------------------------------------------------------------
+// Constants, broadcast with PIE_VLDBC_16()
+
+static const int16_t kOne = 1;
+static const int16_t kEight = 8;
+static const int16_t k128 = 128;
+static const int16_t k255 = 255;
+static const int16_t k0xe0 = 0xe0;
+static const int16_t k0xf8 = 0xf8;
+static const int16_t kYScale = 19077;
+static const int16_t kVToR = 26149;
+static const int16_t kUToG = 6419;
+static const int16_t kVToG = 13320;
+// MultHi(u, 33050) is computed as (u << 7) + MultHi(u, 282): 33050 does not
+// fit in 16 bits.
+static const int16_t kUToB = 33050 - (128 << 8);
+static const int16_t kROffset = -14234;
+static const int16_t kGOffset = 8708;
+static const int16_t kBOffset = -17685;
+
+static WEBP_INLINE uint32_t Load32_Xtensa(const uint8_t* ptr) {
+    uint32_t v;
+    memcpy(&v, ptr, sizeof(v));
+    return v;
+}
+
+// Widens the 4 bytes at 'ptr' to the 16-bit lanes of 'qreg', each of them
+// twice: the chroma is shared by two horizontal pixels. Uses 'tmp'.
+#define LOAD_UV(qreg, ptr, tmp) do {                    \
+    PIE_MOVI_32_Q(qreg, Load32_Xtensa(ptr), 0);         \
+    PIE_VZERO(tmp);                                     \
+    PIE_VZIP_8(qreg, tmp);                              \
+    PIE_ORQ(tmp, qreg, qreg);                           \
+    PIE_VZIP_16(qreg, tmp);                             \
+} while (0)
+
+// VP8Clip8(): (v >> YUV_FIX2) clamped to [0, 255]. Uses q6 and q7.
+#define CLIP_8(qreg) do {                               \
+    PIE_VLDBC_16(q6, &kOne);                            \
+    PIE_VMUL_S16(qreg, qreg, q6, 6);                    \
+    PIE_VZERO(q6);                                      \
+    PIE_VMAX_S16(qreg, qreg, q6);                       \
+    PIE_VLDBC_16(q7, &k255);                            \
+    PIE_VMIN_S16(qreg, qreg, q7);                       \
+} while (0)
+
+// Converts the 8 pixels of 'y' and the 4 samples of 'u' and 'v' to R, G and B,
+// left in the 16-bit lanes of q3, q4 and q5.
+static WEBP_INLINE void YUV420ToRGB_Xtensa(const uint8_t* WEBP_RESTRICT y,
+                                           const uint8_t* WEBP_RESTRICT u,
+                                           const uint8_t* WEBP_RESTRICT v) {
+    PIE_MOVI_32_Q(q0, Load32_Xtensa(y), 0);
+    PIE_MOVI_32_Q(q0, Load32_Xtensa(y + 4), 1);
+    PIE_VZERO(q3);
+    PIE_VZIP_8(q0, q3);
+    LOAD_UV(q1, u, q3);
+    LOAD_UV(q2, v, q3);
+
+    // MultHi(y, 19077)
+    PIE_VLDBC_16(q3, &kYScale);
+    PIE_VMUL_S16(q0, q0, q3, 8);
+
+    // The offsets are added before the positive terms so that only the last
+    // addition can saturate, and only above what CLIP_8 maps to 255.
+    PIE_VLDBC_16(q3, &kROffset);
+    PIE_VADDS_S16(q3, q0, q3);
+    PIE_VLDBC_16(q4, &kVToR);
+    PIE_VMUL_S16(q4, q2, q4, 8);
+    PIE_VADDS_S16(q3, q3, q4);
+
+    PIE_VLDBC_16(q4, &kGOffset);
+    PIE_VADDS_S16(q4, q0, q4);
+    PIE_VLDBC_16(q5, &kUToG);
+    PIE_VMUL_S16(q5, q1, q5, 8);
+    PIE_VSUBS_S16(q4, q4, q5);
+    PIE_VLDBC_16(q5, &kVToG);
+    PIE_VMUL_S16(q5, q2, q5, 8);
+    PIE_VSUBS_S16(q4, q4, q5);
+
+    PIE_VLDBC_16(q5, &k128);
+    PIE_VMUL_S16(q5, q1, q5, 0);
+    PIE_VLDBC_16(q6, &kBOffset);
+    PIE_VADDS_S16(q5, q5, q6);
+    PIE_VLDBC_16(q6, &kUToB);
+    PIE_VMUL_S16(q6, q1, q6, 8);
+    PIE_VADDS_S16(q5, q5, q6);
+    PIE_VADDS_S16(q5, q5, q0);
+
+    CLIP_8(q3);
+    CLIP_8(q4);
+    CLIP_8(q5);
+}
+
+#undef CLIP_8
+#undef LOAD_UV
+
+//------------------------------------------------------------------------------
+// Samplers
+
+// Converts 8 pixels and stores them as 24-bit triplets. 'first' and 'last' are
+// the registers holding the channels stored at offsets 0 and 2.
+#define STORE_24B(first, last) do {                     \
+    PIE_ALIGNED_ARRAY(uint8_t, planes, 32);             \
+    int i;                                              \
+    PIE_VUNZIP_8(first, q4);                            \
+    PIE_VUNZIP_8(last, q6);                             \
+    PIE_VST_128(first, planes);                         \
+    PIE_VST_128(last, planes + 16);                     \
+    for (i = 0; i < 8; ++i) {                           \
+        dst[3 * i + 0] = planes[i];                     \
+        dst[3 * i + 1] = planes[8 + i];                 \
+        dst[3 * i + 2] = planes[16 + i];                \
+    }                                                   \
+} while (0)
+
+static void YuvToRgbRow_Xtensa(const uint8_t* WEBP_RESTRICT y,
+                               const uint8_t* WEBP_RESTRICT u,
+                               const uint8_t* WEBP_RESTRICT v,
+                               uint8_t* WEBP_RESTRICT dst, int len) {
+    int n;
+    for (n = 0; n + 8 <= len; n += 8, dst += 8 * 3) {
+        YUV420ToRGB_Xtensa(y, u, v);
+        STORE_24B(q3, q5);
+        y += 8;
+        u += 4;
+        v += 4;
+    }
+    for (; n < len; ++n) {  // Finish off
+        VP8YuvToRgb(y[0], u[0], v[0], dst);
+        dst += 3;
+        y += 1;
+        u += (n & 1);
+        v += (n & 1);
+    }
+}
+
+static void YuvToBgrRow_Xtensa(const uint8_t* WEBP_RESTRICT y,
+                               const uint8_t* WEBP_RESTRICT u,
+                               const uint8_t* WEBP_RESTRICT v,
+                               uint8_t* WEBP_RESTRICT dst, int len) {
+    int n;
+    for (n = 0; n + 8 <= len; n += 8, dst += 8 * 3) {
+        YUV420ToRGB_Xtensa(y, u, v);
+        // STORE_24B() expects the middle channel in q4 next to the first one.
+        PIE_ORQ(q7, q3, q3);
+        PIE_ORQ(q3, q5, q5);
+        PIE_ORQ(q5, q7, q7);
+        STORE_24B(q3, q5);
+        y += 8;
+        u += 4;
+        v += 4;
+    }
+    for (; n < len; ++n) {  // Finish off
+        VP8YuvToBgr(y[0], u[0], v[0], dst);
+        dst += 3;
+        y += 1;
+        u += (n & 1);
+        v += (n & 1);
+    }
+}
+
+#undef STORE_24B
+
+static void YuvToRgb565Row_Xtensa(const uint8_t* WEBP_RESTRICT y,
+                                  const uint8_t* WEBP_RESTRICT u,
+                                  const uint8_t* WEBP_RESTRICT v,
+                                  uint8_t* WEBP_RESTRICT dst, int len) {
+    int n;
+    for (n = 0; n + 8 <= len; n += 8, dst += 8 * 2) {
+        uint32_t w;
+        int i;
+        YUV420ToRGB_Xtensa(y, u, v);
+        // rg = (r & 0xf8) | (g >> 5)
+        PIE_VLDBC_16(q6, &k0xf8);
+        PIE_ANDQ(q3, q3, q6);
+        PIE_VLDBC_16(q6, &kOne);
+        PIE_VMUL_S16(q7, q4, q6, 5);
+        PIE_ORQ(q3, q3, q7);
+        // gb = ((g << 3) & 0xe0) | (b >> 3)
+        PIE_VMUL_S16(q5, q5, q6, 3);
+        PIE_VLDBC_16(q6, &kEight);
+        PIE_VMUL_S16(q4, q4, q6, 0);
+        PIE_VLDBC_16(q6, &k0xe0);
+        PIE_ANDQ(q4, q4, q6);
+        PIE_ORQ(q4, q4, q5);
+        // Narrow both to bytes and interleave them.
+        PIE_VUNZIP_8(q3, q6);
+        PIE_VUNZIP_8(q4, q6);
+#if (WEBP_SWAP_16BIT_CSP == 1)
+        PIE_VZIP_8(q4, q3);
+        for (i = 0; i < 4; ++i) {
+            PIE_MOVI_32_A(q4, w, i);
+            memcpy(dst + 4 * i, &w, sizeof(w));
+        }
+#else
+        PIE_VZIP_8(q3, q4);
+        for (i = 0; i < 4; ++i) {
+            PIE_MOVI_32_A(q3, w, i);
+            memcpy(dst + 4 * i, &w, sizeof(w));
+        }
+#endif
+        y += 8;
+        u += 4;
+        v += 4;
+    }
+    for (; n < len; ++n) {  // Finish off
+        VP8YuvToRgb565(y[0], u[0], v[0], dst);
+        dst += 2;
+        y += 1;
+        u += (n & 1);
+        v += (n & 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Entry point
+
+extern void WebPInitSamplersXtensa(void);
+
+WEBP_TSAN_IGNORE_FUNCTION void WebPInitSamplersXtensa(void) {
+    WebPSamplers[MODE_RGB] = YuvToRgbRow_Xtensa;
+    WebPSamplers[MODE_BGR] = YuvToBgrRow_Xtensa;
+    WebPSamplers[MODE_RGB_565] = YuvToRgb565Row_Xtensa;
+}
+
+#else  // !WEBP_USE_XTENSA_PIE
+
+WEBP_DSP_INIT_STUB(WebPInitSamplersXtensa)
+
+#endif  // WEBP_USE_XTENSA_PIE
@@ -87,7 +87,7 @@ static int EncodeLossless(const uint8_t* const data, int width, int height,
       (use_quality_100 && effort_level == 6) ? 100 : 8.f * effort_level;
   assert(config.quality >= 0 && config.quality <= 100.f);
 
-  ok = VP8LEncodeStream(&config, &picture, bw);
+  ok = VP8LEncodeStream(&config, &picture, bw, /*enc_store=*/NULL);
   WebPPictureFree(&picture);
   ok = ok && !bw->error;
   if (!ok) {
@@ -237,10 +237,30 @@ static void InitFilterTrial(FilterTrial* const score) {
   VP8BitWriterInit(&score->bw, 0);
 }
 
+// One filter trial, run through a worker so that several can be evaluated in
+// parallel.
+typedef struct {
+  WebPWorker worker;
+  const uint8_t* alpha;
+  int width, height;
+  int method, filter, reduce_levels, effort_level;
+  uint8_t* filtered_alpha;  // scratch buffer of 'width * height' bytes
+  FilterTrial trial;
+} FilterJob;
+
+static int FilterJobHook(void* arg1, void* unused) {
+  FilterJob* const job = (FilterJob*)arg1;
+  (void)unused;
+  return EncodeAlphaInternal(job->alpha, job->width, job->height, job->method,
+                             job->filter, job->reduce_levels,
+                             job->effort_level, job->filtered_alpha,
+                             &job->trial);
+}
+
 static int ApplyFiltersAndEncode(const uint8_t* alpha, int width, int height,
                                  size_t data_size, int method, int filter,
                                  int reduce_levels, int effort_level,
-                                 uint8_t** const output,
+                                 int num_threads, uint8_t** const output,
                                  size_t* const output_size,
                                  WebPAuxStats* const stats) {
   int ok = 1;
@@ -249,23 +269,74 @@ static int ApplyFiltersAndEncode(const uint8_t* alpha, int width, int height,
   InitFilterTrial(&best);
 
   if (try_map != FILTER_TRY_NONE) {
-    uint8_t* filtered_alpha = (uint8_t*)WebPSafeMalloc(1ULL, data_size);
-    if (filtered_alpha == NULL) return 0;
-
-    for (filter = WEBP_FILTER_NONE; ok && try_map; ++filter, try_map >>= 1) {
-      if (try_map & 1) {
-        FilterTrial trial;
-        ok = EncodeAlphaInternal(alpha, width, height, method, filter,
-                                 reduce_levels, effort_level, filtered_alpha,
-                                 &trial);
-        if (ok && trial.score < best.score) {
+    const WebPWorkerInterface* const worker_interface =
+        WebPGetWorkerInterface();
+    int filters[WEBP_FILTER_LAST];
+    int num_filters = 0, num_jobs, i, j;
+    uint8_t* filtered_alpha;
+    FilterJob* jobs;
+
+    for (filter = WEBP_FILTER_NONE; try_map; ++filter, try_map >>= 1) {
+      if (try_map & 1) filters[num_filters++] = filter;
+    }
+#ifdef WEBP_USE_THREAD
+    num_jobs = (num_threads < num_filters) ? num_threads : num_filters;
+    if (num_jobs < 1) num_jobs = 1;
+#else
+    (void)num_threads;
+    num_jobs = 1;
+#endif
+    jobs = (FilterJob*)WebPSafeCalloc(num_jobs, sizeof(*jobs));
+    filtered_alpha = (uint8_t*)WebPSafeMalloc(num_jobs, data_size);
+    if (jobs == NULL || filtered_alpha == NULL) {
+      WebPSafeFree(jobs);
+      WebPSafeFree(filtered_alpha);
+      return 0;
+    }
+    for (j = 0; j < num_jobs; ++j) {
+      FilterJob* const job = &jobs[j];
+      worker_interface->Init(&job->worker);
+      job->worker.data1 = job;
+      job->worker.data2 = NULL;
+      job->worker.hook = FilterJobHook;
+      job->alpha = alpha;
+      job->width = width;
+      job->height = height;
+      job->method = method;
+      job->reduce_levels = reduce_levels;
+      job->effort_level = effort_level;
+      job->filtered_alpha = filtered_alpha + j * data_size;
+    }
+
+    // Trials are run in batches of 'num_jobs', the first one of each batch on
+    // the calling thread. Results are compared in filter order so that the
+    // selected filter does not depend on the number of threads.
+    for (i = 0; ok && i < num_filters; i += num_jobs) {
+      const int batch_size =
+          (num_filters - i < num_jobs) ? num_filters - i : num_jobs;
+      for (j = 1; j < batch_size; ++j) {
+        jobs[j].filter = filters[i + j];
+        ok &= worker_interface->Reset(&jobs[j].worker);
+      }
+      if (!ok) break;
+      for (j = 1; j < batch_size; ++j) {
+        worker_interface->Launch(&jobs[j].worker);
+      }
+      jobs[0].filter = filters[i];
+      worker_interface->Execute(&jobs[0].worker);
+      for (j = 0; j < batch_size; ++j) {
+        FilterJob* const job = &jobs[j];
+        ok &= worker_interface->Sync(&job->worker);
+        if (ok && job->trial.score < best.score) {
           VP8BitWriterWipeOut(&best.bw);
-          best = trial;
+          best = job->trial;
         } else {
-          VP8BitWriterWipeOut(&trial.bw);
+          VP8BitWriterWipeOut(&job->trial.bw);
         }
       }
     }
+    for (j = 0; j < num_jobs; ++j) worker_interface->End(&jobs[j].worker);
+    WebPSafeFree(jobs);
     WebPSafeFree(filtered_alpha);
   } else {
     ok = EncodeAlphaInternal(alpha, width, height, method, WEBP_FILTER_NONE,
@@ -307,6 +378,9 @@ static int EncodeAlpha(VP8Encoder* const enc, int quality, int method,
   uint64_t sse = 0;
   int ok = 1;
   const int reduce_levels = (quality < 100);
+  // The alpha job runs alongside the main encoding, which keeps one thread of
+  // the budget busy.
+  const int num_threads = VP8EncNumThreads(enc->thread_level) - 1;
 
   // quick correctness checks
   assert((uint64_t)data_size == (uint64_t)width * height);  // as per spec
@@ -349,8 +423,8 @@ static int EncodeAlpha(VP8Encoder* const enc, int quality, int method,
   if (ok) {
     VP8FiltersInit();
     ok = ApplyFiltersAndEncode(quant_alpha, width, height, data_size, method,
-                               filter, reduce_levels, effort_level, output,
-                               output_size, pic->stats);
+                               filter, reduce_levels, effort_level,
+                               num_threads, output, output_size, pic->stats);
     if (!ok) {
       WebPEncodingSetError(pic, VP8_ENC_ERROR_OUT_OF_MEMORY);  // imprecise
     }
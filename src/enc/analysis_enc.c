@@ -407,6 +407,26 @@ static void MergeJobs(const SegmentJob* const src, SegmentJob* const dst) {
   dst->alpha += src->alpha;
   dst->uv_alpha += src->uv_alpha;
 }
+
+// Returns the first row of job 'idx' out of 'num_jobs'. We give a little more
+// work to the main thread (job 0): 9 shares of the rows, versus 7 for each
+// side job.
+static int GetJobStartRow(int idx, int num_jobs, int last_row) {
+  const int total_shares = 9 + 7 * (num_jobs - 1);
+  const int shares = (idx == 0) ? 0 : 9 + 7 * (idx - 1);
+  return (shares * last_row + total_shares - 1) / total_shares;
+}
+
+// Returns how many jobs the analysis of 'last_row' rows is split into.
+static int GetNumSegmentJobs(int thread_level, int last_row) {
+  const int kMinSplitRow = 2;  // minimal rows needed for mt to be worth it
+  int num_jobs = VP8EncNumThreads(thread_level);
+  while (num_jobs > 2 && last_row < kMinSplitRow * num_jobs) --num_jobs;
+  if (num_jobs > 1 && GetJobStartRow(1, num_jobs, last_row) < kMinSplitRow) {
+    num_jobs = 1;
+  }
+  return num_jobs;
+}
 #endif
 
 // initialize the job struct with some tasks to perform
@@ -438,36 +458,52 @@ int VP8EncAnalyze(VP8Encoder* const enc) {
     const int last_row = enc->mb_h;
     const int total_mb = last_row * enc->mb_w;
 #ifdef WEBP_USE_THREAD
-    // We give a little more than a half work to the main thread.
-    const int split_row = (9 * last_row + 15) >> 4;
-    const int kMinSplitRow = 2;  // minimal rows needed for mt to be worth it
-    const int do_mt = (enc->thread_level > 0) && (split_row >= kMinSplitRow);
+    const int num_jobs = GetNumSegmentJobs(enc->thread_level, last_row);
 #else
-    const int do_mt = 0;
+    const int num_jobs = 1;
 #endif
+    const int do_mt = (num_jobs > 1);
     const WebPWorkerInterface* const worker_interface =
         WebPGetWorkerInterface();
     SegmentJob main_job;
     if (do_mt) {
 #ifdef WEBP_USE_THREAD
-      SegmentJob side_job;
-      // Note the use of '&' instead of '&&' because we must call the functions
-      // no matter what.
-      InitSegmentJob(enc, &main_job, 0, split_row);
-      InitSegmentJob(enc, &side_job, split_row, last_row);
+      const int num_side_jobs = num_jobs - 1;
+      SegmentJob* const side_jobs =
+          (SegmentJob*)WebPSafeMalloc(num_side_jobs, sizeof(*side_jobs));
+      int i;
+      if (side_jobs == NULL) {
+        return WebPEncodingSetError(enc->pic, VP8_ENC_ERROR_OUT_OF_MEMORY);
+      }
+      InitSegmentJob(enc, &main_job, 0, GetJobStartRow(1, num_jobs, last_row));
+      for (i = 0; i < num_side_jobs; ++i) {
+        InitSegmentJob(enc, &side_jobs[i],
+                       GetJobStartRow(i + 1, num_jobs, last_row),
+                       GetJobStartRow(i + 2, num_jobs, last_row));
+      }
       // we don't need to call Reset() on main_job.worker, since we're calling
-      // WebPWorkerExecute() on it
-      ok &= worker_interface->Reset(&side_job.worker);
-      // launch the two jobs in parallel
+      // WebPWorkerExecute() on it. Note the use of '&' instead of '&&' because
+      // we must call the functions no matter what.
+      for (i = 0; i < num_side_jobs; ++i) {
+        ok &= worker_interface->Reset(&side_jobs[i].worker);
+      }
+      // launch the jobs in parallel
       if (ok) {
-        worker_interface->Launch(&side_job.worker);
+        for (i = 0; i < num_side_jobs; ++i) {
+          worker_interface->Launch(&side_jobs[i].worker);
+        }
         worker_interface->Execute(&main_job.worker);
-        ok &= worker_interface->Sync(&side_job.worker);
+        for (i = 0; i < num_side_jobs; ++i) {
+          ok &= worker_interface->Sync(&side_jobs[i].worker);
+        }
         ok &= worker_interface->Sync(&main_job.worker);
       }
-      worker_interface->End(&side_job.worker);
-      if (ok) MergeJobs(&side_job, &main_job);  // merge results together
-#endif                                          // WEBP_USE_THREAD
+      for (i = 0; i < num_side_jobs; ++i) {
+        worker_interface->End(&side_jobs[i].worker);
+        if (ok) MergeJobs(&side_jobs[i], &main_job);  // merge results together
+      }
+      WebPSafeFree(side_jobs);
+#endif  // WEBP_USE_THREAD
     } else {
       // Even for single-thread case, we use the generic Worker tools.
       InitSegmentJob(enc, &main_job, 0, last_row);
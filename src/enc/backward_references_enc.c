@@ -127,6 +127,27 @@ void VP8LBackwardRefsInit(VP8LBackwardRefs* const refs, int block_size) {
       (block_size < MIN_BLOCK_SIZE) ? MIN_BLOCK_SIZE : block_size;
 }
 
+void VP8LBackwardRefsReset(VP8LBackwardRefs* const refs, int block_size) {
+  PixOrCopyBlock* free_blocks;
+  assert(refs != NULL);
+  if (block_size < MIN_BLOCK_SIZE) block_size = MIN_BLOCK_SIZE;
+  if (refs->block_size != block_size) VP8LBackwardRefsClear(refs);
+  VP8LClearBackwardRefs(refs);
+  free_blocks = refs->free_blocks;
+  VP8LBackwardRefsInit(refs, block_size);
+  refs->free_blocks = free_blocks;
+}
+
+size_t VP8LBackwardRefsMemorySize(const VP8LBackwardRefs* const refs) {
+  const size_t block_size =
+      sizeof(PixOrCopyBlock) + refs->block_size * sizeof(PixOrCopy);
+  size_t size = 0;
+  const PixOrCopyBlock* b;
+  for (b = refs->refs; b != NULL; b = b->next) size += block_size;
+  for (b = refs->free_blocks; b != NULL; b = b->next) size += block_size;
+  return size;
+}
+
 VP8LRefsCursor VP8LRefsCursorInit(const VP8LBackwardRefs* const refs) {
   VP8LRefsCursor c;
   c.cur_block = refs->refs;
@@ -177,6 +177,11 @@ struct VP8LBackwardRefs {
 // Initialize the object. 'block_size' is the common block size to store
 // references (typically, width * height / MAX_REFS_BLOCK_PER_IMAGE).
 void VP8LBackwardRefsInit(VP8LBackwardRefs* const refs, int block_size);
+// Same as VP8LBackwardRefsInit() for an object that was already initialized
+// (or zeroed). Its memory is kept if the block size is the same.
+void VP8LBackwardRefsReset(VP8LBackwardRefs* const refs, int block_size);
+// Returns the size of the memory allocated for the references.
+size_t VP8LBackwardRefsMemorySize(const VP8LBackwardRefs* const refs);
 // Release memory for backward references.
 void VP8LBackwardRefsClear(VP8LBackwardRefs* const refs);
 
@@ -20,6 +20,8 @@
 #include "src/enc/cost_enc.h"
 #include "src/enc/vp8i_enc.h"
 #include "src/utils/bit_writer_utils.h"
+#include "src/utils/thread_utils.h"
+#include "src/utils/utils.h"
 #include "src/webp/encode.h"
 #include "src/webp/format_constants.h"  // RIFF constants
 #include "src/webp/types.h"
@@ -407,16 +409,67 @@ static void RecordResiduals(VP8EncIterator* const it,
   VP8IteratorBytesToNz(it);
 }
 
+static void ResetAfterSkip(VP8EncIterator* const it) {
+  if (it->mb->type == 1) {
+    *it->nz = 0;  // reset all predictors
+    it->left_nz[8] = 0;
+  } else {
+    *it->nz &= (1 << 24);  // preserve the dc_nz bit
+  }
+}
+
+// Same as RecordResiduals(), but only updates the non-zero contexts.
+static void UpdateNonZero(VP8EncIterator* const it,
+                          const VP8ModeScore* const rd) {
+  int x, y, ch;
+  VP8Residual res;
+  VP8Encoder* const enc = it->enc;
+
+  VP8IteratorNzToBytes(it);
+
+  if (it->mb->type == 1) {  // i16x16
+    VP8InitResidual(0, 1, enc, &res);
+    VP8SetResidualCoeffs(rd->y_dc_levels, &res);
+    it->top_nz[8] = it->left_nz[8] = (res.last >= 0);
+    VP8InitResidual(1, 0, enc, &res);
+  } else {
+    VP8InitResidual(0, 3, enc, &res);
+  }
+
+  // luma-AC
+  for (y = 0; y < 4; ++y) {
+    for (x = 0; x < 4; ++x) {
+      VP8SetResidualCoeffs(rd->y_ac_levels[x + y * 4], &res);
+      it->top_nz[x] = it->left_nz[y] = (res.last >= 0);
+    }
+  }
+
+  // U/V
+  VP8InitResidual(0, 2, enc, &res);
+  for (ch = 0; ch <= 2; ch += 2) {
+    for (y = 0; y < 2; ++y) {
+      for (x = 0; x < 2; ++x) {
+        VP8SetResidualCoeffs(rd->uv_levels[ch * 2 + x + y * 2], &res);
+        it->top_nz[4 + ch + x] = it->left_nz[4 + ch + y] = (res.last >= 0);
+      }
+    }
+  }
+
+  VP8IteratorBytesToNz(it);
+}
+
 //------------------------------------------------------------------------------
 // Token buffer
 
 #if !defined(DISABLE_TOKEN_BUFFER)
 
-static int RecordTokens(VP8EncIterator* const it, const VP8ModeScore* const rd,
-                        VP8TBuffer* const tokens) {
+// Records the tokens in the buffer of the macroblock's partition.
+static int RecordTokens(VP8EncIterator* const it,
+                        const VP8ModeScore* const rd) {
   int x, y, ch;
   VP8Residual res;
   VP8Encoder* const enc = it->enc;
+  VP8TBuffer* const tokens = &enc->tokens[it->y & (enc->num_parts - 1)];
 
   VP8IteratorNzToBytes(it);
   if (it->mb->type == 1) {  // i16x16
@@ -479,24 +532,24 @@ static void ResetSSE(VP8Encoder* const enc) {
   enc->sse_count = 0;
 }
 
-static void StoreSSE(const VP8EncIterator* const it) {
-  VP8Encoder* const enc = it->enc;
+static void AccumulateSSE(const VP8EncIterator* const it, uint64_t sse[3],
+                          uint64_t* const sse_count) {
   const uint8_t* const in = it->yuv_in;
   const uint8_t* const out = it->yuv_out;
   // Note: not totally accurate at boundary. And doesn't include in-loop filter.
-  enc->sse[0] += VP8SSE16x16(in + Y_OFF_ENC, out + Y_OFF_ENC);
-  enc->sse[1] += VP8SSE8x8(in + U_OFF_ENC, out + U_OFF_ENC);
-  enc->sse[2] += VP8SSE8x8(in + V_OFF_ENC, out + V_OFF_ENC);
-  enc->sse_count += 16 * 16;
+  sse[0] += VP8SSE16x16(in + Y_OFF_ENC, out + Y_OFF_ENC);
+  sse[1] += VP8SSE8x8(in + U_OFF_ENC, out + U_OFF_ENC);
+  sse[2] += VP8SSE8x8(in + V_OFF_ENC, out + V_OFF_ENC);
+  *sse_count += 16 * 16;
 }
 
-static void StoreSideInfo(const VP8EncIterator* const it) {
+// Side info that doesn't depend on the reconstructed samples.
+static void StoreMBInfo(const VP8EncIterator* const it) {
   VP8Encoder* const enc = it->enc;
   const VP8MBInfo* const mb = it->mb;
   WebPPicture* const pic = enc->pic;
 
   if (pic->stats != NULL) {
-    StoreSSE(it);
     enc->block_count[0] += (mb->type == 0);
     enc->block_count[1] += (mb->type == 1);
     enc->block_count[2] += (mb->skip != 0);
@@ -540,6 +593,14 @@ static void StoreSideInfo(const VP8EncIterator* const it) {
 #endif
 }
 
+static void StoreSideInfo(const VP8EncIterator* const it) {
+  VP8Encoder* const enc = it->enc;
+  if (enc->pic->stats != NULL) {
+    AccumulateSSE(it, enc->sse, &enc->sse_count);
+  }
+  StoreMBInfo(it);
+}
+
 static void ResetSideInfo(const VP8EncIterator* const it) {
   VP8Encoder* const enc = it->enc;
   WebPPicture* const pic = enc->pic;
@@ -550,7 +611,13 @@ static void ResetSideInfo(const VP8EncIterator* const it) {
 }
 #else   // defined(WEBP_DISABLE_STATS)
 static void ResetSSE(VP8Encoder* const enc) { (void)enc; }
-static void StoreSideInfo(const VP8EncIterator* const it) {
+static void AccumulateSSE(const VP8EncIterator* const it, uint64_t sse[3],
+                          uint64_t* const sse_count) {
+  (void)it;
+  (void)sse;
+  (void)sse_count;
+}
+static void StoreMBInfo(const VP8EncIterator* const it) {
   VP8Encoder* const enc = it->enc;
   WebPPicture* const pic = enc->pic;
   if (pic->extra_info != NULL) {
@@ -560,6 +627,7 @@ static void StoreSideInfo(const VP8EncIterator* const it) {
     }
   }
 }
+static void StoreSideInfo(const VP8EncIterator* const it) { StoreMBInfo(it); }
 
 static void ResetSideInfo(const VP8EncIterator* const it) { (void)it; }
 #endif  // !defined(WEBP_DISABLE_STATS)
@@ -568,6 +636,313 @@ static double GetPSNR(uint64_t mse, uint64_t size) {
   return (mse > 0 && size > 0) ? 10. * log10(255. * 255. * size / mse) : 99;
 }
 
+//------------------------------------------------------------------------------
+// Wavefront multi-threading (thread_level > 1).
+//
+// Macroblock rows are handed out in turn to 'num_jobs' row jobs, which
+// import, decimate and reconstruct their macroblocks in parallel, each row
+// staying two macroblocks behind the row above (for the top-right samples).
+// Everything that depends on the raster order (token statistics, bit-writing
+// or token recording, filter statistics, progress) is then 'committed' by the
+// calling thread from the per-macroblock results, in order. Hence the
+// bitstream doesn't depend on the number of threads.
+// In the token loop, the cost tables are refreshed every 'max_count'
+// macroblocks: decimation doesn't go past the next refresh point before the
+// refresh is committed.
+
+#define WAVEFRONT_POS(mb_w, y, x) ((y) * ((mb_w) + 1) + (x))
+
+typedef enum { WF_STAT_PASS, WF_CODE_PASS, WF_TOKEN_PASS } WavefrontPass;
+
+// Decimation result of a macroblock, waiting to be committed.
+typedef struct {
+  VP8ModeScore info;
+  int skip;
+  uint32_t nz[2];   // left and top non-zero contexts before coding
+  int left_dc_nz;   // it->left_nz[8] before coding
+} MBResult;
+
+typedef struct {
+  WebPWorker worker;
+  VP8EncIterator it;
+  int y;               // row being processed
+  MBResult* results;   // mb_w results for the row
+  double* lf_values;   // mb_w * MAX_LF_LEVELS filter stats, or NULL
+  LFStats lf_scratch;  // filter stats of the current macroblock
+  int max_edge[NUM_MB_SEGMENTS];  // max edge deltas of the rows processed
+  uint64_t sse[3];     // distortion stats of the rows processed
+  uint64_t sse_count;
+} RowJob;
+
+typedef struct {
+  VP8Encoder* enc;
+  RowJob* jobs;
+  int num_jobs;
+  // counters [0, num_jobs) track the jobs' positions, counter 'num_jobs' is
+  // the number of macroblocks the jobs are allowed to decimate.
+  WebPProgress progress;
+  // parameters of the current pass
+  WavefrontPass pass;
+  VP8RDLevel rd_opt;
+  int num_mbs;         // number of macroblocks to process
+  int store_info;      // final pass: side info, filter stats and export
+  int percent_delta;   // progress to report
+  int max_count, cnt;  // token pass: cost tables refresh period and countdown
+  // stats of the current pass
+  uint64_t size, size_p0, distortion;
+  uint32_t nz_ctx[2];  // non-zero contexts of the macroblock being committed
+} Wavefront;
+
+static int RowJobHook(void* arg1, void* arg2) {
+  RowJob* const job = (RowJob*)arg1;
+  Wavefront* const wf = (Wavefront*)arg2;
+  VP8Encoder* const enc = wf->enc;
+  VP8EncIterator* const it = &job->it;
+  const int mb_w = enc->mb_w;
+  const int y = job->y;
+  const int job_id = (int)(job - wf->jobs);
+  const int top_id = (y + wf->num_jobs - 1) % wf->num_jobs;
+  const int dont_use_skip = !enc->proba.use_skip_proba;
+  int x;
+
+  VP8IteratorSetRow(it, y);
+  for (x = 0; x < mb_w && y * mb_w + x < wf->num_mbs; ++x) {
+    MBResult* const res = &job->results[x];
+    const int top_x = (x + 2 < mb_w) ? x + 2 : mb_w;
+    if (y > 0 && !WebPProgressWait(&wf->progress, top_id,
+                                   WAVEFRONT_POS(mb_w, y - 1, top_x))) {
+      return 0;  // aborted
+    }
+    if (!WebPProgressWait(&wf->progress, wf->num_jobs, y * mb_w + x + 1)) {
+      return 0;
+    }
+    VP8IteratorImport(it, NULL);
+    res->nz[0] = it->nz[-1];
+    res->nz[1] = it->nz[0];
+    res->left_dc_nz = it->left_nz[8];
+    res->skip = VP8Decimate(it, &res->info, wf->rd_opt);
+    if (wf->pass == WF_CODE_PASS && res->skip && !dont_use_skip) {
+      ResetAfterSkip(it);
+    } else {
+      UpdateNonZero(it, &res->info);
+    }
+    if (wf->store_info) {
+      if (enc->pic->stats != NULL) {
+        AccumulateSSE(it, job->sse, &job->sse_count);
+      }
+      if (job->lf_values != NULL) {
+        const int s = it->mb->segment;
+        memset(job->lf_scratch[s], 0, sizeof(job->lf_scratch[s]));
+        VP8StoreFilterStats(it);
+        memcpy(job->lf_values + x * MAX_LF_LEVELS, job->lf_scratch[s],
+               sizeof(job->lf_scratch[s]));
+      }
+      VP8IteratorExport(it);
+    }
+    VP8IteratorSaveBoundary(it);
+    WebPProgressUpdate(&wf->progress, job_id, WAVEFRONT_POS(mb_w, y, x + 1));
+    if (x + 1 < mb_w) VP8IteratorNext(it);
+  }
+  return 1;
+}
+
+// Commits the result of the macroblock at the position of 'it', in raster
+// order. Returns false in case of error.
+static int CommitMB(Wavefront* const wf, VP8EncIterator* const it,
+                    const MBResult* const res, const double* const lf_values) {
+  VP8Encoder* const enc = wf->enc;
+  const VP8ModeScore* const info = &res->info;
+
+  // restore the non-zero contexts seen by the row job
+  wf->nz_ctx[0] = res->nz[0];
+  wf->nz_ctx[1] = res->nz[1];
+  it->nz = wf->nz_ctx + 1;
+  it->left_nz[8] = res->left_dc_nz;
+
+  switch (wf->pass) {
+    case WF_STAT_PASS:
+      if (res->skip) ++enc->proba.nb_skip;
+      RecordResiduals(it, info);
+      wf->size += info->R + info->H;
+      wf->size_p0 += info->H;
+      wf->distortion += info->D;
+      break;
+    case WF_CODE_PASS:
+      if (!res->skip || !enc->proba.use_skip_proba) {
+        CodeResiduals(it->bw, it, info);
+        // enc->pic->error_code is set in PostLoopFinalize().
+        if (it->bw->error) return 0;
+      }
+      break;
+    default:  // WF_TOKEN_PASS
+#if !defined(DISABLE_TOKEN_BUFFER)
+      if (!RecordTokens(it, info)) {
+        return WebPEncodingSetError(enc->pic, VP8_ENC_ERROR_OUT_OF_MEMORY);
+      }
+#endif
+      wf->size_p0 += info->H;
+      wf->distortion += info->D;
+      break;
+  }
+  if (wf->store_info) {
+    StoreMBInfo(it);
+    if (lf_values != NULL) {
+      double* const lf_stats = (*enc->lf_stats)[it->mb->segment];
+      int i;
+      for (i = 0; i < MAX_LF_LEVELS; ++i) lf_stats[i] += lf_values[i];
+    }
+  }
+  return VP8IteratorProgress(it, wf->percent_delta);
+}
+
+// Processes the first 'num_mbs' macroblocks, committing them through 'it'
+// which must have been initialized. Returns false in case of error.
+static int RunWavefront(Wavefront* const wf, VP8EncIterator* const it,
+                        WavefrontPass pass, VP8RDLevel rd_opt, int num_mbs,
+                        int store_info, int percent_delta) {
+  VP8Encoder* const enc = wf->enc;
+  const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  const int mb_w = enc->mb_w;
+  const int num_rows = (num_mbs + mb_w - 1) / mb_w;
+  int ok, x, y, j;
+  int next_row = 0;
+
+  wf->pass = pass;
+  wf->rd_opt = rd_opt;
+  wf->num_mbs = num_mbs;
+  wf->store_info = store_info;
+  wf->percent_delta = percent_delta;
+  wf->size = wf->size_p0 = wf->distortion = 0;
+
+  ok = WebPProgressInit(&wf->progress, wf->num_jobs + 1);
+  for (j = 0; ok && j < wf->num_jobs; ++j) {
+    RowJob* const job = &wf->jobs[j];
+    VP8IteratorInit(enc, &job->it);
+    if (job->lf_values != NULL) job->it.lf_stats = &job->lf_scratch;
+    memset(job->max_edge, 0, sizeof(job->max_edge));
+    job->it.max_edge = job->max_edge;
+    memset(job->sse, 0, sizeof(job->sse));
+    job->sse_count = 0;
+    ok = worker_interface->Reset(&job->worker);
+  }
+  if (!ok) {
+    WebPProgressClear(&wf->progress);
+    return WebPEncodingSetError(enc->pic, VP8_ENC_ERROR_OUT_OF_MEMORY);
+  }
+  WebPProgressUpdate(&wf->progress, wf->num_jobs,
+                     (pass == WF_TOKEN_PASS) ? wf->cnt : num_mbs);
+
+  for (y = 0; ok && y < num_rows; ++y) {
+    RowJob* const job = &wf->jobs[y % wf->num_jobs];
+    // keep 'num_jobs' rows in flight
+    for (; ok && next_row < num_rows && next_row < y + wf->num_jobs;
+         ++next_row) {
+      RowJob* const next_job = &wf->jobs[next_row % wf->num_jobs];
+      ok = worker_interface->Sync(&next_job->worker);
+      next_job->y = next_row;
+      worker_interface->Launch(&next_job->worker);
+    }
+    for (x = 0; ok && x < mb_w && y * mb_w + x < num_mbs; ++x) {
+      const double* const lf_values =
+          (job->lf_values != NULL) ? job->lf_values + x * MAX_LF_LEVELS : NULL;
+#if !defined(DISABLE_TOKEN_BUFFER)
+      if (pass == WF_TOKEN_PASS && --wf->cnt < 0) {
+        FinalizeTokenProbas(&enc->proba);
+        VP8CalculateLevelCosts(&enc->proba);  // refresh cost tables for rd-opt
+        wf->cnt = wf->max_count;
+        WebPProgressUpdate(&wf->progress, wf->num_jobs,
+                           y * mb_w + x + wf->cnt + 1);
+      }
+#endif
+      ok = WebPProgressWait(&wf->progress, y % wf->num_jobs,
+                            WAVEFRONT_POS(mb_w, y, x + 1)) &&
+           CommitMB(wf, it, &job->results[x], lf_values);
+      if (ok) VP8IteratorNext(it);
+    }
+  }
+
+  if (!ok) WebPProgressAbort(&wf->progress);
+  for (j = 0; j < wf->num_jobs; ++j) {
+    RowJob* const job = &wf->jobs[j];
+    (void)worker_interface->Sync(&job->worker);  // only fails when aborted
+    // The maximum doesn't depend on the order the jobs are folded in.
+    for (x = 0; x < NUM_MB_SEGMENTS; ++x) {
+      VP8SegmentInfo* const dqm = &enc->dqm[x];
+      if (job->max_edge[x] > dqm->max_edge) dqm->max_edge = job->max_edge[x];
+    }
+    if (ok && store_info) {
+      enc->sse[0] += job->sse[0];
+      enc->sse[1] += job->sse[1];
+      enc->sse[2] += job->sse[2];
+      enc->sse_count += job->sse_count;
+    }
+  }
+  WebPProgressClear(&wf->progress);
+  return ok;
+}
+
+static void DeleteWavefront(Wavefront* const wf) {
+  if (wf != NULL) {
+    int j;
+    for (j = 0; j < wf->num_jobs; ++j) {
+      WebPGetWorkerInterface()->End(&wf->jobs[j].worker);
+      WebPSafeFree(wf->jobs[j].results);
+      WebPSafeFree(wf->jobs[j].lf_values);
+    }
+    WebPSafeFree(wf->jobs);
+    WebPSafeFree(wf);
+  }
+}
+
+// Returns NULL if multi-threading is not requested or not available. The
+// encoding then falls back to the single-threaded loops, which produce the
+// same bitstream.
+static Wavefront* NewWavefront(VP8Encoder* const enc) {
+  const int mb_w = enc->mb_w;
+#ifdef WEBP_USE_THREAD
+  // From a pool thread, the row jobs would run synchronously at launch and
+  // wait on progress made by the main thread afterwards.
+  int num_jobs = (enc->thread_level > 1 && !WebPIsPoolThread())
+                     ? VP8EncNumThreads(enc->thread_level)
+                     : 1;
+#else
+  int num_jobs = 1;  // jobs can't wait for each other
+#endif
+  Wavefront* wf;
+  int j;
+
+  if (num_jobs > enc->mb_h) num_jobs = enc->mb_h;
+  if (num_jobs < 2) return NULL;
+
+  wf = (Wavefront*)WebPSafeCalloc(1ULL, sizeof(*wf));
+  if (wf == NULL) return NULL;
+  wf->enc = enc;
+  wf->jobs = (RowJob*)WebPSafeCalloc(num_jobs, sizeof(*wf->jobs));
+  if (wf->jobs == NULL) {
+    WebPSafeFree(wf);
+    return NULL;
+  }
+  wf->num_jobs = num_jobs;
+  for (j = 0; j < num_jobs; ++j) {
+    RowJob* const job = &wf->jobs[j];
+    WebPGetWorkerInterface()->Init(&job->worker);
+    job->worker.hook = RowJobHook;
+    job->worker.data1 = job;
+    job->worker.data2 = wf;
+    job->results = (MBResult*)WebPSafeMalloc(mb_w, sizeof(*job->results));
+    if (enc->lf_stats != NULL) {
+      job->lf_values = (double*)WebPSafeMalloc(
+          (uint64_t)mb_w * MAX_LF_LEVELS, sizeof(*job->lf_values));
+    }
+    if (job->results == NULL ||
+        (enc->lf_stats != NULL && job->lf_values == NULL)) {
+      DeleteWavefront(wf);
+      return NULL;
+    }
+  }
+  return wf;
+}
+
 //------------------------------------------------------------------------------
 //  StatLoop(): only collect statistics (number of skips, token usage, ...).
 //  This is used for deciding optimal probabilities. It also modifies the
@@ -584,8 +959,9 @@ static void SetLoopParams(VP8Encoder* const enc, float q) {
   ResetSSE(enc);
 }
 
-static uint64_t OneStatPass(VP8Encoder* const enc, VP8RDLevel rd_opt,
-                            int nb_mbs, int percent_delta, PassStats* const s) {
+static uint64_t OneStatPass(VP8Encoder* const enc, Wavefront* const wf,
+                            VP8RDLevel rd_opt, int nb_mbs, int percent_delta,
+                            PassStats* const s) {
   VP8EncIterator it;
   uint64_t size = 0;
   uint64_t size_p0 = 0;
@@ -594,22 +970,34 @@ static uint64_t OneStatPass(VP8Encoder* const enc, VP8RDLevel rd_opt,
 
   VP8IteratorInit(enc, &it);
   SetLoopParams(enc, s->q);
-  do {
-    VP8ModeScore info;
-    VP8IteratorImport(&it, NULL);
-    if (VP8Decimate(&it, &info, rd_opt)) {
-      // Just record the number of skips and act like skip_proba is not used.
-      ++enc->proba.nb_skip;
-    }
-    RecordResiduals(&it, &info);
-    size += info.R + info.H;
-    size_p0 += info.H;
-    distortion += info.D;
-    if (percent_delta && !VP8IteratorProgress(&it, percent_delta)) {
+  if (wf != NULL) {
+    const int num_mbs = (nb_mbs < enc->mb_w * enc->mb_h)
+                            ? nb_mbs : enc->mb_w * enc->mb_h;
+    if (!RunWavefront(wf, &it, WF_STAT_PASS, rd_opt, num_mbs, 0,
+                      percent_delta)) {
       return 0;
     }
-    VP8IteratorSaveBoundary(&it);
-  } while (VP8IteratorNext(&it) && --nb_mbs > 0);
+    size = wf->size;
+    size_p0 = wf->size_p0;
+    distortion = wf->distortion;
+  } else {
+    do {
+      VP8ModeScore info;
+      VP8IteratorImport(&it, NULL);
+      if (VP8Decimate(&it, &info, rd_opt)) {
+        // Just record the number of skips and act like skip_proba is not used.
+        ++enc->proba.nb_skip;
+      }
+      RecordResiduals(&it, &info);
+      size += info.R + info.H;
+      size_p0 += info.H;
+      distortion += info.D;
+      if (percent_delta && !VP8IteratorProgress(&it, percent_delta)) {
+        return 0;
+      }
+      VP8IteratorSaveBoundary(&it);
+    } while (VP8IteratorNext(&it) && --nb_mbs > 0);
+  }
 
   size_p0 += enc->segment_hdr.size;
   if (s->do_size_search) {
@@ -623,7 +1011,7 @@ static uint64_t OneStatPass(VP8Encoder* const enc, VP8RDLevel rd_opt,
   return size_p0;
 }
 
-static int StatLoop(VP8Encoder* const enc) {
+static int StatLoop(VP8Encoder* const enc, Wavefront* const wf) {
   const int method = enc->method;
   const int do_search = enc->do_search;
   const int fast_probe = ((method == 0 || method == 3) && !do_search);
@@ -654,7 +1042,7 @@ static int StatLoop(VP8Encoder* const enc) {
                              (num_pass_left == 0) ||
                              (enc->max_i4_header_bits == 0);
     const uint64_t size_p0 =
-        OneStatPass(enc, rd_opt, nb_mbs, percent_per_pass, &stats);
+        OneStatPass(enc, wf, rd_opt, nb_mbs, percent_per_pass, &stats);
     if (size_p0 == 0) return 0;
 #if (DEBUG_SEARCH > 0)
     printf("#%d value:%.1lf -> %.1lf   q:%.2f -> %.2f\n", num_pass_left,
@@ -739,48 +1127,47 @@ static int PostLoopFinalize(VP8EncIterator* const it, int ok) {
 //------------------------------------------------------------------------------
 //  VP8EncLoop(): does the final bitstream coding.
 
-static void ResetAfterSkip(VP8EncIterator* const it) {
-  if (it->mb->type == 1) {
-    *it->nz = 0;  // reset all predictors
-    it->left_nz[8] = 0;
-  } else {
-    *it->nz &= (1 << 24);  // preserve the dc_nz bit
-  }
-}
-
 int VP8EncLoop(VP8Encoder* const enc) {
   VP8EncIterator it;
+  Wavefront* wf;
   int ok = PreLoopInitialize(enc);
   if (!ok) return 0;
 
-  StatLoop(enc);  // stats-collection loop
+  wf = NewWavefront(enc);
+  StatLoop(enc, wf);  // stats-collection loop
 
   VP8IteratorInit(enc, &it);
   VP8InitFilter(&it);
-  do {
-    VP8ModeScore info;
-    const int dont_use_skip = !enc->proba.use_skip_proba;
-    const VP8RDLevel rd_opt = enc->rd_opt_level;
-
-    VP8IteratorImport(&it, NULL);
-    // Warning! order is important: first call VP8Decimate() and
-    // *then* decide how to code the skip decision if there's one.
-    if (!VP8Decimate(&it, &info, rd_opt) || dont_use_skip) {
-      CodeResiduals(it.bw, &it, &info);
-      if (it.bw->error) {
-        // enc->pic->error_code is set in PostLoopFinalize().
-        ok = 0;
-        break;
+  if (wf != NULL) {
+    ok = RunWavefront(wf, &it, WF_CODE_PASS, enc->rd_opt_level,
+                      enc->mb_w * enc->mb_h, 1, 20);
+  } else {
+    do {
+      VP8ModeScore info;
+      const int dont_use_skip = !enc->proba.use_skip_proba;
+      const VP8RDLevel rd_opt = enc->rd_opt_level;
+
+      VP8IteratorImport(&it, NULL);
+      // Warning! order is important: first call VP8Decimate() and
+      // *then* decide how to code the skip decision if there's one.
+      if (!VP8Decimate(&it, &info, rd_opt) || dont_use_skip) {
+        CodeResiduals(it.bw, &it, &info);
+        if (it.bw->error) {
+          // enc->pic->error_code is set in PostLoopFinalize().
+          ok = 0;
+          break;
+        }
+      } else {  // reset predictors after a skip
+        ResetAfterSkip(&it);
       }
-    } else {  // reset predictors after a skip
-      ResetAfterSkip(&it);
-    }
-    StoreSideInfo(&it);
-    VP8StoreFilterStats(&it);
-    VP8IteratorExport(&it);
-    ok = VP8IteratorProgress(&it, 20);
-    VP8IteratorSaveBoundary(&it);
-  } while (ok && VP8IteratorNext(&it));
+      StoreSideInfo(&it);
+      VP8StoreFilterStats(&it);
+      VP8IteratorExport(&it);
+      ok = VP8IteratorProgress(&it, 20);
+      VP8IteratorSaveBoundary(&it);
+    } while (ok && VP8IteratorNext(&it));
+  }
+  DeleteWavefront(wf);
 
   return PostLoopFinalize(&it, ok);
 }
@@ -792,6 +1179,72 @@ int VP8EncLoop(VP8Encoder* const enc) {
 
 #define MIN_COUNT 96  // minimum number of macroblocks before updating stats
 
+// Each partition has its own token buffer and boolean encoder, so that they
+// can be emitted in parallel once the final probabilities are known.
+typedef struct {
+  WebPWorker worker;
+  VP8Encoder* enc;
+  int first_part, step;  // partitions first_part, first_part + step, ...
+} EmitJob;
+
+static int EmitJobHook(void* arg1, void* arg2) {
+  const EmitJob* const job = (const EmitJob*)arg1;
+  VP8Encoder* const enc = job->enc;
+  int p;
+  (void)arg2;
+  for (p = job->first_part; p < enc->num_parts; p += job->step) {
+    if (!VP8EmitTokens(&enc->tokens[p], enc->parts + p,
+                       (const uint8_t*)enc->proba.coeffs, !enc->keep_tokens)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int EmitTokens(VP8Encoder* const enc) {
+  const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  EmitJob jobs[MAX_NUM_PARTITIONS];
+#ifdef WEBP_USE_THREAD
+  const int num_threads =
+      (enc->thread_level > 0) ? VP8EncNumThreads(enc->thread_level) : 1;
+  const int num_jobs =
+      (num_threads < enc->num_parts) ? num_threads : enc->num_parts;
+#else
+  const int num_jobs = 1;
+#endif
+  int i, ok = 1;
+
+  for (i = 0; i < num_jobs; ++i) {
+    EmitJob* const job = &jobs[i];
+    worker_interface->Init(&job->worker);
+    job->worker.hook = EmitJobHook;
+    job->worker.data1 = job;
+    job->worker.data2 = NULL;
+    job->enc = enc;
+    job->first_part = i;
+    job->step = num_jobs;
+  }
+  // jobs[0] is executed in the calling thread.
+  for (i = 1; i < num_jobs; ++i) {
+    ok &= worker_interface->Reset(&jobs[i].worker);
+  }
+  if (ok) {
+    for (i = 1; i < num_jobs; ++i) {
+      worker_interface->Launch(&jobs[i].worker);
+    }
+    worker_interface->Execute(&jobs[0].worker);
+    for (i = 0; i < num_jobs; ++i) {
+      ok &= worker_interface->Sync(&jobs[i].worker);
+    }
+  } else {
+    WebPEncodingSetError(enc->pic, VP8_ENC_ERROR_OUT_OF_MEMORY);
+  }
+  for (i = 0; i < num_jobs; ++i) {
+    worker_interface->End(&jobs[i].worker);
+  }
+  return ok;
+}
+
 int VP8EncTokenLoop(VP8Encoder* const enc) {
   // Roughly refresh the proba eight times per pass
   int max_count = (enc->mb_w * enc->mb_h) >> 3;
@@ -803,15 +1256,16 @@ int VP8EncTokenLoop(VP8Encoder* const enc) {
   const VP8RDLevel rd_opt = enc->rd_opt_level;
   const uint64_t pixel_count = (uint64_t)enc->mb_w * enc->mb_h * 384;
   PassStats stats;
-  int ok;
+  Wavefront* wf;
+  int p, ok;
 
   InitPassStats(enc, &stats);
   ok = PreLoopInitialize(enc);
   if (!ok) return 0;
+  wf = NewWavefront(enc);
 
   if (max_count < MIN_COUNT) max_count = MIN_COUNT;
 
-  assert(enc->num_parts == 1);
   assert(enc->use_tokens);
   assert(proba->use_skip_proba == 0);
   assert(rd_opt >= RD_OPT_BASIC);  // otherwise, token-buffer won't be useful
@@ -833,37 +1287,51 @@ int VP8EncTokenLoop(VP8Encoder* const enc) {
       ResetTokenStats(enc);
       VP8InitFilter(&it);  // don't collect stats until last pass (too costly)
     }
-    VP8TBufferClear(&enc->tokens);
-    do {
-      VP8ModeScore info;
-      VP8IteratorImport(&it, NULL);
-      if (--cnt < 0) {
-        FinalizeTokenProbas(proba);
-        VP8CalculateLevelCosts(proba);  // refresh cost tables for rd-opt
-        cnt = max_count;
-      }
-      VP8Decimate(&it, &info, rd_opt);
-      ok = RecordTokens(&it, &info, &enc->tokens);
-      if (!ok) {
-        WebPEncodingSetError(enc->pic, VP8_ENC_ERROR_OUT_OF_MEMORY);
-        break;
-      }
-      size_p0 += info.H;
-      distortion += info.D;
-      if (is_last_pass) {
-        StoreSideInfo(&it);
-        VP8StoreFilterStats(&it);
-        VP8IteratorExport(&it);
-        ok = VP8IteratorProgress(&it, pass_progress);
-      }
-      VP8IteratorSaveBoundary(&it);
-    } while (ok && VP8IteratorNext(&it));
+    for (p = 0; p < enc->num_parts; ++p) {
+      VP8TBufferRecycle(&enc->tokens[p]);
+    }
+    if (wf != NULL) {
+      wf->max_count = max_count;
+      wf->cnt = cnt;
+      ok = RunWavefront(wf, &it, WF_TOKEN_PASS, rd_opt, enc->mb_w * enc->mb_h,
+                        is_last_pass, is_last_pass ? pass_progress : 0);
+      size_p0 = wf->size_p0;
+      distortion = wf->distortion;
+    } else {
+      do {
+        VP8ModeScore info;
+        VP8IteratorImport(&it, NULL);
+        if (--cnt < 0) {
+          FinalizeTokenProbas(proba);
+          VP8CalculateLevelCosts(proba);  // refresh cost tables for rd-opt
+          cnt = max_count;
+        }
+        VP8Decimate(&it, &info, rd_opt);
+        ok = RecordTokens(&it, &info);
+        if (!ok) {
+          WebPEncodingSetError(enc->pic, VP8_ENC_ERROR_OUT_OF_MEMORY);
+          break;
+        }
+        size_p0 += info.H;
+        distortion += info.D;
+        if (is_last_pass) {
+          StoreSideInfo(&it);
+          VP8StoreFilterStats(&it);
+          VP8IteratorExport(&it);
+          ok = VP8IteratorProgress(&it, pass_progress);
+        }
+        VP8IteratorSaveBoundary(&it);
+      } while (ok && VP8IteratorNext(&it));
+    }
     if (!ok) break;
 
     size_p0 += enc->segment_hdr.size;
     if (stats.do_size_search) {
       uint64_t size = FinalizeTokenProbas(&enc->proba);
-      size += VP8EstimateTokenSize(&enc->tokens, (const uint8_t*)proba->coeffs);
+      for (p = 0; p < enc->num_parts; ++p) {
+        size += VP8EstimateTokenSize(&enc->tokens[p],
+                                     (const uint8_t*)proba->coeffs);
+      }
       size = (size + size_p0 + 1024) >> 11;  // -> size in bytes
       size += HEADER_SIZE_ESTIMATE;
       stats.value = (double)size;
@@ -897,11 +1365,11 @@ int VP8EncTokenLoop(VP8Encoder* const enc) {
     if (!stats.do_size_search) {
       FinalizeTokenProbas(&enc->proba);
     }
-    ok = VP8EmitTokens(&enc->tokens, enc->parts + 0,
-                       (const uint8_t*)proba->coeffs, 1);
+    ok = EmitTokens(enc);
   }
   ok = ok && WebPReportProgress(enc->pic, enc->percent + remaining_progress,
                                 &enc->percent);
+  DeleteWavefront(wf);
   return PostLoopFinalize(&it, ok);
 }
 
@@ -79,10 +79,16 @@ static const int kMinDimensionIterativeConversion = 4;
 //------------------------------------------------------------------------------
 // Main function
 
+extern void SharpYuvInit(VP8CPUInfo cpu_info_func);
+
 static int PreprocessARGB(const uint8_t* r_ptr, const uint8_t* g_ptr,
                           const uint8_t* b_ptr, int step, int rgb_stride,
                           WebPPicture* const picture) {
-  const int ok = SharpYuvConvert(
+  int ok;
+  // Use the same CPU detection as the other DSP functions, including the cap
+  // set by WebPSetDspLevel(), instead of the one of libsharpyuv.
+  SharpYuvInit(VP8GetCPUInfo);
+  ok = SharpYuvConvert(
       r_ptr, g_ptr, b_ptr, step, rgb_stride, /*rgb_bit_depth=*/8, picture->y,
       picture->y_stride, picture->u, picture->uv_stride, picture->v,
       picture->uv_stride, /*yuv_bit_depth=*/8, picture->width, picture->height,
@@ -117,8 +123,6 @@ static WEBP_INLINE void ConvertRowsToUV(const uint16_t* rgb,
   }
 }
 
-extern void SharpYuvInit(VP8CPUInfo cpu_info_func);
-
 static int ImportYUVAFromRGBA(const uint8_t* r_ptr, const uint8_t* g_ptr,
                               const uint8_t* b_ptr, const uint8_t* a_ptr,
                               int step,        // bytes per pixel
@@ -147,7 +151,6 @@ static int ImportYUVAFromRGBA(const uint8_t* r_ptr, const uint8_t* g_ptr,
   }
 
   if (use_iterative_conversion) {
-    SharpYuvInit(VP8GetCPUInfo);
     if (!PreprocessARGB(r_ptr, g_ptr, b_ptr, step, rgb_stride, picture)) {
       return 0;
     }
@@ -50,26 +50,68 @@ void VP8TBufferInit(VP8TBuffer* const b, int page_size) {
   b->tokens = NULL;
   b->pages = NULL;
   b->last_page = &b->pages;
+  b->free_pages = NULL;
   b->left = 0;
   b->page_size = (page_size < MIN_PAGE_SIZE) ? MIN_PAGE_SIZE : page_size;
   b->error = 0;
 }
 
+static void FreePages(VP8Tokens* p) {
+  while (p != NULL) {
+    VP8Tokens* const next = p->next;
+    WebPSafeFree(p);
+    p = next;
+  }
+}
+
 void VP8TBufferClear(VP8TBuffer* const b) {
   if (b != NULL) {
-    VP8Tokens* p = b->pages;
-    while (p != NULL) {
-      VP8Tokens* const next = p->next;
-      WebPSafeFree(p);
-      p = next;
-    }
+    FreePages(b->pages);
+    FreePages(b->free_pages);
     VP8TBufferInit(b, b->page_size);
   }
 }
 
+VP8Tokens* VP8TBufferDetachPages(VP8TBuffer* const b, int* const page_size) {
+  VP8Tokens* const pages = (b->pages != NULL) ? b->pages : b->free_pages;
+  if (b->pages != NULL) *b->last_page = b->free_pages;
+  VP8TBufferInit(b, b->page_size);
+  *page_size = b->page_size;
+  return pages;
+}
+
+void VP8TBufferAttachPages(VP8TBuffer* const b, VP8Tokens* const pages,
+                           int page_size) {
+  VP8Tokens** last = &b->free_pages;
+  if (page_size != b->page_size) {
+    FreePages(pages);
+    return;
+  }
+  while (*last != NULL) last = &(*last)->next;
+  *last = pages;
+}
+
+void VP8TBufferRecycle(VP8TBuffer* const b) {
+  int page_size;
+  VP8Tokens* const pages = VP8TBufferDetachPages(b, &page_size);
+  VP8TBufferAttachPages(b, pages, page_size);
+}
+
+size_t VP8TBufferMemorySize(const VP8TBuffer* const b) {
+  const size_t page_size = sizeof(VP8Tokens) + b->page_size * sizeof(token_t);
+  size_t size = 0;
+  const VP8Tokens* p;
+  for (p = b->pages; p != NULL; p = p->next) size += page_size;
+  for (p = b->free_pages; p != NULL; p = p->next) size += page_size;
+  return size;
+}
+
 static int TBufferNewPage(VP8TBuffer* const b) {
   VP8Tokens* page = NULL;
-  if (!b->error) {
+  if (b->free_pages != NULL) {
+    page = b->free_pages;
+    b->free_pages = page->next;
+  } else if (!b->error) {
     const size_t size = sizeof(*page) + b->page_size * sizeof(token_t);
     page = (VP8Tokens*)WebPSafeMalloc(1ULL, size);
   }
@@ -258,5 +300,21 @@ void VP8TBufferInit(VP8TBuffer* const b, int page_size) {
   (void)page_size;
 }
 void VP8TBufferClear(VP8TBuffer* const b) { (void)b; }
+VP8Tokens* VP8TBufferDetachPages(VP8TBuffer* const b, int* const page_size) {
+  (void)b;
+  *page_size = 0;
+  return NULL;
+}
+void VP8TBufferAttachPages(VP8TBuffer* const b, VP8Tokens* const pages,
+                           int page_size) {
+  (void)b;
+  (void)pages;
+  (void)page_size;
+}
+void VP8TBufferRecycle(VP8TBuffer* const b) { (void)b; }
+size_t VP8TBufferMemorySize(const VP8TBuffer* const b) {
+  (void)b;
+  return 0;
+}
 
 #endif  // !DISABLE_TOKEN_BUFFER
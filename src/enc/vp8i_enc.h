@@ -37,6 +37,16 @@ extern "C" {
 #define ENC_MIN_VERSION 6
 #define ENC_REV_VERSION 0
 
+// maximal value of config->thread_level
+#define MAX_ENC_THREADS 32
+
+// Returns the number of threads (the calling one included) that the given
+// config->thread_level allows: 0 is single-threaded, 1 is the historical
+// main + side worker split and larger values are an explicit thread budget.
+static WEBP_INLINE int VP8EncNumThreads(int thread_level) {
+  return (thread_level <= 0) ? 1 : (thread_level == 1) ? 2 : thread_level;
+}
+
 enum {
   MAX_LF_LEVELS = 64,       // Maximum loop filter level
   MAX_VARIABLE_LEVEL = 67,  // last (inclusive) level with variable cost
@@ -250,6 +260,8 @@ typedef struct {
   uint64_t luma_bits;        // macroblock bit-cost for luma
   uint64_t uv_bits;          // macroblock bit-cost for chroma
   LFStats* lf_stats;         // filter stats (borrowed from enc)
+  int* max_edge;             // per-segment max edge deltas, or NULL to record
+                             // them in enc->dqm[]
   int do_trellis;            // if true, perform extra level optimisation
   int count_down;            // number of mb still to be processed
   int count_down0;           // starting counter value (for progress)
@@ -318,6 +330,7 @@ typedef struct {
 #if !defined(DISABLE_TOKEN_BUFFER)
   VP8Tokens* pages;       // first page
   VP8Tokens** last_page;  // last page
+  VP8Tokens* free_pages;  // recycled pages, used before allocating new ones
   uint16_t* tokens;       // set to (*last_page)->tokens
   int left;               // how many free tokens left before the page is full
   int page_size;          // number of tokens per page
@@ -328,6 +341,17 @@ typedef struct {
 // initialize an empty buffer
 void VP8TBufferInit(VP8TBuffer* const b, int page_size);
 void VP8TBufferClear(VP8TBuffer* const b);  // de-allocate pages memory
+// Returns all the pages of 'b', used or free, and leaves it empty. Their
+// number of tokens is stored in 'page_size'.
+VP8Tokens* VP8TBufferDetachPages(VP8TBuffer* const b, int* const page_size);
+// Adds detached 'pages' of 'page_size' tokens to the free pages of 'b'. They
+// are de-allocated instead if 'page_size' differs from b->page_size.
+void VP8TBufferAttachPages(VP8TBuffer* const b, VP8Tokens* const pages,
+                           int page_size);
+// Empties 'b' but keeps its pages for the next recording.
+void VP8TBufferRecycle(VP8TBuffer* const b);
+// Returns the size of the memory allocated for the pages of 'b'.
+size_t VP8TBufferMemorySize(const VP8TBuffer* const b);
 
 #if !defined(DISABLE_TOKEN_BUFFER)
 
@@ -368,7 +392,7 @@ struct VP8Encoder {
   // per-partition boolean decoders.
   VP8BitWriter bw;                         // part0
   VP8BitWriter parts[MAX_NUM_PARTITIONS];  // token partitions
-  VP8TBuffer tokens;                       // token buffer
+  VP8TBuffer tokens[MAX_NUM_PARTITIONS];   // token buffers, per partition
 
   int percent;  // for progress
 
@@ -405,6 +429,7 @@ struct VP8Encoder {
   int thread_level;         // derived from config->thread_level
   int do_search;            // derived from config->target_XXX
   int use_tokens;           // if true, use token buffer
+  int keep_tokens;          // if true, keep the token pages once emitted
 
   // Memory
   VP8MBInfo* mb_info;  // contextual macroblock infos (mb_w + 1)
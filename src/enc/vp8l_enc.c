@@ -411,9 +411,13 @@ static int EncoderInit(VP8LEncoder* const enc) {
   // at most MAX_REFS_BLOCK_PER_IMAGE blocks used:
   const int refs_block_size = (pix_cnt - 1) / MAX_REFS_BLOCK_PER_IMAGE + 1;
   int i;
-  if (!VP8LHashChainInit(&enc->hash_chain, pix_cnt)) return 0;
+  // A reused encoder (see VP8LEncoderNew()) keeps the memory of the same size.
+  if (enc->hash_chain.size != pix_cnt) {
+    VP8LHashChainClear(&enc->hash_chain);
+    if (!VP8LHashChainInit(&enc->hash_chain, pix_cnt)) return 0;
+  }
 
-  for (i = 0; i < 4; ++i) VP8LBackwardRefsInit(&enc->refs[i], refs_block_size);
+  for (i = 0; i < 4; ++i) VP8LBackwardRefsReset(&enc->refs[i], refs_block_size);
 
   return 1;
 }
@@ -1448,12 +1452,30 @@ static int EncodePalette(VP8LBitWriter* const bw, int low_effort,
 // -----------------------------------------------------------------------------
 // VP8LEncoder
 
+// If 'reused' is not NULL, it is returned instead of a new encoder, in the
+// same state but with the memory of its previous encoding.
 static VP8LEncoder* VP8LEncoderNew(const WebPConfig* const config,
-                                   const WebPPicture* const picture) {
-  VP8LEncoder* const enc = (VP8LEncoder*)WebPSafeCalloc(1ULL, sizeof(*enc));
-  if (enc == NULL) {
-    WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
-    return NULL;
+                                   const WebPPicture* const picture,
+                                   VP8LEncoder* const reused) {
+  VP8LEncoder* enc = reused;
+  if (enc != NULL) {
+    const VP8LHashChain hash_chain = enc->hash_chain;
+    uint32_t* const transform_mem = enc->transform_mem;
+    const size_t transform_mem_size = enc->transform_mem_size;
+    VP8LBackwardRefs refs[4];
+    memcpy(refs, enc->refs, sizeof(refs));
+    memset(enc, 0, sizeof(*enc));
+    // 'refs' may point to itself, so it is restored at the same address.
+    memcpy(enc->refs, refs, sizeof(refs));
+    enc->hash_chain = hash_chain;
+    enc->transform_mem = transform_mem;
+    enc->transform_mem_size = transform_mem_size;
+  } else {
+    enc = (VP8LEncoder*)WebPSafeCalloc(1ULL, sizeof(*enc));
+    if (enc == NULL) {
+      WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
+      return NULL;
+    }
   }
   enc->config = config;
   enc->pic = picture;
@@ -1464,7 +1486,7 @@ static VP8LEncoder* VP8LEncoderNew(const WebPConfig* const config,
   return enc;
 }
 
-static void VP8LEncoderDelete(VP8LEncoder* enc) {
+void VP8LEncoderDelete(VP8LEncoder* enc) {
   if (enc != NULL) {
     int i;
     VP8LHashChainClear(&enc->hash_chain);
@@ -1474,6 +1496,17 @@ static void VP8LEncoderDelete(VP8LEncoder* enc) {
   }
 }
 
+size_t VP8LEncoderMemorySize(const VP8LEncoder* const enc) {
+  size_t size = 0;
+  int i;
+  if (enc == NULL) return 0;
+  size += sizeof(*enc);
+  size += (size_t)enc->hash_chain.size * sizeof(*enc->hash_chain.offset_length);
+  for (i = 0; i < 4; ++i) size += VP8LBackwardRefsMemorySize(&enc->refs[i]);
+  size += enc->transform_mem_size * sizeof(*enc->transform_mem);
+  return size;
+}
+
 // -----------------------------------------------------------------------------
 // Main call
 
@@ -1665,157 +1698,178 @@ Error:
   return (params->picture->error_code == VP8_ENC_OK);
 }
 
+// Resources owned by each side worker of VP8LEncodeStream().
+typedef struct {
+  WebPWorker worker;
+  StreamEncodeContext params;
+  WebPAuxStats stats;
+  VP8LBitWriter bw;
+  WebPPicture picture;
+  VP8LEncoder* enc;
+} StreamEncodeSide;
+
 int VP8LEncodeStream(const WebPConfig* const config,
                      const WebPPicture* const picture,
-                     VP8LBitWriter* const bw_main) {
-  VP8LEncoder* const enc_main = VP8LEncoderNew(config, picture);
-  VP8LEncoder* enc_side = NULL;
+                     VP8LBitWriter* const bw_main,
+                     VP8LEncoder** const enc_store) {
+  VP8LEncoder* const enc_main =
+      VP8LEncoderNew(config, picture, (enc_store != NULL) ? *enc_store : NULL);
   CrunchConfig crunch_configs[CRUNCH_CONFIGS_MAX];
-  int num_crunch_configs_main, num_crunch_configs_side = 0;
+  int num_crunch_configs;
+  int num_workers, num_sides = 0;
   int idx;
   int red_and_blue_always_zero = 0;
-  WebPWorker worker_main, worker_side;
-  StreamEncodeContext params_main, params_side;
-  // The main thread uses picture->stats, the side thread uses stats_side.
-  WebPAuxStats stats_side;
-  VP8LBitWriter bw_side;
-  WebPPicture picture_side;
+  WebPWorker worker_main;
+  StreamEncodeContext params_main;
+  // The main worker uses picture->stats, the side ones their own copy.
+  StreamEncodeSide* sides = NULL;
   const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
-  int ok_main;
+  int ok = 1;
 
-  if (enc_main == NULL || !VP8LBitWriterInit(&bw_side, 0)) {
-    VP8LEncoderDelete(enc_main);
+  if (enc_main == NULL) {
     return WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
   }
 
-  // Avoid "garbage value" error from Clang's static analysis tool.
-  if (!WebPPictureInit(&picture_side)) {
-    goto Error;
-  }
-
   // Analyze image (entropy, num_palettes etc)
-  if (!EncoderAnalyze(enc_main, crunch_configs, &num_crunch_configs_main,
+  if (!EncoderAnalyze(enc_main, crunch_configs, &num_crunch_configs,
                       &red_and_blue_always_zero) ||
       !EncoderInit(enc_main)) {
     WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
     goto Error;
   }
 
-  // Split the configs between the main and side threads (if any).
-  if (config->thread_level > 0) {
-    num_crunch_configs_side = num_crunch_configs_main / 2;
-    for (idx = 0; idx < num_crunch_configs_side; ++idx) {
-      params_side.crunch_configs[idx] =
-          crunch_configs[num_crunch_configs_main - num_crunch_configs_side +
-                         idx];
+  // One worker per crunch config at most, within the thread budget.
+  num_workers = VP8EncNumThreads(config->thread_level);
+  if (num_workers > num_crunch_configs) num_workers = num_crunch_configs;
+  if (num_workers > 1) {
+    sides = (StreamEncodeSide*)WebPSafeCalloc(num_workers - 1, sizeof(*sides));
+    if (sides == NULL) {
+      WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
+      goto Error;
     }
-    params_side.num_crunch_configs = num_crunch_configs_side;
-  }
-  num_crunch_configs_main -= num_crunch_configs_side;
-  for (idx = 0; idx < num_crunch_configs_main; ++idx) {
-    params_main.crunch_configs[idx] = crunch_configs[idx];
-  }
-  params_main.num_crunch_configs = num_crunch_configs_main;
-
-  // Fill in the parameters for the thread workers.
-  {
-    const int params_size = (num_crunch_configs_side > 0) ? 2 : 1;
-    for (idx = 0; idx < params_size; ++idx) {
-      // Create the parameters for each worker.
-      WebPWorker* const worker = (idx == 0) ? &worker_main : &worker_side;
-      StreamEncodeContext* const param =
-          (idx == 0) ? &params_main : &params_side;
-      param->config = config;
-      param->red_and_blue_always_zero = red_and_blue_always_zero;
-      if (idx == 0) {
-        param->picture = picture;
-        param->stats = picture->stats;
-        param->bw = bw_main;
-        param->enc = enc_main;
-      } else {
-        // Create a side picture (error_code is not thread-safe).
-        if (!WebPPictureView(picture, /*left=*/0, /*top=*/0, picture->width,
-                             picture->height, &picture_side)) {
-          assert(0);
-        }
-        picture_side.progress_hook = NULL;  // Progress hook is not thread-safe.
-        param->picture = &picture_side;  // No need to free a view afterwards.
-        param->stats = (picture->stats == NULL) ? NULL : &stats_side;
-        // Create a side bit writer.
-        if (!VP8LBitWriterClone(bw_main, &bw_side)) {
-          WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
-          goto Error;
-        }
-        param->bw = &bw_side;
-        // Create a side encoder.
-        enc_side = VP8LEncoderNew(config, &picture_side);
-        if (enc_side == NULL || !EncoderInit(enc_side)) {
-          WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
-          goto Error;
-        }
-        // Copy the values that were computed for the main encoder.
-        enc_side->histo_bits = enc_main->histo_bits;
-        enc_side->predictor_transform_bits = enc_main->predictor_transform_bits;
-        enc_side->cross_color_transform_bits =
-            enc_main->cross_color_transform_bits;
-        enc_side->palette_size = enc_main->palette_size;
-        memcpy(enc_side->palette, enc_main->palette, sizeof(enc_main->palette));
-        memcpy(enc_side->palette_sorted, enc_main->palette_sorted,
-               sizeof(enc_main->palette_sorted));
-        param->enc = enc_side;
+    num_sides = num_workers - 1;
+  }
+
+  // Fill in the parameters for the thread workers. The configs are split in
+  // contiguous ranges, the main worker getting the first (and largest) one,
+  // so that picking the smallest output in worker order below favors the
+  // same config as a single-threaded run would on ties.
+  for (idx = 0; idx < num_workers; ++idx) {
+    const int first = (idx * num_crunch_configs + num_workers - 1) /
+                      num_workers;
+    const int last = ((idx + 1) * num_crunch_configs + num_workers - 1) /
+                     num_workers;
+    WebPWorker* const worker =
+        (idx == 0) ? &worker_main : &sides[idx - 1].worker;
+    StreamEncodeContext* const param =
+        (idx == 0) ? &params_main : &sides[idx - 1].params;
+    memcpy(param->crunch_configs, crunch_configs + first,
+           (last - first) * sizeof(*crunch_configs));
+    param->num_crunch_configs = last - first;
+    param->config = config;
+    param->red_and_blue_always_zero = red_and_blue_always_zero;
+    if (idx == 0) {
+      param->picture = picture;
+      param->stats = picture->stats;
+      param->bw = bw_main;
+      param->enc = enc_main;
+    } else {
+      StreamEncodeSide* const side = &sides[idx - 1];
+      VP8LEncoder* enc_side;
+      // Create a side picture (error_code is not thread-safe).
+      if (!WebPPictureView(picture, /*left=*/0, /*top=*/0, picture->width,
+                           picture->height, &side->picture)) {
+        assert(0);
+      }
+      side->picture.progress_hook = NULL;  // Progress hook is not thread-safe.
+      param->picture = &side->picture;     // No need to free a view afterwards.
+      param->stats = (picture->stats == NULL) ? NULL : &side->stats;
+      // Create a side bit writer.
+      if (!VP8LBitWriterClone(bw_main, &side->bw)) {
+        WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
+        goto Error;
+      }
+      param->bw = &side->bw;
+      // Create a side encoder.
+      enc_side = VP8LEncoderNew(config, &side->picture, /*reused=*/NULL);
+      side->enc = enc_side;
+      if (enc_side == NULL || !EncoderInit(enc_side)) {
+        WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
+        goto Error;
+      }
+      // Copy the values that were computed for the main encoder.
+      enc_side->histo_bits = enc_main->histo_bits;
+      enc_side->predictor_transform_bits = enc_main->predictor_transform_bits;
+      enc_side->cross_color_transform_bits =
+          enc_main->cross_color_transform_bits;
+      enc_side->palette_size = enc_main->palette_size;
+      memcpy(enc_side->palette, enc_main->palette, sizeof(enc_main->palette));
+      memcpy(enc_side->palette_sorted, enc_main->palette_sorted,
+             sizeof(enc_main->palette_sorted));
+      param->enc = enc_side;
+#if !defined(WEBP_DISABLE_STATS)
+      if (picture->stats != NULL) {
+        memcpy(&side->stats, picture->stats, sizeof(side->stats));
       }
-      // Create the workers.
-      worker_interface->Init(worker);
-      worker->data1 = param;
-      worker->data2 = NULL;
-      worker->hook = EncodeStreamHook;
+#endif
     }
+    // Create the workers.
+    worker_interface->Init(worker);
+    worker->data1 = param;
+    worker->data2 = NULL;
+    worker->hook = EncodeStreamHook;
   }
 
-  // Start the second thread if needed.
-  if (num_crunch_configs_side != 0) {
-    if (!worker_interface->Reset(&worker_side)) {
+  // Start the side threads if needed.
+  for (idx = 0; idx < num_sides; ++idx) {
+    if (!worker_interface->Reset(&sides[idx].worker)) {
       WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
       goto Error;
     }
-#if !defined(WEBP_DISABLE_STATS)
-    // This line is here and not in the param initialization above to remove a
-    // Clang static analyzer warning.
-    if (picture->stats != NULL) {
-      memcpy(&stats_side, picture->stats, sizeof(stats_side));
-    }
-#endif
-    worker_interface->Launch(&worker_side);
+    worker_interface->Launch(&sides[idx].worker);
   }
   // Execute the main thread.
   worker_interface->Execute(&worker_main);
-  ok_main = worker_interface->Sync(&worker_main);
+  ok = worker_interface->Sync(&worker_main);
   worker_interface->End(&worker_main);
-  if (num_crunch_configs_side != 0) {
-    // Wait for the second thread.
-    const int ok_side = worker_interface->Sync(&worker_side);
-    worker_interface->End(&worker_side);
-    if (!ok_main || !ok_side) {
-      if (picture->error_code == VP8_ENC_OK) {
-        assert(picture_side.error_code != VP8_ENC_OK);
-        WebPEncodingSetError(picture, picture_side.error_code);
-      }
-      goto Error;
+  // Wait for the side threads.
+  for (idx = 0; idx < num_sides; ++idx) {
+    StreamEncodeSide* const side = &sides[idx];
+    const int ok_side = worker_interface->Sync(&side->worker);
+    worker_interface->End(&side->worker);
+    if (!ok_side && picture->error_code == VP8_ENC_OK) {
+      assert(side->picture.error_code != VP8_ENC_OK);
+      WebPEncodingSetError(picture, side->picture.error_code);
     }
-    if (VP8LBitWriterNumBytes(&bw_side) < VP8LBitWriterNumBytes(bw_main)) {
-      VP8LBitWriterSwap(bw_main, &bw_side);
+    ok &= ok_side;
+  }
+  if (!ok) goto Error;
+
+  for (idx = 0; idx < num_sides; ++idx) {
+    StreamEncodeSide* const side = &sides[idx];
+    if (VP8LBitWriterNumBytes(&side->bw) < VP8LBitWriterNumBytes(bw_main)) {
+      VP8LBitWriterSwap(bw_main, &side->bw);
 #if !defined(WEBP_DISABLE_STATS)
       if (picture->stats != NULL) {
-        memcpy(picture->stats, &stats_side, sizeof(*picture->stats));
+        memcpy(picture->stats, &side->stats, sizeof(*picture->stats));
       }
 #endif
     }
   }
 
 Error:
-  VP8LBitWriterWipeOut(&bw_side);
-  VP8LEncoderDelete(enc_main);
-  VP8LEncoderDelete(enc_side);
+  for (idx = 0; idx < num_sides; ++idx) {
+    // No-op for workers already ended above.
+    worker_interface->End(&sides[idx].worker);
+    VP8LBitWriterWipeOut(&sides[idx].bw);
+    VP8LEncoderDelete(sides[idx].enc);
+  }
+  WebPSafeFree(sides);
+  if (enc_store != NULL) {
+    *enc_store = enc_main;
+  } else {
+    VP8LEncoderDelete(enc_main);
+  }
   return (picture->error_code == VP8_ENC_OK);
 }
 
@@ -1823,7 +1877,8 @@ Error:
 #undef CRUNCH_SUBCONFIGS_MAX
 
 int VP8LEncodeImage(const WebPConfig* const config,
-                    const WebPPicture* const picture) {
+                    const WebPPicture* const picture,
+                    VP8LEncoder** const enc_store) {
   int width, height;
   int has_alpha;
   size_t coded_size;
@@ -1880,7 +1935,7 @@ int VP8LEncodeImage(const WebPConfig* const config,
   if (!WebPReportProgress(picture, 2, &percent)) goto UserAbort;
 
   // Encode main image stream.
-  if (!VP8LEncodeStream(config, picture, &bw)) goto Error;
+  if (!VP8LEncodeStream(config, picture, &bw, enc_store)) goto Error;
 
   if (!WebPReportProgress(picture, 99, &percent)) goto UserAbort;
 
@@ -86,16 +86,27 @@ typedef struct {
 //------------------------------------------------------------------------------
 // internal functions. Not public.
 
-// Encodes the picture.
+// Encodes the picture. 'enc_store' is passed to VP8LEncodeStream().
 // Returns 0 if config or picture is NULL or picture doesn't have valid argb
 // input.
 int VP8LEncodeImage(const WebPConfig* const config,
-                    const WebPPicture* const picture);
+                    const WebPPicture* const picture,
+                    VP8LEncoder** const enc_store);
 
 // Encodes the main image stream using the supplied bit writer.
+// If 'enc_store' is not NULL, the encoder it points to (if any) is reused,
+// keeping its memory, and the encoder is stored there afterwards instead of
+// being deleted.
 // Returns false in case of error (stored in picture->error_code).
 int VP8LEncodeStream(const WebPConfig* const config,
-                     const WebPPicture* const picture, VP8LBitWriter* const bw);
+                     const WebPPicture* const picture, VP8LBitWriter* const bw,
+                     VP8LEncoder** const enc_store);
+
+// Releases an encoder kept by VP8LEncodeStream(). 'enc' can be NULL.
+void VP8LEncoderDelete(VP8LEncoder* enc);
+
+// Returns the size of the memory kept by 'enc', which can be NULL.
+size_t VP8LEncoderMemorySize(const VP8LEncoder* const enc);
 
 #if (WEBP_NEAR_LOSSLESS == 1)
 // in near_lossless.c
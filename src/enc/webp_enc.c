@@ -120,9 +120,6 @@ static void MapConfigToTools(VP8Encoder* const enc) {
 #if !defined(DISABLE_TOKEN_BUFFER)
     enc->use_tokens = (enc->rd_opt_level >= RD_OPT_BASIC);  // need rd stats
 #endif
-    if (enc->use_tokens) {
-      enc->num_parts = 1;  // doesn't work with multi-partition
-    }
   }
 }
 
@@ -145,8 +142,28 @@ static void MapConfigToTools(VP8Encoder* const enc) {
 //              LFStats: 2048
 // Picture size (yuv): 419328
 
+// Memory kept from one WebPEncodeWithContext() call to the next.
+struct WebPEncoderContext {
+  VP8Encoder* enc;        // last lossy encoder, with its token pages
+  size_t enc_size;        // size of the memory block starting at 'enc'
+  VP8LEncoder* vp8l_enc;  // last main lossless encoder
+};
+
+static void FreeVP8Encoder(VP8Encoder* const enc) {
+  if (enc != NULL) {
+    int p;
+    for (p = 0; p < enc->num_parts; ++p) {
+      VP8TBufferClear(&enc->tokens[p]);
+    }
+    WebPSafeFree(enc);
+  }
+}
+
+// If 'ctx' is not NULL, the memory block of the encoder it keeps is reused if
+// large enough, along with its token pages.
 static VP8Encoder* InitVP8Encoder(const WebPConfig* const config,
-                                  WebPPicture* const picture) {
+                                  WebPPicture* const picture,
+                                  WebPEncoderContext* const ctx) {
   VP8Encoder* enc;
   const int use_filter =
       (config->filter_strength > 0) || (config->autofilter > 0);
@@ -168,6 +185,9 @@ static VP8Encoder* InitVP8Encoder(const WebPConfig* const config,
           ? mb_w * sizeof(*enc->top_derr)
           : 0;
   uint8_t* mem;
+  VP8Tokens* pages[MAX_NUM_PARTITIONS];
+  int num_pages = 0, page_size = 0;
+  int p;
   const uint64_t size = (uint64_t)sizeof(*enc)  // main struct
                         + WEBP_ALIGN_CST        // cache alignment
                         + info_size             // modes info
@@ -203,10 +223,26 @@ static VP8Encoder* InitVP8Encoder(const WebPConfig* const config,
   printf("Picture size (yuv): %ld\n", mb_w * mb_h * 384 * sizeof(uint8_t));
   printf("===================================\n");
 #endif
-  mem = (uint8_t*)WebPSafeMalloc(size, sizeof(*mem));
-  if (mem == NULL) {
-    WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
-    return NULL;
+  if (ctx != NULL && ctx->enc != NULL && size <= ctx->enc_size) {
+    enc = ctx->enc;
+    for (p = 0; p < enc->num_parts; ++p) {
+      pages[p] = VP8TBufferDetachPages(&enc->tokens[p], &page_size);
+    }
+    num_pages = enc->num_parts;
+    ctx->enc = NULL;  // given back by DeleteVP8Encoder()
+    mem = (uint8_t*)enc;
+  } else {
+    if (ctx != NULL) {
+      FreeVP8Encoder(ctx->enc);
+      ctx->enc = NULL;
+      ctx->enc_size = (size_t)size;
+    }
+    mem = (uint8_t*)WebPSafeMalloc(size, sizeof(*mem));
+    if (mem == NULL) {
+      if (ctx != NULL) ctx->enc_size = 0;
+      WebPEncodingSetError(picture, VP8_ENC_ERROR_OUT_OF_MEMORY);
+      return NULL;
+    }
   }
   enc = (VP8Encoder*)mem;
   mem = (uint8_t*)WEBP_ALIGN(mem + sizeof(*enc));
@@ -251,17 +287,30 @@ static VP8Encoder* InitVP8Encoder(const WebPConfig* const config,
   // size based on quality. This is just a crude 1rst-order prediction.
   {
     const float scale = 1.f + config->quality * 5.f / 100.f;  // in [1,6]
-    VP8TBufferInit(&enc->tokens, (int)(mb_w * mb_h * 4 * scale));
+    for (p = 0; p < enc->num_parts; ++p) {
+      VP8TBufferInit(&enc->tokens[p],
+                     (int)(mb_w * mb_h * 4 * scale / enc->num_parts));
+    }
   }
+  // Pages of a different size are freed.
+  for (p = 0; p < num_pages; ++p) {
+    VP8TBufferAttachPages(&enc->tokens[p % enc->num_parts], pages[p],
+                          page_size);
+  }
+  enc->keep_tokens = (ctx != NULL);
   return enc;
 }
 
-static int DeleteVP8Encoder(VP8Encoder* enc) {
+// If 'ctx' is not NULL, 'enc' is kept there for the next encoding.
+static int DeleteVP8Encoder(VP8Encoder* enc, WebPEncoderContext* const ctx) {
   int ok = 1;
   if (enc != NULL) {
     ok = VP8EncDeleteAlpha(enc);
-    VP8TBufferClear(&enc->tokens);
-    WebPSafeFree(enc);
+    if (ctx != NULL) {
+      ctx->enc = enc;
+    } else {
+      FreeVP8Encoder(enc);
+    }
   }
   return ok;
 }
@@ -332,7 +381,9 @@ int WebPReportProgress(const WebPPicture* const pic, int percent,
 }
 //------------------------------------------------------------------------------
 
-int WebPEncode(const WebPConfig* config, WebPPicture* pic) {
+// Shared by WebPEncode() and WebPEncodeWithContext(). 'ctx' can be NULL.
+static int Encode(const WebPConfig* const config, WebPPicture* const pic,
+                  WebPEncoderContext* const ctx) {
   int ok = 0;
   if (pic == NULL) return 0;
 
@@ -378,7 +429,7 @@ int WebPEncode(const WebPConfig* config, WebPPicture* pic) {
       WebPCleanupTransparentArea(pic);
     }
 
-    enc = InitVP8Encoder(config, pic);
+    enc = InitVP8Encoder(config, pic, ctx);
     if (enc == NULL) return 0;  // pic->error is already set.
     // Note: each of the tasks below account for 20% in the progress report.
     ok = VP8EncAnalyze(enc);
@@ -397,7 +448,7 @@ int WebPEncode(const WebPConfig* config, WebPPicture* pic) {
     if (!ok) {
       VP8EncFreeBitWriters(enc);
     }
-    ok &= DeleteVP8Encoder(enc);  // must always be called, even if !ok
+    ok &= DeleteVP8Encoder(enc, ctx);  // must always be called, even if !ok
   } else {
     // Make sure we have ARGB samples.
     if (pic->argb == NULL && !WebPPictureYUVAToARGB(pic)) {
@@ -408,8 +459,54 @@ int WebPEncode(const WebPConfig* config, WebPPicture* pic) {
       WebPReplaceTransparentPixels(pic, 0x000000);
     }
 
-    ok = VP8LEncodeImage(config, pic);  // Sets pic->error in case of problem.
+    // Sets pic->error in case of problem.
+    ok = VP8LEncodeImage(config, pic, (ctx != NULL) ? &ctx->vp8l_enc : NULL);
   }
 
   return ok;
 }
+
+int WebPEncode(const WebPConfig* config, WebPPicture* pic) {
+  return Encode(config, pic, NULL);
+}
+
+//------------------------------------------------------------------------------
+// Encoder context
+
+WebPEncoderContext* WebPNewEncoderContext(void) {
+  return (WebPEncoderContext*)WebPSafeCalloc(1ULL,
+                                             sizeof(WebPEncoderContext));
+}
+
+void WebPDeleteEncoderContext(WebPEncoderContext* context) {
+  if (context != NULL) {
+    FreeVP8Encoder(context->enc);
+    VP8LEncoderDelete(context->vp8l_enc);
+    WebPSafeFree(context);
+  }
+}
+
+int WebPEncodeWithContext(WebPEncoderContext* context,
+                          const WebPConfig* config, WebPPicture* pic) {
+  if (pic == NULL) return 0;
+  if (context == NULL) {
+    pic->error_code = VP8_ENC_OK;
+    return WebPEncodingSetError(pic, VP8_ENC_ERROR_NULL_PARAMETER);
+  }
+  return Encode(config, pic, context);
+}
+
+size_t WebPGetEncoderContextMemory(const WebPEncoderContext* context) {
+  size_t size = 0;
+  if (context == NULL) return 0;
+  size += sizeof(*context);
+  if (context->enc != NULL) {
+    int p;
+    size += context->enc_size;
+    for (p = 0; p < context->enc->num_parts; ++p) {
+      size += VP8TBufferMemorySize(&context->enc->tokens[p]);
+    }
+  }
+  size += VP8LEncoderMemorySize(context->vp8l_enc);
+  return size;
+}
@@ -12,12 +12,15 @@
 
 #include <assert.h>
 #include <limits.h>
-#include <math.h>  // for pow()
+#include <math.h>  // for log() and pow()
 #include <stdio.h>
-#include <stdlib.h>  // for abs()
+#include <stdlib.h>
 #include <string.h>
 
+#include "src/dsp/dsp.h"
 #include "src/mux/animi.h"
+#include "src/mux/muxi.h"
+#include "src/utils/thread_utils.h"
 #include "src/utils/utils.h"
 #include "src/webp/decode.h"
 #include "src/webp/encode.h"
@@ -48,6 +51,54 @@ typedef struct {
   int is_key_frame;            // True if 'key_frame' has been chosen.
 } EncodedFrame;
 
+// Struct representing a candidate encoded frame including its metadata.
+typedef struct {
+  WebPMemoryWriter mem;  // Encoded bytes.
+  WebPMuxFrameInfo info;
+  FrameRectangle rect;  // Coordinates and dimensions of this candidate.
+  int carries_over;  // True if at least one pixel in rect is carried over from
+                     // the previous frame, meaning at least one pixel was set
+                     // to fully transparent and this frame is blended.
+                     // If this is true, such pixels are marked as 1s in
+                     // CandidateJob::carryover_mask.
+} Candidate;
+
+// Encoding of a candidate. With WebPConfig::thread_level, it is done by a
+// worker thread while the next candidates are prepared, and the best one is
+// picked once they are all encoded.
+typedef struct {
+  WebPWorker worker;
+  int threaded;           // True if the encoding was launched in 'worker'.
+  Candidate candidate;
+  WebPConfig config;
+  WebPPicture sub_frame;  // A view of the current canvas, or a copy of the
+                          // pixels to encode if 'threaded'.
+  uint8_t* carryover_mask;  // Mask of the pixels carried over, swapped with
+                            // WebPAnimEncoder::candidate_carryover_mask.
+  WebPMuxAnimDispose dispose_method;
+  int is_key_frame;
+  WebPEncodingError error_code;
+} CandidateJob;
+
+// Up to 4 candidates for the subframe, and 2 for the keyframe.
+#define MAX_CANDIDATE_JOBS 6
+
+// Frame kept by WebPAnimEncoderAdd() when WebPAnimEncoderOptions::lookahead is
+// set. Its keyframe candidates may be encoded by 'worker' before its turn.
+typedef struct {
+  WebPPicture frame;  // Copy of the input frame.
+  int timestamp;
+  WebPConfig config;
+  WebPWorker worker;
+  int key_frame_launched;      // True if 'worker' encodes the keyframe.
+  WebPPicture key_frame;       // Copy of 'frame' encoded by 'worker'.
+  Candidate key_candidates[2];
+  int num_key_candidates;
+  WebPEncodingError error_code;
+} QueuedFrame;
+
+#define MAX_LOOKAHEAD 16
+
 struct WebPAnimEncoder {
   const int canvas_width;                // Canvas width.
   const int canvas_height;               // Canvas height.
@@ -86,6 +137,17 @@ struct WebPAnimEncoder {
   // Same as candidate_carryover_mask but for the best candidate subframe.
   uint8_t* best_candidate_carryover_mask;
 
+  // Candidates of the current frame, in the order they are evaluated.
+  CandidateJob candidate_jobs[MAX_CANDIDATE_JOBS];
+  int num_candidate_jobs;
+  int num_synced_jobs;  // Number of jobs known to be finished.
+
+  // Frames not encoded yet, in a ring buffer of 'options.lookahead' slots.
+  QueuedFrame* queue;
+  int queue_start;
+  int num_queued;
+  QueuedFrame* curr_queued;  // Queued frame being encoded, if any.
+
   // Encoded data.
   EncodedFrame* encoded_frames;  // Array of encoded frames.
   size_t size;                   // Number of allocated frames.
@@ -119,6 +181,13 @@ struct WebPAnimEncoder {
                            // different from 'in_frame_count' due to merging.
 
   WebPMux* mux;  // Muxer to assemble the WebP bitstream.
+
+  // Streaming output, if 'stream.writer' is set.
+  WebPPicture stream;    // Only holds the writer and its 'custom_ptr', NULL
+                         // by default (not WebPPictureInit()'ed).
+  int stream_started;    // True once the header is written.
+  uint64_t stream_size;  // Number of bytes written so far.
+  int stream_has_alpha;  // True if a written frame has alpha.
   char error_str[ERROR_STR_MAX_LENGTH];  // Error string. Empty if no error.
 };
 
@@ -191,6 +260,17 @@ static void SanitizeEncoderOptions(WebPAnimEncoderOptions* const enc_options) {
   assert(enc_options->kmin < enc_options->kmax);
 }
 
+static void SanitizeLookahead(WebPAnimEncoderOptions* const enc_options) {
+  if (enc_options->lookahead < 0) {
+    enc_options->lookahead = 0;
+  } else if (enc_options->lookahead > MAX_LOOKAHEAD) {
+    enc_options->lookahead = MAX_LOOKAHEAD;
+    if (enc_options->verbose) {
+      fprintf(stderr, "WARNING: Setting lookahead = %d.\n", MAX_LOOKAHEAD);
+    }
+  }
+}
+
 #undef MAX_CACHED_FRAMES
 
 static void DefaultEncoderOptions(WebPAnimEncoderOptions* const enc_options) {
@@ -200,6 +280,7 @@ static void DefaultEncoderOptions(WebPAnimEncoderOptions* const enc_options) {
   DisableKeyframes(enc_options);
   enc_options->allow_mixed = 0;
   enc_options->verbose = 0;
+  enc_options->lookahead = 0;
 }
 
 int WebPAnimEncoderOptionsInitInternal(WebPAnimEncoderOptions* enc_options,
@@ -272,6 +353,7 @@ WebPAnimEncoder* WebPAnimEncoderNewInternal(
   enc = (WebPAnimEncoder*)WebPSafeCalloc(1, sizeof(*enc));
   if (enc == NULL) return NULL;
   MarkNoError(enc);
+  WebPAnimEncDspInit();
 
   // Dimensions and options.
   *(int*)&enc->canvas_width = width;
@@ -279,6 +361,7 @@ WebPAnimEncoder* WebPAnimEncoderNewInternal(
   if (enc_options != NULL) {
     *(WebPAnimEncoderOptions*)&enc->options = *enc_options;
     SanitizeEncoderOptions((WebPAnimEncoderOptions*)&enc->options);
+    SanitizeLookahead((WebPAnimEncoderOptions*)&enc->options);
   } else {
     DefaultEncoderOptions((WebPAnimEncoderOptions*)&enc->options);
   }
@@ -307,6 +390,21 @@ WebPAnimEncoder* WebPAnimEncoderNewInternal(
   enc->best_candidate_carryover_mask = (uint8_t*)WebPSafeMalloc(
       width * (uint64_t)height, sizeof(*enc->best_candidate_carryover_mask));
   if (enc->best_candidate_carryover_mask == NULL) goto Err;
+  {
+    int i;
+    for (i = 0; i < MAX_CANDIDATE_JOBS; ++i) {
+      WebPGetWorkerInterface()->Init(&enc->candidate_jobs[i].worker);
+    }
+  }
+  if (enc->options.lookahead > 0) {
+    int i;
+    enc->queue = (QueuedFrame*)WebPSafeCalloc(enc->options.lookahead,
+                                              sizeof(*enc->queue));
+    if (enc->queue == NULL) goto Err;
+    for (i = 0; i < enc->options.lookahead; ++i) {
+      WebPGetWorkerInterface()->Init(&enc->queue[i].worker);
+    }
+  }
 
   // Encoded frames.
   ResetCounters(enc);
@@ -347,15 +445,33 @@ static void FrameRelease(EncodedFrame* const encoded_frame) {
 
 void WebPAnimEncoderDelete(WebPAnimEncoder* enc) {
   if (enc != NULL) {
+    int i;
     WebPPictureFree(&enc->curr_canvas_copy);
     WebPPictureFree(&enc->prev_canvas);
     WebPPictureFree(&enc->canvas_carryover);
     WebPSafeFree(enc->candidate_carryover_mask);
     WebPSafeFree(enc->best_candidate_carryover_mask);
+    for (i = 0; i < MAX_CANDIDATE_JOBS; ++i) {
+      WebPGetWorkerInterface()->End(&enc->candidate_jobs[i].worker);
+      WebPSafeFree(enc->candidate_jobs[i].carryover_mask);
+    }
+    if (enc->queue != NULL) {
+      for (i = 0; i < enc->options.lookahead; ++i) {
+        QueuedFrame* const queued = &enc->queue[i];
+        int k;
+        WebPGetWorkerInterface()->End(&queued->worker);
+        for (k = 0; k < queued->num_key_candidates; ++k) {
+          WebPMemoryWriterClear(&queued->key_candidates[k].mem);
+        }
+        WebPPictureFree(&queued->key_frame);
+        WebPPictureFree(&queued->frame);
+      }
+      WebPSafeFree(enc->queue);
+    }
     if (enc->encoded_frames != NULL) {
-      size_t i;
-      for (i = 0; i < enc->size; ++i) {
-        FrameRelease(&enc->encoded_frames[i]);
+      size_t j;
+      for (j = 0; j < enc->size; ++j) {
+        FrameRelease(&enc->encoded_frames[j]);
       }
       WebPSafeFree(enc->encoded_frames);
     }
@@ -374,62 +490,6 @@ static EncodedFrame* GetFrame(const WebPAnimEncoder* const enc,
   return &enc->encoded_frames[enc->start + position];
 }
 
-typedef int (*ComparePixelsFunc)(const uint32_t*, int, const uint32_t*, int,
-                                 int, int);
-
-// Returns true if 'length' number of pixels in 'src' and 'dst' are equal,
-// assuming the given step sizes between pixels.
-// 'max_allowed_diff' is unused and only there to allow function pointer use.
-static WEBP_INLINE int ComparePixelsLossless(const uint32_t* src, int src_step,
-                                             const uint32_t* dst, int dst_step,
-                                             int length, int max_allowed_diff) {
-  (void)max_allowed_diff;
-  assert(length > 0);
-  while (length-- > 0) {
-    if (*src != *dst) {
-      return 0;
-    }
-    src += src_step;
-    dst += dst_step;
-  }
-  return 1;
-}
-
-// Helper to check if each channel in 'src' and 'dst' is at most off by
-// 'max_allowed_diff'.
-static WEBP_INLINE int PixelsAreSimilar(uint32_t src, uint32_t dst,
-                                        int max_allowed_diff) {
-  const int src_a = (src >> 24) & 0xff;
-  const int src_r = (src >> 16) & 0xff;
-  const int src_g = (src >> 8) & 0xff;
-  const int src_b = (src >> 0) & 0xff;
-  const int dst_a = (dst >> 24) & 0xff;
-  const int dst_r = (dst >> 16) & 0xff;
-  const int dst_g = (dst >> 8) & 0xff;
-  const int dst_b = (dst >> 0) & 0xff;
-
-  return (src_a == dst_a) &&
-         (abs(src_r - dst_r) * dst_a <= (max_allowed_diff * 255)) &&
-         (abs(src_g - dst_g) * dst_a <= (max_allowed_diff * 255)) &&
-         (abs(src_b - dst_b) * dst_a <= (max_allowed_diff * 255));
-}
-
-// Returns true if 'length' number of pixels in 'src' and 'dst' are within an
-// error bound, assuming the given step sizes between pixels.
-static WEBP_INLINE int ComparePixelsLossy(const uint32_t* src, int src_step,
-                                          const uint32_t* dst, int dst_step,
-                                          int length, int max_allowed_diff) {
-  assert(length > 0);
-  while (length-- > 0) {
-    if (!PixelsAreSimilar(*src, *dst, max_allowed_diff)) {
-      return 0;
-    }
-    src += src_step;
-    dst += dst_step;
-  }
-  return 1;
-}
-
 static int IsEmptyRect(const FrameRectangle* const rect) {
   return (rect->width == 0) || (rect->height == 0);
 }
@@ -441,82 +501,70 @@ static int QualityToMaxDiff(float quality) {
 }
 
 // Assumes that an initial valid guess of change rectangle 'rect' is passed.
+// The rectangle is shrunk to the bounding box of the pixels that differ.
 static void MinimizeChangeRectangle(const WebPPicture* const src,
                                     const WebPPicture* const dst,
                                     FrameRectangle* const rect, int is_lossless,
                                     float quality) {
-  int i, j;
-  const ComparePixelsFunc compare_pixels =
-      is_lossless ? ComparePixelsLossless : ComparePixelsLossy;
+  const WebPAnimCompareFunc find_first_diff =
+      is_lossless ? WebPAnimFindFirstDiffLossless : WebPAnimFindFirstDiffLossy;
+  const WebPAnimCompareFunc find_last_diff =
+      is_lossless ? WebPAnimFindLastDiffLossless : WebPAnimFindLastDiffLossy;
   const int max_allowed_diff_lossy = QualityToMaxDiff(quality);
   const int max_allowed_diff = is_lossless ? 0 : max_allowed_diff_lossy;
+  const int width = rect->width;
+  const uint32_t* const src_argb = src->argb + rect->x_offset;
+  const uint32_t* const dst_argb = dst->argb + rect->x_offset;
+  const uint32_t* src_row = NULL;
+  const uint32_t* dst_row = NULL;
+  int left = width, right = -1;  // changed columns, relative to 'x_offset'
+  int top, bottom;
+  int j;
 
   // Assumption/correctness checks.
   assert(src->width == dst->width && src->height == dst->height);
   assert(rect->x_offset + rect->width <= dst->width);
   assert(rect->y_offset + rect->height <= dst->height);
-
-  // Left boundary.
-  for (i = rect->x_offset; i < rect->x_offset + rect->width; ++i) {
-    const uint32_t* const src_argb =
-        &src->argb[rect->y_offset * src->argb_stride + i];
-    const uint32_t* const dst_argb =
-        &dst->argb[rect->y_offset * dst->argb_stride + i];
-    if (compare_pixels(src_argb, src->argb_stride, dst_argb, dst->argb_stride,
-                       rect->height, max_allowed_diff)) {
-      --rect->width;  // Redundant column.
-      ++rect->x_offset;
-    } else {
-      break;
-    }
-  }
-  if (rect->width == 0) goto NoChange;
-
-  // Right boundary.
-  for (i = rect->x_offset + rect->width - 1; i >= rect->x_offset; --i) {
-    const uint32_t* const src_argb =
-        &src->argb[rect->y_offset * src->argb_stride + i];
-    const uint32_t* const dst_argb =
-        &dst->argb[rect->y_offset * dst->argb_stride + i];
-    if (compare_pixels(src_argb, src->argb_stride, dst_argb, dst->argb_stride,
-                       rect->height, max_allowed_diff)) {
-      --rect->width;  // Redundant column.
-    } else {
-      break;
-    }
-  }
-  if (rect->width == 0) goto NoChange;
+  if (IsEmptyRect(rect)) goto NoChange;
 
   // Top boundary.
-  for (j = rect->y_offset; j < rect->y_offset + rect->height; ++j) {
-    const uint32_t* const src_argb =
-        &src->argb[j * src->argb_stride + rect->x_offset];
-    const uint32_t* const dst_argb =
-        &dst->argb[j * dst->argb_stride + rect->x_offset];
-    if (compare_pixels(src_argb, 1, dst_argb, 1, rect->width,
-                       max_allowed_diff)) {
-      --rect->height;  // Redundant row.
-      ++rect->y_offset;
-    } else {
-      break;
-    }
+  for (top = rect->y_offset; top < rect->y_offset + rect->height; ++top) {
+    src_row = src_argb + top * src->argb_stride;
+    dst_row = dst_argb + top * dst->argb_stride;
+    left = find_first_diff(src_row, dst_row, width, max_allowed_diff);
+    if (left < width) break;
   }
-  if (rect->height == 0) goto NoChange;
+  if (left == width) goto NoChange;
+  right = find_last_diff(src_row, dst_row, width, max_allowed_diff);
 
   // Bottom boundary.
-  for (j = rect->y_offset + rect->height - 1; j >= rect->y_offset; --j) {
-    const uint32_t* const src_argb =
-        &src->argb[j * src->argb_stride + rect->x_offset];
-    const uint32_t* const dst_argb =
-        &dst->argb[j * dst->argb_stride + rect->x_offset];
-    if (compare_pixels(src_argb, 1, dst_argb, 1, rect->width,
-                       max_allowed_diff)) {
-      --rect->height;  // Redundant row.
-    } else {
+  for (bottom = rect->y_offset + rect->height - 1; bottom > top; --bottom) {
+    int first;
+    src_row = src_argb + bottom * src->argb_stride;
+    dst_row = dst_argb + bottom * dst->argb_stride;
+    first = find_first_diff(src_row, dst_row, width, max_allowed_diff);
+    if (first < width) {
+      if (first < left) left = first;
+      right = find_last_diff(src_row + right + 1, dst_row + right + 1,
+                             width - right - 1, max_allowed_diff) + right + 1;
       break;
     }
   }
-  if (rect->height == 0) goto NoChange;
+
+  // Left and right boundaries: only the columns outside of [left, right] need
+  // to be checked in the rows in between.
+  for (j = top + 1; j < bottom && (left > 0 || right < width - 1); ++j) {
+    src_row = src_argb + j * src->argb_stride;
+    dst_row = dst_argb + j * dst->argb_stride;
+    left = find_first_diff(src_row, dst_row, left, max_allowed_diff);
+    right = find_last_diff(src_row + right + 1, dst_row + right + 1,
+                           width - right - 1, max_allowed_diff) + right + 1;
+  }
+
+  rect->x_offset += left;
+  rect->width = right - left + 1;
+  rect->y_offset = top;
+  rect->height = bottom - top + 1;
 
   if (IsEmptyRect(rect)) {
   NoChange:
@@ -668,21 +716,17 @@ static uint32_t RectArea(const FrameRectangle* const rect) {
 static int IsLosslessBlendingPossible(const WebPPicture* const src,
                                       const WebPPicture* const dst,
                                       const FrameRectangle* const rect) {
-  int i, j;
+  int j;
   assert(src->width == dst->width && src->height == dst->height);
   assert(rect->x_offset + rect->width <= dst->width);
   assert(rect->y_offset + rect->height <= dst->height);
   for (j = rect->y_offset; j < rect->y_offset + rect->height; ++j) {
-    for (i = rect->x_offset; i < rect->x_offset + rect->width; ++i) {
-      const uint32_t src_pixel = src->argb[j * src->argb_stride + i];
-      const uint32_t dst_pixel = dst->argb[j * dst->argb_stride + i];
-      const uint32_t dst_alpha = dst_pixel >> 24;
-      if (dst_alpha != 0xff && src_pixel != dst_pixel) {
-        // In this case, if we use blending, we can't attain the desired
-        // 'dst_pixel' value for this pixel. So, blending is not possible.
-        return 0;
-      }
-    }
+    const uint32_t* const psrc =
+        src->argb + j * src->argb_stride + rect->x_offset;
+    const uint32_t* const pdst =
+        dst->argb + j * dst->argb_stride + rect->x_offset;
+    // If a non-opaque 'dst' pixel differs, blending can't attain it.
+    if (!WebPAnimCanBlendLossless(psrc, pdst, rect->width, 0)) return 0;
   }
   return 1;
 }
@@ -692,21 +736,19 @@ static int IsLossyBlendingPossible(const WebPPicture* const src,
                                    const FrameRectangle* const rect,
                                    float quality) {
   const int max_allowed_diff_lossy = QualityToMaxDiff(quality);
-  int i, j;
+  int j;
   assert(src->width == dst->width && src->height == dst->height);
   assert(rect->x_offset + rect->width <= dst->width);
   assert(rect->y_offset + rect->height <= dst->height);
   for (j = rect->y_offset; j < rect->y_offset + rect->height; ++j) {
-    for (i = rect->x_offset; i < rect->x_offset + rect->width; ++i) {
-      const uint32_t src_pixel = src->argb[j * src->argb_stride + i];
-      const uint32_t dst_pixel = dst->argb[j * dst->argb_stride + i];
-      const uint32_t dst_alpha = dst_pixel >> 24;
-      if (dst_alpha != 0xff &&
-          !PixelsAreSimilar(src_pixel, dst_pixel, max_allowed_diff_lossy)) {
-        // In this case, if we use blending, we can't attain the desired
-        // 'dst_pixel' value for this pixel. So, blending is not possible.
-        return 0;
-      }
+    const uint32_t* const psrc =
+        src->argb + j * src->argb_stride + rect->x_offset;
+    const uint32_t* const pdst =
+        dst->argb + j * dst->argb_stride + rect->x_offset;
+    // If a non-opaque 'dst' pixel differs, blending can't attain it.
+    if (!WebPAnimCanBlendLossy(psrc, pdst, rect->width,
+                               max_allowed_diff_lossy)) {
+      return 0;
     }
   }
   return 1;
@@ -720,21 +762,20 @@ static int IncreaseTransparency(const WebPPicture* const src,
                                 const FrameRectangle* const rect,
                                 WebPPicture* const dst,
                                 uint8_t* const carryover_mask) {
-  int i, j;
+  int j;
   int modified = 0;
   // carryover_mask spans over the rect part of the canvas.
   uint8_t* carryover_row = carryover_mask;
   assert(src != NULL && dst != NULL && rect != NULL);
   assert(src->width == dst->width && src->height == dst->height);
+  // WebPAnimIncreaseTransparency() uses the same color.
+  assert(TRANSPARENT_COLOR == 0x00000000);
   for (j = rect->y_offset; j < rect->y_offset + rect->height; ++j) {
-    const uint32_t* const psrc = src->argb + j * src->argb_stride;
-    uint32_t* const pdst = dst->argb + j * dst->argb_stride;
-    for (i = rect->x_offset; i < rect->x_offset + rect->width; ++i) {
-      if (psrc[i] == pdst[i] && pdst[i] != TRANSPARENT_COLOR) {
-        pdst[i] = TRANSPARENT_COLOR;
-        carryover_row[i - rect->x_offset] = 1;
-        modified = 1;
-      }
+    const uint32_t* const psrc =
+        src->argb + j * src->argb_stride + rect->x_offset;
+    uint32_t* const pdst = dst->argb + j * dst->argb_stride + rect->x_offset;
+    if (WebPAnimIncreaseTransparency(psrc, pdst, carryover_row, rect->width)) {
+      modified = 1;
     }
     carryover_row += rect->width;
   }
@@ -767,34 +808,19 @@ static int FlattenSimilarBlocks(const WebPPicture* const src,
   assert(src != NULL && dst != NULL && rect != NULL);
   assert(src->width == dst->width && src->height == dst->height);
   assert((block_size & (block_size - 1)) == 0);  // must be a power of 2
-  // Iterate over each block and count similar pixels.
+  // Iterate over each block and check whether all its pixels are similar.
   for (j = y_start; j < y_end; j += block_size) {
     uint8_t* carryover_mask_block = carryover_mask_row;
     for (i = x_start; i < x_end; i += block_size) {
-      int cnt = 0;
-      int avg_r = 0, avg_g = 0, avg_b = 0;
-      int x, y;
       const uint32_t* const psrc = src->argb + j * src->argb_stride + i;
       uint32_t* const pdst = dst->argb + j * dst->argb_stride + i;
-      for (y = 0; y < block_size; ++y) {
-        for (x = 0; x < block_size; ++x) {
-          const uint32_t src_pixel = psrc[x + y * src->argb_stride];
-          const int alpha = src_pixel >> 24;
-          if (alpha == 0xff &&
-              PixelsAreSimilar(src_pixel, pdst[x + y * dst->argb_stride],
-                               max_allowed_diff_lossy)) {
-            ++cnt;
-            avg_r += (src_pixel >> 16) & 0xff;
-            avg_g += (src_pixel >> 8) & 0xff;
-            avg_b += (src_pixel >> 0) & 0xff;
-          }
-        }
-      }
+      uint32_t color;
       // If we have a fully similar block, we replace it with an
       // average transparent block. This compresses better in lossy mode.
-      if (cnt == block_size * block_size) {
-        const uint32_t color = (0x00 << 24) | ((avg_r / cnt) << 16) |
-                               ((avg_g / cnt) << 8) | ((avg_b / cnt) << 0);
+      if (WebPAnimIsSimilarBlock8x8(psrc, src->argb_stride, pdst,
+                                    dst->argb_stride, max_allowed_diff_lossy,
+                                    &color)) {
+        int x, y;
         for (y = 0; y < block_size; ++y) {
           for (x = 0; x < block_size; ++x) {
             pdst[x + y * dst->argb_stride] = color;
@@ -821,28 +847,23 @@ static int EncodeFrame(const WebPConfig* const config, WebPPicture* const pic,
   return 1;
 }
 
-// Struct representing a candidate encoded frame including its metadata.
-typedef struct {
-  WebPMemoryWriter mem;  // Encoded bytes.
-  WebPMuxFrameInfo info;
-  FrameRectangle rect;  // Coordinates and dimensions of this candidate.
-  int carries_over;  // True if at least one pixel in rect is carried over from
-                     // the previous frame, meaning at least one pixel was set
-                     // to fully transparent and this frame is blended.
-                     // If this is true, such pixels are marked as 1s in
-                     // WebPAnimEncoder::candidate_carryover_mask.
-  int evaluate;      // True if this candidate should be evaluated.
-} Candidate;
+// Discards the RGB values under the fully transparent pixels, as the lossless
+// encoding of 'pic' does if WebPConfig::exact is false.
+static void ClearTransparentPixels(WebPPicture* const pic) {
+  int x, y;
+  uint32_t* row = pic->argb;
+  assert(pic->use_argb);
+  for (y = 0; y < pic->height; ++y) {
+    for (x = 0; x < pic->width; ++x) {
+      if ((row[x] >> 24) == 0) row[x] = 0;
+    }
+    row += pic->argb_stride;
+  }
+}
 
-// Generates a candidate encoded frame given a picture and metadata.
-static WebPEncodingError EncodeCandidate(WebPPicture* const sub_frame,
-                                         const FrameRectangle* const rect,
-                                         const WebPConfig* const encoder_config,
-                                         int use_blending,
-                                         Candidate* const candidate) {
-  WebPConfig config = *encoder_config;
-  WebPEncodingError error_code = VP8_ENC_OK;
-  assert(candidate != NULL);
+static void CandidateInit(Candidate* const candidate,
+                          const FrameRectangle* const rect, int use_blending,
+                          int carries_over) {
   memset(candidate, 0, sizeof(*candidate));
 
   // Set frame rect and info.
@@ -854,29 +875,132 @@ static WebPEncodingError EncodeCandidate(WebPPicture* const sub_frame,
   candidate->info.blend_method =
       use_blending ? WEBP_MUX_BLEND : WEBP_MUX_NO_BLEND;
   candidate->info.duration = 0;  // Set in next call to WebPAnimEncoderAdd().
-
-  // Encode picture.
+  candidate->carries_over = carries_over;
   WebPMemoryWriterInit(&candidate->mem);
+}
+
+static int EncodeCandidateHook(void* arg1, void* arg2) {
+  CandidateJob* const job = (CandidateJob*)arg1;
+  (void)arg2;
+  if (!EncodeFrame(&job->config, &job->sub_frame, &job->candidate.mem)) {
+    job->error_code = job->sub_frame.error_code;
+  }
+  // Release the copied pixels, or the YUV planes that a lossy encoding added
+  // to the view.
+  WebPPictureFree(&job->sub_frame);
+  return (job->error_code == VP8_ENC_OK);
+}
 
-  if (!config.lossless && use_blending) {
+// Generates a candidate encoded frame given a picture and metadata. If
+// 'carries_over' is true, the candidate keeps 'enc->candidate_carryover_mask'.
+// The encoding may still be running when this function returns.
+static WebPEncodingError EncodeCandidate(WebPAnimEncoder* const enc,
+                                         WebPPicture* const sub_frame,
+                                         const FrameRectangle* const rect,
+                                         const WebPConfig* const encoder_config,
+                                         int use_blending, int carries_over,
+                                         WebPMuxAnimDispose dispose_method,
+                                         int is_key_frame) {
+  const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  CandidateJob* const job = &enc->candidate_jobs[enc->num_candidate_jobs];
+  Candidate* const candidate = &job->candidate;
+  WebPConfig* const config = &job->config;
+  assert(enc->num_candidate_jobs < MAX_CANDIDATE_JOBS);
+  CandidateInit(candidate, rect, use_blending, carries_over);
+
+  *config = *encoder_config;
+  if (!config->lossless && use_blending) {
     // Disable filtering to avoid blockiness in reconstructed frames at the
     // time of decoding.
-    config.autofilter = 0;
-    config.filter_strength = 0;
-  }
-  if (!EncodeFrame(&config, sub_frame, &candidate->mem)) {
-    error_code = sub_frame->error_code;
-    goto Err;
+    config->autofilter = 0;
+    config->filter_strength = 0;
+  }
+  job->dispose_method = dispose_method;
+  job->is_key_frame = is_key_frame;
+  job->error_code = VP8_ENC_OK;
+  job->threaded = 0;
+
+  if (carries_over) {
+    // The next candidates reuse 'enc->candidate_carryover_mask': keep this
+    // one in the job until the best candidate is picked.
+    uint8_t* tmp_carryover_mask;
+    if (job->carryover_mask == NULL) {
+      job->carryover_mask = (uint8_t*)WebPSafeMalloc(
+          enc->canvas_width * (uint64_t)enc->canvas_height,
+          sizeof(*job->carryover_mask));
+      if (job->carryover_mask == NULL) return VP8_ENC_ERROR_OUT_OF_MEMORY;
+    }
+    tmp_carryover_mask = job->carryover_mask;
+    job->carryover_mask = enc->candidate_carryover_mask;
+    enc->candidate_carryover_mask = tmp_carryover_mask;
   }
+  ++enc->num_candidate_jobs;
 
-  candidate->evaluate = 1;
-  return error_code;
+  // Encode picture.
+  if (config->thread_level <= 0) {
+    job->sub_frame = *sub_frame;
+    (void)EncodeCandidateHook(job, NULL);
+    return job->error_code;
+  }
+
+  // The worker encodes a copy, as the next candidates modify the canvas.
+  if (!WebPPictureCopy(sub_frame, &job->sub_frame)) {
+    return VP8_ENC_ERROR_OUT_OF_MEMORY;
+  }
+  if (config->lossless && !config->exact) {
+    // Do to the canvas what the encoding of 'sub_frame' would have done, so
+    // that the next candidates are the same as without threads.
+    ClearTransparentPixels(sub_frame);
+  }
+  // Values of 'thread_level' above 1 limit the number of concurrent encodings.
+  while (config->thread_level > 1 &&
+         enc->num_candidate_jobs - 1 - enc->num_synced_jobs >=
+             config->thread_level) {
+    CandidateJob* const oldest = &enc->candidate_jobs[enc->num_synced_jobs++];
+    (void)worker_interface->Sync(&oldest->worker);
+  }
+  // The concurrent encodings already use up the thread budget: each of them
+  // runs single-threaded. The bitstream does not depend on it.
+  config->thread_level = 0;
+  if (!worker_interface->Reset(&job->worker)) {
+    WebPPictureFree(&job->sub_frame);
+    return VP8_ENC_ERROR_OUT_OF_MEMORY;
+  }
+  job->worker.hook = EncodeCandidateHook;
+  job->worker.data1 = job;
+  job->worker.data2 = NULL;
+  job->threaded = 1;
+  worker_interface->Launch(&job->worker);
+  return VP8_ENC_OK;
+}
 
-Err:
-  WebPMemoryWriterClear(&candidate->mem);
+// Waits for the encoding of the candidates. Returns the first error, if any.
+static WebPEncodingError SyncCandidates(WebPAnimEncoder* const enc) {
+  WebPEncodingError error_code = VP8_ENC_OK;
+  int i;
+  for (i = 0; i < enc->num_candidate_jobs; ++i) {
+    CandidateJob* const job = &enc->candidate_jobs[i];
+    if (job->threaded) {
+      (void)WebPGetWorkerInterface()->Sync(&job->worker);
+      job->threaded = 0;
+    }
+    if (error_code == VP8_ENC_OK) error_code = job->error_code;
+  }
+  enc->num_synced_jobs = enc->num_candidate_jobs;
   return error_code;
 }
 
+// Releases all the candidates, once they are encoded.
+static void ClearCandidates(WebPAnimEncoder* const enc) {
+  int i;
+  (void)SyncCandidates(enc);
+  for (i = 0; i < enc->num_candidate_jobs; ++i) {
+    WebPMemoryWriterClear(&enc->candidate_jobs[i].candidate.mem);
+  }
+  enc->num_candidate_jobs = 0;
+  enc->num_synced_jobs = 0;
+}
+
 static void CopyCurrentCanvas(WebPAnimEncoder* const enc) {
   if (enc->curr_canvas_copy_modified) {
     WebPCopyPixels(enc->curr_canvas, &enc->curr_canvas_copy);
@@ -886,16 +1010,12 @@ static void CopyCurrentCanvas(WebPAnimEncoder* const enc) {
   }
 }
 
-enum {
-  LL_DISP_NONE = 0,
-  LL_DISP_BG,
-  LOSSY_DISP_NONE,
-  LOSSY_DISP_BG,
-  CANDIDATE_COUNT
-};
-
 #define MIN_COLORS_LOSSY 31      // Don't try lossy below this threshold.
 #define MAX_COLORS_LOSSLESS 194  // Don't try lossless above this threshold.
+// With 'minimize_size', bounds of the estimated lossless bits per pixel within
+// which the smaller of the lossless and lossy encodings is hard to predict.
+#define MIN_BPP_LOSSY 0.05       // Don't try lossy below this estimate.
+#define MAX_BPP_LOSSLESS 6.      // Don't try lossless above this estimate.
 
 static void GetEncodedData(const WebPMemoryWriter* const memory,
                            WebPData* const encoded_data) {
@@ -985,32 +1105,145 @@ static void PickBestCandidate(WebPAnimEncoder* const enc,
     // Release the memory of the previous best candidate if any.
     if (*best_candidate != NULL) {
       WebPMemoryWriterClear(&(*best_candidate)->mem);
-      (*best_candidate)->evaluate = 0;
     }
     *best_candidate = candidate;
   } else {
     // Release the memory of the current candidate which is not the best one.
     WebPMemoryWriterClear(&candidate->mem);
-    candidate->evaluate = 0;
+  }
+}
+
+// Picks the best subframe and keyframe candidates among the encoded ones, in
+// the order they were generated so that the result does not depend on the
+// threads. Releases the other candidates.
+static void PickCandidates(WebPAnimEncoder* const enc,
+                           EncodedFrame* const encoded_frame,
+                           FrameRectangle* const best_sub_candidate_rect,
+                           FrameRectangle* const best_key_candidate_rect) {
+  Candidate* best_sub_candidate = NULL;
+  Candidate* best_key_candidate = NULL;
+  int i;
+  for (i = 0; i < enc->num_candidate_jobs; ++i) {
+    CandidateJob* const job = &enc->candidate_jobs[i];
+    assert(!job->threaded && job->error_code == VP8_ENC_OK);
+    if (job->candidate.carries_over) {
+      // Give the mask back, as PickBestCandidate() expects it there.
+      uint8_t* const tmp_carryover_mask = job->carryover_mask;
+      job->carryover_mask = enc->candidate_carryover_mask;
+      enc->candidate_carryover_mask = tmp_carryover_mask;
+    }
+    PickBestCandidate(
+        enc, &job->candidate, job->dispose_method, job->is_key_frame,
+        job->is_key_frame ? &best_key_candidate : &best_sub_candidate,
+        encoded_frame);
+  }
+  if (best_sub_candidate != NULL) {
+    *best_sub_candidate_rect = best_sub_candidate->rect;
+  }
+  if (best_key_candidate != NULL) {
+    *best_key_candidate_rect = best_key_candidate->rect;
+  }
+  enc->num_candidate_jobs = 0;
+  enc->num_synced_jobs = 0;
+}
+
+// Returns the Shannon entropy, in bits, of the 'histo' population.
+static double HistogramBits(const uint32_t* const histo, int size) {
+  double sum_log = 0., total = 0.;
+  int i;
+  for (i = 0; i < size; ++i) {
+    if (histo[i] != 0) {
+      sum_log += histo[i] * log((double)histo[i]);
+      total += histo[i];
+    }
+  }
+  // 1.44... is 1 / log(2).
+  return (total > 0.) ? (total * log(total) - sum_log) * 1.4426950408889634
+                      : 0.;
+}
+
+// Roughly estimates the size in bits per pixel of 'pic' once losslessly
+// compressed. This is a standalone approximation, cheaper than the analysis of
+// the lossless encoder: the pixels repeating their left or top neighbor are
+// considered free, the others cost the entropy of either their left-predicted
+// residuals, color-decorrelated by subtracting green, or their palette index.
+static double EstimateLosslessBpp(const WebPPicture* const pic,
+                                  int num_colors) {
+  uint32_t histo[5][256];  // Alpha, green, red-green, blue-green, palette.
+  const uint32_t* prev_row = NULL;
+  const uint32_t* curr_row = pic->argb;
+  uint32_t pix_prev = pic->argb[0];  // Skip the first pixel.
+  double spatial_bits, bits;
+  int x, y;
+  memset(histo, 0, sizeof(histo));
+  for (y = 0; y < pic->height; ++y) {
+    for (x = 0; x < pic->width; ++x) {
+      const uint32_t pix = curr_row[x];
+      if (pix != pix_prev && (prev_row == NULL || pix != prev_row[x])) {
+        // Per-channel 'pix - pix_prev'.
+        const uint32_t alpha_green =
+            0x00ff00ffu + (pix & 0xff00ff00u) - (pix_prev & 0xff00ff00u);
+        const uint32_t red_blue =
+            0xff00ff00u + (pix & 0x00ff00ffu) - (pix_prev & 0x00ff00ffu);
+        const uint32_t diff =
+            (alpha_green & 0xff00ff00u) | (red_blue & 0x00ff00ffu);
+        const uint32_t green = (diff >> 8) & 0xff;
+        ++histo[0][diff >> 24];
+        ++histo[1][green];
+        ++histo[2][((diff >> 16) - green) & 0xff];
+        ++histo[3][(diff - green) & 0xff];
+        // Approximate the palette by the entropy of a multiplicative hash.
+        ++histo[4][((((uint64_t)pix + (pix >> 19)) * 0x39c5fba7ull) &
+                    0xffffffffu) >> 24];
+      }
+      pix_prev = pix;
+    }
+    prev_row = curr_row;
+    curr_row += pic->argb_stride;
+  }
+  spatial_bits = HistogramBits(histo[0], 256) + HistogramBits(histo[1], 256) +
+                 HistogramBits(histo[2], 256) + HistogramBits(histo[3], 256);
+  bits = spatial_bits;
+  if (num_colors <= MAX_PALETTE_SIZE) {
+    // A compressed palette entry costs about 8 bits.
+    const double palette_bits = HistogramBits(histo[4], 256) + num_colors * 8.;
+    if (palette_bits < bits) bits = palette_bits;
+  }
+  return bits / ((double)pic->width * pic->height);
+}
+
+// Picks the candidates to be tried for 'sub_frame_ll'.
+static void ChooseCompressions(const WebPAnimEncoderOptions* const options,
+                               const WebPPicture* const sub_frame_ll,
+                               int is_lossless, int* const evaluate_ll,
+                               int* const evaluate_lossy) {
+  if (!options->allow_mixed) {
+    *evaluate_ll = is_lossless;
+    *evaluate_lossy = !is_lossless;
+  } else if (options->minimize_size) {
+    // Only skip the encodings that are very unlikely to be the smallest:
+    // lossless is hopeless on noisy or photographic content and lossy on flat
+    // or repetitive content.
+    const int num_colors = WebPGetColorPalette(sub_frame_ll, NULL);
+    const double bpp = EstimateLosslessBpp(sub_frame_ll, num_colors);
+    *evaluate_ll = (bpp < MAX_BPP_LOSSLESS);
+    *evaluate_lossy = (bpp >= MIN_BPP_LOSSY);
+  } else {  // Use a heuristic for trying lossless and/or lossy compression.
+    const int num_colors = WebPGetColorPalette(sub_frame_ll, NULL);
+    *evaluate_ll = (num_colors < MAX_COLORS_LOSSLESS);
+    *evaluate_lossy = (num_colors >= MIN_COLORS_LOSSY);
   }
 }
 
 // Generates candidates for a given dispose method given pre-filled subframe
 // 'params'.
 static WebPEncodingError GenerateCandidates(
-    WebPAnimEncoder* const enc, Candidate candidates[CANDIDATE_COUNT],
-    WebPMuxAnimDispose dispose_method,
+    WebPAnimEncoder* const enc, WebPMuxAnimDispose dispose_method,
     const WebPPicture* const canvas_carryover_disposed, int is_lossless,
     int is_key_frame, SubFrameParams* const params,
-    const WebPConfig* const config_ll, const WebPConfig* const config_lossy,
-    Candidate** const best_candidate, EncodedFrame* const encoded_frame) {
+    const WebPConfig* const config_ll, const WebPConfig* const config_lossy) {
   WebPEncodingError error_code = VP8_ENC_OK;
   const int is_dispose_none = (dispose_method == WEBP_MUX_DISPOSE_NONE);
-  Candidate* const candidate_ll =
-      is_dispose_none ? &candidates[LL_DISP_NONE] : &candidates[LL_DISP_BG];
-  Candidate* const candidate_lossy = is_dispose_none
-                                         ? &candidates[LOSSY_DISP_NONE]
-                                         : &candidates[LOSSY_DISP_BG];
   WebPPicture* const curr_canvas = &enc->curr_canvas_copy;
   const WebPPicture* const canvas_carryover =
       is_dispose_none ? &enc->canvas_carryover : canvas_carryover_disposed;
@@ -1026,18 +1259,8 @@ static WebPEncodingError GenerateCandidates(
       IsLossyBlendingPossible(canvas_carryover, curr_canvas,
                               &params->rect_lossy, config_lossy->quality);
 
-  // Pick candidates to be tried.
-  if (!enc->options.allow_mixed) {
-    evaluate_ll = is_lossless;
-    evaluate_lossy = !is_lossless;
-  } else if (enc->options.minimize_size) {
-    evaluate_ll = 1;
-    evaluate_lossy = 1;
-  } else {  // Use a heuristic for trying lossless and/or lossy compression.
-    const int num_colors = WebPGetColorPalette(&params->sub_frame_ll, NULL);
-    evaluate_ll = (num_colors < MAX_COLORS_LOSSLESS);
-    evaluate_lossy = (num_colors >= MIN_COLORS_LOSSY);
-  }
+  ChooseCompressions(&enc->options, &params->sub_frame_ll, is_lossless,
+                     &evaluate_ll, &evaluate_lossy);
 
   // Generate candidates.
   if (evaluate_ll) {
@@ -1051,12 +1274,11 @@ static WebPEncodingError GenerateCandidates(
           IncreaseTransparency(canvas_carryover, &params->rect_ll, curr_canvas,
                                enc->candidate_carryover_mask);
     }
-    error_code = EncodeCandidate(&params->sub_frame_ll, &params->rect_ll,
-                                 config_ll, use_blending_ll, candidate_ll);
+    error_code = EncodeCandidate(
+        enc, &params->sub_frame_ll, &params->rect_ll, config_ll,
+        use_blending_ll, enc->curr_canvas_copy_modified, dispose_method,
+        is_key_frame);
     if (error_code != VP8_ENC_OK) return error_code;
-    candidate_ll->carries_over = enc->curr_canvas_copy_modified;
-    PickBestCandidate(enc, candidate_ll, dispose_method, is_key_frame,
-                      best_candidate, encoded_frame);
   }
   if (evaluate_lossy) {
     CopyCurrentCanvas(enc);
@@ -1069,20 +1291,20 @@ static WebPEncodingError GenerateCandidates(
           canvas_carryover, &params->rect_lossy, curr_canvas,
           config_lossy->quality, enc->candidate_carryover_mask);
     }
-    error_code =
-        EncodeCandidate(&params->sub_frame_lossy, &params->rect_lossy,
-                        config_lossy, use_blending_lossy, candidate_lossy);
+    error_code = EncodeCandidate(
+        enc, &params->sub_frame_lossy, &params->rect_lossy, config_lossy,
+        use_blending_lossy, enc->curr_canvas_copy_modified, dispose_method,
+        is_key_frame);
     if (error_code != VP8_ENC_OK) return error_code;
-    candidate_lossy->carries_over = enc->curr_canvas_copy_modified;
     enc->curr_canvas_copy_modified = 1;
-    PickBestCandidate(enc, candidate_lossy, dispose_method, is_key_frame,
-                      best_candidate, encoded_frame);
   }
   return error_code;
 }
 
 #undef MIN_COLORS_LOSSY
 #undef MAX_COLORS_LOSSLESS
+#undef MIN_BPP_LOSSY
+#undef MAX_BPP_LOSSLESS
 
 static int IncreasePreviousDuration(WebPAnimEncoder* const enc, int duration) {
   const size_t position = enc->count - 1;
@@ -1192,23 +1414,17 @@ static void CopyMaskedPixels(const WebPPicture* const src,
 
 // Depending on the configuration, tries different compressions
 // (lossy/lossless), dispose methods, blending methods etc to encode the current
-// frame and outputs the best one in 'encoded_frame'.
+// frame. PickCandidates() then outputs the best one in an EncodedFrame.
 // 'frame_skipped' will be set to true if this frame should actually be skipped.
 static WebPEncodingError SetFrame(WebPAnimEncoder* const enc,
                                   const WebPConfig* const config,
-                                  int is_key_frame,
-                                  FrameRectangle* const best_candidate_rect,
-                                  EncodedFrame* const encoded_frame,
-                                  int* const frame_skipped) {
-  int i;
+                                  int is_key_frame, int* const frame_skipped) {
   WebPEncodingError error_code = VP8_ENC_OK;
   const WebPPicture* const curr_canvas = &enc->curr_canvas_copy;
   const WebPPicture* const canvas_carryover = &enc->canvas_carryover;
   // canvas_carryover with the area corresponding to the previous frame disposed
   // to background color.
   WebPPicture* canvas_carryover_disposed = NULL;
-  Candidate candidates[CANDIDATE_COUNT];
-  Candidate* best_candidate = NULL;
   const int is_lossless = config->lossless;
   const int consider_lossless = is_lossless || enc->options.allow_mixed;
   const int consider_lossy = !is_lossless || enc->options.allow_mixed;
@@ -1249,13 +1465,11 @@ static WebPEncodingError SetFrame(WebPAnimEncoder* const enc,
     return VP8_ENC_ERROR_INVALID_CONFIGURATION;
   }
 
-  memset(candidates, 0, sizeof(candidates));
-
   // Change-rectangle assuming previous frame was DISPOSE_NONE.
   if (!GetSubRects(canvas_carryover, curr_canvas, is_key_frame, is_first_frame,
                    config_lossy.quality, &dispose_none_params)) {
     error_code = VP8_ENC_ERROR_INVALID_CONFIGURATION;
-    goto Err;
+    goto End;
   }
 
   if ((consider_lossless && IsEmptyRect(&dispose_none_params.rect_ll)) ||
@@ -1281,7 +1495,7 @@ static WebPEncodingError SetFrame(WebPAnimEncoder* const enc,
                      is_first_frame, config_lossy.quality,
                      &dispose_bg_params)) {
       error_code = VP8_ENC_ERROR_INVALID_CONFIGURATION;
-      goto Err;
+      goto End;
     }
     assert(!IsEmptyRect(&dispose_bg_params.rect_ll));
     assert(!IsEmptyRect(&dispose_bg_params.rect_lossy));
@@ -1300,38 +1514,120 @@ static WebPEncodingError SetFrame(WebPAnimEncoder* const enc,
   }
 
   if (dispose_none_params.should_try) {
-    error_code =
-        GenerateCandidates(enc, candidates, WEBP_MUX_DISPOSE_NONE,
-                           /*canvas_carryover_disposed=*/NULL, is_lossless,
-                           is_key_frame, &dispose_none_params, &config_ll,
-                           &config_lossy, &best_candidate, encoded_frame);
-    if (error_code != VP8_ENC_OK) goto Err;
+    error_code = GenerateCandidates(
+        enc, WEBP_MUX_DISPOSE_NONE, /*canvas_carryover_disposed=*/NULL,
+        is_lossless, is_key_frame, &dispose_none_params, &config_ll,
+        &config_lossy);
+    if (error_code != VP8_ENC_OK) goto End;
   }
 
   if (dispose_bg_params.should_try) {
     assert(!enc->is_first_frame);
     assert(dispose_bg_possible);
     error_code = GenerateCandidates(
-        enc, candidates, WEBP_MUX_DISPOSE_BACKGROUND, canvas_carryover_disposed,
+        enc, WEBP_MUX_DISPOSE_BACKGROUND, canvas_carryover_disposed,
         is_lossless, is_key_frame, &dispose_bg_params, &config_ll,
-        &config_lossy, &best_candidate, encoded_frame);
-    if (error_code != VP8_ENC_OK) goto Err;
+        &config_lossy);
   }
 
-  assert(best_candidate != NULL);
-  *best_candidate_rect = best_candidate->rect;
-  goto End;
+End:
+  SubFrameParamsFree(&dispose_none_params);
+  SubFrameParamsFree(&dispose_bg_params);
+  return error_code;
+}
 
-Err:
-  for (i = 0; i < CANDIDATE_COUNT; ++i) {
-    if (candidates[i].evaluate) {
-      WebPMemoryWriterClear(&candidates[i].mem);
+// Encodes the keyframe candidates of a queued frame as SetFrame() would,
+// lossless first as its encoding may clear the RGB of transparent pixels.
+static int EncodeKeyFrameHook(void* arg1, void* arg2) {
+  QueuedFrame* const queued = (QueuedFrame*)arg1;
+  const WebPAnimEncoderOptions* const options =
+      (const WebPAnimEncoderOptions*)arg2;
+  const FrameRectangle rect = {0, 0, queued->key_frame.width,
+                               queued->key_frame.height};
+  int evaluate[2];  // Lossless, lossy.
+  int i;
+  ChooseCompressions(options, &queued->key_frame, queued->config.lossless,
+                     &evaluate[0], &evaluate[1]);
+  for (i = 0; i < 2 && queued->error_code == VP8_ENC_OK; ++i) {
+    Candidate* const candidate =
+        &queued->key_candidates[queued->num_key_candidates];
+    WebPConfig config = queued->config;
+    WebPPicture view;
+    if (!evaluate[i]) continue;
+    config.lossless = (i == 0);
+    // Runs alongside the candidates of the current frame and the keyframes of
+    // the other queued frames, which already use up the thread budget.
+    config.thread_level = 0;
+    CandidateInit(candidate, &rect, /*use_blending=*/0, /*carries_over=*/0);
+    ++queued->num_key_candidates;
+    if (!WebPPictureView(&queued->key_frame, 0, 0, rect.width, rect.height,
+                         &view)) {
+      queued->error_code = VP8_ENC_ERROR_INVALID_CONFIGURATION;
+    } else if (!EncodeFrame(&config, &view, &candidate->mem)) {
+      queued->error_code = view.error_code;
     }
+    WebPPictureFree(&view);
   }
+  WebPPictureFree(&queued->key_frame);
+  return (queued->error_code == VP8_ENC_OK);
+}
 
-End:
-  SubFrameParamsFree(&dispose_none_params);
-  SubFrameParamsFree(&dispose_bg_params);
+// Starts the encoding of the keyframe candidates of 'queued'.
+static int LaunchKeyFrame(WebPAnimEncoder* const enc,
+                          QueuedFrame* const queued) {
+  const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  assert(!queued->key_frame_launched && queued->num_key_candidates == 0);
+  if (!WebPPictureCopy(&queued->frame, &queued->key_frame)) return 0;
+  if (!worker_interface->Reset(&queued->worker)) {
+    WebPPictureFree(&queued->key_frame);
+    return 0;
+  }
+  queued->error_code = VP8_ENC_OK;
+  queued->worker.hook = EncodeKeyFrameHook;
+  queued->worker.data1 = queued;
+  queued->worker.data2 = (void*)&enc->options;
+  queued->key_frame_launched = 1;
+  worker_interface->Launch(&queued->worker);
+  return 1;
+}
+
+// Waits for the keyframe candidates of 'queued' and releases them.
+static void ClearKeyFrame(QueuedFrame* const queued) {
+  int i;
+  if (queued->key_frame_launched) {
+    (void)WebPGetWorkerInterface()->Sync(&queued->worker);
+    queued->key_frame_launched = 0;
+  }
+  for (i = 0; i < queued->num_key_candidates; ++i) {
+    WebPMemoryWriterClear(&queued->key_candidates[i].mem);
+  }
+  queued->num_key_candidates = 0;
+}
+
+// Adds the keyframe candidates encoded ahead of time for the current frame to
+// the candidate jobs, where SetFrame() would have generated them.
+static WebPEncodingError TakeKeyFrameCandidates(WebPAnimEncoder* const enc,
+                                                QueuedFrame* const queued) {
+  WebPEncodingError error_code;
+  int i;
+  assert(queued->key_frame_launched);
+  (void)WebPGetWorkerInterface()->Sync(&queued->worker);
+  queued->key_frame_launched = 0;
+  error_code = queued->error_code;
+  if (error_code == VP8_ENC_OK) {
+    for (i = 0; i < queued->num_key_candidates; ++i) {
+      CandidateJob* const job = &enc->candidate_jobs[enc->num_candidate_jobs];
+      assert(enc->num_candidate_jobs < MAX_CANDIDATE_JOBS);
+      job->candidate = queued->key_candidates[i];
+      job->dispose_method = WEBP_MUX_DISPOSE_NONE;
+      job->is_key_frame = 1;
+      job->error_code = VP8_ENC_OK;
+      job->threaded = 0;
+      ++enc->num_candidate_jobs;
+    }
+    queued->num_key_candidates = 0;
+  }
+  ClearKeyFrame(queued);
   return error_code;
 }
 
@@ -1355,10 +1651,13 @@ static int CacheFrame(WebPAnimEncoder* const enc,
   ++enc->count;
 
   if (enc->is_first_frame) {  // Add this as a keyframe.
-    error_code = SetFrame(enc, config, 1, &best_key_candidate_rect,
-                          encoded_frame, &frame_skipped);
+    error_code = SetFrame(enc, config, 1, &frame_skipped);
     if (error_code != VP8_ENC_OK) goto End;
     assert(frame_skipped == 0);  // First frame can't be skipped, even if empty.
+    error_code = SyncCandidates(enc);
+    if (error_code != VP8_ENC_OK) goto End;
+    PickCandidates(enc, encoded_frame, &best_sub_candidate_rect,
+                   &best_key_candidate_rect);
     assert(position == 0 && enc->count == 1);
     encoded_frame->is_key_frame = 1;
     enc->flush_count = 0;
@@ -1380,10 +1679,13 @@ static int CacheFrame(WebPAnimEncoder* const enc,
 
     if (enc->count_since_key_frame <= enc->options.kmin) {
       // Add this as a frame rectangle.
-      error_code = SetFrame(enc, config, 0, &best_sub_candidate_rect,
-                            encoded_frame, &frame_skipped);
+      error_code = SetFrame(enc, config, 0, &frame_skipped);
       if (error_code != VP8_ENC_OK) goto End;
       if (frame_skipped) goto Skip;
+      error_code = SyncCandidates(enc);
+      if (error_code != VP8_ENC_OK) goto End;
+      PickCandidates(enc, encoded_frame, &best_sub_candidate_rect,
+                     &best_key_candidate_rect);
       encoded_frame->is_key_frame = 0;
       enc->flush_count = enc->count - 1;
       candidate_undecided = 0;
@@ -1395,16 +1697,27 @@ static int CacheFrame(WebPAnimEncoder* const enc,
       //       only when enc->count_since_key_frame < enc->options.kmax ||
       //       enc->best_delta < DELTA_INFINITY).
       //       frame_skipped should still be tested to keep exact same behavior.
-      error_code = SetFrame(enc, config, 0, &best_sub_candidate_rect,
-                            encoded_frame, &frame_skipped);
+      error_code = SetFrame(enc, config, 0, &frame_skipped);
       if (error_code != VP8_ENC_OK) goto End;
       if (frame_skipped) goto Skip;
 
-      // Add this as a keyframe to enc, too.
-      error_code = SetFrame(enc, config, 1, &best_key_candidate_rect,
-                            encoded_frame, &frame_skipped);
+      // Add this as a keyframe to enc, too. Its candidates are encoded at the
+      // same time as the subframe ones, or were encoded ahead of time. Either
+      // way they start from the input frame, whatever the subframe ones did
+      // to 'curr_canvas_copy'.
+      enc->curr_canvas_copy_modified = 1;
+      if (enc->curr_queued != NULL && enc->curr_queued->key_frame_launched) {
+        error_code = TakeKeyFrameCandidates(enc, enc->curr_queued);
+        if (error_code != VP8_ENC_OK) goto End;
+      } else {
+        error_code = SetFrame(enc, config, 1, &frame_skipped);
+        if (error_code != VP8_ENC_OK) goto End;
+        assert(frame_skipped == 0);  // keyframe cannot be an empty rectangle.
+      }
+      error_code = SyncCandidates(enc);
       if (error_code != VP8_ENC_OK) goto End;
-      assert(frame_skipped == 0);  // keyframe cannot be an empty rectangle.
+      PickCandidates(enc, encoded_frame, &best_sub_candidate_rect,
+                     &best_key_candidate_rect);
 
       // Analyze size difference of the two variants.
       curr_delta = KeyFramePenalty(encoded_frame);
@@ -1505,6 +1818,7 @@ Skip:
 
 End:
   if (!ok || frame_skipped) {
+    ClearCandidates(enc);
     FrameRelease(encoded_frame);
     // We reset some counters, as the frame addition failed/was skipped.
     --enc->count;
@@ -1518,6 +1832,144 @@ End:
   return ok;
 }
 
+// Streaming header: RIFF header and VP8X chunk.
+#define STREAM_HEADER_SIZE \
+  (RIFF_HEADER_SIZE + CHUNK_HEADER_SIZE + VP8X_CHUNK_SIZE)
+
+// Writes 'size' bytes of 'data' to the streaming writer.
+static int StreamWrite(WebPAnimEncoder* const enc, const uint8_t* const data,
+                       size_t size) {
+  if (!enc->stream.writer(data, size, &enc->stream)) {
+    MarkError(enc, "ERROR writing the animation");
+    return 0;
+  }
+  enc->stream_size += size;
+  return 1;
+}
+
+// Fills the STREAM_HEADER_SIZE first bytes of the output, as
+// WebPMuxAssemble() would for a bitstream of 'size' bytes.
+static void GetStreamHeader(const WebPAnimEncoder* const enc, size_t size,
+                            uint8_t* const data) {
+  const WebPMux* const mux = enc->mux;
+  uint32_t flags = ANIMATION_FLAG;
+  uint8_t* const vp8x = MuxEmitRiffHeader(data, size);
+  if (mux->iccp != NULL && mux->iccp->data.bytes != NULL) {
+    flags |= ICCP_FLAG;
+  }
+  if (mux->exif != NULL && mux->exif->data.bytes != NULL) {
+    flags |= EXIF_FLAG;
+  }
+  if (mux->xmp != NULL && mux->xmp->data.bytes != NULL) {
+    flags |= XMP_FLAG;
+  }
+  if (enc->stream_has_alpha) flags |= ALPHA_FLAG;
+  PutLE32(vp8x + 0, MKFOURCC('V', 'P', '8', 'X'));
+  PutLE32(vp8x + TAG_SIZE, VP8X_CHUNK_SIZE);
+  PutLE32(vp8x + CHUNK_HEADER_SIZE + 0, flags);
+  PutLE24(vp8x + CHUNK_HEADER_SIZE + 4, enc->canvas_width - 1);
+  PutLE24(vp8x + CHUNK_HEADER_SIZE + 7, enc->canvas_height - 1);
+}
+
+// Writes the chunks preceding the frames. The RIFF size and the VP8X flags
+// are placeholders until WebPAnimEncoderAssemble().
+static int StartStream(WebPAnimEncoder* const enc) {
+  WebPMux* const mux = enc->mux;
+  size_t size;
+  uint8_t* data;
+  uint8_t* dst;
+  int ok;
+  WebPMuxError err =
+      WebPMuxSetCanvasSize(mux, enc->canvas_width, enc->canvas_height);
+  if (err == WEBP_MUX_OK) {
+    err = WebPMuxSetAnimationParams(mux, &enc->options.anim_params);
+  }
+  if (err != WEBP_MUX_OK) {
+    MarkError2(enc, "ERROR writing the animation. WebPMuxError", err);
+    return 0;
+  }
+  size = STREAM_HEADER_SIZE + ChunkListDiskSize(mux->iccp) +
+         ChunkListDiskSize(mux->anim);
+  data = (uint8_t*)WebPSafeMalloc(1ULL, size);
+  if (data == NULL) {
+    MarkError(enc, "ERROR writing the animation: out of memory");
+    return 0;
+  }
+  GetStreamHeader(enc, size, data);
+  dst = ChunkListEmit(mux->iccp, data + STREAM_HEADER_SIZE);
+  dst = ChunkListEmit(mux->anim, dst);
+  assert(dst == data + size);
+  ok = StreamWrite(enc, data, size);
+  WebPSafeFree(data);
+  enc->stream_started = ok;
+  return ok;
+}
+
+// Writes the frames pushed to the muxer, and removes them from it.
+static int StreamFrames(WebPAnimEncoder* const enc) {
+  WebPMux* const mux = enc->mux;
+  if (mux->images != NULL && !enc->stream_started && !StartStream(enc)) {
+    return 0;
+  }
+  while (mux->images != NULL) {
+    WebPMuxImage* const image = mux->images;
+    const size_t size = MuxImageDiskSize(image);
+    uint8_t* const data = (uint8_t*)WebPSafeMalloc(1ULL, size);
+    int ok;
+    if (data == NULL) {
+      MarkError(enc, "ERROR writing the animation: out of memory");
+      return 0;
+    }
+    (void)MuxImageEmit(image, data);
+    ok = StreamWrite(enc, data, size);
+    WebPSafeFree(data);
+    if (!ok) return 0;
+    if (image->has_alpha || image->alpha != NULL) enc->stream_has_alpha = 1;
+    mux->images = MuxImageDelete(image);
+  }
+  return 1;
+}
+
+// Writes the chunks following the frames, and returns the final header in
+// 'webp_data'.
+static int FinishStream(WebPAnimEncoder* const enc, WebPData* const webp_data) {
+  WebPMux* const mux = enc->mux;
+  const size_t size = ChunkListDiskSize(mux->exif) +
+                      ChunkListDiskSize(mux->xmp) +
+                      ChunkListDiskSize(mux->unknown);
+  uint8_t* header;
+  assert(enc->stream_started);
+  if (size > 0) {
+    uint8_t* const data = (uint8_t*)WebPSafeMalloc(1ULL, size);
+    uint8_t* dst;
+    int ok;
+    if (data == NULL) {
+      MarkError(enc, "ERROR writing the animation: out of memory");
+      return 0;
+    }
+    dst = ChunkListEmit(mux->exif, data);
+    dst = ChunkListEmit(mux->xmp, dst);
+    dst = ChunkListEmit(mux->unknown, dst);
+    assert(dst == data + size);
+    ok = StreamWrite(enc, data, size);
+    WebPSafeFree(data);
+    if (!ok) return 0;
+  }
+  if (enc->stream_size - CHUNK_HEADER_SIZE > MAX_CHUNK_PAYLOAD) {
+    MarkError(enc, "ERROR writing the animation: too large");
+    return 0;
+  }
+  header = (uint8_t*)WebPSafeMalloc(1ULL, STREAM_HEADER_SIZE);
+  if (header == NULL) {
+    MarkError(enc, "ERROR writing the animation: out of memory");
+    return 0;
+  }
+  GetStreamHeader(enc, (size_t)enc->stream_size, header);
+  webp_data->bytes = header;
+  webp_data->size = STREAM_HEADER_SIZE;
+  return 1;
+}
+
 static int FlushFrames(WebPAnimEncoder* const enc) {
   while (enc->flush_count > 0) {
     WebPMuxError err;
@@ -1552,52 +2004,32 @@ static int FlushFrames(WebPAnimEncoder* const enc) {
     FrameRelease(&enc->encoded_frames[enc_start_tmp]);
     enc->start = 0;
   }
+  if (enc->stream.writer != NULL) return StreamFrames(enc);
   return 1;
 }
 
+#undef STREAM_HEADER_SIZE
 #undef DELTA_INFINITY
 #undef KEYFRAME_NONE
 
-int WebPAnimEncoderAdd(WebPAnimEncoder* enc, WebPPicture* frame, int timestamp,
-                       const WebPConfig* encoder_config) {
-  WebPConfig config;
-  int ok;
-
-  if (enc == NULL) {
-    return 0;
-  }
-  MarkNoError(enc);
-
-  if (!enc->is_first_frame) {
-    // Make sure timestamps are non-decreasing (integer wrap-around is OK).
-    const uint32_t prev_frame_duration =
-        (uint32_t)timestamp - enc->prev_timestamp;
-    if (prev_frame_duration >= MAX_DURATION) {
-      if (frame != NULL) {
-        frame->error_code = VP8_ENC_ERROR_INVALID_CONFIGURATION;
-      }
-      MarkError(enc, "ERROR adding frame: timestamps must be non-decreasing");
-      return 0;
+// Makes sure timestamps are non-decreasing (integer wrap-around is OK).
+static int CheckTimestamp(WebPAnimEncoder* const enc, WebPPicture* const frame,
+                          int prev_timestamp, int timestamp) {
+  const uint32_t prev_frame_duration = (uint32_t)timestamp - prev_timestamp;
+  if (prev_frame_duration >= MAX_DURATION) {
+    if (frame != NULL) {
+      frame->error_code = VP8_ENC_ERROR_INVALID_CONFIGURATION;
     }
-    if (!IncreasePreviousDuration(enc, (int)prev_frame_duration)) {
-      return 0;
-    }
-    // IncreasePreviousDuration() may add a frame to avoid exceeding
-    // MAX_DURATION which could cause CacheFrame() to over read 'encoded_frames'
-    // before the next flush.
-    if (enc->count == enc->size && !FlushFrames(enc)) {
-      return 0;
-    }
-  } else {
-    enc->first_timestamp = timestamp;
-  }
-
-  if (frame == NULL) {  // Special: last call.
-    enc->got_null_frame = 1;
-    enc->prev_timestamp = timestamp;
-    return 1;
+    MarkError(enc, "ERROR adding frame: timestamps must be non-decreasing");
+    return 0;
   }
+  return 1;
+}
 
+// Checks 'frame', converts it to ARGB if needed, and fills 'config'.
+static int PrepareFrame(WebPAnimEncoder* const enc, WebPPicture* const frame,
+                        const WebPConfig* const encoder_config,
+                        WebPConfig* const config) {
   if (frame->width != enc->canvas_width ||
       frame->height != enc->canvas_height) {
     frame->error_code = VP8_ENC_ERROR_INVALID_CONFIGURATION;
@@ -1622,14 +2054,48 @@ int WebPAnimEncoderAdd(WebPAnimEncoder* enc, WebPPicture* frame, int timestamp,
       MarkError(enc, "ERROR adding frame: Invalid WebPConfig");
       return 0;
     }
-    config = *encoder_config;
+    *config = *encoder_config;
   } else {
-    if (!WebPConfigInit(&config)) {
+    if (!WebPConfigInit(config)) {
       MarkError(enc, "Cannot Init config");
       return 0;
     }
-    config.lossless = 1;
+    config->lossless = 1;
+  }
+  return 1;
+}
+
+static int AddFrame(WebPAnimEncoder* const enc, WebPPicture* const frame,
+                    int timestamp, const WebPConfig* const encoder_config) {
+  WebPConfig config;
+  int ok;
+
+  if (!enc->is_first_frame) {
+    const uint32_t prev_frame_duration =
+        (uint32_t)timestamp - enc->prev_timestamp;
+    if (!CheckTimestamp(enc, frame, enc->prev_timestamp, timestamp)) {
+      return 0;
+    }
+    if (!IncreasePreviousDuration(enc, (int)prev_frame_duration)) {
+      return 0;
+    }
+    // IncreasePreviousDuration() may add a frame to avoid exceeding
+    // MAX_DURATION which could cause CacheFrame() to over read 'encoded_frames'
+    // before the next flush.
+    if (enc->count == enc->size && !FlushFrames(enc)) {
+      return 0;
+    }
+  } else {
+    enc->first_timestamp = timestamp;
   }
+
+  if (frame == NULL) {  // Special: last call.
+    enc->got_null_frame = 1;
+    enc->prev_timestamp = timestamp;
+    return 1;
+  }
+
+  if (!PrepareFrame(enc, frame, encoder_config, &config)) return 0;
   assert(enc->curr_canvas == NULL);
   enc->curr_canvas = frame;  // Store reference.
   assert(enc->curr_canvas_copy_modified == 1);
@@ -1645,6 +2111,119 @@ int WebPAnimEncoderAdd(WebPAnimEncoder* enc, WebPPicture* frame, int timestamp,
   return ok;
 }
 
+// Returns true if the frame queued at 'index' will be tried as a keyframe,
+// provided no frame before it is skipped. Follows CacheFrame().
+static int IsKeyFrameCandidate(const WebPAnimEncoder* const enc, int index) {
+  int count_since_key_frame = enc->count_since_key_frame;
+  int is_first_frame = enc->is_first_frame;
+  int is_candidate = 0;
+  int i;
+  for (i = 0; i <= index; ++i) {
+    is_candidate = 0;
+    if (is_first_frame) {  // Not tried as a subframe: nothing to overlap.
+      is_first_frame = 0;
+    } else if (++count_since_key_frame > enc->options.kmin) {
+      is_candidate = 1;
+      if (count_since_key_frame >= enc->options.kmax) {
+        count_since_key_frame = 0;
+      }
+    }
+  }
+  return is_candidate;
+}
+
+// Encodes the oldest queued frame. Its error code is reported in 'frame', if
+// not NULL.
+static int EncodeQueuedFrame(WebPAnimEncoder* const enc,
+                             WebPPicture* const frame) {
+  QueuedFrame* const queued = &enc->queue[enc->queue_start];
+  int ok;
+  assert(enc->num_queued > 0);
+  enc->queue_start = (enc->queue_start + 1) % enc->options.lookahead;
+  --enc->num_queued;
+  // 'prev_timestamp' is still the one of the frame before.
+  enc->curr_queued = queued;
+  ok = AddFrame(enc, &queued->frame, queued->timestamp, &queued->config);
+  enc->curr_queued = NULL;
+  ClearKeyFrame(queued);  // Not used if the frame was a subframe.
+  if (!ok && frame != NULL) frame->error_code = queued->frame.error_code;
+  return ok;
+}
+
+static int EncodeAllQueuedFrames(WebPAnimEncoder* const enc) {
+  while (enc->num_queued > 0) {
+    if (!EncodeQueuedFrame(enc, NULL)) return 0;
+  }
+  return 1;
+}
+
+// Copies 'frame' to the queue, encoding the oldest queued frame first if there
+// is no room left.
+static int QueueFrame(WebPAnimEncoder* const enc, WebPPicture* const frame,
+                      int timestamp, const WebPConfig* const encoder_config) {
+  const int lookahead = enc->options.lookahead;
+  QueuedFrame* queued;
+  int index;
+
+  if (enc->num_queued > 0) {
+    const int last = (enc->queue_start + enc->num_queued - 1) % lookahead;
+    if (!CheckTimestamp(enc, frame, enc->queue[last].timestamp, timestamp)) {
+      return 0;
+    }
+  } else if (!enc->is_first_frame) {
+    if (!CheckTimestamp(enc, frame, enc->prev_timestamp, timestamp)) {
+      return 0;
+    }
+  }
+
+  if (frame == NULL) {  // Special: last call.
+    return EncodeAllQueuedFrames(enc) && AddFrame(enc, NULL, timestamp, NULL);
+  }
+
+  if (enc->num_queued == lookahead && !EncodeQueuedFrame(enc, frame)) {
+    return 0;
+  }
+  index = enc->num_queued;
+  queued = &enc->queue[(enc->queue_start + index) % lookahead];
+  if (!PrepareFrame(enc, frame, encoder_config, &queued->config)) return 0;
+
+  if (queued->frame.argb == NULL) {
+    queued->frame.width = enc->canvas_width;
+    queued->frame.height = enc->canvas_height;
+    queued->frame.use_argb = 1;
+    if (!WebPPictureAlloc(&queued->frame)) {
+      frame->error_code = VP8_ENC_ERROR_OUT_OF_MEMORY;
+      MarkError(enc, "ERROR adding frame: out of memory");
+      return 0;
+    }
+  }
+  WebPCopyPixels(frame, &queued->frame);
+  queued->frame.progress_hook = frame->progress_hook;
+  queued->frame.user_data = frame->user_data;
+  queued->frame.error_code = VP8_ENC_OK;
+  queued->timestamp = timestamp;
+  ++enc->num_queued;
+
+  if (queued->config.thread_level > 0 && IsKeyFrameCandidate(enc, index)) {
+    // Not fatal: the keyframe candidates are then encoded in turn.
+    (void)LaunchKeyFrame(enc, queued);
+  }
+  return 1;
+}
+
+int WebPAnimEncoderAdd(WebPAnimEncoder* enc, WebPPicture* frame, int timestamp,
+                       const WebPConfig* encoder_config) {
+  if (enc == NULL) {
+    return 0;
+  }
+  MarkNoError(enc);
+
+  if (enc->options.lookahead > 0) {
+    return QueueFrame(enc, frame, timestamp, encoder_config);
+  }
+  return AddFrame(enc, frame, timestamp, encoder_config);
+}
+
 // -----------------------------------------------------------------------------
 // Bitstream assembly.
 
@@ -1765,6 +2344,10 @@ int WebPAnimEncoderAssemble(WebPAnimEncoder* enc, WebPData* webp_data) {
     return 0;
   }
 
+  if (!EncodeAllQueuedFrames(enc)) {
+    return 0;
+  }
+
   if (enc->in_frame_count == 0) {
     MarkError(enc, "ERROR: No frames to assemble");
     return 0;
@@ -1786,6 +2369,10 @@ int WebPAnimEncoderAssemble(WebPAnimEncoder* enc, WebPData* webp_data) {
     return 0;
   }
 
+  if (enc->stream.writer != NULL) {
+    return FinishStream(enc, webp_data);
+  }
+
   // Set definitive canvas size.
   mux = enc->mux;
   err = WebPMuxSetCanvasSize(mux, enc->canvas_width, enc->canvas_height);
@@ -1809,6 +2396,19 @@ Err:
   return 0;
 }
 
+int WebPAnimEncoderSetWriter(WebPAnimEncoder* enc, WebPWriterFunction writer,
+                             void* custom_ptr) {
+  if (enc == NULL) return 0;
+  MarkNoError(enc);
+  if (writer == NULL || !enc->is_first_frame || enc->num_queued > 0) {
+    MarkError(enc, "ERROR setting writer: invalid argument");
+    return 0;
+  }
+  enc->stream.writer = writer;
+  enc->stream.custom_ptr = custom_ptr;
+  return 1;
+}
+
 const char* WebPAnimEncoderGetError(WebPAnimEncoder* enc) {
   if (enc == NULL) return NULL;
   return enc->error_str;
@@ -1818,6 +2418,10 @@ WebPMuxError WebPAnimEncoderSetChunk(WebPAnimEncoder* enc, const char fourcc[4],
                                      const WebPData* chunk_data,
                                      int copy_data) {
   if (enc == NULL) return WEBP_MUX_INVALID_ARGUMENT;
+  if (enc->stream_started && fourcc != NULL &&
+      !memcmp(fourcc, "ICCP", TAG_SIZE)) {
+    return WEBP_MUX_INVALID_ARGUMENT;  // Too late, already written.
+  }
   return WebPMuxSetChunk(enc->mux, fourcc, chunk_data, copy_data);
 }
 
@@ -28,8 +28,8 @@ WEBP_ASSUME_UNSAFE_INDEXABLE_ABI
 
 int VP8LColorCacheInit(VP8LColorCache* const color_cache, int hash_bits) {
   const int hash_size = 1 << hash_bits;
-  uint32_t* colors = (uint32_t*)WebPSafeCalloc((uint64_t)hash_size,
-                                               sizeof(*color_cache->colors));
+  uint32_t* colors = (uint32_t*)WebPSafeCallocWithHint(
+      (uint64_t)hash_size, sizeof(*color_cache->colors), WEBP_MEMORY_HINT_HOT);
   assert(color_cache != NULL);
   assert(hash_bits > 0);
   if (colors == NULL) {
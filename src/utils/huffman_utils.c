@@ -30,7 +30,9 @@ WEBP_ASSUME_UNSAFE_INDEXABLE_ABI
 
 HTreeGroup* VP8LHtreeGroupsNew(int num_htree_groups) {
   HTreeGroup* const htree_groups =
-      (HTreeGroup*)WebPSafeMalloc(num_htree_groups, sizeof(*htree_groups));
+      (HTreeGroup*)WebPSafeMallocWithHint(num_htree_groups,
+                                          sizeof(*htree_groups),
+                                          WEBP_MEMORY_HINT_HOT);
   if (htree_groups == NULL) {
     return NULL;
   }
@@ -258,7 +260,8 @@ int VP8LBuildHuffmanTable(HuffmanTables* const root_table, int root_bits,
       const int next_size =
           total_size > segment_size ? total_size : segment_size;
       HuffmanCode* WEBP_BIDI_INDEXABLE const next_start =
-          (HuffmanCode*)WebPSafeMalloc(next_size, sizeof(*next_start));
+          (HuffmanCode*)WebPSafeMallocWithHint(next_size, sizeof(*next_start),
+                                               WEBP_MEMORY_HINT_HOT);
       if (next_start == NULL) {
         WebPSafeFree(next);
         return 0;
@@ -304,7 +307,8 @@ int VP8LHuffmanTablesAllocate(int size, HuffmanTables* huffman_tables) {
   // Allocate root.
   {
     HuffmanCode* WEBP_BIDI_INDEXABLE const start =
-        (HuffmanCode*)WebPSafeMalloc(size, sizeof(*root->start));
+        (HuffmanCode*)WebPSafeMallocWithHint(size, sizeof(*root->start),
+                                             WEBP_MEMORY_HINT_HOT);
     if (start == NULL) {
       root->start = NULL;
       root->size = 0;
@@ -90,6 +90,10 @@ static int pthread_join(pthread_t thread, void** value_ptr) {
           CloseHandle(thread) == 0);
 }
 
+static int IsCurrentThread(pthread_t thread) {
+  return (GetThreadId(thread) == GetCurrentThreadId());
+}
+
 // Mutex
 static int pthread_mutex_init(pthread_mutex_t* const mutex, void* mutexattr) {
   (void)mutexattr;
@@ -129,6 +133,11 @@ static int pthread_cond_signal(pthread_cond_t* const condition) {
   return 0;
 }
 
+static int pthread_cond_broadcast(pthread_cond_t* const condition) {
+  WakeAllConditionVariable(condition);
+  return 0;
+}
+
 static int pthread_cond_wait(pthread_cond_t* const condition,
                              pthread_mutex_t* const mutex) {
   const int ok = SleepConditionVariableSRW(condition, mutex, INFINITE, 0);
@@ -138,6 +147,10 @@ static int pthread_cond_wait(pthread_cond_t* const condition,
 #else  // !_WIN32
 #define THREADFN void*
 #define THREAD_RETURN(val) val
+
+static int IsCurrentThread(pthread_t thread) {
+  return pthread_equal(thread, pthread_self());
+}
 #endif  // _WIN32
 
 //------------------------------------------------------------------------------
@@ -307,3 +320,371 @@ const WebPWorkerInterface* WebPGetWorkerInterface(void) {
 }
 
 //------------------------------------------------------------------------------
+// Thread pool
+
+#ifdef WEBP_USE_THREAD
+
+// Per-worker state, stored in worker->impl.
+typedef struct WebPPoolTask WebPPoolTask;
+struct WebPPoolTask {
+  WebPWorker* worker;
+  WebPPoolTask* next;  // next task in the queue
+  int queued;          // true if waiting in the queue
+};
+
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t work_condition;  // signaled when a task is queued
+  pthread_cond_t done_condition;  // signaled when a task is finished
+  pthread_t* threads;
+  int num_threads;
+  WebPPoolTask* head;  // queue of launched tasks, in launch order
+  WebPPoolTask* tail;
+  int quit;
+} WebPThreadPool;
+
+static WebPThreadPool* g_pool = NULL;
+
+// Runs the worker's hook in the current thread, with the pool mutex held on
+// entry and on exit.
+static void PoolExecuteLocked(WebPThreadPool* const pool,
+                              WebPWorker* const worker) {
+  pthread_mutex_unlock(&pool->mutex);
+  WebPGetWorkerInterface()->Execute(worker);
+  pthread_mutex_lock(&pool->mutex);
+  worker->status = OK;
+  pthread_cond_broadcast(&pool->done_condition);
+}
+
+static THREADFN PoolThreadLoop(void* ptr) {
+  WebPThreadPool* const pool = (WebPThreadPool*)ptr;
+  pthread_mutex_lock(&pool->mutex);
+  while (!pool->quit) {
+    WebPPoolTask* const task = pool->head;
+    if (task == NULL) {
+      pthread_cond_wait(&pool->work_condition, &pool->mutex);
+      continue;
+    }
+    pool->head = task->next;
+    if (pool->head == NULL) pool->tail = NULL;
+    task->next = NULL;
+    task->queued = 0;
+    PoolExecuteLocked(pool, task->worker);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return THREAD_RETURN(NULL);
+}
+
+// Removes 'task' from the queue. Must be called with the pool mutex held.
+static void PoolDequeue(WebPThreadPool* const pool, WebPPoolTask* const task) {
+  WebPPoolTask* prev = NULL;
+  WebPPoolTask* cur = pool->head;
+  while (cur != task) {
+    assert(cur != NULL);
+    prev = cur;
+    cur = cur->next;
+  }
+  if (prev == NULL) {
+    pool->head = task->next;
+  } else {
+    prev->next = task->next;
+  }
+  if (pool->tail == task) pool->tail = prev;
+  task->next = NULL;
+  task->queued = 0;
+}
+
+static int PoolSync(WebPWorker* const worker) {
+  WebPPoolTask* const task = (WebPPoolTask*)worker->impl;
+  if (task != NULL) {
+    WebPThreadPool* const pool = g_pool;
+    pthread_mutex_lock(&pool->mutex);
+    if (task->queued) {  // not started yet: run it right away
+      PoolDequeue(pool, task);
+      PoolExecuteLocked(pool, worker);
+    }
+    while (worker->status == WORK) {
+      pthread_cond_wait(&pool->done_condition, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+  }
+  assert(worker->status <= OK);
+  return !worker->had_error;
+}
+
+static int PoolReset(WebPWorker* const worker) {
+  int ok = 1;
+  worker->had_error = 0;
+  if (worker->status < OK) {
+    WebPPoolTask* const task =
+        (WebPPoolTask*)WebPSafeCalloc(1, sizeof(WebPPoolTask));
+    if (task == NULL) return 0;
+    task->worker = worker;
+    worker->impl = (void*)task;
+    worker->status = OK;
+  } else if (worker->status > OK) {
+    ok = PoolSync(worker);
+  }
+  assert(!ok || (worker->status == OK));
+  return ok;
+}
+
+// Returns true if the calling thread is one of the threads of 'pool'.
+static int IsPoolThread(const WebPThreadPool* const pool) {
+  int i;
+  for (i = 0; i < pool->num_threads; ++i) {
+    if (IsCurrentThread(pool->threads[i])) return 1;
+  }
+  return 0;
+}
+
+static void PoolLaunch(WebPWorker* const worker) {
+  WebPPoolTask* const task = (WebPPoolTask*)worker->impl;
+  WebPThreadPool* const pool = g_pool;
+  assert(task != NULL && !task->queued);
+  if (IsPoolThread(pool)) {
+    // Nested job: queuing it could leave every pool thread waiting on a job
+    // that none of them is free to start, so run it right away instead.
+    assert(worker->status == OK);
+    Execute(worker);
+    return;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  assert(worker->status == OK);
+  worker->status = WORK;
+  task->queued = 1;
+  if (pool->tail == NULL) {
+    pool->head = task;
+  } else {
+    pool->tail->next = task;
+  }
+  pool->tail = task;
+  pthread_mutex_unlock(&pool->mutex);
+  pthread_cond_signal(&pool->work_condition);
+}
+
+static void PoolEnd(WebPWorker* const worker) {
+  if (worker->impl != NULL) {
+    PoolSync(worker);
+    WebPSafeFree(worker->impl);
+    worker->impl = NULL;
+  }
+  worker->status = NOT_OK;
+}
+
+static const WebPWorkerInterface kDefaultWorkerInterface = {
+    Init, Reset, Sync, Launch, Execute, End};
+static const WebPWorkerInterface kPoolWorkerInterface = {
+    Init, PoolReset, PoolSync, PoolLaunch, Execute, PoolEnd};
+
+static void DeletePool(WebPThreadPool* const pool, int num_threads) {
+  int i;
+  pthread_mutex_lock(&pool->mutex);
+  pool->quit = 1;
+  pthread_mutex_unlock(&pool->mutex);
+  for (i = 0; i < num_threads; ++i) {
+    pthread_cond_broadcast(&pool->work_condition);
+    pthread_join(pool->threads[i], NULL);
+  }
+  assert(pool->head == NULL);
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->work_condition);
+  pthread_cond_destroy(&pool->done_condition);
+  WebPSafeFree(pool->threads);
+  WebPSafeFree(pool);
+}
+
+static WebPThreadPool* NewPool(int num_threads) {
+  int i;
+  WebPThreadPool* const pool =
+      (WebPThreadPool*)WebPSafeCalloc(1, sizeof(WebPThreadPool));
+  if (pool == NULL) return NULL;
+  pool->threads =
+      (pthread_t*)WebPSafeCalloc(num_threads, sizeof(*pool->threads));
+  if (pool->threads == NULL) {
+    WebPSafeFree(pool);
+    return NULL;
+  }
+  if (pthread_mutex_init(&pool->mutex, NULL)) goto Error;
+  if (pthread_cond_init(&pool->work_condition, NULL)) {
+    pthread_mutex_destroy(&pool->mutex);
+    goto Error;
+  }
+  if (pthread_cond_init(&pool->done_condition, NULL)) {
+    pthread_cond_destroy(&pool->work_condition);
+    pthread_mutex_destroy(&pool->mutex);
+    goto Error;
+  }
+  for (i = 0; i < num_threads; ++i) {
+    if (pthread_create(&pool->threads[i], NULL, PoolThreadLoop, pool)) {
+      DeletePool(pool, i);
+      return NULL;
+    }
+  }
+  pool->num_threads = num_threads;
+  return pool;
+
+Error:
+  WebPSafeFree(pool->threads);
+  WebPSafeFree(pool);
+  return NULL;
+}
+
+#endif  // WEBP_USE_THREAD
+
+int WebPSetThreadPool(int num_threads) {
+  if (num_threads < 0) return 0;
+#ifdef WEBP_USE_THREAD
+  if (g_pool != NULL) {
+    DeletePool(g_pool, g_pool->num_threads);
+    g_pool = NULL;
+    g_worker_interface = kDefaultWorkerInterface;
+  }
+  if (num_threads > 0) {
+    g_pool = NewPool(num_threads);
+    if (g_pool == NULL) return 0;
+    g_worker_interface = kPoolWorkerInterface;
+  }
+  return 1;
+#else
+  return (num_threads == 0);
+#endif
+}
+
+int WebPGetThreadPoolSize(void) {
+#ifdef WEBP_USE_THREAD
+  return (g_pool != NULL) ? g_pool->num_threads : 0;
+#else
+  return 0;
+#endif
+}
+
+int WebPIsPoolThread(void) {
+#ifdef WEBP_USE_THREAD
+  return (g_pool != NULL) && IsPoolThread(g_pool);
+#else
+  return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Progress counters
+
+#ifdef WEBP_USE_THREAD
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t condition;
+  int num_waiting;  // number of jobs blocked on this counter
+  int aborted;      // per-counter copy of the 'aborted' flag
+} WebPProgressImpl;
+#endif
+
+int WebPProgressInit(WebPProgress* const progress, int size) {
+  assert(progress != NULL && size > 0);
+  assert(progress->counters == NULL && progress->impl == NULL);
+#ifdef WEBP_USE_THREAD
+  {
+    int i;
+    WebPProgressImpl* const impl =
+        (WebPProgressImpl*)WebPSafeCalloc(size, sizeof(*impl));
+    if (impl == NULL) return 0;
+    for (i = 0; i < size; ++i) {
+      if (pthread_mutex_init(&impl[i].mutex, NULL)) break;
+      if (pthread_cond_init(&impl[i].condition, NULL)) {
+        pthread_mutex_destroy(&impl[i].mutex);
+        break;
+      }
+    }
+    progress->impl = (void*)impl;
+    progress->size = i;  // only the initialized ones, for WebPProgressClear()
+    if (i < size) {
+      WebPProgressClear(progress);
+      return 0;
+    }
+  }
+#endif
+  progress->counters = (int*)WebPSafeCalloc(size, sizeof(*progress->counters));
+  progress->size = size;
+  progress->aborted = 0;
+  if (progress->counters == NULL) {
+    WebPProgressClear(progress);
+    return 0;
+  }
+  return 1;
+}
+
+void WebPProgressClear(WebPProgress* const progress) {
+  if (progress == NULL) return;
+#ifdef WEBP_USE_THREAD
+  if (progress->impl != NULL) {
+    WebPProgressImpl* const impl = (WebPProgressImpl*)progress->impl;
+    int i;
+    for (i = 0; i < progress->size; ++i) {
+      pthread_mutex_destroy(&impl[i].mutex);
+      pthread_cond_destroy(&impl[i].condition);
+    }
+    WebPSafeFree(impl);
+  }
+#endif
+  WebPSafeFree(progress->counters);
+  WEBP_UNSAFE_MEMSET(progress, 0, sizeof(*progress));
+}
+
+void WebPProgressUpdate(WebPProgress* const progress, int index, int value) {
+  assert(index >= 0 && index < progress->size);
+#ifdef WEBP_USE_THREAD
+  {
+    WebPProgressImpl* const impl = (WebPProgressImpl*)progress->impl + index;
+    int num_waiting;
+    pthread_mutex_lock(&impl->mutex);
+    assert(value >= progress->counters[index]);
+    progress->counters[index] = value;
+    num_waiting = impl->num_waiting;
+    pthread_mutex_unlock(&impl->mutex);
+    if (num_waiting > 0) pthread_cond_broadcast(&impl->condition);
+  }
+#else
+  progress->counters[index] = value;
+#endif
+}
+
+int WebPProgressWait(WebPProgress* const progress, int index, int value) {
+  int ok;
+  assert(index >= 0 && index < progress->size);
+#ifdef WEBP_USE_THREAD
+  {
+    WebPProgressImpl* const impl = (WebPProgressImpl*)progress->impl + index;
+    pthread_mutex_lock(&impl->mutex);
+    while (progress->counters[index] < value && !impl->aborted) {
+      ++impl->num_waiting;
+      pthread_cond_wait(&impl->condition, &impl->mutex);
+      --impl->num_waiting;
+    }
+    ok = !impl->aborted;
+    pthread_mutex_unlock(&impl->mutex);
+  }
+#else
+  ok = !progress->aborted;
+  assert(!ok || progress->counters[index] >= value);
+  (void)index;
+  (void)value;
+#endif
+  return ok;
+}
+
+void WebPProgressAbort(WebPProgress* const progress) {
+#ifdef WEBP_USE_THREAD
+  WebPProgressImpl* const impl = (WebPProgressImpl*)progress->impl;
+  int i;
+  for (i = 0; i < progress->size; ++i) {
+    pthread_mutex_lock(&impl[i].mutex);
+    impl[i].aborted = 1;
+    pthread_mutex_unlock(&impl[i].mutex);
+    pthread_cond_broadcast(&impl[i].condition);
+  }
+#else
+  progress->aborted = 1;
+#endif
+}
+
+//------------------------------------------------------------------------------
@@ -84,6 +84,55 @@ WEBP_EXTERN int WebPSetWorkerInterface(
 // Retrieve the currently set thread worker interface.
 WEBP_EXTERN const WebPWorkerInterface* WebPGetWorkerInterface(void);
 
+// Create a process-wide pool of 'num_threads' persistent threads and install
+// a worker interface running the jobs of all workers on it, instead of
+// spawning one thread per worker. Jobs are started in launch order, and
+// Sync() runs a job not started yet in the calling thread. Jobs launched from
+// a pool thread (nested jobs) are executed synchronously by Launch(), so that
+// a job waiting on its own sub-jobs cannot starve the pool. If 'num_threads'
+// is 0, the pool is released and the default interface is restored.
+// Like WebPSetWorkerInterface(), this function is not thread-safe and must be
+// called while no worker is in use. Returns false in case of error, or if
+// threads are not supported.
+WEBP_EXTERN int WebPSetThreadPool(int num_threads);
+
+// Return the number of threads of the current pool (0 if there is none).
+WEBP_EXTERN int WebPGetThreadPoolSize(void);
+
+// Return true if the calling thread belongs to the current pool, in which case
+// Launch() executes the hook synchronously. Jobs that wait on each other's
+// progress should then be run in dependency order by the caller.
+int WebPIsPoolThread(void);
+
+//------------------------------------------------------------------------------
+// Progress counters
+
+// Set of monotonically increasing counters shared between workers. They are
+// used to synchronize jobs depending on each other's partial results (e.g.
+// wavefront processing of macroblock rows). Without WEBP_USE_THREAD, or with a
+// worker interface executing hooks synchronously, waiting never blocks since
+// the jobs are expected to be launched in dependency order.
+typedef struct {
+  void* impl;     // platform-dependent locks and conditions
+  int* counters;  // current values
+  int size;       // number of counters
+  int aborted;    // set by WebPProgressAbort() when threads are disabled
+} WebPProgress;
+
+// Allocates 'size' counters, all set to zero. 'progress' must have been
+// zero-initialized or previously cleared. Returns false in case of error.
+WEBP_NODISCARD int WebPProgressInit(WebPProgress* const progress, int size);
+// Releases the memory. Must not be called while some jobs are still using it.
+void WebPProgressClear(WebPProgress* const progress);
+// Sets the counter 'index' to 'value' and wakes up the jobs waiting on it.
+void WebPProgressUpdate(WebPProgress* const progress, int index, int value);
+// Waits until the counter 'index' is at least 'value'. Returns false if the
+// wait was interrupted by WebPProgressAbort().
+WEBP_NODISCARD int WebPProgressWait(WebPProgress* const progress, int index,
+                                    int value);
+// Wakes up all waiting jobs, and makes any subsequent wait fail.
+void WebPProgressAbort(WebPProgress* const progress);
+
 //------------------------------------------------------------------------------
 
 #ifdef __cplusplus
@@ -22,9 +22,11 @@
 #include "src/webp/encode.h"
 #include "src/webp/types.h"
 
-WEBP_ASSUME_UNSAFE_INDEXABLE_ABI
-
+#if defined(ESP_PLATFORM)
 #include "esp_heap_caps.h"
+#endif
+
+WEBP_ASSUME_UNSAFE_INDEXABLE_ABI
 
 // If PRINT_MEM_INFO is defined, extra info (like total memory used, number of
 // alloc/free etc) is printed. For debugging/tuning purpose only (it's slow,
@@ -33,7 +35,9 @@ WEBP_ASSUME_UNSAFE_INDEXABLE_ABI
 //    https://valgrind.org/docs/manual/ms-manual.html
 // Here is an example command line:
 /*    valgrind --tool=massif --massif-out-file=massif.out \
-               --stacks=yes --alloc-fn=WebPSafeMalloc --alloc-fn=WebPSafeCalloc
+               --stacks=yes --alloc-fn=WebPSafeMalloc --alloc-fn=WebPSafeCalloc \
+               --alloc-fn=WebPSafeMallocWithHint \
+               --alloc-fn=WebPSafeCallocWithHint
       ms_print massif.out
 */
 // In addition:
@@ -180,6 +184,100 @@ static void SubMem(void* ptr) {
   } while (0)
 #endif
 
+//------------------------------------------------------------------------------
+// Allocator
+
+#if defined(ESP_PLATFORM)
+
+// 'opaque' holds the MALLOC_CAP_* capabilities. Hot allocations go to the
+// internal RAM when possible.
+#define HOT_CAPS (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+
+static void* HeapCapsMalloc(void* opaque, size_t size, WebPMemoryHint hint) {
+  const uint32_t caps = (uint32_t)(uintptr_t)opaque;
+  void* ptr = NULL;
+  if (hint == WEBP_MEMORY_HINT_HOT) ptr = heap_caps_malloc(size, HOT_CAPS);
+  if (ptr == NULL) ptr = heap_caps_malloc(size, caps);
+  return ptr;
+}
+
+static void* HeapCapsCalloc(void* opaque, size_t nmemb, size_t size,
+                            WebPMemoryHint hint) {
+  const uint32_t caps = (uint32_t)(uintptr_t)opaque;
+  void* ptr = NULL;
+  if (hint == WEBP_MEMORY_HINT_HOT) {
+    ptr = heap_caps_calloc(nmemb, size, HOT_CAPS);
+  }
+  if (ptr == NULL) ptr = heap_caps_calloc(nmemb, size, caps);
+  return ptr;
+}
+
+static void HeapCapsFree(void* opaque, void* ptr) {
+  (void)opaque;
+  heap_caps_free(ptr);
+}
+
+void WebPGetHeapCapsAllocator(uint32_t caps, WebPMemoryAllocator* const dst) {
+  assert(dst != NULL);
+  dst->malloc_func = HeapCapsMalloc;
+  dst->calloc_func = HeapCapsCalloc;
+  dst->free_func = HeapCapsFree;
+  dst->opaque = (void*)(uintptr_t)caps;
+}
+
+#define DEFAULT_ALLOCATOR                           \
+  {                                                 \
+    HeapCapsMalloc, HeapCapsCalloc, HeapCapsFree,   \
+        (void*)(uintptr_t)MALLOC_CAP_SPIRAM         \
+  }
+
+#else
+
+static void* LibcMalloc(void* opaque, size_t size, WebPMemoryHint hint) {
+  (void)opaque;
+  (void)hint;
+  return malloc(size);
+}
+
+static void* LibcCalloc(void* opaque, size_t nmemb, size_t size,
+                        WebPMemoryHint hint) {
+  (void)opaque;
+  (void)hint;
+  return calloc(nmemb, size);
+}
+
+static void LibcFree(void* opaque, void* ptr) {
+  (void)opaque;
+  free(ptr);
+}
+
+#define DEFAULT_ALLOCATOR { LibcMalloc, LibcCalloc, LibcFree, NULL }
+
+#endif  // ESP_PLATFORM
+
+static const WebPMemoryAllocator kDefaultAllocator = DEFAULT_ALLOCATOR;
+static WebPMemoryAllocator mem_allocator = DEFAULT_ALLOCATOR;
+
+int WebPSetMemoryAllocator(const WebPMemoryAllocator* const new_allocator) {
+  if (new_allocator == NULL) {
+    mem_allocator = kDefaultAllocator;
+    return 1;
+  }
+  if (new_allocator->malloc_func == NULL ||
+      new_allocator->calloc_func == NULL || new_allocator->free_func == NULL) {
+    return 0;
+  }
+  mem_allocator = *new_allocator;
+  return 1;
+}
+
+void WebPGetMemoryAllocator(WebPMemoryAllocator* const dst) {
+  assert(dst != NULL);
+  *dst = mem_allocator;
+}
+
+//------------------------------------------------------------------------------
+
 // Returns 0 in case of overflow of nmemb * size.
 static int CheckSizeArgumentsOverflow(uint64_t nmemb, size_t size) {
   const uint64_t total_size = nmemb * size;
@@ -204,33 +302,45 @@ static int CheckSizeArgumentsOverflow(uint64_t nmemb, size_t size) {
 }
 
 void* WEBP_SIZED_BY_OR_NULL(nmemb* size)
-    WebPSafeMalloc(uint64_t nmemb, size_t size) {
+    WebPSafeMallocWithHint(uint64_t nmemb, size_t size, WebPMemoryHint hint) {
   void* ptr;
   Increment(&num_malloc_calls);
   if (!CheckSizeArgumentsOverflow(nmemb, size)) return NULL;
   assert(nmemb * size > 0);
-  ptr = heap_caps_malloc((size_t)(nmemb * size), MALLOC_CAP_SPIRAM);
+  ptr = mem_allocator.malloc_func(mem_allocator.opaque, (size_t)(nmemb * size),
+                                  hint);
   AddMem(ptr, (size_t)(nmemb * size));
   return WEBP_UNSAFE_FORGE_BIDI_INDEXABLE(void*, ptr, (size_t)(nmemb * size));
 }
 
 void* WEBP_SIZED_BY_OR_NULL(nmemb* size)
-    WebPSafeCalloc(uint64_t nmemb, size_t size) {
+    WebPSafeCallocWithHint(uint64_t nmemb, size_t size, WebPMemoryHint hint) {
   void* ptr;
   Increment(&num_calloc_calls);
   if (!CheckSizeArgumentsOverflow(nmemb, size)) return NULL;
   assert(nmemb * size > 0);
-  ptr = heap_caps_calloc((size_t)nmemb, size, MALLOC_CAP_SPIRAM);
+  ptr = mem_allocator.calloc_func(mem_allocator.opaque, (size_t)nmemb, size,
+                                  hint);
   AddMem(ptr, (size_t)(nmemb * size));
   return WEBP_UNSAFE_FORGE_BIDI_INDEXABLE(void*, ptr, (size_t)(nmemb * size));
 }
 
+void* WEBP_SIZED_BY_OR_NULL(nmemb* size)
+    WebPSafeMalloc(uint64_t nmemb, size_t size) {
+  return WebPSafeMallocWithHint(nmemb, size, WEBP_MEMORY_HINT_BULK);
+}
+
+void* WEBP_SIZED_BY_OR_NULL(nmemb* size)
+    WebPSafeCalloc(uint64_t nmemb, size_t size) {
+  return WebPSafeCallocWithHint(nmemb, size, WEBP_MEMORY_HINT_BULK);
+}
+
 void WebPSafeFree(void* const ptr) {
   if (ptr != NULL) {
     Increment(&num_free_calls);
     SubMem(ptr);
+    mem_allocator.free_func(mem_allocator.opaque, ptr);
   }
-  heap_caps_free(ptr);
 }
 
 // Public API functions.
@@ -61,6 +61,14 @@ WEBP_EXTERN void* WEBP_SIZED_BY_OR_NULL(nmemb* size)
 WEBP_EXTERN void* WEBP_SIZED_BY_OR_NULL(nmemb* size)
     WebPSafeCalloc(uint64_t nmemb, size_t size);
 
+// Same as WebPSafeMalloc() and WebPSafeCalloc(), with a placement hint for the
+// allocator. Use WEBP_MEMORY_HINT_HOT for the small buffers the inner loops
+// keep accessing.
+WEBP_EXTERN void* WEBP_SIZED_BY_OR_NULL(nmemb* size)
+    WebPSafeMallocWithHint(uint64_t nmemb, size_t size, WebPMemoryHint hint);
+WEBP_EXTERN void* WEBP_SIZED_BY_OR_NULL(nmemb* size)
+    WebPSafeCallocWithHint(uint64_t nmemb, size_t size, WebPMemoryHint hint);
+
 // Companion deallocation function to the above allocations.
 WEBP_EXTERN void WebPSafeFree(void* const ptr);
 
@@ -24,7 +24,7 @@ WEBP_ASSUME_UNSAFE_INDEXABLE_ABI
 extern "C" {
 #endif
 
-#define WEBP_DECODER_ABI_VERSION 0x0210  // MAJOR(8b) + MINOR(8b)
+#define WEBP_DECODER_ABI_VERSION 0x0211  // MAJOR(8b) + MINOR(8b)
 
 // Note: forward declaring enumerations is not allowed in (strict) C and C++,
 // the types are left here for reference.
@@ -486,8 +486,13 @@ struct WebPDecoderOptions {
   int dithering_strength;           // dithering strength (0=Off, 100=full)
   int flip;                         // if true, flip output vertically
   int alpha_dithering_strength;     // alpha dithering strength in [0..100]
+  int num_threads;                  // if use_threads is true and num_threads
+                                    // is more than 1, lossy macroblock rows
+                                    // are reconstructed and filtered by this
+                                    // many threads (wavefront). Otherwise, a
+                                    // single extra thread is used.
 
-  uint32_t pad[5];  // padding for later use
+  uint32_t pad[4];  // padding for later use
 };
 
 // Main object storing the configuration for advanced decoding.
@@ -537,6 +542,29 @@ WEBP_EXTERN VP8StatusCode WebPDecode(const uint8_t* WEBP_COUNTED_BY(data_size)
                                      size_t data_size,
                                      WebPDecoderConfig* config);
 
+//------------------------------------------------------------------------------
+// Decoder context
+//
+// A context keeps the decoder objects and their working memory (frame buffers,
+// Huffman tables, ...) from one WebPDecodeWithContext() call to the next,
+// growing them to the largest picture decoded so far. This avoids most of the
+// allocations when decoding many small pictures. A context must not be used
+// by several threads at the same time.
+
+typedef struct WebPDecoderContext WebPDecoderContext;
+
+// Creates a new context. Returns NULL in case of memory error.
+WEBP_NODISCARD WEBP_EXTERN WebPDecoderContext* WebPNewDecoderContext(void);
+
+// Releases the context and all the memory it keeps.
+WEBP_EXTERN void WebPDeleteDecoderContext(WebPDecoderContext* context);
+
+// Same as WebPDecode(), reusing the memory kept by 'context'.
+WEBP_EXTERN VP8StatusCode WebPDecodeWithContext(
+    WebPDecoderContext* context,
+    const uint8_t* WEBP_COUNTED_BY(data_size) data, size_t data_size,
+    WebPDecoderConfig* config);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
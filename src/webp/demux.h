@@ -58,7 +58,7 @@
 extern "C" {
 #endif
 
-#define WEBP_DEMUX_ABI_VERSION 0x0107  // MAJOR(8b) + MINOR(8b)
+#define WEBP_DEMUX_ABI_VERSION 0x0108  // MAJOR(8b) + MINOR(8b)
 
 // Note: forward declaring enumerations is not allowed in (strict) C and C++,
 // the types are left here for reference.
@@ -258,7 +258,11 @@ struct WebPAnimDecoderOptions {
   // MODE_RGBA, MODE_BGRA, MODE_rgbA and MODE_bgrA.
   WEBP_CSP_MODE color_mode;
   int use_threads;      // If true, use multi-threaded decoding.
-  uint32_t padding[7];  // Padding for later use.
+  // Number of upcoming frames decoded ahead of time by worker threads, while
+  // the caller uses the current canvas. 0 disables it. At most 16.
+  // Each of them holds a buffer as large as its frame.
+  int lookahead;
+  uint32_t padding[6];  // Padding for later use.
 };
 
 // Internal, version-checked, entry point.
@@ -330,6 +334,48 @@ WEBP_NODISCARD WEBP_EXTERN int WebPAnimDecoderGetNext(WebPAnimDecoder* dec,
                                                       uint8_t** buf,
                                                       int* timestamp);
 
+// Same as WebPAnimDecoderGetNext(), but reconstructs the canvas in 'canvas',
+// which is owned by the caller. 'canvas' holds 'canvas_height' rows of
+// 'canvas_width * 4' bytes, 'stride' bytes apart. Only the pixels that change
+// are written: the rectangle of the previous frame if it is disposed to the
+// background, and the rectangle of the new frame. So the same 'canvas' must
+// be passed, unmodified, to all the calls that follow WebPAnimDecoderNew() or
+// WebPAnimDecoderReset(). This avoids the copies of the whole canvas done for
+// each frame by WebPAnimDecoderGetNext(), and the decoder does not allocate
+// any canvas. WebPAnimDecoderGetNext() and WebPAnimDecoderGetNextInto() cannot
+// be mixed between two resets.
+// Parameters:
+//   dec - (in/out) decoder instance from which the next frame is to be fetched.
+//   canvas - (in/out) canvas to update with the next frame.
+//   stride - (in) distance in bytes between two rows of 'canvas'.
+//   timestamp - (out) timestamp of the frame in milliseconds.
+// Returns:
+//   False if any of the arguments are NULL or invalid, if there is a parsing
+//   or decoding error, or if there are no more frames. Otherwise, returns
+//   true. In case of error, the content of 'canvas' is undefined until the
+//   next WebPAnimDecoderReset().
+WEBP_NODISCARD WEBP_EXTERN int WebPAnimDecoderGetNextInto(WebPAnimDecoder* dec,
+                                                          uint8_t* canvas,
+                                                          int stride,
+                                                          int* timestamp);
+
+// Retrieves the rectangle of the canvas that was changed by the last frame
+// returned by WebPAnimDecoderGetNext() or WebPAnimDecoderGetNextInto(): the
+// pixels outside of it are the same as in the previous canvas. It is the
+// bounding box of the frame and of the previous frame if that one was disposed
+// to the background. After WebPAnimDecoderNew(), WebPAnimDecoderReset() or a
+// seek, the first frame changes the whole canvas.
+// Parameters:
+//   dec - (in) decoder instance.
+//   x_offset, y_offset - (out) top-left corner of the rectangle.
+//   width, height - (out) dimensions of the rectangle.
+// Returns:
+//   False if any of the arguments are NULL, or if no frame was returned since
+//   the last reset or seek. Otherwise, returns true.
+WEBP_NODISCARD WEBP_EXTERN int WebPAnimDecoderGetDirtyRect(
+    const WebPAnimDecoder* dec, int* x_offset, int* y_offset, int* width,
+    int* height);
+
 // Check if there are more frames left to decode.
 // Parameters:
 //   dec - (in) decoder instance to be checked.
@@ -347,6 +393,36 @@ WEBP_NODISCARD WEBP_EXTERN int WebPAnimDecoderHasMoreFrames(
 //   dec - (in/out) decoder instance to be reset
 WEBP_EXTERN void WebPAnimDecoderReset(WebPAnimDecoder* dec);
 
+// Sets the frame returned by the next call to WebPAnimDecoderGetNext() or
+// WebPAnimDecoderGetNextInto(). That call decodes the frames from the closest
+// key-frame before 'frame_num' on, or from the current position if it is
+// closer. The key-frames are indexed by the first seek.
+// WebPAnimDecoderGetNext() and WebPAnimDecoderGetNextInto() still cannot be
+// mixed between two resets. The canvas passed to the latter is fully rewritten
+// if the decoding restarts from a key-frame, so it only has to be the same as
+// before if the position moves forward.
+// Parameters:
+//   dec - (in/out) decoder instance.
+//   frame_num - (in) frame number, starting from 1.
+// Returns:
+//   False if 'dec' is NULL, if 'frame_num' is out of range or in case of memory
+//   error. Otherwise, returns true.
+WEBP_NODISCARD WEBP_EXTERN int WebPAnimDecoderSeekToFrame(WebPAnimDecoder* dec,
+                                                          int frame_num);
+
+// Same as WebPAnimDecoderSeekToFrame(), for the frame displayed at 'timestamp'
+// milliseconds: the first frame whose timestamp, as returned by
+// WebPAnimDecoderGetNext(), is larger than 'timestamp'. The last frame is
+// picked if 'timestamp' is past the end of the animation.
+// Parameters:
+//   dec - (in/out) decoder instance.
+//   timestamp - (in) time in milliseconds, starting from 0.
+// Returns:
+//   False if 'dec' is NULL, if 'timestamp' is negative or in case of memory
+//   error. Otherwise, returns true.
+WEBP_NODISCARD WEBP_EXTERN int WebPAnimDecoderSeekToTimestamp(
+    WebPAnimDecoder* dec, int timestamp);
+
 // Grab the internal demuxer object.
 // Getting the demuxer object can be useful if one wants to use operations only
 // available through demuxer; e.g. to get XMP/EXIF/ICC metadata. The returned
@@ -139,6 +139,9 @@ struct WebPConfig {
                           // JPEG compression. Generally, the output size will
                           // be similar but the degradation will be lower.
   int thread_level;       // If non-zero, try and use multi-threaded encoding.
+                          // 1 uses up to two threads. Values above 1 are
+                          // taken as the maximum number of threads to use,
+                          // up to 32.
   int low_memory;         // If set, reduce memory usage (but increase CPU use).
 
   int near_lossless;  // Near lossless encoding [0 = max loss .. 100 = off
@@ -559,6 +562,36 @@ WEBP_EXTERN void WebPBlendAlpha(WebPPicture* picture, uint32_t background_rgb);
 WEBP_NODISCARD WEBP_EXTERN int WebPEncode(const WebPConfig* config,
                                           WebPPicture* picture);
 
+//------------------------------------------------------------------------------
+// Encoder context
+//
+// A context keeps the encoder objects and their working memory (macroblock
+// info, token buffer pages, lossless hash chain, backward references and
+// transform buffers) from one WebPEncodeWithContext() call to the next. This
+// avoids most of the allocations when encoding a series of pictures of the
+// same dimensions, e.g. video thumbnails or animation frames. Memory that is
+// too small for a new picture is re-allocated. The memory of the extra
+// lossless threads (WebPConfig::thread_level) and of the alpha plane
+// compression is not kept. A context must not be used by several threads at
+// the same time.
+
+typedef struct WebPEncoderContext WebPEncoderContext;
+
+// Creates a new context. Returns NULL in case of memory error.
+WEBP_NODISCARD WEBP_EXTERN WebPEncoderContext* WebPNewEncoderContext(void);
+
+// Releases the context and all the memory it keeps.
+WEBP_EXTERN void WebPDeleteEncoderContext(WebPEncoderContext* context);
+
+// Same as WebPEncode(), reusing the memory kept by 'context'.
+WEBP_NODISCARD WEBP_EXTERN int WebPEncodeWithContext(
+    WebPEncoderContext* context, const WebPConfig* config,
+    WebPPicture* picture);
+
+// Returns the size in bytes of the memory kept by 'context' between calls.
+WEBP_EXTERN size_t WebPGetEncoderContextMemory(
+    const WebPEncoderContext* context);
+
 //------------------------------------------------------------------------------
 
 #ifdef __cplusplus
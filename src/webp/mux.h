@@ -22,7 +22,7 @@
 extern "C" {
 #endif
 
-#define WEBP_MUX_ABI_VERSION 0x0109  // MAJOR(8b) + MINOR(8b)
+#define WEBP_MUX_ABI_VERSION 0x010a  // MAJOR(8b) + MINOR(8b)
 
 //------------------------------------------------------------------------------
 // Mux API
@@ -436,7 +436,10 @@ struct WebPConfig;
 struct WebPAnimEncoderOptions {
   WebPMuxAnimParams anim_params;  // Animation parameters.
   int minimize_size;  // If true, minimize the output size (slow). Implicitly
-                      // disables key-frame insertion.
+                      // disables key-frame insertion. With 'allow_mixed',
+                      // lossless and lossy are both tried unless a quick
+                      // estimate of the lossless size makes one of them
+                      // very unlikely to be the smaller.
   int kmin;
   int kmax;         // Minimum and maximum distance between consecutive key
                     // frames in the output. The library may insert some key
@@ -449,8 +452,12 @@ struct WebPAnimEncoderOptions {
   int allow_mixed;  // If true, use mixed compression mode; may choose
                     // either lossy and lossless for each frame.
   int verbose;      // If true, print info and warning messages to stderr.
+  int lookahead;    // Number of frames WebPAnimEncoderAdd() may keep before
+                    // encoding them, so that their keyframe candidates can
+                    // be encoded ahead of time when 'config->thread_level' is
+                    // non-zero. 0 disables it. At most 16.
 
-  uint32_t padding[4];  // Padding for later use.
+  uint32_t padding[3];  // Padding for later use.
 };
 
 // Internal, version-checked, entry point.
@@ -498,7 +505,15 @@ static WEBP_INLINE WebPAnimEncoder* WebPAnimEncoderNew(
 //                       "timestamp of next frame - timestamp of this frame".
 //                       Hence, timestamps should be in non-decreasing order.
 //   config - (in) encoding options; can be passed NULL to pick
-//            reasonable defaults.
+//            reasonable defaults. If 'config->thread_level' is non-zero, the
+//            candidate encodings of the frame (lossless/lossy, subframe/
+//            keyframe, ...) are run in parallel, at most 'thread_level' at a
+//            time if it is above 1. The output does not change, but the
+//            progress hook of 'frame' may then be called from several threads.
+// If 'lookahead' is set in the options, 'frame' is copied and the call may
+// return before it is encoded. An error in the encoding of such a frame is
+// then reported by a later call, in the error_code of the frame passed to that
+// call, which is not added either.
 // Returns:
 //   On error, returns false and frame->error_code is set appropriately.
 //   Otherwise, returns true.
@@ -518,6 +533,29 @@ WEBP_NODISCARD WEBP_EXTERN int WebPAnimEncoderAdd(
 WEBP_NODISCARD WEBP_EXTERN int WebPAnimEncoderAssemble(WebPAnimEncoder* enc,
                                                        WebPData* webp_data);
 
+// Makes 'enc' write the bitstream to 'writer' as the frames are encoded,
+// instead of keeping all of them until WebPAnimEncoderAssemble(). 'writer' is
+// called like a WebPWriterFunction (see encode.h), with a picture whose
+// 'custom_ptr' is 'custom_ptr'. The output is then always an animation, even
+// with a single frame, and the chunks set through WebPAnimEncoderSetChunk()
+// are written after the frames, except "ICCP" which must be set before the
+// first frame is written.
+// The total size and some of the flags are only known at the end:
+// WebPAnimEncoderAssemble() then writes the remaining data and returns in
+// 'webp_data' the first bytes of the bitstream, which must be written again
+// over the first bytes passed to 'writer'.
+// Parameters:
+//   enc - (in/out) object to stream from. No frame must have been added yet.
+//   writer - (in) function receiving the bitstream, in order.
+//   custom_ptr - (in) passed to 'writer' as picture->custom_ptr.
+// Returns:
+//   True on success.
+WEBP_NODISCARD WEBP_EXTERN int WebPAnimEncoderSetWriter(
+    WebPAnimEncoder* enc,
+    int (*writer)(const uint8_t* data, size_t data_size,
+                  const struct WebPPicture* picture),
+    void* custom_ptr);
+
 // Get error string corresponding to the most recent call using 'enc'. The
 // returned string is owned by 'enc' and is valid only until the next call to
 // WebPAnimEncoderAdd() or WebPAnimEncoderAssemble() or WebPAnimEncoderDelete().
@@ -86,6 +86,73 @@ WEBP_NODISCARD WEBP_EXTERN void* WebPMalloc(size_t size);
 // Releases memory returned by the WebPDecode*() functions (from decode.h).
 WEBP_EXTERN void WebPFree(void* ptr);
 
+// Placement hint passed to the allocator along with each allocation.
+typedef enum WebPMemoryHint {
+  WEBP_MEMORY_HINT_BULK = 0,  // large or streamed buffers (pixels, bitstream)
+  WEBP_MEMORY_HINT_HOT        // small buffers accessed in the inner loops
+} WebPMemoryHint;
+
+// Memory allocation functions used for all the memory allocated by the library,
+// WebPMalloc() included. 'opaque' is passed back to each function as is.
+// 'hint' can be used to place the allocation in faster memory, and may be
+// ignored. 'calloc_func' must return zero-initialized memory.
+typedef struct WebPMemoryAllocator {
+  void* (*malloc_func)(void* opaque, size_t size, WebPMemoryHint hint);
+  void* (*calloc_func)(void* opaque, size_t nmemb, size_t size,
+                       WebPMemoryHint hint);
+  void (*free_func)(void* opaque, void* ptr);
+  void* opaque;
+} WebPMemoryAllocator;
+
+// Installs 'allocator' (copied) in place of the default one, which is the C
+// library's malloc()/calloc()/free() or, on ESP-IDF, heap_caps_*() with
+// MALLOC_CAP_SPIRAM. Passing NULL restores the default allocator.
+// Memory must be released with the allocator that allocated it, so the
+// allocator should be installed before any other call to the library and must
+// not be changed while another thread is using it.
+// Returns false if one of the functions of 'allocator' is NULL. This function
+// is made available by the core 'libwebp' library.
+WEBP_EXTERN int WebPSetMemoryAllocator(const WebPMemoryAllocator* allocator);
+
+// Copies the allocator currently in use into 'allocator'.
+WEBP_EXTERN void WebPGetMemoryAllocator(WebPMemoryAllocator* allocator);
+
+#if defined(ESP_PLATFORM)
+// Fills 'allocator' with the heap_caps_*() allocator using the MALLOC_CAP_*
+// capabilities 'caps', e.g. MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT.
+// WEBP_MEMORY_HINT_HOT allocations are first tried in internal RAM.
+WEBP_EXTERN void WebPGetHeapCapsAllocator(uint32_t caps,
+                                          WebPMemoryAllocator* allocator);
+#endif
+
+// Highest SIMD instruction set the encoding and decoding functions may use.
+// The x86 levels are cumulative: WEBP_DSP_LEVEL_SSE41 also allows SSE2 code.
+// Levels are compared within the instruction sets of the running CPU: a level
+// naming another architecture is taken as its base SIMD set, so on ARM every
+// level but WEBP_DSP_LEVEL_C allows NEON, and on x86 WEBP_DSP_LEVEL_NEON
+// allows SSE2 only.
+typedef enum WebPDspLevel {
+  WEBP_DSP_LEVEL_C = 0,  // plain C code only
+  WEBP_DSP_LEVEL_SSE2,
+  WEBP_DSP_LEVEL_SSE41,
+  WEBP_DSP_LEVEL_AVX2,
+  WEBP_DSP_LEVEL_NEON,
+  WEBP_DSP_LEVEL_AUTO  // no cap: everything the build and the CPU support
+} WebPDspLevel;
+
+// Caps the SIMD code used by the library at 'level', e.g. to compare the
+// implementations on one host or to work around a faulty one. The function
+// pointers are re-initialized by the next encoding or decoding call. Must not
+// be called while another thread is encoding or decoding. Builds that omit the
+// C code in favor of NEON (WEBP_NEON_OMIT_C_CODE) keep using NEON. The cap also
+// applies to the sharp RGB->YUV conversion done by the encoder.
+// Returns false if 'level' is invalid. This function is made available by the
+// core 'libwebp' library.
+WEBP_EXTERN int WebPSetDspLevel(WebPDspLevel level);
+
+// Returns the level set by WebPSetDspLevel(), WEBP_DSP_LEVEL_AUTO by default.
+WEBP_EXTERN WebPDspLevel WebPGetDspLevel(void);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -16,6 +16,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <string_view>
 
 #include "./fuzz_utils.h"
@@ -64,10 +66,69 @@ void AnimDecoderTest(std::string_view blob) {
     goto End;
   }
 
-  while (WebPAnimDecoderHasMoreFrames(dec)) {
-    uint8_t* buf;
-    int timestamp;
-    if (!WebPAnimDecoderGetNext(dec, &buf, &timestamp)) break;
+  {
+    // Also decode in a caller-owned canvas, with frames decoded ahead of time,
+    // which must give the same frames. Its rows are padded to check the
+    // stride handling.
+    const size_t stride = info.canvas_width * 4 + 4;
+    const bool check_canvas =
+        static_cast<size_t>(info.canvas_width) * info.canvas_height <=
+        kMaxNumPixelsSafe / 4;
+    WebPAnimDecoderOptions options;
+    WebPAnimDecoder* dec_canvas = nullptr;
+    if (check_canvas && WebPAnimDecoderOptionsInit(&options)) {
+      options.lookahead = 2;
+      dec_canvas = WebPAnimDecoderNew(&webp_data, &options);
+    }
+    // malloc() rather than std::vector, as nalloc may make it fail.
+    uint8_t* const canvas =
+        (dec_canvas != nullptr)
+            ? static_cast<uint8_t*>(malloc(stride * info.canvas_height))
+            : nullptr;
+
+    // Timestamp of the middle frame, to check a seek back to it.
+    const int seek_frame = static_cast<int>((info.frame_count + 1) / 2);
+    int seek_timestamp = -1;
+    int frame_num = 0;
+    while (WebPAnimDecoderHasMoreFrames(dec)) {
+      uint8_t* buf;
+      int timestamp;
+      if (!WebPAnimDecoderGetNext(dec, &buf, &timestamp)) break;
+      if (++frame_num == seek_frame) seek_timestamp = timestamp;
+      int dirty_x, dirty_y, dirty_w, dirty_h;
+      if (!WebPAnimDecoderGetDirtyRect(dec, &dirty_x, &dirty_y, &dirty_w,
+                                       &dirty_h) ||
+          dirty_x < 0 || dirty_y < 0 || dirty_w <= 0 || dirty_h <= 0 ||
+          static_cast<uint32_t>(dirty_x + dirty_w) > info.canvas_width ||
+          static_cast<uint32_t>(dirty_y + dirty_h) > info.canvas_height) {
+        abort();
+      }
+      if (canvas == nullptr) continue;
+      int canvas_timestamp;
+      if (!WebPAnimDecoderGetNextInto(dec_canvas, canvas,
+                                      static_cast<int>(stride),
+                                      &canvas_timestamp)) {
+        break;
+      }
+      if (canvas_timestamp != timestamp) abort();
+      for (uint32_t y = 0; y < info.canvas_height; ++y) {
+        if (memcmp(buf + y * info.canvas_width * 4, &canvas[y * stride],
+                   info.canvas_width * 4) != 0) {
+          abort();
+        }
+      }
+    }
+    free(canvas);
+    WebPAnimDecoderDelete(dec_canvas);
+
+    if (seek_timestamp >= 0 && WebPAnimDecoderSeekToFrame(dec, seek_frame)) {
+      uint8_t* buf;
+      int timestamp;
+      if (WebPAnimDecoderGetNext(dec, &buf, &timestamp) &&
+          timestamp != seek_timestamp) {
+        abort();
+      }
+    }
   }
 End:
   WebPAnimDecoderDelete(dec);
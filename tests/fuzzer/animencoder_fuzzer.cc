@@ -123,7 +123,8 @@ int AddFrame(WebPAnimEncoder** const enc,
 }
 
 void AnimEncoderTest(bool minimize_size, std::pair<int, int> kmin_kmax,
-                     bool allow_mixed, std::vector<FrameConfig> frame_configs,
+                     bool allow_mixed, int lookahead,
+                     std::vector<FrameConfig> frame_configs,
                      int optimization_index) {
   WebPAnimEncoder* enc = nullptr;
   int width = 0, height = 0, timestamp_ms = 0;
@@ -141,6 +142,7 @@ void AnimEncoderTest(bool minimize_size, std::pair<int, int> kmin_kmax,
   anim_config.kmin = kmin_kmax.first;
   anim_config.kmax = kmin_kmax.second;
   anim_config.allow_mixed = allow_mixed;
+  anim_config.lookahead = lookahead;
   anim_config.verbose = 0;
 
   // For each frame.
@@ -183,6 +185,7 @@ FUZZ_TEST(AnimIndexEncoder, AnimEncoderTest)
     .WithDomains(
         /*minimize_size=*/fuzztest::Arbitrary<bool>(), ArbitraryKMinKMax(),
         /*allow_mixed=*/fuzztest::Arbitrary<bool>(),
+        /*lookahead=*/fuzztest::InRange<int>(0, 3),
         fuzztest::VectorOf(fuzztest::StructOf<FrameConfig>(
                                fuzztest::InRange<int>(0, 1),
                                fuzztest::InRange<int>(0, 131073),
@@ -198,6 +201,7 @@ FUZZ_TEST(AnimArbitraryEncoder, AnimEncoderTest)
     .WithDomains(
         /*minimize_size=*/fuzztest::Arbitrary<bool>(), ArbitraryKMinKMax(),
         /*allow_mixed=*/fuzztest::Arbitrary<bool>(),
+        /*lookahead=*/fuzztest::InRange<int>(0, 3),
         fuzztest::VectorOf(fuzztest::StructOf<FrameConfig>(
                                fuzztest::InRange<int>(0, 1),
                                fuzztest::InRange<int>(0, 131073),
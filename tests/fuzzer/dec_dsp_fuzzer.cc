@@ -0,0 +1,210 @@
+// Copyright 2025 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Checks that the SIMD decoding functions and YUV->RGB samplers (including the
+// Xtensa PIE ones, which can be run on the host by building with
+// -DWEBP_XTENSA_PIE_EMULATION) give the same results as the plain C ones.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "./fuzz_utils.h"
+#include "src/dec/common_dec.h"
+#include "src/dsp/dsp.h"
+#include "webp/decode.h"
+#include "webp/types.h"
+
+namespace {
+
+// Pixels are laid out with the stride used by the decoder for prediction.
+constexpr int kStride = BPS;
+constexpr int kHeight = 32;
+constexpr int kPixelsSize = kStride * kHeight;
+constexpr int kNumCoeffs = 4 * 16;
+constexpr int kMaxSamplerWidth = 64;
+
+struct DecDsp {
+  VP8DecIdct2 transform;
+  VP8DecIdct transform_ac3, transform_uv, transform_dc, transform_dcuv;
+  VP8WHT transform_wht;
+  VP8PredFunc pred_luma16[NUM_B_DC_MODES];
+  VP8PredFunc pred_chroma8[NUM_B_DC_MODES];
+  VP8PredFunc pred_luma4[NUM_BMODES];
+  VP8SimpleFilterFunc simple_filters[4];
+  VP8LumaFilterFunc luma_filters[4];
+  VP8ChromaFilterFunc chroma_filters[4];
+  WebPSamplerRowFunc samplers[MODE_LAST];
+};
+
+DecDsp GetDecDsp(WebPDspLevel level) {
+  DecDsp dsp;
+  if (!WebPSetDspLevel(level)) std::abort();
+  VP8DspInit();
+  WebPInitSamplers();
+  dsp.transform = VP8Transform;
+  dsp.transform_ac3 = VP8TransformAC3;
+  dsp.transform_uv = VP8TransformUV;
+  dsp.transform_dc = VP8TransformDC;
+  dsp.transform_dcuv = VP8TransformDCUV;
+  dsp.transform_wht = VP8TransformWHT;
+  std::memcpy(dsp.pred_luma16, VP8PredLuma16, sizeof(dsp.pred_luma16));
+  std::memcpy(dsp.pred_chroma8, VP8PredChroma8, sizeof(dsp.pred_chroma8));
+  std::memcpy(dsp.pred_luma4, VP8PredLuma4, sizeof(dsp.pred_luma4));
+  dsp.simple_filters[0] = VP8SimpleVFilter16;
+  dsp.simple_filters[1] = VP8SimpleHFilter16;
+  dsp.simple_filters[2] = VP8SimpleVFilter16i;
+  dsp.simple_filters[3] = VP8SimpleHFilter16i;
+  dsp.luma_filters[0] = VP8VFilter16;
+  dsp.luma_filters[1] = VP8HFilter16;
+  dsp.luma_filters[2] = VP8VFilter16i;
+  dsp.luma_filters[3] = VP8HFilter16i;
+  dsp.chroma_filters[0] = VP8VFilter8;
+  dsp.chroma_filters[1] = VP8HFilter8;
+  dsp.chroma_filters[2] = VP8VFilter8i;
+  dsp.chroma_filters[3] = VP8HFilter8i;
+  std::memcpy(dsp.samplers, WebPSamplers, sizeof(dsp.samplers));
+  return dsp;
+}
+
+const DecDsp& GetReferenceDsp() {
+  static const DecDsp dsp = GetDecDsp(WEBP_DSP_LEVEL_C);
+  return dsp;
+}
+
+const DecDsp& GetOptimizedDsp() {
+  static const DecDsp dsp = GetDecDsp(WEBP_DSP_LEVEL_AUTO);
+  return dsp;
+}
+
+// Runs 'func' on a copy of 'pixels' for both implementations and compares the
+// results.
+template <typename Func>
+void Compare(const char* name, const std::vector<uint8_t>& pixels, Func func) {
+  std::vector<uint8_t> ref(pixels), opt(pixels);
+  func(GetReferenceDsp(), ref.data());
+  func(GetOptimizedDsp(), opt.data());
+  if (ref != opt) {
+    fprintf(stderr, "%s differs from the C implementation\n", name);
+    std::abort();
+  }
+}
+
+void DecDspTest(const std::vector<uint8_t>& pixels,
+                const std::vector<int16_t>& coeffs, int thresh, int ithresh,
+                int hev_t) {
+  // The filters and the predictors work in the middle of the buffer so that
+  // the borders they read are in bounds.
+  const int offset = 8 * kStride + 8;
+  const int16_t* const in = coeffs.data();
+
+  Compare("VP8Transform", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+    dsp.transform(in, dst + offset, /*do_two=*/0);
+    dsp.transform(in + 16, dst + offset + 4 * kStride, /*do_two=*/1);
+  });
+  Compare("VP8TransformAC3", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+    dsp.transform_ac3(in, dst + offset);
+  });
+  Compare("VP8TransformUV", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+    dsp.transform_uv(in, dst + offset);
+  });
+  Compare("VP8TransformDC", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+    dsp.transform_dc(in, dst + offset);
+  });
+  Compare("VP8TransformDCUV", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+    dsp.transform_dcuv(in, dst + offset);
+  });
+  {
+    int16_t ref[16 * 16], opt[16 * 16];
+    GetReferenceDsp().transform_wht(in, ref);
+    GetOptimizedDsp().transform_wht(in, opt);
+    for (int i = 0; i < 16; ++i) {
+      if (ref[16 * i] != opt[16 * i]) {
+        fprintf(stderr, "VP8TransformWHT differs from the C implementation\n");
+        std::abort();
+      }
+    }
+  }
+
+  for (int mode = 0; mode < NUM_B_DC_MODES; ++mode) {
+    Compare("VP8PredLuma16", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+      dsp.pred_luma16[mode](dst + offset);
+    });
+    Compare("VP8PredChroma8", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+      dsp.pred_chroma8[mode](dst + offset);
+    });
+  }
+  for (int mode = 0; mode < NUM_BMODES; ++mode) {
+    Compare("VP8PredLuma4", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+      dsp.pred_luma4[mode](dst + offset);
+    });
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    Compare("simple filter", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+      dsp.simple_filters[i](dst + offset, kStride, thresh);
+    });
+    Compare("luma filter", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+      dsp.luma_filters[i](dst + offset, kStride, thresh, ithresh, hev_t);
+    });
+    Compare("chroma filter", pixels, [&](const DecDsp& dsp, uint8_t* dst) {
+      // u and v are side by side, as in the decoder's cache.
+      dsp.chroma_filters[i](dst + offset, dst + offset + 8, kStride, thresh,
+                            ithresh, hev_t);
+    });
+  }
+}
+
+// The ranges are the ones the decoder can produce: dequantized coefficients,
+// and the filter strengths computed in PrecomputeFilterStrengths().
+FUZZ_TEST(DecDsp, DecDspTest)
+    .WithDomains(
+        fuzztest::VectorOf(fuzztest::Arbitrary<uint8_t>())
+            .WithSize(kPixelsSize),
+        fuzztest::VectorOf(fuzztest::InRange<int16_t>(-2048, 2047))
+            .WithSize(kNumCoeffs),
+        /*thresh=*/fuzztest::InRange<int>(0, 2 * 63 + 63 + 4),
+        /*ithresh=*/fuzztest::InRange<int>(1, 63),
+        /*hev_t=*/fuzztest::InRange<int>(0, 2));
+
+// 'yuv' holds a row of kMaxSamplerWidth luma samples followed by the two rows
+// of chroma samples.
+void SamplersTest(const std::vector<uint8_t>& yuv, int width) {
+  const uint8_t* const y = yuv.data();
+  const uint8_t* const u = y + kMaxSamplerWidth;
+  const uint8_t* const v = u + kMaxSamplerWidth / 2;
+
+  for (int mode = MODE_RGB; mode < MODE_LAST; ++mode) {
+    if (!WebPIsRGBMode(static_cast<WEBP_CSP_MODE>(mode))) continue;
+    std::vector<uint8_t> ref(4 * kMaxSamplerWidth), opt(ref);
+    GetReferenceDsp().samplers[mode](y, u, v, ref.data(), width);
+    GetOptimizedDsp().samplers[mode](y, u, v, opt.data(), width);
+    if (ref != opt) {
+      fprintf(stderr, "WebPSamplers[%d] differs from the C implementation\n",
+              mode);
+      std::abort();
+    }
+  }
+}
+
+FUZZ_TEST(DecDsp, SamplersTest)
+    .WithDomains(fuzztest::VectorOf(fuzztest::Arbitrary<uint8_t>())
+                     .WithSize(2 * kMaxSamplerWidth),
+                 fuzztest::InRange<int>(1, kMaxSamplerWidth));
+
+}  // namespace
@@ -137,6 +137,54 @@ void EncArbitraryTest(
   EncTestImpl(pic, optimization_index, use_argb, config, crop_or_scale_params);
 }
 
+// Encodes a copy of 'pic' into 'output'. Returns false on memory error.
+bool EncodeCopy(const WebPPicture& pic, const WebPConfig& config,
+                std::string* const output) {
+  WebPPicture copy;
+  if (!WebPPictureInit(&copy)) std::abort();
+  if (!WebPPictureCopy(&pic, &copy)) return false;
+  WebPMemoryWriter memory_writer;
+  WebPMemoryWriterInit(&memory_writer);
+  copy.writer = WebPMemoryWrite;
+  copy.custom_ptr = &memory_writer;
+  const int ok = WebPEncode(&config, &copy);
+  const WebPEncodingError error_code = copy.error_code;
+  output->assign(reinterpret_cast<const char*>(memory_writer.mem),
+                 memory_writer.size);
+  WebPMemoryWriterClear(&memory_writer);
+  WebPPictureFree(&copy);
+  if (!ok) {
+    if (error_code == VP8_ENC_ERROR_OUT_OF_MEMORY) return false;
+    std::cerr << "WebPEncode failed. Error code: " << error_code << "\n";
+    std::abort();
+  }
+  return true;
+}
+
+// The lossy bitstream must not depend on the number of threads, including the
+// filter strength derived from the macroblocks decimated concurrently.
+void EncThreadsTest(fuzz_utils::WebPPictureCpp pic_cpp, WebPConfig config,
+                    int filter_strength, int thread_level) {
+  const WebPPicture& pic = pic_cpp.ref();
+  config.lossless = 0;
+  config.autofilter = 0;
+  config.filter_strength = filter_strength;
+  // Skip slow settings on big images, it's likely to timeout.
+  if (pic.width * pic.height > 128 * 128 && config.method > 4) {
+    config.method = 4;
+  }
+
+  std::string single_threaded, multi_threaded;
+  config.thread_level = 0;
+  if (!EncodeCopy(pic, config, &single_threaded)) return;
+  config.thread_level = thread_level;
+  if (!EncodeCopy(pic, config, &multi_threaded)) return;
+  if (single_threaded != multi_threaded) {
+    std::cerr << "Output differs with thread_level " << thread_level << ".\n";
+    std::abort();
+  }
+}
+
 }  // namespace
 
 FUZZ_TEST(Enc, EncArbitraryTest)
@@ -147,3 +195,9 @@ FUZZ_TEST(Enc, EncArbitraryTest)
                  /*use_argb=*/fuzztest::Arbitrary<bool>(),
                  fuzz_utils::ArbitraryWebPConfig(),
                  fuzz_utils::ArbitraryCropOrScaleParams());
+
+FUZZ_TEST(Enc, EncThreadsTest)
+    .WithDomains(fuzz_utils::ArbitraryWebPPicture(),
+                 fuzz_utils::ArbitraryWebPConfig(),
+                 /*filter_strength=*/fuzztest::InRange<int>(1, 100),
+                 /*thread_level=*/fuzztest::InRange<int>(1, 8));
@@ -0,0 +1,125 @@
+// Copyright 2026 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "./fuzz_utils.h"
+#include "src/utils/thread_utils.h"
+
+namespace {
+
+// Row of a wavefront: step 's' of row 'index' waits for step 's' of the row
+// above, like the macroblock rows of the lossy decoder.
+struct RowJob {
+  WebPWorker worker;
+  WebPProgress* progress;
+  int index;
+  int num_steps;
+};
+
+int RowJobHook(void* arg1, void* arg2) {
+  RowJob* const job = static_cast<RowJob*>(arg1);
+  (void)arg2;
+  for (int step = 1; step <= job->num_steps; ++step) {
+    if (job->index > 0 &&
+        !WebPProgressWait(job->progress, job->index - 1, step)) {
+      return 0;
+    }
+    WebPProgressUpdate(job->progress, job->index, step);
+  }
+  return 1;
+}
+
+// Job running a wavefront of 'num_rows' sub-jobs and waiting for the progress
+// of the last row, before syncing them all.
+struct FrameJob {
+  WebPWorker worker;
+  int num_rows;
+  int num_steps;
+};
+
+int FrameJobHook(void* arg1, void* arg2) {
+  FrameJob* const job = static_cast<FrameJob*>(arg1);
+  const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  (void)arg2;
+  WebPProgress progress = {};
+  if (!WebPProgressInit(&progress, job->num_rows)) return 0;
+  std::vector<RowJob> rows(job->num_rows);
+  int num_launched = 0;
+  for (RowJob& row : rows) {
+    worker_interface->Init(&row.worker);
+    row.progress = &progress;
+    row.index = num_launched;
+    row.num_steps = job->num_steps;
+    row.worker.hook = RowJobHook;
+    row.worker.data1 = &row;
+    if (!worker_interface->Reset(&row.worker)) break;
+    worker_interface->Launch(&row.worker);
+    ++num_launched;
+  }
+  int ok = (num_launched == job->num_rows) &&
+           WebPProgressWait(&progress, job->num_rows - 1, job->num_steps);
+  if (!ok) WebPProgressAbort(&progress);
+  for (int i = 0; i < num_launched; ++i) {
+    ok &= worker_interface->Sync(&rows[i].worker);
+  }
+  for (RowJob& row : rows) worker_interface->End(&row.worker);
+  WebPProgressClear(&progress);
+  return ok;
+}
+
+// Launches 'num_jobs' frame jobs on a pool of 'pool_size' threads. Nested
+// wavefronts used to deadlock when all the pool threads were waiting on the
+// progress of rows still queued behind them.
+void NestedJobsTest(int pool_size, int num_jobs, int num_rows, int num_steps) {
+  if (!WebPSetThreadPool(pool_size)) {
+    std::cerr << "WebPSetThreadPool failed.\n";
+    std::abort();
+  }
+  const WebPWorkerInterface* const worker_interface = WebPGetWorkerInterface();
+  std::vector<FrameJob> jobs(num_jobs);
+  int num_launched = 0;
+  for (FrameJob& job : jobs) {
+    worker_interface->Init(&job.worker);
+    job.num_rows = num_rows;
+    job.num_steps = num_steps;
+    job.worker.hook = FrameJobHook;
+    job.worker.data1 = &job;
+    if (!worker_interface->Reset(&job.worker)) break;
+    worker_interface->Launch(&job.worker);
+    ++num_launched;
+  }
+  for (int i = 0; i < num_launched; ++i) {
+    // Only allocation failures are tolerated, under the nallocfuzz engine.
+    if (!worker_interface->Sync(&jobs[i].worker) &&
+        getenv("NALLOC_FUZZ_VERSION") == nullptr) {
+      std::cerr << "Frame job " << i << " failed.\n";
+      std::abort();
+    }
+  }
+  for (FrameJob& job : jobs) worker_interface->End(&job.worker);
+  if (!WebPSetThreadPool(0)) std::abort();
+}
+
+}  // namespace
+
+FUZZ_TEST(ThreadPool, NestedJobsTest)
+    .WithDomains(/*pool_size=*/fuzztest::InRange<int>(1, 4),
+                 /*num_jobs=*/fuzztest::InRange<int>(1, 8),
+                 /*num_rows=*/fuzztest::InRange<int>(1, 6),
+                 /*num_steps=*/fuzztest::InRange<int>(1, 16));